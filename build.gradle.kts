@@ -1,6 +1,7 @@
 plugins {
     application
     kotlin("jvm") version "2.3.20"
+    id("me.champeau.jmh") version "0.7.2"
 }
 
 application {
@@ -40,11 +41,67 @@ tasks.register<CreateStartScripts>("startLspScripts") {
     outputDir = layout.buildDirectory.dir("scripts-lsp").get().asFile
 }
 
+// Prebuilt stdlib frontend state (see StdlibSnapshot); installDist ships it
+// next to the jar as lib/kira-stdlib.snapshot.
+val stdlibSnapshot = tasks.register<JavaExec>("stdlibSnapshot") {
+    val output = layout.buildDirectory.file("stdlib-snapshot/kira-stdlib.snapshot")
+    mainClass.set("net.exoad.kira.cli.StdlibSnapshotMainKt")
+    classpath = sourceSets.main.get().runtimeClasspath
+    inputs.dir(rootProject.file("kira"))
+    outputs.file(output)
+    args(rootProject.file("kira").absolutePath, output.get().asFile.absolutePath)
+}
+
 tasks.named<Sync>("installDist") {
     dependsOn("startLspScripts")
     from(tasks.named("startLspScripts")) {
         into("bin")
     }
+    from(stdlibSnapshot) {
+        into("lib")
+    }
+}
+
+// Compiler benchmarks (src/jmh): ./gradlew jmh, results in build/results/jmh.
+// -PbenchLines=1000,1000000 overrides the project sizes, -PbenchIncludes=PipelineBenchmark.lex
+// runs only the matching benchmarks.
+jmh {
+    jmhVersion.set("1.37")
+    profilers.add("gc")
+    resultFormat.set("JSON")
+    providers.gradleProperty("benchLines").orNull?.let { lines ->
+        benchmarkParameters.put("lines", objects.listProperty<String>().value(lines.split(",")))
+    }
+    providers.gradleProperty("benchIncludes").orNull?.let { pattern ->
+        includes.set(listOf(pattern))
+    }
+}
+
+// C prelude microbenchmarks (src/test/c): ./gradlew preludeBench builds the harness with the
+// host cc (-Pcc=clang for another) at -O2 and fails when a row exceeds prelude_bench.thresholds.
+// -PbenchMax=10000000 adds the 1e7 rows.
+val preludeBenchBinary = layout.buildDirectory.file("prelude-bench/prelude_bench")
+
+val compilePreludeBench = tasks.register<Exec>("compilePreludeBench") {
+    val source = file("src/test/c/prelude_bench.c")
+    inputs.file(source)
+    inputs.dir(rootProject.file("kira/c"))
+    outputs.file(preludeBenchBinary)
+    doFirst { preludeBenchBinary.get().asFile.parentFile.mkdirs() }
+    commandLine(
+        providers.gradleProperty("cc").getOrElse("cc"), "-std=c17", "-O2",
+        "-I", rootProject.file("kira/c").absolutePath,
+        "-o", preludeBenchBinary.get().asFile.absolutePath, source.absolutePath,
+    )
+}
+
+tasks.register<Exec>("preludeBench") {
+    dependsOn(compilePreludeBench)
+    commandLine(
+        preludeBenchBinary.get().asFile.absolutePath,
+        "--max", providers.gradleProperty("benchMax").getOrElse("1000000"),
+        "--thresholds", file("src/test/c/prelude_bench.thresholds").absolutePath,
+    )
 }
 
 kotlin {
@@ -1,2 +1,2 @@
 #include <math.h>
-typedef struct o o;typedef struct aa aa;typedef struct f f;struct o{Int32 x;Int32 y;};simple o*w(Int32 x,Int32 y){o*self=(o*)kira_rc_alloc_with(sizeof(o),null);self->x=x;self->y=y;return self;}struct aa{o*bc;o*ae;};Int32 ad(aa*this){Int32 width=(this->ae->x-this->bc->x);Int32 ak=(this->bc->y-this->ae->y);return((width+ak)*2);}static Void ab(Void*p){aa*self=(aa*)p;kira_rc_release(self->bc);kira_rc_release(self->ae);}simple aa*ac(o*bc,o*ae){aa*self=(aa*)kira_rc_alloc_with(sizeof(aa),ab);self->bc=bc;self->ae=ae;return self;}struct f{Str ar;Str az;};Str k(f*this){return this->az;}simple f*j(Str ar,Str az){f*self=(f*)kira_rc_alloc_with(sizeof(f),null);self->ar=ar;self->az=az;return self;}Float64 af(Float64 value,Float64 aq,Float64 al);Float64 ap(Float64 a,Float64 b,Float64 t);Int32 ay(Float64 value);Float64 bb(Float64 ai,Float64 value);Float64 am(Float64 a,Float64 b,Float64 value);Float64 ag(Float64 ah);Float64 av(Float64 aw);Bool ao(Float64 value,Float64 aq,Float64 al);Int32 main(Void);Int32 ad(aa*this);Str k(f*this);Float64 af(Float64 value,Float64 aq,Float64 al){return fmax(aq,fmin(value,al));}Float64 ap(Float64 a,Float64 b,Float64 t){return(a+((b-a)*t));}Int32 ay(Float64 value){if((value>0)){return 1;}else if((value<0)){return-1;}else{return 0;}}Float64 bb(Float64 ai,Float64 value){if((value>=ai)){return 1.0;}else{return 0.0;}}Float64 am(Float64 a,Float64 b,Float64 value){return((value-a)/(b-a));}Float64 ag(Float64 ah){return((ah*3.141592653589793)/180.0);}Float64 av(Float64 aw){return((aw*180.0)/3.141592653589793);}Bool ao(Float64 value,Float64 aq,Float64 al){return((value>=aq)&&(value<=al));}Int32 main(Void){aa*ax=ac(w(0,1),w(1,0));f*aj=j("Mochi","meow");print("%d\n",ad(ax));print("%s\n",aj->ar);print("%s\n",k(aj));kira_rc_release(aj);kira_rc_release(ax);return 0;}
+typedef struct o o;typedef struct aa aa;typedef struct f f;struct o{Int32 x;Int32 y;};simple o*w(Int32 x,Int32 y){o*self=(o*)kira_rc_alloc_with(sizeof(o),null,"Point");self->x=x;self->y=y;return self;}struct aa{o*bc;o*ae;};Int32 ad(aa*this){Int32 width=(this->ae->x-this->bc->x);Int32 ak=(this->bc->y-this->ae->y);return((width+ak)*2);}static Void ab(Void*p,KiraRcVisitor visit){aa*self=(aa*)p;visit(self->bc);visit(self->ae);}simple aa*ac(o*bc,o*ae){aa*self=(aa*)kira_rc_alloc_with(sizeof(aa),ab,"Rectangle");self->bc=bc;self->ae=ae;return self;}struct f{Str ar;Str az;};Str k(f*this){return this->az;}simple f*j(Str ar,Str az){f*self=(f*)kira_rc_alloc_with(sizeof(f),null,"Pet");self->ar=ar;self->az=az;return self;}Float64 af(Float64 value,Float64 aq,Float64 al);Float64 ap(Float64 a,Float64 b,Float64 t);Int32 ay(Float64 value);Float64 bb(Float64 ai,Float64 value);Float64 am(Float64 a,Float64 b,Float64 value);Float64 ag(Float64 ah);Float64 av(Float64 aw);Bool ao(Float64 value,Float64 aq,Float64 al);Int32 main(Void);Int32 ad(aa*this);Str k(f*this);Float64 af(Float64 value,Float64 aq,Float64 al){return fmax(aq,fmin(value,al));}Float64 ap(Float64 a,Float64 b,Float64 t){return(a+((b-a)*t));}Int32 ay(Float64 value){if((value>0)){return 1;}else if((value<0)){return-1;}else{return 0;}}Float64 bb(Float64 ai,Float64 value){if((value>=ai)){return 1.0;}else{return 0.0;}}Float64 am(Float64 a,Float64 b,Float64 value){return((value-a)/(b-a));}Float64 ag(Float64 ah){return((ah*3.141592653589793)/180.0);}Float64 av(Float64 aw){return((aw*180.0)/3.141592653589793);}Bool ao(Float64 value,Float64 aq,Float64 al){return((value>=aq)&&(value<=al));}Int32 main(Void){aa*ax=ac(w(0,1),w(1,0));f*aj=j("Mochi","meow");print("%d\n",ad(ax));print("%s\n",aj->ar);print("%s\n",k(aj));kira_rc_release(aj);kira_rc_release(ax);return 0;}
@@ -1,2 +1,2 @@
 #include <math.h>
-typedef struct o o;struct o{Int32 value;};simple o*w(Int32 value){o*self=(o*)kira_rc_alloc_with(sizeof(o),null);self->value=value;return self;}typedef enum aa{g,j,f}aa;Float64 ab(Float64 value,Float64 ak,Float64 af);Float64 aj(Float64 a,Float64 b,Float64 t);Int32 ao(Float64 value);Float64 aq(Float64 ae,Float64 value);Float64 ah(Float64 a,Float64 b,Float64 value);Float64 ac(Float64 ad);Float64 al(Float64 am);Bool ai(Float64 value,Float64 ak,Float64 af);Int32 ag(Int32 value);Int32 main(Void);Int32 ag(Int32 value){return value;}Float64 ab(Float64 value,Float64 ak,Float64 af){return fmax(ak,fmin(value,af));}Float64 aj(Float64 a,Float64 b,Float64 t){return(a+((b-a)*t));}Int32 ao(Float64 value){if((value>0)){return 1;}else if((value<0)){return-1;}else{return 0;}}Float64 aq(Float64 ae,Float64 value){if((value>=ae)){return 1.0;}else{return 0.0;}}Float64 ah(Float64 a,Float64 b,Float64 value){return((value-a)/(b-a));}Float64 ac(Float64 ad){return((ad*3.141592653589793)/180.0);}Float64 al(Float64 am){return((am*180.0)/3.141592653589793);}Bool ai(Float64 value,Float64 ak,Float64 af){return((value>=ak)&&(value<=af));}Int32 main(Void){aa ap=g;o*ar=w(7);Int32 value=ag(ar->value);if((ap==g)){print("%d\n",value);}kira_rc_release(ar);return 0;}
+typedef struct o o;struct o{Int32 value;};simple o*w(Int32 value){o*self=(o*)kira_rc_alloc_with(sizeof(o),null,"Box<Int32>");self->value=value;return self;}typedef enum aa{g,j,f}aa;Float64 ab(Float64 value,Float64 ak,Float64 af);Float64 aj(Float64 a,Float64 b,Float64 t);Int32 ao(Float64 value);Float64 aq(Float64 ae,Float64 value);Float64 ah(Float64 a,Float64 b,Float64 value);Float64 ac(Float64 ad);Float64 al(Float64 am);Bool ai(Float64 value,Float64 ak,Float64 af);Int32 ag(Int32 value);Int32 main(Void);Int32 ag(Int32 value){return value;}Float64 ab(Float64 value,Float64 ak,Float64 af){return fmax(ak,fmin(value,af));}Float64 aj(Float64 a,Float64 b,Float64 t){return(a+((b-a)*t));}Int32 ao(Float64 value){if((value>0)){return 1;}else if((value<0)){return-1;}else{return 0;}}Float64 aq(Float64 ae,Float64 value){if((value>=ae)){return 1.0;}else{return 0.0;}}Float64 ah(Float64 a,Float64 b,Float64 value){return((value-a)/(b-a));}Float64 ac(Float64 ad){return((ad*3.141592653589793)/180.0);}Float64 al(Float64 am){return((am*180.0)/3.141592653589793);}Bool ai(Float64 value,Float64 ak,Float64 af){return((value>=ak)&&(value<=af));}Int32 main(Void){aa ap=g;o*ar=w(7);Int32 value=ag(ar->value);if((ap==g)){print("%d\n",value);}kira_rc_release(ar);return 0;}
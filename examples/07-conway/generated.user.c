@@ -1,2 +1,2 @@
 #include <math.h>
-typedef struct f f;struct f{Int32 width;Int32 ak;Arr aa;};Int32 g(f*this,Int32 az,Int32 ac){Int32 ad=0;Int32 r=-1;while((r<=1)){Int32 c=-1;while((c<=1)){if(((r==0)&&(c==0))){c=(c+1);continue;}Int32 av=(az+r);Int32 ar=(ac+c);if(((((av>=0)&&(av<this->ak))&&(ar>=0))&&(ar<this->width))){Int32 idx=((av*this->width)+ar);Int32 val=Arr_get_i32(this->aa,idx);ad=(ad+val);}c=(c+1);}r=(r+1);}return ad;}Void u(f*this){Arr au=Arr_lit((KiraSlot[]){0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0},25);Int32 i=0;while((i<(this->width*this->ak))){Int32 az=(i/this->width);Int32 ac=(i%this->width);Int32 w=Arr_get_i32(this->aa,i);Int32 n=g(this,az,ac);if(((w==1)&&((n==2)||(n==3)))){Arr_set(au,i,KIRA_SLOT(1));}else if(((w==0)&&(n==3))){Arr_set(au,i,KIRA_SLOT(1));}else{Arr_set(au,i,KIRA_SLOT(0));}i=(i+1);}i=0;while((i<(this->width*this->ak))){Int32 bb=Arr_get_i32(au,i);Arr_set(this->aa,i,KIRA_SLOT(bb));i=(i+1);}}Void o(f*this){Int32 r=0;while((r<this->ak)){Int32 c=0;while((c<this->width)){Int32 idx=((r*this->width)+c);if((Arr_get_i32(this->aa,idx)==1)){print("%s\n","#");}else{print("%s\n",".");}c=(c+1);}print("%s\n","");r=(r+1);}}simple f*k(Int32 width,Int32 ak,Arr aa){f*self=(f*)kira_rc_alloc_with(sizeof(f),null);self->width=width;self->ak=ak;self->aa=aa;return self;}Float64 ab(Float64 value,Float64 aq,Float64 al);Float64 ap(Float64 a,Float64 b,Float64 t);Int32 ba(Float64 value);Float64 bc(Float64 ah,Float64 value);Float64 am(Float64 a,Float64 b,Float64 value);Float64 af(Float64 ag);Float64 ax(Float64 ay);Bool ao(Float64 value,Float64 aq,Float64 al);Int32 g(f*this,Int32 az,Int32 ac);Void u(f*this);Void o(f*this);Int32 main(Void);Float64 ab(Float64 value,Float64 aq,Float64 al){return fmax(aq,fmin(value,al));}Float64 ap(Float64 a,Float64 b,Float64 t){return(a+((b-a)*t));}Int32 ba(Float64 value){if((value>0)){return 1;}else if((value<0)){return-1;}else{return 0;}}Float64 bc(Float64 ah,Float64 value){if((value>=ah)){return 1.0;}else{return 0.0;}}Float64 am(Float64 a,Float64 b,Float64 value){return((value-a)/(b-a));}Float64 af(Float64 ag){return((ag*3.141592653589793)/180.0);}Float64 ax(Float64 ay){return((ay*180.0)/3.141592653589793);}Bool ao(Float64 value,Float64 aq,Float64 al){return((value>=aq)&&(value<=al));}Int32 main(Void){f*ai=k(5,5,Arr_lit((KiraSlot[]){0,0,1,0,0,0,1,0,0,0,1,1,1,0,0,0,0,0,0,0,0,0,0,0,0},25));Int32 aj=0;while((aj<5)){o(ai);print("%s\n","");u(ai);aj=(aj+1);}kira_rc_release(ai);return 0;}
+typedef struct f f;struct f{Int32 width;Int32 ak;Arr aa;};Int32 g(f*this,Int32 az,Int32 ac){Int32 ad=0;Int32 r=-1;while((r<=1)){Int32 c=-1;while((c<=1)){if(((r==0)&&(c==0))){c=(c+1);continue;}Int32 av=(az+r);Int32 ar=(ac+c);if(((((av>=0)&&(av<this->ak))&&(ar>=0))&&(ar<this->width))){Int32 idx=((av*this->width)+ar);Int32 val=Arr_get_i32(this->aa,idx);ad=(ad+val);}c=(c+1);}r=(r+1);}return ad;}Void u(f*this){Arr au=Arr_lit((KiraSlot[]){0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0},25);Int32 i=0;while((i<(this->width*this->ak))){Int32 az=(i/this->width);Int32 ac=(i%this->width);Int32 w=Arr_get_i32(this->aa,i);Int32 n=g(this,az,ac);if(((w==1)&&((n==2)||(n==3)))){Arr_set(au,i,KIRA_SLOT(1));}else if(((w==0)&&(n==3))){Arr_set(au,i,KIRA_SLOT(1));}else{Arr_set(au,i,KIRA_SLOT(0));}i=(i+1);}i=0;while((i<(this->width*this->ak))){Int32 bb=Arr_get_i32(au,i);Arr_set(this->aa,i,KIRA_SLOT(bb));i=(i+1);}}Void o(f*this){Int32 r=0;while((r<this->ak)){Int32 c=0;while((c<this->width)){Int32 idx=((r*this->width)+c);if((Arr_get_i32(this->aa,idx)==1)){print("%s\n","#");}else{print("%s\n",".");}c=(c+1);}print("%s\n","");r=(r+1);}}simple f*k(Int32 width,Int32 ak,Arr aa){f*self=(f*)kira_rc_alloc_with(sizeof(f),null,"Grid");self->width=width;self->ak=ak;self->aa=aa;return self;}Float64 ab(Float64 value,Float64 aq,Float64 al);Float64 ap(Float64 a,Float64 b,Float64 t);Int32 ba(Float64 value);Float64 bc(Float64 ah,Float64 value);Float64 am(Float64 a,Float64 b,Float64 value);Float64 af(Float64 ag);Float64 ax(Float64 ay);Bool ao(Float64 value,Float64 aq,Float64 al);Int32 g(f*this,Int32 az,Int32 ac);Void u(f*this);Void o(f*this);Int32 main(Void);Float64 ab(Float64 value,Float64 aq,Float64 al){return fmax(aq,fmin(value,al));}Float64 ap(Float64 a,Float64 b,Float64 t){return(a+((b-a)*t));}Int32 ba(Float64 value){if((value>0)){return 1;}else if((value<0)){return-1;}else{return 0;}}Float64 bc(Float64 ah,Float64 value){if((value>=ah)){return 1.0;}else{return 0.0;}}Float64 am(Float64 a,Float64 b,Float64 value){return((value-a)/(b-a));}Float64 af(Float64 ag){return((ag*3.141592653589793)/180.0);}Float64 ax(Float64 ay){return((ay*180.0)/3.141592653589793);}Bool ao(Float64 value,Float64 aq,Float64 al){return((value>=aq)&&(value<=al));}Int32 main(Void){f*ai=k(5,5,Arr_lit((KiraSlot[]){0,0,1,0,0,0,1,0,0,0,1,1,1,0,0,0,0,0,0,0,0,0,0,0,0},25));Int32 aj=0;while((aj<5)){o(ai);print("%s\n","");u(ai);aj=(aj+1);}kira_rc_release(ai);return 0;}
@@ -1,2 +1,2 @@
 #include <math.h>
-typedef struct u u;typedef struct f f;struct u{Str bi;};Str ad(u*this){return "woof";}Str ab(u*this){return this->bi;}Int32 aa(u*this){return 8;}simple u*ac(Str bi){u*self=(u*)kira_rc_alloc_with(sizeof(u),null);self->bi=bi;return self;}struct f{Str bi;};Str o(f*this){return "meow";}Str j(f*this){return this->bi;}simple f*k(Str bi){f*self=(f*)kira_rc_alloc_with(sizeof(f),null);self->bi=bi;return self;}typedef struct ae ae;typedef struct af af;struct af{Str(*bt)(void*self);Str(*bo)(void*self);Int32(*bl)(void*self);};struct ae{void*data;af*vtable;};typedef struct ak ak;typedef struct al al;struct al{Str(*bt)(void*self);Str(*bo)(void*self);};struct ak{void*data;al*vtable;};Float64 ay(Float64 value,Float64 bk,Float64 bf);Float64 bj(Float64 a,Float64 b,Float64 t);Int32 bs(Float64 value);Float64 bu(Float64 bd,Float64 value);Float64 bg(Float64 a,Float64 b,Float64 value);Float64 az(Float64 ba);Float64 bq(Float64 br);Bool bh(Float64 value,Float64 bk,Float64 bf);Str ad(u*this);Str ab(u*this);Int32 aa(u*this);Str o(f*this);Str j(f*this);Void av(ak s);Int32 bp(ae s);u*bm(Void);ak bn(Void);Int32 main(Void);static Str ai(void*self){return ad((u*)self);}static Str ah(void*self){return ab((u*)self);}static Int32 ag(void*self){return aa((u*)self);}static af aj={ai,ah,ag};static Str aq(void*self){return ad((u*)self);}static Str ao(void*self){return ab((u*)self);}static al au={aq,ao};static Str ap(void*self){return o((f*)self);}static Str am(void*self){return j((f*)self);}static al ar={ap,am};Float64 ay(Float64 value,Float64 bk,Float64 bf){return fmax(bk,fmin(value,bf));}Float64 bj(Float64 a,Float64 b,Float64 t){return(a+((b-a)*t));}Int32 bs(Float64 value){if((value>0)){return 1;}else if((value<0)){return-1;}else{return 0;}}Float64 bu(Float64 bd,Float64 value){if((value>=bd)){return 1.0;}else{return 0.0;}}Float64 bg(Float64 a,Float64 b,Float64 value){return((value-a)/(b-a));}Float64 az(Float64 ba){return((ba*3.141592653589793)/180.0);}Float64 bq(Float64 br){return((br*180.0)/3.141592653589793);}Bool bh(Float64 value,Float64 bk,Float64 bf){return((value>=bk)&&(value<=bf));}Void av(ak s){print("%s\n",s.vtable->bo(s.data));print("%s\n",s.vtable->bt(s.data));}Int32 bp(ae s){return s.vtable->bl(s.data);}u*bm(Void){u*bb=ac("Rex");return bb;}ak bn(Void){f*ax=k("Luna");return((ak){.data=ax,.vtable=&ar});}Int32 main(Void){u*bb=bm();f*ax=k("Luna");av(((ak){.data=bb,.vtable=&au}));av(((ak){.data=ax,.vtable=&ar}));Int32 bc=bp(((ae){.data=bb,.vtable=&aj}));print("%d\n",bc);ak s=((ak){.data=bb,.vtable=&au});print("%s\n",s.vtable->bo(s.data));ak aw=((ak){.data=ac("Bolt"),.vtable=&au});print("%s\n",aw.vtable->bt(aw.data));print("%s\n",bn().vtable->bo(bn().data));kira_rc_release(ax);kira_rc_release(bb);return 0;}
+typedef struct u u;typedef struct f f;struct u{Str bi;};Str ad(u*this){return "woof";}Str ab(u*this){return this->bi;}Int32 aa(u*this){return 8;}simple u*ac(Str bi){u*self=(u*)kira_rc_alloc_with(sizeof(u),null,"Dog");self->bi=bi;return self;}struct f{Str bi;};Str o(f*this){return "meow";}Str j(f*this){return this->bi;}simple f*k(Str bi){f*self=(f*)kira_rc_alloc_with(sizeof(f),null,"Cat");self->bi=bi;return self;}typedef struct ae ae;typedef struct af af;struct af{Str(*bt)(void*self);Str(*bo)(void*self);Int32(*bl)(void*self);};struct ae{void*data;af*vtable;};typedef struct ak ak;typedef struct al al;struct al{Str(*bt)(void*self);Str(*bo)(void*self);};struct ak{void*data;al*vtable;};Float64 ay(Float64 value,Float64 bk,Float64 bf);Float64 bj(Float64 a,Float64 b,Float64 t);Int32 bs(Float64 value);Float64 bu(Float64 bd,Float64 value);Float64 bg(Float64 a,Float64 b,Float64 value);Float64 az(Float64 ba);Float64 bq(Float64 br);Bool bh(Float64 value,Float64 bk,Float64 bf);Str ad(u*this);Str ab(u*this);Int32 aa(u*this);Str o(f*this);Str j(f*this);Void av(ak s);Int32 bp(ae s);u*bm(Void);ak bn(Void);Int32 main(Void);static Str ai(void*self){return ad((u*)self);}static Str ah(void*self){return ab((u*)self);}static Int32 ag(void*self){return aa((u*)self);}static af aj={ai,ah,ag};static Str aq(void*self){return ad((u*)self);}static Str ao(void*self){return ab((u*)self);}static al au={aq,ao};static Str ap(void*self){return o((f*)self);}static Str am(void*self){return j((f*)self);}static al ar={ap,am};Float64 ay(Float64 value,Float64 bk,Float64 bf){return fmax(bk,fmin(value,bf));}Float64 bj(Float64 a,Float64 b,Float64 t){return(a+((b-a)*t));}Int32 bs(Float64 value){if((value>0)){return 1;}else if((value<0)){return-1;}else{return 0;}}Float64 bu(Float64 bd,Float64 value){if((value>=bd)){return 1.0;}else{return 0.0;}}Float64 bg(Float64 a,Float64 b,Float64 value){return((value-a)/(b-a));}Float64 az(Float64 ba){return((ba*3.141592653589793)/180.0);}Float64 bq(Float64 br){return((br*180.0)/3.141592653589793);}Bool bh(Float64 value,Float64 bk,Float64 bf){return((value>=bk)&&(value<=bf));}Void av(ak s){print("%s\n",s.vtable->bo(s.data));print("%s\n",s.vtable->bt(s.data));}Int32 bp(ae s){return s.vtable->bl(s.data);}u*bm(Void){u*bb=ac("Rex");return bb;}ak bn(Void){f*ax=k("Luna");return((ak){.data=ax,.vtable=&ar});}Int32 main(Void){u*bb=bm();f*ax=k("Luna");av(((ak){.data=bb,.vtable=&au}));av(((ak){.data=ax,.vtable=&ar}));Int32 bc=bp(((ae){.data=bb,.vtable=&aj}));print("%d\n",bc);ak s=((ak){.data=bb,.vtable=&au});print("%s\n",s.vtable->bo(s.data));ak aw=((ak){.data=ac("Bolt"),.vtable=&au});print("%s\n",aw.vtable->bt(aw.data));print("%s\n",bn().vtable->bo(bn().data));kira_rc_release(ax);kira_rc_release(bb);return 0;}
@@ -0,0 +1,190 @@
+#!/usr/bin/env bash
+# End-to-end benchmark ladder: emit each program under examples/bench with
+# kira, build it with every available C compiler at -O2 / -O3 / -O2 -flto,
+# run it, and append runtime, peak RSS and binary size to a JSON Lines
+# history (one object per build).
+#
+#   ./examples/bench/run.sh                    # every program, every compiler
+#   ./examples/bench/run.sh word-count         # one program
+#   ./examples/bench/run.sh --runs 5 --out results.jsonl
+#   CCS="gcc-12 clang-17" ./examples/bench/run.sh
+#
+# Compilers come from $CCS (default: cc gcc clang); missing ones are skipped,
+# and `cc` is skipped when it is the same compiler as one already listed.
+# $FLAGS overrides the flag sets, separated by ';'. The time recorded is the
+# fastest of --runs (default 3). Every build must print exactly the program's
+# expected.txt, or the run fails: a flag that changes behaviour is a bug, not
+# a speedup.
+#
+# Peak RSS needs python3 (os.wait4); without it, the field is null and the
+# time comes from bash's `time`.
+set -euo pipefail
+
+ROOT="$(cd "$(dirname "$0")/../.." && pwd)"
+BENCH="$ROOT/examples/bench"
+KIRA_BIN="${KIRA:-$ROOT/build/install/kira/bin/kira}"
+PYTHON_BIN="${PYTHON:-python3}"
+read -r -a COMPILERS <<< "${CCS:-cc gcc clang}"
+IFS=';' read -r -a FLAG_SETS <<< "${FLAGS:--O2;-O3;-O2 -flto}"
+
+RUNS=3
+OUT="$BENCH/history.jsonl"
+SELECTED=()
+while [[ $# -gt 0 ]]; do
+  case "$1" in
+    --runs) RUNS="$2"; shift 2 ;;
+    --out) OUT="$2"; shift 2 ;;
+    -*) echo "unknown flag: $1" >&2; exit 2 ;;
+    *) SELECTED+=("$1"); shift ;;
+  esac
+done
+
+if [[ ! -x "$KIRA_BIN" ]]; then
+  echo "kira CLI not found at $KIRA_BIN" >&2
+  echo "Run: ./gradlew installDist" >&2
+  echo "Or set KIRA=/path/to/kira" >&2
+  exit 1
+fi
+
+HAVE_PYTHON=0
+if command -v "$PYTHON_BIN" >/dev/null 2>&1; then
+  HAVE_PYTHON=1
+else
+  echo "note: $PYTHON_BIN not found; peak RSS will be recorded as null" >&2
+fi
+
+# --- compilers --------------------------------------------------------------
+AVAILABLE=()
+VERSIONS=()
+for compiler in "${COMPILERS[@]}"; do
+  command -v "$compiler" >/dev/null 2>&1 || continue
+  version="$("$compiler" --version 2>/dev/null | head -n 1)"
+  duplicate=0
+  for seen in "${VERSIONS[@]+"${VERSIONS[@]}"}"; do
+    # "cc (Debian 12.2.0-14) 12.2.0" and "gcc (Debian 12.2.0-14) 12.2.0" are one compiler
+    [[ "${seen#* }" == "${version#* }" ]] && duplicate=1
+  done
+  [[ $duplicate -eq 1 ]] && continue
+  AVAILABLE+=("$compiler")
+  VERSIONS+=("$version")
+done
+if [[ ${#AVAILABLE[@]} -eq 0 ]]; then
+  echo "no C compiler found (tried: ${COMPILERS[*]})" >&2
+  exit 1
+fi
+
+if [[ ${#SELECTED[@]} -gt 0 ]]; then
+  DIRS=()
+  for name in "${SELECTED[@]}"; do DIRS+=("$BENCH/$name"); done
+else
+  DIRS=("$BENCH"/*/)
+fi
+
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+
+json_string() {
+  local s="${1//\\/\\\\}"
+  s="${s//\"/\\\"}"
+  printf '"%s"' "$s"
+}
+
+# One run of "$2..." with stdout to $1; prints "<seconds> <peak RSS KiB or null> <exit code>".
+measure() {
+  local stdout="$1"
+  shift
+  if [[ $HAVE_PYTHON -eq 1 ]]; then
+    "$PYTHON_BIN" - "$stdout" "$@" <<'PY'
+import os, subprocess, sys, time
+with open(sys.argv[1], "wb") as out:
+    start = time.perf_counter()
+    child = subprocess.Popen(sys.argv[2:], stdout=out)
+    _, status, usage = os.wait4(child.pid, 0)
+    elapsed = time.perf_counter() - start
+# ru_maxrss is KiB on Linux, bytes on macOS
+rss = usage.ru_maxrss // 1024 if sys.platform == "darwin" else usage.ru_maxrss
+code = os.WEXITSTATUS(status) if os.WIFEXITED(status) else 128 + os.WTERMSIG(status)
+print(f"{elapsed:.6f} {rss} {code}")
+PY
+  else
+    local TIMEFORMAT=%R
+    local code=0
+    local seconds
+    seconds="$( { time "$@" > "$stdout" 2>/dev/null || code=$?; } 2>&1 )"
+    echo "$seconds null $code"
+  fi
+}
+
+COMMIT="$(git -C "$ROOT" rev-parse --short HEAD 2>/dev/null || echo unknown)"
+DIRTY=false
+if [[ -n "$(git -C "$ROOT" status --porcelain --untracked-files=no 2>/dev/null)" ]]; then DIRTY=true; fi
+DATE="$(date -u +%Y-%m-%dT%H:%M:%SZ)"
+HOST="$(uname -sm)"
+
+mkdir -p "$(dirname "$OUT")"
+failures=0
+printf '%-20s %-8s %-12s %10s %12s %12s\n' program cc flags seconds "peak KiB" "binary B"
+
+for dir in "${DIRS[@]}"; do
+  dir="${dir%/}"
+  name="$(basename "$dir")"
+  if [[ ! -f "$dir/kira.yaml" ]]; then
+    echo "unknown benchmark: $name" >&2
+    exit 1
+  fi
+  if [[ ! -f "$dir/expected.txt" ]]; then
+    echo "$name: no expected.txt to check its output against" >&2
+    exit 1
+  fi
+  (
+    cd "$dir"
+    rm -f out.kira.c
+    "$KIRA_BIN" >/dev/null 2>&1
+  ) || { echo "$name: kira failed" >&2; failures=$((failures + 1)); continue; }
+  mv "$dir/out.kira.c" "$WORK/$name.c"
+
+  for c in "${!AVAILABLE[@]}"; do
+    compiler="${AVAILABLE[$c]}"
+    for flags in "${FLAG_SETS[@]}"; do
+      binary="$WORK/app"
+      read -r -a flag_words <<< "$flags"
+      if ! "$compiler" -std=c17 "${flag_words[@]}" -o "$binary" "$WORK/$name.c" 2>"$WORK/cc.err"; then
+        echo "$name: $compiler $flags failed:" >&2
+        head -20 "$WORK/cc.err" >&2
+        failures=$((failures + 1))
+        continue
+      fi
+      size="$(wc -c < "$binary" | tr -d ' ')"
+      best=""
+      peak="null"
+      for ((r = 0; r < RUNS; r++)); do
+        read -r seconds rss code < <(measure "$WORK/stdout" "$binary")
+        if [[ "$code" != 0 ]]; then
+          echo "$name: $compiler $flags exited with $code" >&2
+          failures=$((failures + 1))
+          continue 2
+        fi
+        if [[ -z "$best" ]] || awk -v a="$seconds" -v b="$best" 'BEGIN { exit !(a < b) }'; then best="$seconds"; fi
+        if [[ "$rss" != null ]] && [[ "$peak" == null || "$rss" -gt "$peak" ]]; then peak="$rss"; fi
+      done
+      checksum="$(cksum < "$WORK/stdout" | awk '{ print $1 }')"
+      if ! cmp -s "$dir/expected.txt" "$WORK/stdout"; then
+        echo "$name: $compiler $flags printed something other than expected.txt:" >&2
+        diff "$dir/expected.txt" "$WORK/stdout" | head -10 >&2 || true
+        failures=$((failures + 1))
+      fi
+      printf '%-20s %-8s %-12s %10s %12s %12s\n' "$name" "$compiler" "$flags" "$best" "$peak" "$size"
+      printf '{"date":%s,"commit":%s,"dirty":%s,"host":%s,"program":%s,"compiler":%s,"compilerVersion":%s,"flags":%s,"runs":%d,"seconds":%s,"peakRssKib":%s,"binaryBytes":%s,"outputCksum":%s}\n' \
+        "$(json_string "$DATE")" "$(json_string "$COMMIT")" "$DIRTY" "$(json_string "$HOST")" \
+        "$(json_string "$name")" "$(json_string "$compiler")" "$(json_string "${VERSIONS[$c]}")" \
+        "$(json_string "$flags")" "$RUNS" "$best" "$peak" "$size" "$(json_string "$checksum")" >> "$OUT"
+    done
+  done
+done
+
+echo
+echo "appended to $OUT"
+if [[ $failures -gt 0 ]]; then
+  echo "$failures build(s) failed" >&2
+  exit 1
+fi
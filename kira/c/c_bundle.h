@@ -12,6 +12,13 @@
 #ifndef KIRA_COMPILER_BUNDLE_H
 #define KIRA_COMPILER_BUNDLE_H
 
+/* Strict -std=c17 hides POSIX declarations such as clock_gettime. Ask for
+ * them on POSIX hosts, but only in strict mode: GNU-mode builds already see
+ * them, and defining a feature macro there would narrow their defaults. */
+#if defined(__STRICT_ANSI__) && defined(__unix__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdint.h>
 #include <stddef.h>
 
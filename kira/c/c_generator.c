@@ -49,19 +49,128 @@ typedef CharSeq Str;
 /* -------------------------------------------------------------------------- */
 
 /*
- * Finalizer for one class: releases whatever that class's fields own. Codegen
- * emits one per class with class-typed fields and hands it to kira_rc_alloc_with,
- * so releasing an owner transitively releases what it holds.
+ * Finalizer for one class: hands every reference the class's fields own to
+ * `visit`. Codegen emits one per class with class-typed fields and hands it
+ * to kira_rc_alloc_with. Freeing an owner passes kira_rc_release, so releasing
+ * it transitively releases what it holds; the cycle collector passes its
+ * trial-deletion steps instead, so the same function is the class's tracer.
  */
-typedef Void (*KiraFinalizer)(Void*);
+typedef Void (*KiraRcVisitor)(Void*);
+typedef Void (*KiraFinalizer)(Void*, KiraRcVisitor);
 
 typedef struct KiraRcHeader
 {
     Int32         strong;
+    Int32         weak;       /* side-table entry for Weak refs; 0 = none */
+#ifdef KIRA_RC_STATS
+    Int32         tag;        /* index into kira_rc_stats.classes */
+#endif
+#ifdef KIRA_CYCLE_COLLECTOR
+    Int32         cycle;      /* collector color + "in root buffer" bit */
+#endif
     KiraFinalizer finalize;   /* null when the class owns no references */
 } KiraRcHeader;
 
-simple Void* kira_rc_alloc_with(Int32 nbytes, KiraFinalizer finalize)
+/*
+ * KIRA_RC_STATS -- allocation and leak telemetry (build with -DKIRA_RC_STATS).
+ *
+ * Every Class_new passes its Kira class name as the allocation tag; in stats
+ * builds the tag is resolved to a per-class record stored in the header, and
+ * allocations, frees, retains, releases, the live count and its high-water
+ * mark are counted per class. A leak table goes to stderr at exit, and
+ * kira:debug (rcLive, rcPeak, ...) reads the same counters at runtime. Off by
+ * default: the header and the hot paths are unchanged, and the kira:debug
+ * readers return 0.
+ */
+typedef struct KiraRcClassStats
+{
+    Str   name;
+    Int64 allocations;
+    Int64 frees;
+    Int64 retains;
+    Int64 releases;
+    Int64 live;
+    Int64 peak;
+} KiraRcClassStats;
+
+#ifdef KIRA_RC_STATS
+static struct
+{
+    KiraRcClassStats* classes;
+    Int32             count;
+    Int32             capacity;
+    Int32             recent;   /* last tag resolved: Class_new runs in bursts */
+    KiraRcClassStats  total;    /* whole-heap counters, peak included */
+} kira_rc_stats;
+
+simple Void kira_rc_stats_print(FILE* out, Bool atExit)
+{
+    KiraRcClassStats* total = &kira_rc_stats.total;
+    fprintf(out, "kira RC stats%s -- %lld live of %lld allocated, peak %lld\n",
+            atExit ? " at exit" : "",
+            (long long)total->live, (long long)total->allocations, (long long)total->peak);
+    fprintf(out, "%-24s %10s %10s %10s %10s %8s %8s\n",
+            "class", "allocs", "frees", "retains", "releases", "live", "peak");
+    Int32 index;
+    for (index = 0; index < kira_rc_stats.count; index++)
+    {
+        KiraRcClassStats* entry = &kira_rc_stats.classes[index];
+        fprintf(out, "%-24s %10lld %10lld %10lld %10lld %8lld %8lld%s\n",
+                entry->name,
+                (long long)entry->allocations, (long long)entry->frees,
+                (long long)entry->retains, (long long)entry->releases,
+                (long long)entry->live, (long long)entry->peak,
+                atExit && entry->live > 0 ? "  LEAK" : "");
+    }
+}
+
+simple Void kira_rc_stats_at_exit(Void)
+{
+    kira_rc_stats_print(stderr, true);
+}
+
+simple Int32 kira_rc_stats_tag(Str name)
+{
+    if (name == null) name = "(untagged)";
+    if (kira_rc_stats.count > 0 && kira_rc_stats.classes[kira_rc_stats.recent].name == name)
+    {
+        return kira_rc_stats.recent;
+    }
+    Int32 index;
+    for (index = 0; index < kira_rc_stats.count; index++)
+    {
+        if (strcmp(kira_rc_stats.classes[index].name, name) == 0)
+        {
+            kira_rc_stats.recent = index;
+            return index;
+        }
+    }
+    if (kira_rc_stats.count == kira_rc_stats.capacity)
+    {
+        if (kira_rc_stats.capacity == 0)
+        {
+            atexit(kira_rc_stats_at_exit);
+        }
+        Int32 grown = kira_rc_stats.capacity == 0 ? 16 : kira_rc_stats.capacity * 2;
+        KiraRcClassStats* classes = (KiraRcClassStats*)realloc(kira_rc_stats.classes, (size_t)grown * sizeof(KiraRcClassStats));
+        if (classes == null) abort();
+        kira_rc_stats.classes  = classes;
+        kira_rc_stats.capacity = grown;
+    }
+    KiraRcClassStats* entry = &kira_rc_stats.classes[kira_rc_stats.count];
+    memset(entry, 0, sizeof(KiraRcClassStats));
+    entry->name = name;
+    kira_rc_stats.recent = kira_rc_stats.count;
+    return kira_rc_stats.count++;
+}
+
+simple KiraRcClassStats* kira_rc_stats_of(Void* obj)
+{
+    return &kira_rc_stats.classes[(((KiraRcHeader*)obj) - 1)->tag];
+}
+#endif
+
+simple Void* kira_rc_alloc_with(Int32 nbytes, KiraFinalizer finalize, Str tag)
 {
     /* header + payload; payload begins immediately after header */
     KiraRcHeader* h = (KiraRcHeader*)malloc((size_t)nbytes + sizeof(KiraRcHeader));
@@ -70,15 +179,371 @@ simple Void* kira_rc_alloc_with(Int32 nbytes, KiraFinalizer finalize)
         abort();
     }
     h->strong   = 1;
+    h->weak     = 0;
     h->finalize = finalize;
+#ifdef KIRA_CYCLE_COLLECTOR
+    h->cycle = 0;   /* black, not buffered */
+#endif
+#ifdef KIRA_RC_STATS
+    h->tag = kira_rc_stats_tag(tag);
+    KiraRcClassStats* entry = &kira_rc_stats.classes[h->tag];
+    KiraRcClassStats* total = &kira_rc_stats.total;
+    entry->allocations++;
+    total->allocations++;
+    if (++entry->live > entry->peak) entry->peak = entry->live;
+    if (++total->live > total->peak) total->peak = total->live;
+#else
+    (Void)tag;
+#endif
     return (Void*)(h + 1);
 }
 
 simple Void* kira_rc_alloc(Int32 nbytes)
 {
-    return kira_rc_alloc_with(nbytes, null);
+    return kira_rc_alloc_with(nbytes, null, null);
+}
+
+/*
+ * Weak references -- side table.
+ *
+ * An object's first Weak_of gives it an entry in a global side table and
+ * records the (1-based) index in its header; objects that are never weakly
+ * referenced keep `weak == 0` and pay nothing else. A Weak is a plain Int64
+ * handle -- entry index in the high half, the entry's generation in the low
+ * half -- so it copies freely and owns nothing. The final release clears the
+ * entry before the finalizer runs, bumps its generation and recycles it, so
+ * every handle still naming the old generation upgrades to None.
+ */
+typedef Int64 Weak;
+
+typedef struct KiraWeakEntry
+{
+    Void* target;       /* null once the object has been released */
+    Int32 generation;   /* bumped on every clear; stale handles stop matching */
+    Int32 nextFree;     /* free-list link while the entry is unused */
+} KiraWeakEntry;
+
+static struct
+{
+    KiraWeakEntry* entries;    /* entries[0] is unused: index 0 means "no entry" */
+    Int32          count;
+    Int32          capacity;
+    Int32          freeList;
+} kira_weak;
+
+simple Int32 kira_weak_entry(Void* obj)
+{
+    Int32 index = kira_weak.freeList;
+    if (index != 0)
+    {
+        kira_weak.freeList = kira_weak.entries[index].nextFree;
+    }
+    else
+    {
+        if (kira_weak.count == 0)
+        {
+            kira_weak.count = 1;   /* skip the "no entry" index */
+        }
+        if (kira_weak.count >= kira_weak.capacity)
+        {
+            Int32 grown = kira_weak.capacity == 0 ? 64 : kira_weak.capacity * 2;
+            KiraWeakEntry* entries = (KiraWeakEntry*)realloc(kira_weak.entries, (size_t)grown * sizeof(KiraWeakEntry));
+            if (entries == null)
+            {
+                abort();
+            }
+            kira_weak.entries  = entries;
+            kira_weak.capacity = grown;
+        }
+        index = kira_weak.count++;
+        kira_weak.entries[index].generation = 0;
+    }
+    kira_weak.entries[index].target   = obj;
+    kira_weak.entries[index].nextFree = 0;
+    return index;
+}
+
+/* Called on the final release: dangling handles must stop upgrading from here on. */
+simple Void kira_weak_clear(KiraRcHeader* h)
+{
+    if (h->weak == 0)
+    {
+        return;
+    }
+    KiraWeakEntry* entry = &kira_weak.entries[h->weak];
+    entry->target     = null;
+    entry->generation = entry->generation == INT32_MAX ? 0 : entry->generation + 1;
+    entry->nextFree   = kira_weak.freeList;
+    kira_weak.freeList = h->weak;
+    h->weak = 0;
+}
+
+/* Return an object's storage to malloc once nothing owns it any more. */
+simple Void kira_rc_free(KiraRcHeader* h)
+{
+    kira_weak_clear(h);
+#ifdef KIRA_RC_STATS
+    KiraRcClassStats* entry = &kira_rc_stats.classes[h->tag];
+    entry->frees++;
+    entry->live--;
+    kira_rc_stats.total.frees++;
+    kira_rc_stats.total.live--;
+#endif
+    free(h);
+}
+
+/*
+ * KIRA_CYCLE_COLLECTOR -- synchronous cycle collection (build with
+ * -DKIRA_CYCLE_COLLECTOR).
+ *
+ * Trial deletion after Bacon & Rajan, "Concurrent Cycle Collection in
+ * Reference Counted Systems" (synchronous variant). A release that leaves an
+ * object with a finalizer still alive marks it purple and buffers it as a
+ * possible cycle root; objects without class-typed fields can never be on a
+ * cycle and are skipped. Collection runs when the buffer reaches
+ * KIRA_CYCLE_ROOTS entries, or on collectCycles() (kira:debug):
+ *
+ *   mark    gray everything reachable from purple roots, subtracting internal
+ *           edges from the counts;
+ *   scan    anything still counted is externally held -- paint it black again
+ *           and restore the counts below it; the rest turns white;
+ *   collect free the white objects without running their finalizers (their
+ *           internal edges were already subtracted in the mark phase).
+ *
+ * Every phase walks an explicit stack, so long chains do not recurse. The
+ * finalizer doubles as the tracer: each phase passes it a visitor that
+ * pushes or adjusts children. Off by default; the header and the release
+ * path are then unchanged and collectCycles() returns 0.
+ */
+#ifdef KIRA_CYCLE_COLLECTOR
+#ifndef KIRA_CYCLE_ROOTS
+#define KIRA_CYCLE_ROOTS 10000
+#endif
+
+enum
+{
+    KIRA_CYCLE_BLACK    = 0,   /* in use, or freed */
+    KIRA_CYCLE_GRAY     = 1,   /* possible member of a garbage cycle */
+    KIRA_CYCLE_WHITE    = 2,   /* member of a garbage cycle */
+    KIRA_CYCLE_PURPLE   = 3,   /* possible root of a garbage cycle */
+    KIRA_CYCLE_COLOR    = 3,
+    KIRA_CYCLE_BUFFERED = 4
+};
+
+typedef struct KiraCycleStack
+{
+    KiraRcHeader** items;
+    Int32          count;
+    Int32          capacity;
+} KiraCycleStack;
+
+static struct
+{
+    KiraCycleStack roots;
+    KiraCycleStack work;
+    KiraCycleStack garbage;      /* white objects, freed once every root is walked */
+    Int32          releasing;    /* nesting depth of kira_rc_release */
+    Bool           collecting;
+} kira_cycles;
+
+simple KiraRcHeader* kira_cycles_header(Void* obj)
+{
+    return ((KiraRcHeader*)obj) - 1;
+}
+
+simple Int32 kira_cycles_color(KiraRcHeader* h)
+{
+    return h->cycle & KIRA_CYCLE_COLOR;
+}
+
+simple Void kira_cycles_paint(KiraRcHeader* h, Int32 color)
+{
+    h->cycle = (h->cycle & ~KIRA_CYCLE_COLOR) | color;
+}
+
+simple Void kira_cycles_push(KiraCycleStack* stack, KiraRcHeader* h)
+{
+    if (stack->count == stack->capacity)
+    {
+        Int32 grown = stack->capacity == 0 ? 256 : stack->capacity * 2;
+        KiraRcHeader** items = (KiraRcHeader**)realloc(stack->items, (size_t)grown * sizeof(KiraRcHeader*));
+        if (items == null) abort();
+        stack->items    = items;
+        stack->capacity = grown;
+    }
+    stack->items[stack->count++] = h;
+}
+
+simple Void kira_cycles_trace(KiraRcHeader* h, KiraRcVisitor visit)
+{
+    if (h->finalize != null)
+    {
+        h->finalize((Void*)(h + 1), visit);
+    }
+}
+
+/* mark: every edge into a child is internal until proven otherwise. */
+simple Void kira_cycles_gray_child(Void* child)
+{
+    if (child == null) return;
+    KiraRcHeader* h = kira_cycles_header(child);
+    h->strong -= 1;
+    kira_cycles_push(&kira_cycles.work, h);
+}
+
+simple Void kira_cycles_mark_gray(KiraRcHeader* root)
+{
+    kira_cycles_push(&kira_cycles.work, root);
+    while (kira_cycles.work.count > 0)
+    {
+        KiraRcHeader* h = kira_cycles.work.items[--kira_cycles.work.count];
+        if (kira_cycles_color(h) == KIRA_CYCLE_GRAY) continue;
+        kira_cycles_paint(h, KIRA_CYCLE_GRAY);
+        kira_cycles_trace(h, kira_cycles_gray_child);
+    }
+}
+
+/* scan, externally held branch: undo the mark-phase decrements below it. */
+simple Void kira_cycles_black_child(Void* child)
+{
+    if (child == null) return;
+    KiraRcHeader* h = kira_cycles_header(child);
+    h->strong += 1;
+    if (kira_cycles_color(h) != KIRA_CYCLE_BLACK)
+    {
+        kira_cycles_paint(h, KIRA_CYCLE_BLACK);
+        kira_cycles_push(&kira_cycles.work, h);
+    }
+}
+
+simple Void kira_cycles_scan_black(KiraRcHeader* root)
+{
+    Int32 base = kira_cycles.work.count;
+    kira_cycles_paint(root, KIRA_CYCLE_BLACK);
+    kira_cycles_push(&kira_cycles.work, root);
+    while (kira_cycles.work.count > base)
+    {
+        KiraRcHeader* h = kira_cycles.work.items[--kira_cycles.work.count];
+        kira_cycles_trace(h, kira_cycles_black_child);
+    }
+}
+
+simple Void kira_cycles_scan_child(Void* child)
+{
+    if (child == null) return;
+    kira_cycles_push(&kira_cycles.work, kira_cycles_header(child));
 }
 
+simple Void kira_cycles_scan(KiraRcHeader* root)
+{
+    kira_cycles_push(&kira_cycles.work, root);
+    while (kira_cycles.work.count > 0)
+    {
+        KiraRcHeader* h = kira_cycles.work.items[--kira_cycles.work.count];
+        if (kira_cycles_color(h) != KIRA_CYCLE_GRAY) continue;
+        if (h->strong > 0)
+        {
+            kira_cycles_scan_black(h);
+        }
+        else
+        {
+            kira_cycles_paint(h, KIRA_CYCLE_WHITE);
+            kira_cycles_trace(h, kira_cycles_scan_child);
+        }
+    }
+}
+
+/*
+ * collect: claim each white object once. Frees wait until every root has been
+ * walked, since a later white object may still point at an earlier one.
+ */
+simple Void kira_cycles_white_child(Void* child)
+{
+    if (child == null) return;
+    KiraRcHeader* h = kira_cycles_header(child);
+    if (kira_cycles_color(h) == KIRA_CYCLE_WHITE && !(h->cycle & KIRA_CYCLE_BUFFERED))
+    {
+        kira_cycles_paint(h, KIRA_CYCLE_BLACK);
+        kira_cycles_push(&kira_cycles.work, h);
+    }
+}
+
+simple Void kira_cycles_collect_white(KiraRcHeader* root)
+{
+    if (kira_cycles_color(root) != KIRA_CYCLE_WHITE) return;
+    kira_cycles_paint(root, KIRA_CYCLE_BLACK);
+    kira_cycles_push(&kira_cycles.work, root);
+    while (kira_cycles.work.count > 0)
+    {
+        KiraRcHeader* h = kira_cycles.work.items[--kira_cycles.work.count];
+        kira_cycles_trace(h, kira_cycles_white_child);
+        kira_cycles_push(&kira_cycles.garbage, h);
+    }
+}
+
+simple Int64 kira_cycles_collect(Void)
+{
+    if (kira_cycles.collecting) return 0;
+    kira_cycles.collecting = true;
+    KiraCycleStack* roots = &kira_cycles.roots;
+    Int64 freed = 0;
+    Int32 index;
+    Int32 kept = 0;
+    for (index = 0; index < roots->count; index++)
+    {
+        KiraRcHeader* h = roots->items[index];
+        if (kira_cycles_color(h) == KIRA_CYCLE_PURPLE && h->strong > 0)
+        {
+            kira_cycles_mark_gray(h);
+            roots->items[kept++] = h;
+            continue;
+        }
+        h->cycle &= ~KIRA_CYCLE_BUFFERED;
+        /* A gray root was reached from an earlier root's walk and belongs to
+         * that root's scan and collect; only a black root released to zero
+         * while buffered is ours to free (its finalizer already ran). */
+        if (kira_cycles_color(h) == KIRA_CYCLE_BLACK && h->strong <= 0)
+        {
+            kira_rc_free(h);
+            freed++;
+        }
+    }
+    roots->count = kept;
+    for (index = 0; index < roots->count; index++)
+    {
+        kira_cycles_scan(roots->items[index]);
+    }
+    for (index = 0; index < roots->count; index++)
+    {
+        roots->items[index]->cycle &= ~KIRA_CYCLE_BUFFERED;
+    }
+    for (index = 0; index < roots->count; index++)
+    {
+        kira_cycles_collect_white(roots->items[index]);
+    }
+    roots->count = 0;
+    for (index = 0; index < kira_cycles.garbage.count; index++)
+    {
+        kira_rc_free(kira_cycles.garbage.items[index]);
+    }
+    freed += kira_cycles.garbage.count;
+    kira_cycles.garbage.count = 0;
+    kira_cycles.collecting = false;
+    return freed;
+}
+
+simple Void kira_cycles_possible_root(KiraRcHeader* h)
+{
+    if (h->finalize == null || kira_cycles_color(h) == KIRA_CYCLE_PURPLE) return;
+    kira_cycles_paint(h, KIRA_CYCLE_PURPLE);
+    if (!(h->cycle & KIRA_CYCLE_BUFFERED))
+    {
+        h->cycle |= KIRA_CYCLE_BUFFERED;
+        kira_cycles_push(&kira_cycles.roots, h);
+    }
+}
+#endif
+
 simple Void kira_rc_retain(Void* obj)
 {
     if (obj == null)
@@ -87,6 +552,13 @@ simple Void kira_rc_retain(Void* obj)
     }
     KiraRcHeader* h = ((KiraRcHeader*)obj) - 1;
     h->strong += 1;
+#ifdef KIRA_CYCLE_COLLECTOR
+    kira_cycles_paint(h, KIRA_CYCLE_BLACK);
+#endif
+#ifdef KIRA_RC_STATS
+    kira_rc_stats_of(obj)->retains++;
+    kira_rc_stats.total.retains++;
+#endif
 }
 
 simple Void kira_rc_release(Void* obj)
@@ -96,15 +568,47 @@ simple Void kira_rc_release(Void* obj)
         return;
     }
     KiraRcHeader* h = ((KiraRcHeader*)obj) - 1;
+#ifdef KIRA_RC_STATS
+    kira_rc_stats_of(obj)->releases++;
+    kira_rc_stats.total.releases++;
+#endif
     h->strong -= 1;
+#ifdef KIRA_CYCLE_COLLECTOR
+    kira_cycles.releasing++;
+    if (h->strong <= 0)
+    {
+        kira_weak_clear(h);
+        if (h->finalize != null)
+        {
+            h->finalize(obj, kira_rc_release);
+        }
+        kira_cycles_paint(h, KIRA_CYCLE_BLACK);
+        /* A buffered object is still referenced by the root buffer; the next collection frees it. */
+        if (!(h->cycle & KIRA_CYCLE_BUFFERED))
+        {
+            kira_rc_free(h);
+        }
+    }
+    else
+    {
+        kira_cycles_possible_root(h);
+    }
+    /* Collect only once the outermost release has finished its cascade. */
+    if (--kira_cycles.releasing == 0 && kira_cycles.roots.count >= KIRA_CYCLE_ROOTS)
+    {
+        kira_cycles_collect();
+    }
+#else
     if (h->strong <= 0)
     {
+        kira_weak_clear(h);
         if (h->finalize != null)
         {
-            h->finalize(obj);
+            h->finalize(obj, kira_rc_release);
         }
-        free(h);
+        kira_rc_free(h);
     }
+#endif
 }
 
 /* Retain and hand back, so a borrowed argument can be passed where a +1 is expected. */
@@ -145,6 +649,71 @@ simple Void kira_rc_store_owned(Void** slot, Void* value)
     *slot = value;
 }
 
+/*
+ * kira:debug readers. `className` is the Kira class name as written
+ * ("Point", "Box<Int32>"); an empty name reads the whole-heap totals and an
+ * unknown one reads zeros. Without KIRA_RC_STATS every counter reads 0.
+ */
+simple KiraRcClassStats kira_rc_stats_snapshot(Str className)
+{
+    KiraRcClassStats snapshot;
+    memset(&snapshot, 0, sizeof(KiraRcClassStats));
+    snapshot.name = className;
+#ifdef KIRA_RC_STATS
+    if (className == null || className[0] == '\0')
+    {
+        snapshot      = kira_rc_stats.total;
+        snapshot.name = className;
+        return snapshot;
+    }
+    Int32 index;
+    for (index = 0; index < kira_rc_stats.count; index++)
+    {
+        if (strcmp(kira_rc_stats.classes[index].name, className) == 0)
+        {
+            return kira_rc_stats.classes[index];
+        }
+    }
+#endif
+    return snapshot;
+}
+
+simple Bool kira_rc_stats_enabled(Void)
+{
+#ifdef KIRA_RC_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+simple Int64 kira_rc_stats_allocations(Str className) { return kira_rc_stats_snapshot(className).allocations; }
+simple Int64 kira_rc_stats_frees(Str className)       { return kira_rc_stats_snapshot(className).frees; }
+simple Int64 kira_rc_stats_retains(Str className)     { return kira_rc_stats_snapshot(className).retains; }
+simple Int64 kira_rc_stats_releases(Str className)    { return kira_rc_stats_snapshot(className).releases; }
+simple Int64 kira_rc_stats_live(Str className)        { return kira_rc_stats_snapshot(className).live; }
+simple Int64 kira_rc_stats_peak(Str className)        { return kira_rc_stats_snapshot(className).peak; }
+
+/* Run the cycle collector now; returns how many objects it freed. */
+simple Int64 kira_rc_collect_cycles(Void)
+{
+#ifdef KIRA_CYCLE_COLLECTOR
+    return kira_cycles_collect();
+#else
+    return 0;
+#endif
+}
+
+/* Print the current table to stderr (the same table the exit hook prints). */
+simple Void kira_rc_stats_dump(Void)
+{
+#ifdef KIRA_RC_STATS
+    kira_rc_stats_print(stderr, false);
+#else
+    eprint("kira RC stats: disabled (compile with -DKIRA_RC_STATS)\n");
+#endif
+}
+
 /* -------------------------------------------------------------------------- */
 /* KiraSlot -- uniform erased element                                          */
 /*                                                                            */
@@ -153,8 +722,8 @@ simple Void kira_rc_store_owned(Void** slot, Void* value)
 /* pointer (Str, class instance) cast through intptr_t. Codegen casts back to  */
 /* the declared element type at each use site.                                 */
 /*                                                                            */
-/* Limit, on purpose: Float32/Float64 elements are NOT representable this way  */
-/* and are rejected in the frontend rather than silently reinterpreted.        */
+/* Float32/Float64 cannot take the integer cast without losing the fraction,   */
+/* so they slot by bit pattern instead (KIRA_SLOT_FLT / KIRA_UNSLOT_FLT).      */
 /* -------------------------------------------------------------------------- */
 
 typedef Int64 KiraSlot;
@@ -164,6 +733,12 @@ typedef Int64 KiraSlot;
 #define KIRA_UNSLOT(T, s) ((T)(s))
 #define KIRA_UNSLOT_PTR(T, s) ((T)(intptr_t)(s))
 
+simple KiraSlot kira_slot_from_f64(Float64 v) { KiraSlot s; memcpy(&s, &v, sizeof s); return s; }
+simple Float64  kira_slot_to_f64(KiraSlot s)  { Float64 v; memcpy(&v, &s, sizeof v); return v; }
+
+#define KIRA_SLOT_FLT(x)      kira_slot_from_f64((Float64)(x))
+#define KIRA_UNSLOT_FLT(T, s) ((T)kira_slot_to_f64(s))
+
 /* -------------------------------------------------------------------------- */
 /* KiraVec -- owning dynamic array of slots                                    */
 /* Backing store for Set / Stack / Queue / Deque and the Map view helpers.     */
@@ -312,6 +887,52 @@ simple KiraSlot Result_unwrapErr(Result* r)
     return r->error;
 }
 
+/* -------------------------------------------------------------------------- */
+/* Weak -- non-owning class references (side table lives with the ARC hooks)  */
+/* -------------------------------------------------------------------------- */
+
+simple Weak Weak_empty(Void) { return 0; }
+
+simple Weak Weak_of(Void* obj)
+{
+    if (obj == null)
+    {
+        return 0;
+    }
+    KiraRcHeader* h = ((KiraRcHeader*)obj) - 1;
+    if (h->weak == 0)
+    {
+        h->weak = kira_weak_entry(obj);
+    }
+    return ((Int64)h->weak << 32) | (Int64)kira_weak.entries[h->weak].generation;
+}
+
+/* The live target, or null when the handle is empty or its object is gone. */
+simple Void* kira_weak_target(Weak handle)
+{
+    Int32 index = (Int32)(handle >> 32);
+    if (index <= 0 || index >= kira_weak.count)
+    {
+        return null;
+    }
+    KiraWeakEntry* entry = &kira_weak.entries[index];
+    return entry->generation == (Int32)(handle & INT32_MAX) ? entry->target : null;
+}
+
+simple Bool Weak_isAlive(Weak* handle) { return kira_weak_target(*handle) != null; }
+
+/* Some(target) with a strong (+1) reference the caller now owns, or None. */
+simple Maybe Weak_upgrade(Weak* handle)
+{
+    Void* target = kira_weak_target(*handle);
+    if (target == null)
+    {
+        return Maybe_none();
+    }
+    kira_rc_retain(target);
+    return Maybe_some(KIRA_SLOT_PTR(target));
+}
+
 /* -------------------------------------------------------------------------- */
 /* Str -- immutable UTF-8-ish byte strings                                     */
 /*                                                                            */
@@ -434,6 +1055,190 @@ simple Int64 Str_hashCode(Str s)
     return (Int64)h;
 }
 
+/* -------------------------------------------------------------------------- */
+/* Number parsing -- shared by Str.toInt32 / toFloat64 and Scanner             */
+/*                                                                            */
+/* Digit runs are consumed eight at a time (SWAR): load 8 bytes into one       */
+/* 64-bit word, check every byte is '0'..'9' with two masks, then fold the     */
+/* lanes pairwise (2 -> 4 -> 8 digits) with three multiplies. The lane order   */
+/* assumes a little-endian word; other targets take the byte loop only.        */
+/* -------------------------------------------------------------------------- */
+
+#if (defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && \
+     __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined(_WIN32)
+#define KIRA_SWAR_DIGITS 1
+#else
+#define KIRA_SWAR_DIGITS 0
+#endif
+
+simple Bool kira_swar_is_8digits(UInt64 word)
+{
+    return ((word & 0xF0F0F0F0F0F0F0F0ULL) |
+            (((word + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+           0x3333333333333333ULL;
+}
+
+simple UInt32 kira_swar_parse_8digits(UInt64 word)
+{
+    word -= 0x3030303030303030ULL;
+    word = (word * 10 + (word >> 8)) & 0x00FF00FF00FF00FFULL;
+    word = (word * 100 + (word >> 16)) & 0x0000FFFF0000FFFFULL;
+    word = (word * 10000 + (word >> 32)) & 0x00000000FFFFFFFFULL;
+    return (UInt32)word;
+}
+
+/*
+ * Fold the digit run at *cursor (bounded by end) into *acc and advance *cursor past
+ * it. Returns the number of digits read, or -1 when the value no longer fits
+ * a UInt64 -- *cursor still lands after the whole run, so a caller can keep going.
+ */
+simple Int32 kira_parse_digits(const Utf8** cursor, const Utf8* end, UInt64* acc)
+{
+    const Utf8* p = *cursor;
+    UInt64 v = *acc;
+    Int32 n = 0;
+    Bool overflow = false;
+#if KIRA_SWAR_DIGITS
+    /* Past this bound another 8 digits might wrap; the byte loop checks exactly. */
+    while (end - p >= 8 && v <= (UINT64_MAX - 99999999ULL) / 100000000ULL)
+    {
+        UInt64 word;
+        memcpy(&word, p, sizeof word);
+        if (!kira_swar_is_8digits(word)) break;
+        v = v * 100000000ULL + kira_swar_parse_8digits(word);
+        p += 8;
+        n += 8;
+    }
+#endif
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+        UInt64 d = (UInt64)(*p - '0');
+        if (v > (UINT64_MAX - d) / 10)
+        {
+            overflow = true;
+        }
+        v = v * 10 + d;
+        p++;
+        n++;
+    }
+    *cursor = p;
+    *acc = v;
+    return overflow ? -1 : n;
+}
+
+/* Strict: optional sign, then digits, and nothing else in [p, end). */
+simple Bool kira_parse_i64(const Utf8* p, const Utf8* end, Int64* out)
+{
+    Bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        p++;
+    }
+    UInt64 magnitude = 0;
+    if (kira_parse_digits(&p, end, &magnitude) <= 0 || p != end) return false;
+    if (negative)
+    {
+        if (magnitude > (UInt64)INT64_MAX + 1) return false;
+        *out = magnitude == (UInt64)INT64_MAX + 1 ? INT64_MIN : -(Int64)magnitude;
+    }
+    else
+    {
+        if (magnitude > (UInt64)INT64_MAX) return false;
+        *out = (Int64)magnitude;
+    }
+    return true;
+}
+
+/*
+ * Decimal float: [sign] digits [. digits] [(e|E) [sign] digits]. When every
+ * digit fits in 53 bits and the decimal exponent is within +-22, one exact
+ * multiply or divide is correctly rounded; anything else goes to strtod, so
+ * [p, end) must be followed by a NUL.
+ */
+simple Bool kira_parse_f64(const Utf8* p, const Utf8* end, Float64* out)
+{
+    static const Float64 powers[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const Utf8* start = p;
+    Bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        p++;
+    }
+    UInt64 mantissa = 0;
+    Int32 whole = kira_parse_digits(&p, end, &mantissa);
+    Int32 fraction = 0;
+    if (p < end && *p == '.')
+    {
+        p++;
+        fraction = kira_parse_digits(&p, end, &mantissa);
+    }
+    if (whole == 0 && fraction == 0) return false;
+    Bool exact = whole >= 0 && fraction >= 0;
+    Int32 exponent = 0;
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        p++;
+        Bool negativeExponent = false;
+        if (p < end && (*p == '-' || *p == '+'))
+        {
+            negativeExponent = *p == '-';
+            p++;
+        }
+        UInt64 e = 0;
+        Int32 digits = kira_parse_digits(&p, end, &e);
+        if (digits == 0) return false;
+        if (digits < 0 || e > 400)
+        {
+            exact = false;   /* far outside the fast window; strtod decides inf / 0 */
+        }
+        else
+        {
+            exponent = negativeExponent ? -(Int32)e : (Int32)e;
+        }
+    }
+    if (p != end) return false;
+    exponent -= fraction > 0 ? fraction : 0;
+    if (exact && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22)
+    {
+        Float64 v = (Float64)mantissa;
+        v = exponent < 0 ? v / powers[-exponent] : v * powers[exponent];
+        *out = negative ? -v : v;
+        return true;
+    }
+    Utf8* stop = null;
+    *out = strtod(start, &stop);
+    return stop == end;
+}
+
+/*
+ * Str -> number. The whole string must be the number (no surrounding
+ * whitespace -- trim() first); anything else is an Err with a Str message.
+ */
+simple Result Str_toInt32(Str s)
+{
+    Int64 v = 0;
+    if (s == null || !kira_parse_i64(s, s + strlen(s), &v) || v < INT32_MIN || v > INT32_MAX)
+    {
+        return Result_err(KIRA_SLOT_PTR("not a valid Int32"));
+    }
+    return Result_ok(KIRA_SLOT(v));
+}
+
+simple Result Str_toFloat64(Str s)
+{
+    Float64 v = 0;
+    if (s == null || !kira_parse_f64(s, s + strlen(s), &v))
+    {
+        return Result_err(KIRA_SLOT_PTR("not a valid Float64"));
+    }
+    return Result_ok(KIRA_SLOT_FLT(v));
+}
+
 /* -------------------------------------------------------------------------- */
 /* assert -- Kira's two-argument form (C's assert takes one)                   */
 /* -------------------------------------------------------------------------- */
@@ -1112,4 +1917,549 @@ simple Void Stack_dispose(Stack* s) { KiraVec_clear(&s->items); }
 simple Void Queue_dispose(Queue* q) { KiraVec_clear(&q->items); }
 simple Void Deque_dispose(Deque* d) { KiraVec_clear(&d->items); }
 
+/* -------------------------------------------------------------------------- */
+/* Scanner -- block-buffered token reader over stdin or a file                 */
+/*                                                                            */
+/* Input arrives KIRA_SCANNER_BLOCK bytes at a time, never per character. On   */
+/* POSIX hosts the block is a read(2) on the descriptor, which returns what    */
+/* is available instead of waiting for a full block; elsewhere it is fread.    */
+/*                                                                            */
+/* nextToken / nextLine hand back a Str that points *into* the buffer, NUL-    */
+/* terminated in place, so reading allocates nothing per token. Such a view    */
+/* stays valid until the next call on the same Scanner -- copy it with         */
+/* substring() to keep it. The byte the NUL replaced is put back on that call. */
+/*                                                                            */
+/* A Scanner is a by-value struct that owns its buffer: a copy shares that     */
+/* buffer, so exactly one copy may be disposed. Disposing leaves the Scanner   */
+/* empty, so disposing it again (or reading from it) is safe.                  */
+/* -------------------------------------------------------------------------- */
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define KIRA_SCANNER_POSIX 1
+#else
+#define KIRA_SCANNER_POSIX 0
+#endif
+
+#ifndef KIRA_SCANNER_BLOCK
+#define KIRA_SCANNER_BLOCK (1 << 16)
+#endif
+
+typedef struct Scanner
+{
+    FILE* in;         /* fread source; unused on POSIX hosts */
+    Int32 descriptor; /* read(2) source on POSIX hosts, else -1 */
+    Utf8* buffer;     /* capacity + 1 bytes: room for a terminating NUL */
+    Int32 capacity;
+    Int32 pos;        /* next unread byte */
+    Int32 length;     /* bytes filled */
+    Int32 cut;        /* where the last view's NUL went, or -1 */
+    Utf8  cutByte;    /* the byte that NUL replaced */
+    Bool  eof;
+    Bool  owned;      /* opened by Scanner_open, so dispose closes it */
+} Scanner;
+
+simple Scanner kira_scanner_over(FILE* in, Int32 descriptor, Bool owned)
+{
+    Scanner scanner;
+    scanner.in         = in;
+    scanner.descriptor = descriptor;
+    scanner.capacity   = KIRA_SCANNER_BLOCK;
+    scanner.buffer     = (Utf8*)malloc((size_t)scanner.capacity + 1);
+    if (scanner.buffer == null) abort();
+    scanner.pos        = 0;
+    scanner.length     = 0;
+    scanner.cut        = -1;
+    scanner.cutByte    = '\0';
+    scanner.eof        = false;
+    scanner.owned      = owned;
+    return scanner;
+}
+
+/* No buffer and no input: what an uninitialized `s: Scanner` holds. */
+simple Scanner Scanner_empty(Void)
+{
+    Scanner scanner = {0};
+    scanner.descriptor = -1;
+    scanner.cut        = -1;
+    scanner.eof        = true;
+    return scanner;
+}
+
+simple Scanner Scanner_stdin(Void)
+{
+#if KIRA_SCANNER_POSIX
+    return kira_scanner_over(null, STDIN_FILENO, false);
+#else
+    return kira_scanner_over(stdin, -1, false);
+#endif
+}
+
+simple Scanner Scanner_open(Str path)
+{
+#if KIRA_SCANNER_POSIX
+    Int32 descriptor = path == null ? -1 : open(path, O_RDONLY);
+    Bool failed = descriptor < 0;
+    FILE* in = null;
+#else
+    Int32 descriptor = -1;
+    FILE* in = path == null ? null : fopen(path, "r");
+    Bool failed = in == null;
+#endif
+    if (failed)
+    {
+        fprintf(stderr, "kira: Scanner: cannot open '%s'\n", path == null ? "" : path);
+        abort();
+    }
+    return kira_scanner_over(in, descriptor, true);
+}
+
+simple Void Scanner_dispose(Scanner* scanner)
+{
+    free(scanner->buffer);
+    if (scanner->owned)
+    {
+#if KIRA_SCANNER_POSIX
+        close(scanner->descriptor);
+#else
+        fclose(scanner->in);
+#endif
+    }
+    *scanner = Scanner_empty();
+}
+
+simple Bool kira_scanner_is_space(Utf8 c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/* Put back the byte the previous view's NUL replaced. */
+simple Void kira_scanner_restore(Scanner* scanner)
+{
+    if (scanner->cut >= 0)
+    {
+        scanner->buffer[scanner->cut] = scanner->cutByte;
+        scanner->cut = -1;
+    }
+}
+
+/* NUL-terminate [start, end) in place and hand it out as a Str view. */
+simple Str kira_scanner_view(Scanner* scanner, Int32 start, Int32 end)
+{
+    scanner->cut     = end;
+    scanner->cutByte = scanner->buffer[end];
+    scanner->buffer[end] = '\0';
+    return (Str)(scanner->buffer + start);
+}
+
+/*
+ * Drop the consumed prefix [0, pos), then read one more block after what is
+ * left. The buffer doubles only when a single unread token fills all of it.
+ * Returns the number of bytes added; 0 means end of input.
+ */
+simple Int32 kira_scanner_fill(Scanner* scanner)
+{
+    if (scanner->eof) return 0;
+    if (scanner->pos > 0)
+    {
+        scanner->length -= scanner->pos;
+        memmove(scanner->buffer, scanner->buffer + scanner->pos, (size_t)scanner->length);
+        scanner->pos = 0;
+    }
+    if (scanner->length == scanner->capacity)
+    {
+        scanner->capacity *= 2;
+        Utf8* grown = (Utf8*)realloc(scanner->buffer, (size_t)scanner->capacity + 1);
+        if (grown == null) abort();
+        scanner->buffer = grown;
+    }
+    size_t want = (size_t)(scanner->capacity - scanner->length);
+#if KIRA_SCANNER_POSIX
+    fflush(stdout);   /* stdio is bypassed, so a pending prompt must be flushed first */
+    ssize_t got = read(scanner->descriptor, scanner->buffer + scanner->length, want);
+    if (got <= 0)
+    {
+        scanner->eof = true;
+        return 0;
+    }
+#else
+    size_t got = fread(scanner->buffer + scanner->length, 1, want, scanner->in);
+    if (got == 0)
+    {
+        scanner->eof = true;
+        return 0;
+    }
+#endif
+    scanner->length += (Int32)got;
+    return (Int32)got;
+}
+
+/*
+ * Skip whitespace, then make sure the whole next token sits contiguously in
+ * the buffer. On success [*start, *end) is the token and pos moves past it.
+ */
+simple Bool kira_scanner_token(Scanner* scanner, Int32* start, Int32* end)
+{
+    kira_scanner_restore(scanner);
+    for (;;)
+    {
+        while (scanner->pos < scanner->length && kira_scanner_is_space(scanner->buffer[scanner->pos])) scanner->pos++;
+        if (scanner->pos < scanner->length) break;
+        if (kira_scanner_fill(scanner) == 0) return false;
+    }
+    Int32 scanned = 0;
+    for (;;)
+    {
+        Int32 i = scanner->pos + scanned;
+        while (i < scanner->length && !kira_scanner_is_space(scanner->buffer[i])) i++;
+        scanned = i - scanner->pos;
+        if (i < scanner->length || kira_scanner_fill(scanner) == 0) break;
+    }
+    *start = scanner->pos;
+    *end = scanner->pos + scanned;
+    scanner->pos = *end;
+    return true;
+}
+
+simple Bool Scanner_hasNext(Scanner* scanner)
+{
+    kira_scanner_restore(scanner);
+    for (;;)
+    {
+        while (scanner->pos < scanner->length && kira_scanner_is_space(scanner->buffer[scanner->pos])) scanner->pos++;
+        if (scanner->pos < scanner->length) return true;
+        if (kira_scanner_fill(scanner) == 0) return false;
+    }
+}
+
+simple Bool Scanner_hasNextLine(Scanner* scanner)
+{
+    kira_scanner_restore(scanner);
+    return scanner->pos < scanner->length || kira_scanner_fill(scanner) > 0;
+}
+
+simple Void kira_scanner_fail(Str method, Str want, Scanner* scanner, Int32 start, Int32 end)
+{
+    if (start == end)
+    {
+        fprintf(stderr, "kira: Scanner.%s: no more input\n", method);
+    }
+    else
+    {
+        fprintf(stderr, "kira: Scanner.%s: '%.*s' is not %s\n", method, (int)(end - start), scanner->buffer + start, want);
+    }
+    abort();
+}
+
+simple Str Scanner_nextToken(Scanner* scanner)
+{
+    Int32 start = 0;
+    Int32 end = 0;
+    if (!kira_scanner_token(scanner, &start, &end)) kira_scanner_fail("nextToken", "", scanner, 0, 0);
+    return kira_scanner_view(scanner, start, end);
+}
+
+simple Int64 Scanner_nextInt64(Scanner* scanner)
+{
+    Int32 start = 0;
+    Int32 end = 0;
+    Int64 v = 0;
+    if (!kira_scanner_token(scanner, &start, &end) ||
+        !kira_parse_i64(scanner->buffer + start, scanner->buffer + end, &v))
+    {
+        kira_scanner_fail("nextInt64", "an Int64", scanner, start, end);
+    }
+    return v;
+}
+
+simple Int32 Scanner_nextInt32(Scanner* scanner)
+{
+    Int32 start = 0;
+    Int32 end = 0;
+    Int64 v = 0;
+    if (!kira_scanner_token(scanner, &start, &end) ||
+        !kira_parse_i64(scanner->buffer + start, scanner->buffer + end, &v) ||
+        v < INT32_MIN || v > INT32_MAX)
+    {
+        kira_scanner_fail("nextInt32", "an Int32", scanner, start, end);
+    }
+    return (Int32)v;
+}
+
+simple Float64 Scanner_nextFloat64(Scanner* scanner)
+{
+    Int32 start = 0;
+    Int32 end = 0;
+    Float64 v = 0;
+    if (!kira_scanner_token(scanner, &start, &end))
+    {
+        kira_scanner_fail("nextFloat64", "a Float64", scanner, 0, 0);
+    }
+    /* the slow path hands the token to strtod, which needs the NUL */
+    kira_scanner_view(scanner, start, end);
+    if (!kira_parse_f64(scanner->buffer + start, scanner->buffer + end, &v))
+    {
+        kira_scanner_restore(scanner);
+        kira_scanner_fail("nextFloat64", "a Float64", scanner, start, end);
+    }
+    return v;
+}
+
+/* The rest of the current line, without its "\n" / "\r\n". */
+simple Str Scanner_nextLine(Scanner* scanner)
+{
+    kira_scanner_restore(scanner);
+    if (scanner->pos == scanner->length && kira_scanner_fill(scanner) == 0)
+    {
+        kira_scanner_fail("nextLine", "", scanner, 0, 0);
+    }
+    Int32 scanned = 0;
+    Bool newline = false;
+    for (;;)
+    {
+        Utf8* from = scanner->buffer + scanner->pos + scanned;
+        Utf8* hit = (Utf8*)memchr(from, '\n', (size_t)(scanner->length - scanner->pos - scanned));
+        if (hit != null)
+        {
+            scanned = (Int32)(hit - (scanner->buffer + scanner->pos));
+            newline = true;
+            break;
+        }
+        scanned = scanner->length - scanner->pos;
+        if (kira_scanner_fill(scanner) == 0) break;
+    }
+    Int32 start = scanner->pos;
+    Int32 end = start + scanned;
+    scanner->pos = newline ? end + 1 : end;
+    if (end > start && scanner->buffer[end - 1] == '\r') end--;
+    return kira_scanner_view(scanner, start, end);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Profiler -- entry/exit probes for `kira --instrument`                      */
+/*                                                                            */
+/* Only compiled when codegen defines KIRA_INSTRUMENT ahead of the bundle.    */
+/* Codegen numbers every user function and method, wraps each body in         */
+/* kira_prof_enter(n) / kira_prof_exit(), and emits kira_prof_names[] with    */
+/* the Kira-side names as string literals -- the minifier never rewrites      */
+/* literals, so the report reads the same for minified and --readable output. */
+/*                                                                            */
+/* Per function: call count, inclusive time (outermost activation only, so    */
+/* recursion is not double counted) and exclusive time (minus callees). Per   */
+/* caller -> callee edge: call count. State is thread-local; the report is    */
+/* appended at exit to $KIRA_PROFILE, or kira.profile.txt when unset.         */
+/* -------------------------------------------------------------------------- */
+
+#ifdef KIRA_INSTRUMENT
+#include <time.h>
+
+typedef struct KiraProfFrame
+{
+    Int32 function;
+    Int64 start;
+    Int64 child;      /* nanoseconds spent in callees of this activation */
+} KiraProfFrame;
+
+typedef struct KiraProfEdge
+{
+    Int32 caller;     /* -1 for the program entry */
+    Int32 callee;
+    Int64 calls;      /* 0 marks an empty bucket */
+} KiraProfEdge;
+
+typedef struct KiraProfState
+{
+    const Str*     names;
+    Int32          count;
+    Int64*         calls;
+    Int64*         inclusive;
+    Int64*         exclusive;
+    Int32*         active;
+    KiraProfFrame* frames;
+    Int32          depth;
+    Int32          frameCapacity;
+    KiraProfEdge*  edges;
+    Int32          edgeCount;
+    Int32          edgeCapacity;   /* power of two */
+} KiraProfState;
+
+static _Thread_local KiraProfState kira_prof;
+
+simple Int64 kira_prof_now(Void)
+{
+    struct timespec now;
+#ifdef CLOCK_MONOTONIC
+    clock_gettime(CLOCK_MONOTONIC, &now);
+#else
+    /* No POSIX clocks on this host: the C17 wall clock is all there is. */
+    timespec_get(&now, TIME_UTC);
+#endif
+    return (Int64)now.tv_sec * 1000000000 + (Int64)now.tv_nsec;
+}
+
+simple Void* kira_prof_zalloc(Int32 count, size_t size)
+{
+    Void* block = calloc((size_t)(count > 0 ? count : 1), size);
+    if (block == null) abort();
+    return block;
+}
+
+simple Int32 kira_prof_slot(KiraProfEdge* edges, Int32 capacity, Int32 caller, Int32 callee)
+{
+    UInt64 key = ((UInt64)(UInt32)(caller + 1) << 32) | (UInt32)callee;
+    Int32 mask = capacity - 1;
+    Int32 index = (Int32)((key * 0x9E3779B97F4A7C15ULL) >> 40) & mask;
+    while (edges[index].calls != 0 &&
+           (edges[index].caller != caller || edges[index].callee != callee))
+    {
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+simple Void kira_prof_count_edge(KiraProfState* state, Int32 caller, Int32 callee)
+{
+    if ((state->edgeCount + 1) * 2 > state->edgeCapacity)
+    {
+        Int32 grown = state->edgeCapacity * 2;
+        KiraProfEdge* table = (KiraProfEdge*)kira_prof_zalloc(grown, sizeof(KiraProfEdge));
+        Int32 i;
+        for (i = 0; i < state->edgeCapacity; i++)
+        {
+            if (state->edges[i].calls != 0)
+            {
+                table[kira_prof_slot(table, grown, state->edges[i].caller, state->edges[i].callee)] = state->edges[i];
+            }
+        }
+        free(state->edges);
+        state->edges = table;
+        state->edgeCapacity = grown;
+    }
+    KiraProfEdge* edge = &state->edges[kira_prof_slot(state->edges, state->edgeCapacity, caller, callee)];
+    if (edge->calls == 0)
+    {
+        edge->caller = caller;
+        edge->callee = callee;
+        state->edgeCount++;
+    }
+    edge->calls++;
+}
+
+simple Void kira_prof_report(Void)
+{
+    KiraProfState* state = &kira_prof;
+    if (state->count == 0) return;
+    Str path = getenv("KIRA_PROFILE");
+    /* Append mode: repeated runs against one $KIRA_PROFILE accumulate reports. */
+    FILE* out = fopen(path != null && path[0] != '\0' ? path : "kira.profile.txt", "a");
+    if (out == null) out = stderr;
+
+    /* Hottest first: insertion-sort function indices by exclusive time. */
+    Int32* order = (Int32*)kira_prof_zalloc(state->count, sizeof(Int32));
+    Int32 i;
+    Int32 walk;
+    for (i = 0; i < state->count; i++)
+    {
+        for (walk = i; walk > 0 && state->exclusive[order[walk - 1]] < state->exclusive[i]; walk--)
+        {
+            order[walk] = order[walk - 1];
+        }
+        order[walk] = i;
+    }
+
+    fprintf(out, "kira profile -- %d instrumented function%s\n\n", (int)state->count, state->count == 1 ? "" : "s");
+    fprintf(out, "%12s %14s %14s  %s\n", "calls", "inclusive", "exclusive", "function (times in milliseconds)");
+    for (i = 0; i < state->count; i++)
+    {
+        Int32 function = order[i];
+        if (state->calls[function] == 0) continue;
+        fprintf(out, "%12lld %10lld.%03lld %10lld.%03lld  %s\n",
+                (long long)state->calls[function],
+                (long long)(state->inclusive[function] / 1000000),
+                (long long)(state->inclusive[function] / 1000 % 1000),
+                (long long)(state->exclusive[function] / 1000000),
+                (long long)(state->exclusive[function] / 1000 % 1000),
+                state->names[function]);
+    }
+    fprintf(out, "\ncall graph (caller -> callee: calls)\n");
+    for (i = 0; i < state->edgeCapacity; i++)
+    {
+        KiraProfEdge* edge = &state->edges[i];
+        if (edge->calls == 0) continue;
+        fprintf(out, "  %s -> %s: %lld\n",
+                edge->caller < 0 ? "<entry>" : state->names[edge->caller],
+                state->names[edge->callee],
+                (long long)edge->calls);
+    }
+    if (out != stderr) fclose(out);
+
+    free(order);
+    free(state->calls);
+    free(state->inclusive);
+    free(state->exclusive);
+    free(state->active);
+    free(state->frames);
+    free(state->edges);
+    state->count = 0;
+}
+
+/* Called once at the top of main, before main's own entry probe. */
+simple Void kira_prof_install(const Str* names, Int32 count)
+{
+    KiraProfState* state = &kira_prof;
+    state->names         = names;
+    state->count         = count;
+    state->calls         = (Int64*)kira_prof_zalloc(count, sizeof(Int64));
+    state->inclusive     = (Int64*)kira_prof_zalloc(count, sizeof(Int64));
+    state->exclusive     = (Int64*)kira_prof_zalloc(count, sizeof(Int64));
+    state->active        = (Int32*)kira_prof_zalloc(count, sizeof(Int32));
+    state->frameCapacity = 64;
+    state->frames        = (KiraProfFrame*)kira_prof_zalloc(state->frameCapacity, sizeof(KiraProfFrame));
+    state->depth         = 0;
+    state->edgeCapacity  = 64;
+    state->edges         = (KiraProfEdge*)kira_prof_zalloc(state->edgeCapacity, sizeof(KiraProfEdge));
+    state->edgeCount     = 0;
+    atexit(kira_prof_report);
+}
+
+simple Void kira_prof_enter(Int32 function)
+{
+    KiraProfState* state = &kira_prof;
+    if (state->count == 0) return;
+    if (state->depth == state->frameCapacity)
+    {
+        state->frameCapacity *= 2;
+        KiraProfFrame* grown = (KiraProfFrame*)realloc(state->frames, (size_t)state->frameCapacity * sizeof(KiraProfFrame));
+        if (grown == null) abort();
+        state->frames = grown;
+    }
+    kira_prof_count_edge(state, state->depth > 0 ? state->frames[state->depth - 1].function : -1, function);
+    state->calls[function]++;
+    state->active[function]++;
+    KiraProfFrame* frame = &state->frames[state->depth++];
+    frame->function = function;
+    frame->child    = 0;
+    frame->start    = kira_prof_now();
+}
+
+simple Void kira_prof_exit(Void)
+{
+    Int64 end = kira_prof_now();
+    KiraProfState* state = &kira_prof;
+    if (state->count == 0 || state->depth == 0) return;
+    KiraProfFrame* frame = &state->frames[--state->depth];
+    Int64 elapsed = end - frame->start;
+    state->exclusive[frame->function] += elapsed - frame->child;
+    if (--state->active[frame->function] == 0)
+    {
+        state->inclusive[frame->function] += elapsed;
+    }
+    if (state->depth > 0)
+    {
+        state->frames[state->depth - 1].child += elapsed;
+    }
+}
+#endif /* KIRA_INSTRUMENT */
+
 #endif /* KIRA_RUNTIME_H */
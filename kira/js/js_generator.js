@@ -2,7 +2,7 @@
  * Kira JS backend -- runtime prelude (mirrors the C facade in c_generator.c).
  *
  * Maps the Kira stdlib surface (kira/core, kira/tuples, kira/collections,
- * kira/result, kira/io, kira/math) onto plain JavaScript. The generated user
+ * kira/result, kira/io, kira/math, kira/debug) onto plain JavaScript. The generated user
  * code sits after this prelude in the same file, so the whole artifact is one
  * self-contained Node script.
  *
@@ -12,6 +12,8 @@
  *   Arr<T>                                 -> JS Array
  *   List / Map / Set / Stack / Queue / Deque -> Kira* classes below
  *   Maybe / Result / Exception             -> Kira* classes below
+ *   Scanner                                -> KiraScanner below
+ *   Weak<T>                                -> KiraWeak below (WeakRef)
  *   Tuple0..Tuple9 / Pair                  -> KiraTuple* classes below
  *   User classes                           -> JS classes emitted by codegen
  *   Traits                                 -> erased (duck typing)
@@ -59,6 +61,14 @@ function kira_assert(condition, message) {
   }
 }
 
+/* ---- kira:debug (no RC heap under GC: counters read 0) ------------------ */
+function kira_rc_stats_enabled() { return false; }
+function kira_rc_stats_counter(className) { return 0; }
+function kira_rc_collect_cycles() { return 0; }
+function kira_rc_stats_dump() {
+  process.stderr.write("kira RC stats: not available on the JS backend\n");
+}
+
 /* ---- Str (JS primitive strings) ----------------------------------------- */
 function kira_str_length(s) { return s == null ? 0 : s.length; }
 
@@ -149,6 +159,22 @@ function kira_str_hashCode(s) {
   return h;
 }
 
+/* Strict parses, mirroring Str_toInt32 / Str_toFloat64 in the C prelude. */
+const KIRA_INT_RE = /^[+-]?[0-9]+$/;
+const KIRA_FLOAT_RE = /^[+-]?([0-9]+\.?[0-9]*|\.[0-9]+)([eE][+-]?[0-9]+)?$/;
+
+function kira_str_toInt32(s) {
+  if (s == null || !KIRA_INT_RE.test(s)) return kira_err("not a valid Int32");
+  const v = Number(s);
+  if (v < -2147483648 || v > 2147483647) return kira_err("not a valid Int32");
+  return kira_ok(v);
+}
+
+function kira_str_toFloat64(s) {
+  if (s == null || !KIRA_FLOAT_RE.test(s)) return kira_err("not a valid Float64");
+  return kira_ok(Number(s));
+}
+
 /* ---- Num (all scalars are JS numbers) ----------------------------------- */
 function kira_num_toInt32(v) { return Math.trunc(v); }
 function kira_num_toInt64(v) { return Math.trunc(v); }
@@ -333,6 +359,71 @@ class KiraDeque {
 
 function kira_deque_new() { return new KiraDeque(); }
 
+/* ---- Scanner (whole input read once, then tokenized in place) ---------- */
+class KiraScanner {
+  constructor(path) {
+    this.path = path;
+    this.text = null;
+    this.pos = 0;
+  }
+  load() {
+    if (this.text === null) {
+      this.text = require("fs").readFileSync(this.path === undefined ? 0 : this.path, "utf8");
+    }
+    return this.text;
+  }
+  skipSpace() {
+    const t = this.load();
+    while (this.pos < t.length && /\s/.test(t[this.pos])) this.pos++;
+  }
+  hasNext() {
+    this.skipSpace();
+    return this.pos < this.text.length;
+  }
+  hasNextLine() { return this.pos < this.load().length; }
+  nextToken() {
+    this.skipSpace();
+    const t = this.text;
+    if (this.pos >= t.length) throw new Error("kira: Scanner.nextToken: no more input");
+    const start = this.pos;
+    while (this.pos < t.length && !/\s/.test(t[this.pos])) this.pos++;
+    return t.substring(start, this.pos);
+  }
+  nextNumber(method, parse) {
+    const tok = this.hasNext() ? this.nextToken() : null;
+    if (tok === null) throw new Error("kira: Scanner." + method + ": no more input");
+    const r = parse(tok);
+    if (!r.ok) throw new Error("kira: Scanner." + method + ": '" + tok + "' is not a number");
+    return r.value;
+  }
+  nextInt32() { return this.nextNumber("nextInt32", kira_str_toInt32); }
+  nextInt64() {
+    return this.nextNumber("nextInt64", (s) => KIRA_INT_RE.test(s) ? kira_ok(Number(s)) : kira_err(s));
+  }
+  nextFloat64() { return this.nextNumber("nextFloat64", kira_str_toFloat64); }
+  nextLine() {
+    const t = this.load();
+    if (this.pos >= t.length) throw new Error("kira: Scanner.nextLine: no more input");
+    let end = t.indexOf("\n", this.pos);
+    const next = end < 0 ? t.length : end + 1;
+    if (end < 0) end = t.length;
+    if (end > this.pos && t[end - 1] === "\r") end--;
+    const line = t.substring(this.pos, end);
+    this.pos = next;
+    return line;
+  }
+}
+
+/* ---- Weak (WeakRef: the GC, not a refcount, decides when upgrade fails) */
+class KiraWeak {
+  constructor(target) { this.ref = target == null ? null : new WeakRef(target); }
+  upgrade() {
+    const target = this.ref === null ? undefined : this.ref.deref();
+    return target === undefined ? kira_none() : kira_some(target);
+  }
+  isAlive() { return this.ref !== null && this.ref.deref() !== undefined; }
+}
+
 /* ---- Tuples ------------------------------------------------------------- */
 class KiraTuple0 {
   size() { return 0; }
@@ -0,0 +1,82 @@
+package net.exoad.kira.bench
+
+import net.exoad.kira.compiler.FrontendService
+import org.openjdk.jmh.annotations.AuxCounters
+import org.openjdk.jmh.annotations.Benchmark
+import org.openjdk.jmh.annotations.BenchmarkMode
+import org.openjdk.jmh.annotations.Fork
+import org.openjdk.jmh.annotations.Level
+import org.openjdk.jmh.annotations.Measurement
+import org.openjdk.jmh.annotations.Mode
+import org.openjdk.jmh.annotations.OutputTimeUnit
+import org.openjdk.jmh.annotations.Param
+import org.openjdk.jmh.annotations.Scope
+import org.openjdk.jmh.annotations.Setup
+import org.openjdk.jmh.annotations.State
+import org.openjdk.jmh.annotations.Warmup
+import java.lang.management.ManagementFactory
+import java.lang.ref.Reference
+import java.util.concurrent.TimeUnit
+
+/**
+ * Parse + semantic analysis of a [SyntheticProject], the work the language
+ * server redoes on every open workspace.
+ *
+ * [parseAndAnalyze] is the time; run with `-prof gc` for allocation per
+ * operation. [retainedHeap] reports the heap the finished result keeps alive
+ * (the `retainedBytes` counter), which is what the server holds resident.
+ */
+@State(Scope.Benchmark)
+@BenchmarkMode(Mode.SingleShotTime)
+@OutputTimeUnit(TimeUnit.MILLISECONDS)
+@Warmup(iterations = 3)
+@Measurement(iterations = 5)
+@Fork(value = 1, jvmArgsAppend = ["-Xms4g", "-Xmx4g"])
+open class FrontendBenchmark {
+    @Param("100000")
+    var lines: Int = 0
+
+    private lateinit var project: SyntheticProject
+
+    @Setup(Level.Trial)
+    fun generate() {
+        project = SyntheticProject.generate(lines)
+        // a generator that drifts out of the language would otherwise time the error path
+        val diagnostics = compile().diagnostics
+        check(diagnostics.isEmpty()) { "synthetic project does not compile: ${diagnostics.first()}" }
+    }
+
+    private fun compile(): FrontendService.FrontendResult {
+        return FrontendService.compileSources(project.paths, overlays = project.sources, projectRoot = project.root)
+    }
+
+    @Benchmark
+    fun parseAndAnalyze(): FrontendService.FrontendResult {
+        return compile()
+    }
+
+    @Benchmark
+    fun retainedHeap(heap: RetainedHeap): FrontendService.FrontendResult {
+        val before = RetainedHeap.used()
+        val result = compile()
+        heap.retainedBytes = RetainedHeap.used() - before
+        Reference.reachabilityFence(result)
+        return result
+    }
+
+    @State(Scope.Thread)
+    @AuxCounters(AuxCounters.Type.EVENTS)
+    open class RetainedHeap {
+        @JvmField
+        var retainedBytes: Long = 0
+
+        companion object {
+            /** Heap in use after collections have settled; a couple of passes so finalizable garbage goes too. */
+            fun used(): Long {
+                val memory = ManagementFactory.getMemoryMXBean()
+                repeat(3) { System.gc() }
+                return memory.heapMemoryUsage.used
+            }
+        }
+    }
+}
@@ -0,0 +1,152 @@
+package net.exoad.kira.bench
+
+import net.exoad.kira.compiler.CompilationUnit
+import net.exoad.kira.compiler.CompilerSession
+import net.exoad.kira.compiler.analysis.semantic.KiraSemanticAnalyzer
+import net.exoad.kira.compiler.analysis.semantic.SemanticAnalyzerResults
+import net.exoad.kira.compiler.backend.codegen.MinifyLanguage
+import net.exoad.kira.compiler.backend.codegen.OutputMinifier
+import net.exoad.kira.compiler.backend.codegen.c.KiraCCodeGenerator
+import net.exoad.kira.compiler.frontend.lexer.KiraLexer
+import net.exoad.kira.compiler.frontend.lexer.TokenStream
+import net.exoad.kira.compiler.frontend.parser.KiraSourceParsers
+import net.exoad.kira.source.SourceContext
+import org.openjdk.jmh.annotations.Benchmark
+import org.openjdk.jmh.annotations.BenchmarkMode
+import org.openjdk.jmh.annotations.Fork
+import org.openjdk.jmh.annotations.Level
+import org.openjdk.jmh.annotations.Measurement
+import org.openjdk.jmh.annotations.Mode
+import org.openjdk.jmh.annotations.OutputTimeUnit
+import org.openjdk.jmh.annotations.Param
+import org.openjdk.jmh.annotations.Scope
+import org.openjdk.jmh.annotations.Setup
+import org.openjdk.jmh.annotations.State
+import org.openjdk.jmh.annotations.Warmup
+import java.util.concurrent.TimeUnit
+
+/**
+ * Each stage of a build on its own, over [SyntheticProject]s from 1k lines
+ * up: lexing, parsing, semantic analysis, C emission and minification.
+ * Where [FrontendBenchmark] answers "how long does the language server take
+ * to load a workspace", this says which stage a regression is in and how
+ * each one scales with project size.
+ *
+ * Every stage is timed on the output of the stages before it, prepared
+ * outside the measurement. Parsing and analysis change the unit they run
+ * on, so those get a fresh one per invocation.
+ */
+@BenchmarkMode(Mode.SingleShotTime)
+@OutputTimeUnit(TimeUnit.MILLISECONDS)
+@Warmup(iterations = 3)
+@Measurement(iterations = 5)
+@Fork(value = 1, jvmArgsAppend = ["-Xms4g", "-Xmx8g"])
+open class PipelineBenchmark {
+    /** The generated project and its tokens, shared by every stage. 1M lines: `-PbenchLines=1000000`. */
+    @State(Scope.Benchmark)
+    open class Project {
+        @Param("1000", "10000", "100000")
+        var lines: Int = 0
+
+        lateinit var project: SyntheticProject
+        lateinit var tokens: Map<String, TokenStream>
+
+        @Setup(Level.Trial)
+        fun generate() {
+            project = SyntheticProject.generate(lines)
+            tokens = project.sources.mapValues { (path, text) -> lex(path, text) }
+        }
+
+        /** A unit holding every file, lexed but not parsed. */
+        fun lexedUnit(): CompilationUnit {
+            val unit = CompilationUnit(CompilerSession())
+            project.sources.forEach { (path, text) -> unit.addSource(path, text, tokens.getValue(path)) }
+            return unit
+        }
+
+        /** Parse the project's files in [unit]; the stdlib the unit bootstrapped is already parsed. */
+        fun parse(unit: CompilationUnit) {
+            project.paths.forEach { path -> KiraSourceParsers.from(unit.getSource(path)!!).parse() }
+        }
+
+        fun parsedUnit(): CompilationUnit {
+            return lexedUnit().also(::parse)
+        }
+    }
+
+    @State(Scope.Thread)
+    open class Lexed {
+        lateinit var project: Project
+        lateinit var unit: CompilationUnit
+
+        @Setup(Level.Invocation)
+        fun prepare(project: Project) {
+            this.project = project
+            unit = project.lexedUnit()
+        }
+    }
+
+    @State(Scope.Thread)
+    open class Parsed {
+        lateinit var unit: CompilationUnit
+
+        @Setup(Level.Invocation)
+        fun prepare(project: Project) {
+            unit = project.parsedUnit()
+        }
+    }
+
+    /** An analyzed unit and the C it emits; neither stage after analysis changes the unit. */
+    @State(Scope.Thread)
+    open class Analyzed {
+        lateinit var unit: CompilationUnit
+        lateinit var userLayer: String
+
+        @Setup(Level.Trial)
+        fun prepare(project: Project) {
+            unit = project.parsedUnit()
+            val results = KiraSemanticAnalyzer(unit, unit.session.jobs).validateAST()
+            // a generator that drifts out of the language would otherwise time the error path
+            check(results.diagnostics.isEmpty()) { "synthetic project does not analyze: ${results.diagnostics.first()}" }
+            val emitted = KiraCCodeGenerator(unit).emitToString()
+            check(emitted == KiraCCodeGenerator(unit).emitToString()) { "emitting twice gave different C" }
+            userLayer = emitted.substringAfterLast(PRELUDE_END)
+        }
+    }
+
+    @Benchmark
+    fun lex(project: Project): Int {
+        return project.project.sources.entries.sumOf { (path, text) -> lex(path, text).size }
+    }
+
+    @Benchmark
+    fun parse(lexed: Lexed): CompilationUnit {
+        lexed.project.parse(lexed.unit)
+        return lexed.unit
+    }
+
+    @Benchmark
+    fun analyze(parsed: Parsed): SemanticAnalyzerResults {
+        return KiraSemanticAnalyzer(parsed.unit, parsed.unit.session.jobs).validateAST()
+    }
+
+    @Benchmark
+    fun emitC(analyzed: Analyzed): String {
+        return KiraCCodeGenerator(analyzed.unit).emitToString()
+    }
+
+    /** The user layer of the emitted C, as `generate()` minifies it, minus the symbol renaming. */
+    @Benchmark
+    fun minifyC(analyzed: Analyzed): String {
+        return OutputMinifier.minify(MinifyLanguage.C, analyzed.userLayer)
+    }
+
+    companion object {
+        /** Where the C prelude ends and the user layer starts. */
+        private const val PRELUDE_END = "#endif /* KIRA_RUNTIME_H */"
+
+        private fun lex(path: String, text: String): TokenStream {
+            return KiraLexer(SourceContext(text, path, emptyList())).tokenize()
+        }
+    }
+}
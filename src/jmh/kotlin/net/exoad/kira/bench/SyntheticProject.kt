@@ -0,0 +1,141 @@
+package net.exoad.kira.bench
+
+import java.nio.file.Path
+
+/**
+ * A deterministic Kira project of roughly [lines] lines, held in memory and fed
+ * to the frontend as overlays so no benchmark touches the disk.
+ *
+ * Module `n` declares a trait, a class implementing it, a generic class and
+ * function, a few free functions and a driver that calls into module
+ * `n - 1`, so analysis has a `use` chain, cross-module calls, trait dispatch
+ * and generic instantiations (`Int32` and `Str`) to resolve rather than a
+ * pile of unrelated files. A last module holds `main`, so the C backend emits
+ * a whole program.
+ *
+ * The output depends on [lines] alone; change it and benchmark numbers from
+ * before the change stop being comparable.
+ */
+class SyntheticProject private constructor(val root: Path, val sources: Map<String, String>) {
+    val paths: List<String> = sources.keys.toList()
+
+    val lines: Int = sources.values.sumOf { text -> text.count { it == '\n' } }
+
+    companion object {
+        /** Helper functions per module; with the types and driver a module comes to about 130 lines. */
+        private const val HELPERS_PER_MODULE = 5
+
+        fun generate(lines: Int): SyntheticProject {
+            val root = Path.of(System.getProperty("java.io.tmpdir"), "kira-bench", "src")
+            val sources = LinkedHashMap<String, String>()
+            var total = 0
+            var index = 0
+            while (total < lines) {
+                val text = module(index)
+                sources[root.resolve("m$index.kira").toString()] = text
+                total += text.count { it == '\n' }
+                index++
+            }
+            sources[root.resolve("main.kira").toString()] = entry(index - 1)
+            return SyntheticProject(root, sources)
+        }
+
+        private fun module(n: Int): String {
+            return buildString {
+                appendLine("module \"bench:m$n\"")
+                appendLine()
+                if (n > 0) {
+                    appendLine("use \"bench:m${n - 1}\"")
+                    appendLine()
+                }
+                appendLine("pub trait Metric$n {")
+                appendLine("    pub fx measure: () Int32")
+                appendLine("}")
+                appendLine()
+                appendLine("pub class Cell$n: Metric$n {")
+                appendLine("    require pub x: Int32")
+                appendLine("    require pub y: Int32")
+                appendLine()
+                appendLine("    pub fx sum: () Int32 {")
+                appendLine("        return x + y")
+                appendLine("    }")
+                appendLine()
+                appendLine("    pub fx scaled: (k: Int32) Int32 {")
+                appendLine("        return (x * k) + (y * k)")
+                appendLine("    }")
+                appendLine()
+                appendLine("    pub fx measure: () Int32 {")
+                appendLine("        return x - y")
+                appendLine("    }")
+                appendLine("}")
+                appendLine()
+                appendLine("pub class Slot$n<T> {")
+                appendLine("    require pub value: T")
+                appendLine("    require pub weight: Int32")
+                appendLine("}")
+                appendLine()
+                appendLine("pub fx keep$n<T>: (value: T) T {")
+                appendLine("    return value")
+                appendLine("}")
+                appendLine()
+                appendLine("pub fx total$n: (metric: Metric$n) Int32 {")
+                appendLine("    return metric.measure()")
+                appendLine("}")
+                appendLine()
+                for (j in 0 until HELPERS_PER_MODULE) {
+                    appendLine("pub fx sumTo${n}_$j: (limit: Int32) Int32 {")
+                    appendLine("    mut total: Int32 = $j")
+                    appendLine("    for mut i: 0..limit {")
+                    appendLine("        total = total + i")
+                    appendLine("    }")
+                    appendLine("    return total")
+                    appendLine("}")
+                    appendLine()
+                    appendLine("pub fx parity${n}_$j: (value: Int32) Str {")
+                    appendLine("    if value % 2 == 0 {")
+                    appendLine("        return \"even\"")
+                    appendLine("    } else {")
+                    appendLine("        return \"odd\"")
+                    appendLine("    }")
+                    appendLine("}")
+                    appendLine()
+                }
+                appendLine("pub fx run$n: (seed: Int32) Int32 {")
+                appendLine("    cell: Cell$n = Cell$n { seed, seed + 1 }")
+                appendLine("    mut acc: Int32 = cell.sum()")
+                appendLine("    mut i: Int32 = 0")
+                appendLine("    while i < 4 {")
+                appendLine("        acc = acc + cell.scaled(i)")
+                appendLine("        i = i + 1")
+                appendLine("    }")
+                for (j in 0 until HELPERS_PER_MODULE) {
+                    appendLine("    acc = acc + sumTo${n}_$j(seed)")
+                }
+                appendLine("    metric: Metric$n = cell")
+                appendLine("    acc = acc + total$n(metric)")
+                appendLine("    count: Slot$n<Int32> = Slot$n<Int32> { acc, 1 }")
+                appendLine("    label: Slot$n<Str> = Slot$n<Str> { parity${n}_0(seed), 2 }")
+                appendLine("    acc = acc + keep$n<Int32>(count.value) + label.weight")
+                appendLine("    name: Str = keep$n<Str>(label.value)")
+                appendLine("    trace(name)")
+                if (n > 0) {
+                    appendLine("    acc = acc + run${n - 1}(seed)")
+                }
+                appendLine("    return acc")
+                appendLine("}")
+            }
+        }
+
+        private fun entry(last: Int): String {
+            return buildString {
+                appendLine("module \"bench:main\"")
+                appendLine()
+                appendLine("use \"bench:m$last\"")
+                appendLine()
+                appendLine("fx main: () Void {")
+                appendLine("    trace(run$last(1))")
+                appendLine("}")
+            }
+        }
+    }
+}
@@ -6,20 +6,11 @@ import java.nio.file.Paths
 
 object Public {
 
-    val flagsDefault = mapOf(
-        "useDiagnosticsUnicode" to true,
-        "beVerbose" to false,
-    )
-
-    // Restored mutable flags map used by tests and runtime toggles
-    var flags: Map<String, Boolean> = flagsDefault.toMutableMap()
-
     object Builtin {
-        var intrinsicalStandardLibrarySources: Array<String> = emptyArray()
-
-        // fallback discovery in case no manifest is provided or manifest has no kira deps
-        fun discoverLegacyKiraFolder(): Array<String> {
-            val rootPath = Paths.get("kira").toAbsolutePath().normalize()
+        // fallback discovery in case no manifest is provided or manifest has no kira deps;
+        // the resolved list lives on CompilerSession.stdlibSources
+        fun discoverLegacyKiraFolder(projectRoot: Path = Paths.get("")): Array<String> {
+            val rootPath = projectRoot.resolve("kira").toAbsolutePath().normalize()
             if (!Files.exists(rootPath) || !Files.isDirectory(rootPath)) {
                 return emptyArray()
             }
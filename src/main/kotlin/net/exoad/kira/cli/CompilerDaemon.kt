@@ -0,0 +1,279 @@
+package net.exoad.kira.cli
+
+import net.exoad.kira.compiler.analysis.diagnostics.Diagnostics
+import java.io.BufferedInputStream
+import java.io.BufferedOutputStream
+import java.io.DataInputStream
+import java.io.DataOutputStream
+import java.io.EOFException
+import java.io.File
+import java.io.IOException
+import java.io.OutputStream
+import java.io.PrintStream
+import java.net.StandardProtocolFamily
+import java.net.UnixDomainSocketAddress
+import java.nio.channels.Channels
+import java.nio.channels.ServerSocketChannel
+import java.nio.channels.SocketChannel
+import java.nio.file.FileSystems
+import java.nio.file.Files
+import java.nio.file.Path
+import java.nio.file.attribute.PosixFilePermissions
+
+/**
+ * `kira --daemon`: a compiler that stays up between builds.
+ *
+ * A cold `kira` spends most of a small build starting the JVM, loading
+ * snakeyaml and the compiler classes, and running the lexer and parser
+ * interpreted until the JIT catches up. The daemon pays that once and keeps
+ * the warm compiler (and the mapped [net.exoad.kira.compiler.StdlibSnapshot])
+ * resident; every later `kira` forwards its arguments, working directory and
+ * environment over a Unix domain socket and gets its stdout, stderr and exit
+ * code back. The environment is what `cc` and the PGO training command run
+ * with, so a build sees the client shell's `PATH` and toolchain variables.
+ *
+ * There is one socket per user ([socketPath]). Builds are served one at a
+ * time, since a build's log goes through the process-wide `System.out` and
+ * `System.err`. A client built from a different compiler than the daemon's is
+ * refused and compiles in its own process; the daemon keeps serving its own
+ * clients (a test run from a build directory must not take down the
+ * installed compiler's daemon) until `kira --stop-daemon`.
+ */
+object CompilerDaemon {
+    private const val MAGIC = 0x4B495241 // "KIRA"
+    private const val PROTOCOL = 2
+
+    private const val REQUEST_BUILD: Byte = 1
+    private const val REQUEST_STOP: Byte = 2
+
+    private const val FRAME_STDOUT: Byte = 1
+    private const val FRAME_STDERR: Byte = 2
+    private const val FRAME_EXIT: Byte = 3
+    private const val FRAME_REFUSED: Byte = 4
+
+    /** `$XDG_RUNTIME_DIR/kira/daemon.sock`, else a private directory under the temp dir. */
+    fun socketPath(): Path {
+        val runtime = System.getenv("XDG_RUNTIME_DIR")
+        if (!runtime.isNullOrBlank()) {
+            return Path.of(runtime, "kira", "daemon.sock")
+        }
+        return Path.of(System.getProperty("java.io.tmpdir"), "kira-${System.getProperty("user.name")}", "daemon.sock")
+    }
+
+    /**
+     * Where this compiler was loaded from and when that was last written. A
+     * rebuilt or reinstalled compiler changes it, so a daemon left running
+     * across an upgrade does not keep compiling with the old one.
+     */
+    private val identity: String by lazy {
+        val location = CompilerDaemon::class.java.protectionDomain?.codeSource?.location
+        val file = location?.let { File(it.toURI()) }
+        "$PROTOCOL:${file?.absolutePath}:${file?.lastModified()}"
+    }
+
+    /** Accept builds on [socket] until a client sends `--stop-daemon` or the process is killed. */
+    fun serve(socket: Path = socketPath()) {
+        val directory = socket.parent
+        if (!Files.isDirectory(directory)) {
+            if ("posix" in FileSystems.getDefault().supportedFileAttributeViews()) {
+                Files.createDirectories(directory, PosixFilePermissions.asFileAttribute(PosixFilePermissions.fromString("rwx------")))
+            } else {
+                Files.createDirectories(directory)
+            }
+        }
+        if (Files.exists(socket)) {
+            connect(socket)?.use {
+                Diagnostics.panic("A Kira daemon is already listening on $socket")
+            }
+            // left behind by a daemon that was killed
+            Files.delete(socket)
+        }
+        ServerSocketChannel.open(StandardProtocolFamily.UNIX).use { server ->
+            server.bind(UnixDomainSocketAddress.of(socket))
+            Runtime.getRuntime().addShutdownHook(Thread { Files.deleteIfExists(socket) })
+            Diagnostics.Logging.info("Kira", "Daemon listening on $socket")
+            var running = true
+            while (running) {
+                server.accept().use { channel ->
+                    running = try {
+                        handle(channel)
+                    } catch (_: IOException) {
+                        // the client went away mid-build; nothing to report to
+                        true
+                    }
+                }
+            }
+            Files.deleteIfExists(socket)
+        }
+    }
+
+    /** Serve one connection; false when the daemon should stop. */
+    private fun handle(channel: SocketChannel): Boolean {
+        val input = DataInputStream(BufferedInputStream(Channels.newInputStream(channel)))
+        val output = DataOutputStream(BufferedOutputStream(Channels.newOutputStream(channel)))
+        if (input.readInt() != MAGIC) {
+            return true
+        }
+        val clientIdentity = input.readUTF()
+        val request = input.readByte()
+        if (request == REQUEST_STOP) {
+            output.writeByte(FRAME_EXIT.toInt())
+            output.writeInt(0)
+            output.flush()
+            return false
+        }
+        if (clientIdentity != identity) {
+            // before reading the rest: a client speaking another protocol may not send what this one expects
+            output.writeByte(FRAME_REFUSED.toInt())
+            output.writeUTF("daemon runs $identity, client is $clientIdentity")
+            output.flush()
+            return true
+        }
+        val workingDirectory = Path.of(input.readUTF())
+        val args = Array(input.readInt()) { input.readUTF() }
+        val environment = HashMap<String, String>()
+        repeat(input.readInt()) {
+            environment[input.readUTF()] = input.readUTF()
+        }
+        val stdout = System.out
+        val stderr = System.err
+        System.setOut(PrintStream(FrameStream(output, FRAME_STDOUT), true))
+        System.setErr(PrintStream(FrameStream(output, FRAME_STDERR), true))
+        val exitCode = try {
+            compile(args, workingDirectory, environment)
+        } catch (e: Throwable) {
+            // what an uncaught exception would have printed in a process of its own
+            e.printStackTrace()
+            1
+        } finally {
+            System.out.flush()
+            System.err.flush()
+            System.setOut(stdout)
+            System.setErr(stderr)
+        }
+        synchronized(output) {
+            output.writeByte(FRAME_EXIT.toInt())
+            output.writeInt(exitCode)
+            output.flush()
+        }
+        return true
+    }
+
+    /**
+     * Run `kira [args]` in [workingDirectory] with [environment] on the
+     * daemon listening on [socket], copying its output to [stdout] and
+     * [stderr]. Null when there
+     * is no daemon or it refused the build, in which case the caller compiles
+     * itself.
+     */
+    fun forward(
+        args: Array<String>,
+        workingDirectory: Path,
+        socket: Path = socketPath(),
+        stdout: PrintStream = System.out,
+        stderr: PrintStream = System.err,
+        environment: Map<String, String> = System.getenv(),
+    ): Int? {
+        val channel = connect(socket) ?: return null
+        channel.use {
+            val output = DataOutputStream(BufferedOutputStream(Channels.newOutputStream(channel)))
+            output.writeInt(MAGIC)
+            output.writeUTF(identity)
+            output.writeByte(REQUEST_BUILD.toInt())
+            output.writeUTF(workingDirectory.toString())
+            output.writeInt(args.size)
+            args.forEach(output::writeUTF)
+            output.writeInt(environment.size)
+            environment.forEach { (name, value) ->
+                output.writeUTF(name)
+                output.writeUTF(value)
+            }
+            output.flush()
+            val input = DataInputStream(BufferedInputStream(Channels.newInputStream(channel)))
+            var answered = false
+            try {
+                while (true) {
+                    val frame = input.readByte()
+                    answered = true
+                    when (frame) {
+                        FRAME_STDOUT -> copyChunk(input, stdout)
+                        FRAME_STDERR -> copyChunk(input, stderr)
+                        FRAME_EXIT -> return input.readInt()
+                        FRAME_REFUSED -> {
+                            stderr.println(
+                                "The Kira daemon is from a different compiler build (${input.readUTF()}); " +
+                                    "compiling in-process. Restart it with kira --stop-daemon && kira --daemon."
+                            )
+                            return null
+                        }
+                        else -> throw IOException("Unknown daemon frame $frame")
+                    }
+                }
+            } catch (e: IOException) {
+                if (!answered) {
+                    // died before it took the build; nothing has run yet
+                    return null
+                }
+                stderr.println("Lost the connection to the Kira daemon mid-build: ${e.message}")
+                return 1
+            }
+        }
+    }
+
+    /** Ask the daemon on [socket] to exit; false when none is running. */
+    fun stop(socket: Path = socketPath()): Boolean {
+        val channel = connect(socket) ?: return false
+        channel.use {
+            val output = DataOutputStream(BufferedOutputStream(Channels.newOutputStream(channel)))
+            output.writeInt(MAGIC)
+            output.writeUTF(identity)
+            output.writeByte(REQUEST_STOP.toInt())
+            output.flush()
+            return try {
+                DataInputStream(Channels.newInputStream(channel)).readByte() == FRAME_EXIT
+            } catch (_: EOFException) {
+                false
+            }
+        }
+    }
+
+    private fun connect(socket: Path): SocketChannel? {
+        if (!Files.exists(socket)) {
+            return null
+        }
+        return try {
+            SocketChannel.open(UnixDomainSocketAddress.of(socket))
+        } catch (_: IOException) {
+            null
+        }
+    }
+
+    private fun copyChunk(input: DataInputStream, target: PrintStream) {
+        val bytes = ByteArray(input.readInt())
+        input.readFully(bytes)
+        target.write(bytes)
+        target.flush()
+    }
+
+    /** Bytes written to it go to the client as frames of one [kind]. */
+    private class FrameStream(private val output: DataOutputStream, private val kind: Byte) : OutputStream() {
+        override fun write(b: Int) {
+            write(byteArrayOf(b.toByte()), 0, 1)
+        }
+
+        override fun write(b: ByteArray, off: Int, len: Int) {
+            if (len == 0) return
+            synchronized(output) {
+                output.writeByte(kind.toInt())
+                output.writeInt(len)
+                output.write(b, off, len)
+            }
+        }
+
+        override fun flush() {
+            synchronized(output) {
+                output.flush()
+            }
+        }
+    }
+}
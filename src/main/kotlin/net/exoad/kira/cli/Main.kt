@@ -2,7 +2,12 @@ package net.exoad.kira.cli
 
 import net.exoad.kira.Public
 import net.exoad.kira.compiler.CompilationUnit
+import net.exoad.kira.compiler.CompilerSession
+import net.exoad.kira.compiler.FrontendCache
+import net.exoad.kira.compiler.FrontendService
+import net.exoad.kira.compiler.PassTrace
 import net.exoad.kira.compiler.analysis.diagnostics.Diagnostics
+import net.exoad.kira.compiler.analysis.diagnostics.DiagnosticsException
 import net.exoad.kira.compiler.analysis.semantic.KiraSemanticAnalyzer
 import net.exoad.kira.compiler.analysis.semantic.SemanticScope
 import net.exoad.kira.compiler.backend.codegen.c.KiraCCodeGenerator
@@ -10,8 +15,9 @@ import net.exoad.kira.compiler.backend.codegen.js.KiraJSCodeGenerator
 import net.exoad.kira.compiler.backend.targets.GeneratedProvider
 import net.exoad.kira.compiler.frontend.lexer.KiraLexer
 import net.exoad.kira.compiler.frontend.parser.KiraSourceParsers
+import net.exoad.kira.compiler.frontend.parser.ast.ASTNode
 import net.exoad.kira.compiler.frontend.parser.ast.XMLASTVisitorKira
-import net.exoad.kira.compiler.frontend.preprocessor.KiraPreprocessor
+import net.exoad.kira.kim.BuildOptions
 import net.exoad.kira.kim.DependencyResolver
 import net.exoad.kira.kim.ManifestLoader
 import net.exoad.kira.kim.ManifestValidator
@@ -19,15 +25,18 @@ import net.exoad.kira.kim.ProjectManifest
 import net.exoad.kira.utils.Chronos
 import net.exoad.kira.utils.EnglishUtils
 import java.io.File
+import java.lang.reflect.Modifier
 import java.nio.file.Files
 import java.nio.file.Path
 import java.nio.file.Paths
+import java.util.Collections
+import java.util.IdentityHashMap
 import kotlin.math.floor
 import kotlin.math.log10
 import kotlin.time.measureTimedValue
 
-private fun applyTargetOverride(target: String) {
-    GeneratedProvider.outputMode = when (target) {
+private fun parseTarget(target: String): GeneratedProvider.OutputTarget {
+    return when (target) {
         "c", "native" -> GeneratedProvider.OutputTarget.C
         "js", "javascript" -> GeneratedProvider.OutputTarget.JS
         "neko" -> GeneratedProvider.OutputTarget.NEKO
@@ -36,15 +45,129 @@ private fun applyTargetOverride(target: String) {
     }
 }
 
+/**
+ * Every node under [root] the parser recorded a position on. Positions live on
+ * the nodes rather than in a map, so the AST dump has to walk the tree; it
+ * reads fields reflectively since nothing else needs a generic child walk.
+ */
+private fun positionedNodes(root: ASTNode): List<ASTNode> {
+    val found = ArrayList<ASTNode>()
+    val seen = Collections.newSetFromMap(IdentityHashMap<Any, Boolean>())
+    val pending = ArrayDeque<Any>()
+    pending.add(root)
+    while (pending.isNotEmpty()) {
+        val value = pending.removeLast()
+        when (value) {
+            is ASTNode -> {
+                if (!seen.add(value)) continue
+                if (value.packedOrigin != ASTNode.NO_ORIGIN) found.add(value)
+                var type: Class<*>? = value.javaClass
+                while (type != null && type != Any::class.java) {
+                    for (field in type.declaredFields) {
+                        if (Modifier.isStatic(field.modifiers) || field.type.isPrimitive) continue
+                        field.isAccessible = true
+                        field.get(value)?.let { pending.add(it) }
+                    }
+                    type = type.superclass
+                }
+            }
+            is Iterable<*> -> value.forEach { if (it != null) pending.add(it) }
+            is Array<*> -> value.forEach { if (it != null) pending.add(it) }
+            is Map<*, *> -> value.forEach { (k, v) -> k?.let(pending::add); v?.let(pending::add) }
+        }
+    }
+    return found
+}
+
 fun main(args: Array<String>) {
-    // Minimal CLI: `kira --target js|c|neko|none` overrides build.target from
-    // kira.yaml; `--readable` emits pretty (non-minified) output. Nothing else
-    // is read today; the compiler is cwd-driven.
+    // `--daemon` serves builds over a Unix domain socket (see CompilerDaemon);
+    // any other invocation goes to a running daemon when there is one and
+    // compiles in this process otherwise. `--no-daemon` always compiles here.
+    // `kira run` builds the same way, then runs the program here with
+    // whatever follows `--`.
+    val separator = args.indexOf("--")
+    val kiraArgs = if (separator < 0) args else args.copyOfRange(0, separator)
+    val programArgs = if (separator < 0) emptyList() else args.drop(separator + 1)
+    if ("--daemon" in kiraArgs) {
+        CompilerDaemon.serve()
+        return
+    }
+    if ("--stop-daemon" in kiraArgs) {
+        kotlin.system.exitProcess(if (CompilerDaemon.stop()) 0 else 1)
+    }
+    val workingDirectory = Paths.get("").toAbsolutePath().normalize()
+    val forwarded = if ("--no-daemon" in kiraArgs) null else CompilerDaemon.forward(kiraArgs, workingDirectory)
+    var exitCode = forwarded ?: compile(kiraArgs.filter { it != "--no-daemon" }.toTypedArray(), workingDirectory)
+    if (exitCode == 0 && kiraArgs.firstOrNull() == "run") {
+        exitCode = NativeBuild.run(workingDirectory.resolve(NativeBuild.BINARY), programArgs)
+    }
+    if (exitCode != 0) {
+        kotlin.system.exitProcess(exitCode)
+    }
+}
+
+/**
+ * One `kira` build of the project in [workingDirectory], returning the
+ * process exit code. Everything it reads and writes is resolved against
+ * [workingDirectory] rather than the JVM's own, and the C compiler and PGO
+ * training run with [environment], so [CompilerDaemon] can run it for
+ * clients in other directories and shells.
+ */
+fun compile(args: Array<String>, workingDirectory: Path, environment: Map<String, String> = System.getenv()): Int {
+    // Minimal CLI: `kira build` also runs the C compiler on the emitted C
+    // (`--profile debug|release|size`, `--cc` to pick the compiler), reusing
+    // a cached binary when the C is unchanged; `--pgo` trains and rebuilds
+    // it with build.pgo.train; `kira run` builds the same way. `--time-passes`
+    // prints time, CPU and allocation per phase and file; `--trace out.json`
+    // writes the same spans as a Chrome trace. `kira --target js|c|neko|none` overrides build.target from
+    // kira.yaml; `--readable` emits pretty (non-minified) output; `--instrument`
+    // adds profiler probes to C output; `--no-cache` ignores and skips writing
+    // the incremental frontend cache in .kira/cache; `--jobs N` caps the
+    // threads that parse source files (default: one per core). Nothing else
+    // is read today; the compiler is driven by the project in workingDirectory.
     var targetOverride: String? = null
     var readableOverride = false
+    var instrument = false
+    var useCache = true
+    var jobs: Int? = null
+    var command: String? = null
+    var profile: NativeBuild.Profile? = null
+    var pgo = false
+    var timePasses = false
+    var traceFile: String? = null
+    var ccOverride: String? = null
     var i = 0
     while (i < args.size) {
         when (args[i]) {
+            "build", "run" -> {
+                if (i != 0) {
+                    Diagnostics.panic("'${args[i]}' must come first (kira ${args[i]} [options])")
+                }
+                command = args[i]
+                i += 1
+            }
+            "--profile" -> {
+                profile = NativeBuild.Profile.parse(
+                    args.getOrNull(i + 1) ?: Diagnostics.panic("--profile requires a value (debug, release, size)")
+                )
+                i += 2
+            }
+            "--pgo" -> {
+                pgo = true
+                i += 1
+            }
+            "--time-passes" -> {
+                timePasses = true
+                i += 1
+            }
+            "--trace" -> {
+                traceFile = args.getOrNull(i + 1) ?: Diagnostics.panic("--trace requires an output file")
+                i += 2
+            }
+            "--cc" -> {
+                ccOverride = args.getOrNull(i + 1) ?: Diagnostics.panic("--cc requires a compiler command")
+                i += 2
+            }
             "--target", "-t" -> {
                 if (i + 1 >= args.size) {
                     Diagnostics.panic("--target requires a value (c, js, neko, none)")
@@ -56,17 +179,38 @@ fun main(args: Array<String>) {
                 readableOverride = true
                 i += 1
             }
+            "--instrument" -> {
+                instrument = true
+                i += 1
+            }
+            "--no-cache" -> {
+                useCache = false
+                i += 1
+            }
+            "--jobs", "-j" -> {
+                jobs = args.getOrNull(i + 1)?.toIntOrNull()?.takeIf { it > 0 }
+                    ?: Diagnostics.panic("--jobs requires a positive thread count")
+                i += 2
+            }
             "--help", "-h" -> {
-                println("Usage: kira [--target c|js|neko|none] [--readable]")
-                kotlin.system.exitProcess(0)
+                println(
+                    "Usage: kira [build | run] [--target c|js|neko|none] [--readable] [--instrument] [--no-cache]\n" +
+                        "            [--jobs N] [--profile debug|release|size] [--pgo] [--cc COMPILER]\n" +
+                        "            [--time-passes] [--trace FILE.json]\n" +
+                        "            [--daemon | --stop-daemon | --no-daemon] [-- PROGRAM ARGS]"
+                )
+                return 0
             }
             else -> Diagnostics.panic("Unknown argument '${args[i]}' (try --help)")
         }
     }
+    var nativeFailed = false
+    var trace: PassTrace? = null
     val result = measureTimedValue {
 //        Diagnostics.silenceDiagnostics()
-        val projectRoot: Path = Paths.get(".").toAbsolutePath().normalize()
+        val projectRoot: Path = workingDirectory
         var manifest: ProjectManifest? = null
+        var outputMode = GeneratedProvider.OutputTarget.NONE
         val yamlManifestPath = projectRoot.resolve("kira.yaml")
         val legacyTomlPath = projectRoot.resolve("kira.toml")
 
@@ -91,41 +235,59 @@ fun main(args: Array<String>) {
                 Diagnostics.Logging.info("Kira", "Loaded project config from $yamlManifestPath")
 
                 when (manifest.build.target.lowercase()) {
-                    "c", "native" -> GeneratedProvider.outputMode = GeneratedProvider.OutputTarget.C
-                    "js", "javascript" -> GeneratedProvider.outputMode = GeneratedProvider.OutputTarget.JS
-                    "neko" -> GeneratedProvider.outputMode = GeneratedProvider.OutputTarget.NEKO
+                    "c", "native" -> outputMode = GeneratedProvider.OutputTarget.C
+                    "js", "javascript" -> outputMode = GeneratedProvider.OutputTarget.JS
+                    "neko" -> outputMode = GeneratedProvider.OutputTarget.NEKO
                     "none" -> {}
                 }
                 // A --target flag beats the manifest.
                 if (targetOverride != null) {
-                    applyTargetOverride(targetOverride!!)
+                    outputMode = parseTarget(targetOverride!!)
                 }
             } catch (e: Exception) {
                 Diagnostics.panic("Failed to load project config from $yamlManifestPath: ${e.message}")
             }
         } else if (targetOverride != null) {
             // No manifest: the flag is the only target source.
-            applyTargetOverride(targetOverride!!)
+            outputMode = parseTarget(targetOverride!!)
         }
-
-        // Minified + obfuscated output is the default; `build.minify: false`
-        // in kira.yaml, or the --readable flag, restores pretty output.
-        GeneratedProvider.minifyOutput = manifest?.build?.minify ?: true
-        if (readableOverride) {
-            GeneratedProvider.minifyOutput = false
+        if (pgo && command == null) {
+            Diagnostics.panic("--pgo only applies to kira build and kira run")
+        }
+        if (command != null) {
+            if (outputMode == GeneratedProvider.OutputTarget.NONE) {
+                outputMode = GeneratedProvider.OutputTarget.C
+            } else if (outputMode != GeneratedProvider.OutputTarget.C) {
+                Diagnostics.panic("kira $command only drives the C target (this build targets ${outputMode.name.lowercase()})")
+            }
+        }
+        if (instrument && outputMode != GeneratedProvider.OutputTarget.C) {
+            Diagnostics.Logging.warn("Kira", "--instrument only affects the C target; ignoring it.")
         }
 
         val stdlibEntries = DependencyResolver.resolveDependencySources(manifest, projectRoot).toMutableList()
         if (stdlibEntries.isEmpty()) {
-            stdlibEntries.addAll(Public.Builtin.discoverLegacyKiraFolder())
+            stdlibEntries.addAll(Public.Builtin.discoverLegacyKiraFolder(projectRoot))
         }
-        Public.Builtin.intrinsicalStandardLibrarySources = stdlibEntries.distinct().sorted().toTypedArray()
+        val defaults = CompilerSession(stdlibRoot = projectRoot.resolve("kira").takeIf { Files.isDirectory(it) })
+        val session = defaults.copy(
+            outputMode = outputMode,
+            // Minified + obfuscated output is the default; `build.minify: false`
+            // in kira.yaml, or the --readable flag, restores pretty output.
+            minifyOutput = !readableOverride && (manifest?.build?.minify ?: true),
+            instrument = instrument,
+            useIncrementalCache = useCache,
+            jobs = jobs ?: defaults.jobs,
+            stdlibSources = stdlibEntries.distinct().sorted(),
+            trace = if (timePasses || traceFile != null) PassTrace() else null,
+        )
+        trace = session.trace
         val dumpSB = if (manifest?.compiler?.emitIr != null) StringBuilder() else null
         val workspaceSources: Array<String> = DependencyResolver.resolveProjectSources(manifest, projectRoot).toTypedArray()
-        if (workspaceSources.isEmpty() && Public.Builtin.intrinsicalStandardLibrarySources.isEmpty()) {
+        if (workspaceSources.isEmpty() && session.stdlibSources.isEmpty()) {
             Diagnostics.panic("No source files to compile. Add .kira files to 'src' or configure 'kira.yaml'.")
         }
-        val sources = arrayOf(*Public.Builtin.intrinsicalStandardLibrarySources, *workspaceSources)
+        val sources = arrayOf(*session.stdlibSources.toTypedArray(), *workspaceSources)
         Diagnostics.Logging.info("Kira", "Parser: kotlin-native (KiraLexer + KiraParser)")
         dumpSB?.appendLine(
             "----------- Kira Processed Symbols Dump File -----------\nGenerated: ${Chronos.formatTimestamp()}\nTotal Source Files: ${sources.size}\nSources List: \n${
@@ -134,77 +296,113 @@ fun main(args: Array<String>) {
                 ) { " $it" }
             }"
         )
-        val dumpFile = if (manifest?.compiler?.emitIr != null) File(manifest.compiler.emitIr) else null
-        if (dumpFile?.exists() ?: false) {
-            dumpFile.delete()
-        }
-        dumpFile?.createNewFile()
-        val compilationUnit = CompilationUnit()
-        for (sourceFile in sources) {
-            dumpSB?.appendLine("----------- '$sourceFile' / ${sources.size} -----------")
-            val file = File(sourceFile)
-            val preprocessor = KiraPreprocessor(file.readText())
-            val preprocessingResult = preprocessor.process()
-            var srcContext = compilationUnit.addSource(
-                file.canonicalPath,
-                preprocessingResult.processedContent,
-                emptyList()
-            )
-            val (_, duration) = measureTimedValue {
-                val lexer = KiraLexer(srcContext)
-                val tokens = lexer.tokenize()
-                srcContext = compilationUnit.addSource(
+        val dumpFile = manifest?.compiler?.emitIr?.let { projectRoot.resolve(it).toFile() }
+        // one writer for the whole dump rather than reopening the file per section
+        val dumpWriter = dumpFile?.bufferedWriter()
+        // The IR dump wants live lexer/parser output, so only plain builds use the cache.
+        val cache = if (dumpSB == null) FrontendCache.forProject(projectRoot, session) else null
+        val compilationUnit = CompilationUnit(session)
+        if (dumpSB == null) {
+            // Files are independent until the analyzer, so they are parsed
+            // --jobs at a time; logs and failures still come out in source order.
+            val parsed = FrontendService.parseAll(
+                compilationUnit,
+                sources.map { File(it).canonicalPath },
+                cache
+            ) { path -> File(path).readText() }
+            parsed.forEach { result ->
+                result.failure?.let { throw it }
+                val name = File(result.path).name
+                Diagnostics.Logging.info(
+                    "Kira", when (result.origin) {
+                        FrontendService.ParsedFile.Origin.PARSED -> "Parsed $name in ${result.duration}"
+                        FrontendService.ParsedFile.Origin.CACHED -> "Loaded $name from cache in ${result.duration}"
+                        FrontendService.ParsedFile.Origin.PREBUILT -> "Reused prebuilt $name (stdlib bootstrap or snapshot)"
+                        FrontendService.ParsedFile.Origin.RETAINED -> "Reused $name from the workspace"
+                    }
+                )
+            }
+        } else {
+            for (sourceFile in sources) {
+                dumpSB.appendLine("----------- '$sourceFile' / ${sources.size} -----------")
+                val file = File(sourceFile)
+                val rawText = file.readText()
+                var srcContext = compilationUnit.addSource(
                     file.canonicalPath,
-                    srcContext.content,
-                    tokens
+                    rawText,
+                    emptyList()
                 )
-                if (dumpSB != null) {
-                    var i = 0
-                    dumpSB.appendLine("    ############### Lexer Tokens '$sourceFile' ###############")
-                    dumpSB.appendLine(srcContext.tokens.joinToString("\n") { tk ->
-                        "    ${
-                            (++i).toString().padStart(
-                                length = floor(log10(srcContext.tokens.size.toDouble())).toInt() + 1,
-                                padChar = ' '
-                            )
-                        }: $tk"
-                    })
-                    dumpFile!!.appendText(dumpSB.toString())
-                    dumpSB.clear() // save on memory (so not everything is in dumpSB): problematic for large projects
+                val (_, duration) = measureTimedValue {
+                    val lexer = KiraLexer(srcContext, compilationUnit.identifiers)
+                    val tokens = session.traced("lex", file.canonicalPath) { lexer.tokenize() }
+                    srcContext = compilationUnit.addSource(
+                        file.canonicalPath,
+                        srcContext.content,
+                        tokens
+                    )
+                    if (dumpSB != null) {
+                        var i = 0
+                        dumpSB.appendLine("    ############### Lexer Tokens '$sourceFile' ###############")
+                        dumpSB.appendLine(srcContext.tokens.joinToString("\n") { tk ->
+                            "    ${
+                                (++i).toString().padStart(
+                                    length = floor(log10(srcContext.tokens.size.toDouble())).toInt() + 1,
+                                    padChar = ' '
+                                )
+                            }: $tk"
+                        })
+                        dumpWriter!!.append(dumpSB)
+                        dumpSB.clear() // save on memory (so not everything is in dumpSB): problematic for large projects
+                    }
+                    val lexed = srcContext
+                    session.traced("parse", file.canonicalPath) { KiraSourceParsers.from(lexed).parse() }
                 }
-                KiraSourceParsers.from(srcContext).parse()
-
-            }
-            Diagnostics.Logging.info("Kira", "Parsed ${file.name} in $duration")
-            if (dumpSB != null) {
-                dumpSB.appendLine("    ############### AST XML '$sourceFile' ###############")
-                dumpSB.appendLine(
-                    XMLASTVisitorKira.build(srcContext.ast).split("\n").joinToString("\n") { "    $it" })
-                dumpFile!!.appendText(dumpSB.toString())
-                dumpSB.clear()
-                dumpSB.appendLine("    ############### AST -> SRC MAP '$sourceFile' ###############")
-                dumpSB.appendLine("\tTotal Sources: ${compilationUnit.getSourcesLength()}")
-                compilationUnit.allSources().forEach {
-                    it.astOrigins.entries.sortedBy { entry -> entry.value }.forEach { element ->
-                        dumpSB.appendLine("        ${element.value.lineNumber}, ${element.value.column} : ${element.key}")
+                Diagnostics.Logging.info("Kira", "Parsed ${file.name} in $duration")
+                if (dumpSB != null) {
+                    dumpSB.appendLine("    ############### AST XML '$sourceFile' ###############")
+                    dumpSB.appendLine(
+                        XMLASTVisitorKira.build(srcContext.ast).split("\n").joinToString("\n") { "    $it" })
+                    dumpWriter!!.append(dumpSB)
+                    dumpSB.clear()
+                    dumpSB.appendLine("    ############### AST -> SRC MAP '$sourceFile' ###############")
+                    dumpSB.appendLine("\tTotal Sources: ${compilationUnit.getSourcesLength()}")
+                    compilationUnit.allSources().forEach {
+                        positionedNodes(it.ast).sortedBy { node -> node.packedOrigin }.forEach { node ->
+                            val origin = it.relativeOriginOf(node)
+                            dumpSB.appendLine("        ${origin.lineNumber}, ${origin.column} : $node")
+                        }
                     }
+                    dumpWriter.append(dumpSB)
+                    dumpSB.clear()
                 }
-                dumpFile.appendText(dumpSB.toString())
-                dumpSB.clear()
             }
         }
 
         // Semantics before any backend emit so bad programs do not produce half-written C.
-        val semanticAnalyzer = KiraSemanticAnalyzer(compilationUnit)
-        val semanticAnalyzerResults = semanticAnalyzer.validateAST()
-        val diagnosticCount = semanticAnalyzerResults.diagnostics.size
+        // A unit whose every file matches the last clean build analyzes the same way.
+        val unitKey = cache?.unitKey()
+        val semanticSummary = unitKey?.let { cache?.loadSemantic(it) }
+        val semanticDiagnostics = if (semanticSummary != null) {
+            session.traced("semantic replay") { semanticSummary.replayInto(compilationUnit) }
+            Diagnostics.Logging.info("Kira", "Sources unchanged since the last clean build; reusing its semantic pass.")
+            emptyList<DiagnosticsException>()
+        } else {
+            session.traced("semantic") { KiraSemanticAnalyzer(compilationUnit, session.jobs).validateAST() }.diagnostics
+        }
+        val diagnosticCount = semanticDiagnostics.size
+        if (cache != null && unitKey != null) {
+            if (semanticSummary == null && diagnosticCount == 0) {
+                cache.storeSemantic(unitKey, FrontendCache.SemanticSummary.of(compilationUnit))
+            }
+            cache.prune(unitKey)
+        }
         if (diagnosticCount > 0) {
             repeat(diagnosticCount) {
                 Diagnostics.Logging.warn(
                     "Kira",
                     "\n-- Diagnostic Report #${it + 1} ${
                         Diagnostics.recordDiagnostics(
-                            semanticAnalyzerResults.diagnostics[it]
+                            semanticDiagnostics[it]
                         )
                     }"
                 )
@@ -259,34 +457,75 @@ fun main(args: Array<String>) {
                 }
             }
             dumpSB.appendLine("----------- End Dump File -----------")
-            dumpFile!!.appendText(dumpSB.toString())
+            dumpWriter!!.append(dumpSB)
+            dumpWriter.close()
             dumpSB.clear()
-            Diagnostics.Logging.info("Kira", "Dumped processed symbols to ${dumpFile.path}.")
+            Diagnostics.Logging.info("Kira", "Dumped processed symbols to ${dumpFile!!.path}.")
         }
 
         // Backend emit only after a clean semantic pass.
         if (diagnosticCount == 0) {
-            when (GeneratedProvider.outputMode) {
+            when (session.outputMode) {
                 GeneratedProvider.OutputTarget.C -> {
                     val out = KiraCCodeGenerator.DEFAULT_OUTPUT
                     Diagnostics.Logging.info("Kira", "Emitting C -> $out")
-                    KiraCCodeGenerator(compilationUnit).generate(out)
-                    val cSources = manifest?.build?.cSources.orEmpty()
-                    val linkFlags = manifest?.build?.linkFlags.orEmpty()
-                    val extras = buildString {
-                        cSources.forEach { append(' ').append(it) }
-                        linkFlags.forEach { append(' ').append(it) }
+                    KiraCCodeGenerator(compilationUnit).generate(projectRoot.resolve(out).toString())
+                    val buildOptions = manifest?.build ?: BuildOptions()
+                    if (command != null) {
+                        // profiling an unoptimized build would be pointless, so --pgo defaults to release
+                        val nativeProfile = profile ?: if (pgo) NativeBuild.Profile.RELEASE else NativeBuild.Profile.DEBUG
+                        val compiler = ccOverride ?: buildOptions.cc
+                        val built = if (pgo) {
+                            NativeBuild.buildWithProfile(
+                                projectRoot,
+                                projectRoot.resolve(out),
+                                buildOptions,
+                                nativeProfile,
+                                compiler,
+                                environment,
+                            )
+                        } else {
+                            NativeBuild.build(
+                                projectRoot,
+                                projectRoot.resolve(out),
+                                buildOptions,
+                                nativeProfile,
+                                compiler,
+                                session.useIncrementalCache,
+                                environment,
+                            )
+                        }
+                        if (built == null) {
+                            nativeFailed = true
+                            Diagnostics.Logging.warn("Kira", "The C compiler failed; see its output above.")
+                        } else if (built.reused) {
+                            Diagnostics.Logging.info("Kira", "C unchanged; reused the cached ${built.binary.fileName}.")
+                        } else {
+                            val kind = nativeProfile.name.lowercase() + if (pgo) ", profile-guided" else ""
+                            Diagnostics.Logging.info("Kira", "Built ${built.binary.fileName} ($kind).")
+                        }
+                    } else {
+                        val extras = buildString {
+                            buildOptions.cSources.forEach { append(' ').append(it) }
+                            buildOptions.linkFlags.forEach { append(' ').append(it) }
+                        }
+                        Diagnostics.Logging.info(
+                            "Kira",
+                            "Done. Compile with: cc -std=c17 -O2 -o app $out$extras && ./app (or run kira build)"
+                        )
+                    }
+                    if (session.instrument) {
+                        Diagnostics.Logging.info(
+                            "Kira",
+                            "Instrumented: ./app writes its profile to \$KIRA_PROFILE (default kira.profile.txt)."
+                        )
                     }
-                    Diagnostics.Logging.info(
-                        "Kira",
-                        "Done. Compile with: cc -std=c17 -O2 -o app $out$extras && ./app"
-                    )
                 }
 
                 GeneratedProvider.OutputTarget.JS -> {
                     val out = KiraJSCodeGenerator.DEFAULT_OUTPUT
                     Diagnostics.Logging.info("Kira", "Emitting JS -> $out")
-                    KiraJSCodeGenerator(compilationUnit).generate(out)
+                    KiraJSCodeGenerator(compilationUnit).generate(projectRoot.resolve(out).toString())
                     Diagnostics.Logging.info(
                         "Kira",
                         "Done. Run with: node $out"
@@ -307,9 +546,17 @@ fun main(args: Array<String>) {
         diagnosticCount
     }
     Diagnostics.Logging.info("Kira", "Everything took ${result.duration}")
-    if (result.value > 0) {
-        kotlin.system.exitProcess(1)
+    trace?.let { recorded ->
+        if (timePasses) {
+            Diagnostics.Logging.info("Kira", "Time per pass:\n${recorded.report()}")
+        }
+        traceFile?.let { name ->
+            val output = workingDirectory.resolve(name)
+            Files.newBufferedWriter(output).use { recorded.writeChromeTrace(it) }
+            Diagnostics.Logging.info("Kira", "Wrote trace to $output (open in chrome://tracing or ui.perfetto.dev)")
+        }
     }
+    return if (result.value > 0 || nativeFailed) 1 else 0
 }
 
 
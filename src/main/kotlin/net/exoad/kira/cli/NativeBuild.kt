@@ -0,0 +1,382 @@
+package net.exoad.kira.cli
+
+import net.exoad.kira.compiler.analysis.diagnostics.Diagnostics
+import net.exoad.kira.kim.BuildOptions
+import java.io.File
+import java.io.IOException
+import java.nio.file.Files
+import java.nio.file.Path
+import java.nio.file.StandardCopyOption
+import java.nio.file.attribute.FileTime
+import java.security.MessageDigest
+import java.util.concurrent.ConcurrentHashMap
+import kotlin.io.path.isDirectory
+import kotlin.io.path.isRegularFile
+import kotlin.io.path.listDirectoryEntries
+
+/**
+ * The `cc` step of `kira build` and `kira run`: compile the emitted C
+ * together with `build.cSources` and `build.linkFlags` under a [Profile],
+ * leaving the program at [BINARY] in the project root.
+ *
+ * Binaries are kept in `.kira/bin`, keyed by a SHA-256 of the compiler
+ * command, which compiler that is (its resolved path and `--version`
+ * banner), the emitted C, the bytes of every extra source, the project
+ * headers they include (`cc -MM`) and the libraries `build.linkFlags` names
+ * by path or through `-L`/`-l`. Rebuilding a
+ * program whose C did not change copies the earlier binary back instead of
+ * running `cc` again, which is most of an edit-run cycle on an unchanged
+ * program. Only the [KEPT_BINARIES] most recently used entries are kept.
+ *
+ * `--pgo` builds go through [buildWithProfile] instead.
+ *
+ * Every process started here (`cc`, the training command, `llvm-profdata`)
+ * gets the `environment` it is handed rather than this JVM's, so a build the
+ * [CompilerDaemon] runs for a client sees the client's `PATH`, `CC`-style
+ * toolchain variables and `SDKROOT`, not whatever the daemon started with.
+ */
+object NativeBuild {
+    enum class Profile(val flags: List<String>) {
+        DEBUG(listOf("-O0", "-g")),
+        RELEASE(listOf("-O2", "-flto")),
+        SIZE(listOf("-Os", "-flto"));
+
+        companion object {
+            fun parse(name: String): Profile {
+                return entries.firstOrNull { it.name.equals(name, ignoreCase = true) }
+                    ?: Diagnostics.panic("Unknown build profile '$name' (expected debug, release, size)")
+            }
+        }
+    }
+
+    /** `-o` of every build; `kira run` executes this. */
+    const val BINARY = "app"
+
+    /** Bump when the key stops covering something that changes the binary. */
+    private const val FORMAT = 2
+    private const val KEPT_BINARIES = 8
+    private const val KEPT_PROFILES = 4
+    private val LIBRARY_SUFFIXES = listOf(".so", ".dylib", ".a", ".lib")
+
+    /** `--version` output per compiler binary, its path, size and modification time; a daemon asks once per compiler. */
+    private val banners = ConcurrentHashMap<String, String>()
+
+    class Result(val binary: Path, val reused: Boolean)
+
+    /** The `cc` command line of one build, minus its output and any PGO flags. */
+    private class Invocation(
+        val projectRoot: Path,
+        val emittedC: Path,
+        val options: BuildOptions,
+        val profile: Profile,
+        val compiler: String,
+        val environment: Map<String, String>,
+    ) {
+        val extraSources = options.cSources.map { projectRoot.resolve(it).normalize() }
+
+        fun command(output: Path, extraFlags: List<String> = emptyList()): List<String> {
+            return listOf(compiler, "-std=c17") + profile.flags + extraFlags +
+                listOf("-o", output.toString(), emittedC.toString()) +
+                extraSources.map { it.toString() } + options.linkFlags
+        }
+
+        /** SHA-256 of [salt] and everything [command] compiles. */
+        fun key(vararg salt: String): String {
+            val digest = MessageDigest.getInstance("SHA-256")
+            fun part(bytes: ByteArray) {
+                digest.update(bytes)
+                digest.update(0.toByte())
+            }
+            part("kira-native/$FORMAT".toByteArray())
+            salt.forEach { part(it.toByteArray()) }
+            command(Path.of(BINARY)).forEach { part(it.toByteArray()) }
+            // the same command line means a different binary once cc itself changes
+            val resolved = executable(compiler, environment)
+            part(resolved.toByteArray())
+            part(compilerBanner(resolved, environment).toByteArray())
+            part(Files.readAllBytes(emittedC))
+            extraSources.forEach { source ->
+                // a missing extra source is cc's error to report, not a cache key problem
+                part(if (source.isRegularFile()) Files.readAllBytes(source) else ByteArray(0))
+            }
+            (headers() + libraries()).forEach { file ->
+                part(file.toString().toByteArray())
+                part(Files.readAllBytes(file))
+            }
+            return digest.digest().joinToString("") { "%02x".format(it) }
+        }
+
+        /**
+         * Project headers the emitted C and the extra `.c` sources include,
+         * as `cc -MM` lists them (system headers are left to the compiler's
+         * banner). Empty when that fails; the compile will then fail too and
+         * nothing is cached.
+         */
+        private fun headers(): List<Path> {
+            val sources = listOf(emittedC) + extraSources.filter { it.toString().endsWith(".c") && it.isRegularFile() }
+            val rules = try {
+                val process = process(listOf(compiler, "-std=c17", "-MM") + sources.map { it.toString() }, environment)
+                    .directory(projectRoot.toFile())
+                    .redirectError(ProcessBuilder.Redirect.DISCARD)
+                    .start()
+                val text = process.inputStream.bufferedReader().readText()
+                if (process.waitFor() != 0) return emptyList()
+                text
+            } catch (_: IOException) {
+                return emptyList()
+            }
+            // `out.o: out.c a.h \` continuation lines; spaces inside a path are escaped
+            return rules.replace("\\\n", " ")
+                .split(Regex("""(?<!\\)\s+"""))
+                .filter { it.isNotEmpty() && !it.endsWith(":") }
+                .map { projectRoot.resolve(it.replace("\\ ", " ")).normalize() }
+                .filter { it !in sources && it.isRegularFile() }
+                .distinct()
+                .sorted()
+        }
+
+        /** Library files `build.linkFlags` links: given as a path, or `-lname` found in one of its `-L` directories. */
+        private fun libraries(): List<Path> {
+            val flags = options.linkFlags
+            val directories = flags.indices.mapNotNull { i ->
+                when {
+                    flags[i] == "-L" -> flags.getOrNull(i + 1)
+                    flags[i].startsWith("-L") -> flags[i].substring(2)
+                    else -> null
+                }
+            }.map { projectRoot.resolve(it).normalize() }
+            return flags.flatMap { flag ->
+                when {
+                    flag.startsWith("-l") && flag.length > 2 -> {
+                        val name = flag.substring(2)
+                        directories.flatMap { directory ->
+                            LIBRARY_SUFFIXES.map { directory.resolve("lib$name$it") }
+                        }.filter { it.isRegularFile() }.take(1)
+                    }
+
+                    !flag.startsWith("-") -> listOf(projectRoot.resolve(flag).normalize()).filter { it.isRegularFile() }
+                    else -> emptyList()
+                }
+            }.distinct()
+        }
+    }
+
+    /**
+     * Compile [emittedC] in [projectRoot] with [compiler]. Null when `cc`
+     * failed; its output has gone to `System.err` either way. [useCache]
+     * false (`--no-cache`) always runs `cc` and leaves `.kira/bin` alone.
+     */
+    fun build(
+        projectRoot: Path,
+        emittedC: Path,
+        options: BuildOptions,
+        profile: Profile,
+        compiler: String,
+        useCache: Boolean = true,
+        environment: Map<String, String> = System.getenv(),
+    ): Result? {
+        val invocation = Invocation(projectRoot, emittedC, options, profile, compiler, environment)
+        val binary = projectRoot.resolve(BINARY)
+        if (!useCache) {
+            return if (runCompiler(invocation.command(binary), projectRoot, environment)) Result(binary, false) else null
+        }
+        val cacheDir = projectRoot.resolve(".kira").resolve("bin")
+        val cached = cacheDir.resolve(invocation.key())
+        if (cached.isRegularFile()) {
+            touch(cached)
+            install(cached, binary)
+            return Result(binary, true)
+        }
+        Files.createDirectories(cacheDir)
+        val temp = Files.createTempFile(cacheDir, "cc-", ".tmp")
+        try {
+            if (!runCompiler(invocation.command(temp), projectRoot, environment)) {
+                return null
+            }
+            Files.move(temp, cached, StandardCopyOption.REPLACE_EXISTING)
+        } finally {
+            Files.deleteIfExists(temp)
+        }
+        prune(cacheDir, KEPT_BINARIES)
+        install(cached, binary)
+        return Result(binary, false)
+    }
+
+    /**
+     * `kira build --pgo`: compile with `-fprofile-generate`, run
+     * `build.pgo.train` against that binary, then compile again with
+     * `-fprofile-use`.
+     *
+     * The profile and the optimized binary live in `.kira/pgo/<key>`, where
+     * the key covers the same inputs as the binary cache plus the training
+     * command. Changed C gets a fresh profile rather than a stale one; an
+     * unchanged build reuses the optimized binary without training again.
+     * Both compiles write the same `-o` path, since gcc looks its `.gcda`
+     * files up by the name of the object they were recorded for. Clang's raw
+     * profiles are merged with `llvm-profdata` in between.
+     */
+    fun buildWithProfile(
+        projectRoot: Path,
+        emittedC: Path,
+        options: BuildOptions,
+        profile: Profile,
+        compiler: String,
+        environment: Map<String, String> = System.getenv(),
+    ): Result? {
+        val train = options.pgo.train
+            ?: Diagnostics.panic("kira build --pgo needs a training command in kira.yaml (build.pgo.train)")
+        val invocation = Invocation(projectRoot, emittedC, options, profile, compiler, environment)
+        val binary = projectRoot.resolve(BINARY)
+        val pgoRoot = projectRoot.resolve(".kira").resolve("pgo")
+        val stage = pgoRoot.resolve(invocation.key("pgo", train))
+        val output = stage.resolve(BINARY)
+        val data = stage.resolve("data")
+        val optimized = stage.resolve("optimized")
+        if (optimized.isRegularFile() && output.isRegularFile()) {
+            touch(stage)
+            install(output, binary)
+            return Result(binary, true)
+        }
+        // a stage left behind by an interrupted build holds a partial profile
+        stage.toFile().deleteRecursively()
+        Files.createDirectories(data)
+
+        Diagnostics.Logging.info("Kira", "PGO 1/3: instrumented build")
+        if (!runCompiler(invocation.command(output, listOf("-fprofile-generate=$data")), projectRoot, environment)) {
+            return null
+        }
+        install(output, binary)
+
+        Diagnostics.Logging.info("Kira", "PGO 2/3: training with '$train'")
+        if (!runLogged(shell(train), projectRoot, environment)) {
+            Diagnostics.Logging.warn("Kira", "The PGO training command failed.")
+            return null
+        }
+        val profileFlag = if ("clang" in compilerBanner(executable(compiler, environment), environment)) {
+            val merged = stage.resolve("kira.profdata")
+            val raw = data.listDirectoryEntries("*.profraw").map { it.toString() }
+            val merge = profdataTool(environment) + listOf("merge", "-output=$merged") + raw
+            if (raw.isEmpty() || !runLogged(merge, projectRoot, environment)) {
+                Diagnostics.Logging.warn("Kira", "Training left no profile to merge.")
+                return null
+            }
+            "-fprofile-use=$merged"
+        } else {
+            "-fprofile-use=$data"
+        }
+
+        Diagnostics.Logging.info("Kira", "PGO 3/3: optimized build")
+        if (!runCompiler(invocation.command(output, listOf(profileFlag)), projectRoot, environment)) {
+            return null
+        }
+        Files.writeString(optimized, train)
+        prune(pgoRoot, KEPT_PROFILES)
+        install(output, binary)
+        return Result(binary, false)
+    }
+
+    /** `kira run`: the built [binary] with [args], sharing this process's terminal. */
+    fun run(binary: Path, args: List<String>): Int {
+        val process = ProcessBuilder(listOf(binary.toString()) + args)
+            .directory(binary.parent.toFile())
+            .inheritIO()
+            .start()
+        return process.waitFor()
+    }
+
+    private fun install(from: Path, binary: Path) {
+        Files.copy(from, binary, StandardCopyOption.REPLACE_EXISTING, StandardCopyOption.COPY_ATTRIBUTES)
+    }
+
+    private fun touch(path: Path) {
+        Files.setLastModifiedTime(path, FileTime.fromMillis(System.currentTimeMillis()))
+    }
+
+    private fun isWindows(): Boolean = System.getProperty("os.name").startsWith("Windows")
+
+    private fun shell(command: String): List<String> {
+        return if (isWindows()) listOf("cmd", "/c", command) else listOf("sh", "-c", command)
+    }
+
+    /** What [compiler] (already resolved by [executable]) prints for `--version`; empty when it does not run. */
+    private fun compilerBanner(compiler: String, environment: Map<String, String>): String {
+        val file = File(compiler)
+        return banners.computeIfAbsent("$compiler:${file.length()}:${file.lastModified()}") {
+            try {
+                val process = process(listOf(compiler, "--version"), environment).redirectErrorStream(true).start()
+                val banner = process.inputStream.bufferedReader().readText()
+                process.waitFor()
+                banner
+            } catch (_: IOException) {
+                ""
+            }
+        }
+    }
+
+    /** `llvm-profdata`, or Xcode's copy when that is the only one installed. */
+    private fun profdataTool(environment: Map<String, String>): List<String> {
+        val onPath = environment["PATH"].orEmpty().split(File.pathSeparator)
+            .any { it.isNotEmpty() && Files.isExecutable(Path.of(it, "llvm-profdata")) }
+        return if (onPath || !System.getProperty("os.name").startsWith("Mac")) {
+            listOf("llvm-profdata")
+        } else {
+            listOf("xcrun", "llvm-profdata")
+        }
+    }
+
+    private fun runCompiler(command: List<String>, workingDirectory: Path, environment: Map<String, String>): Boolean {
+        return try {
+            runLogged(command, workingDirectory, environment)
+        } catch (e: IOException) {
+            Diagnostics.panic("Could not start C compiler '${command.first()}': ${e.message}")
+        }
+    }
+
+    private fun runLogged(command: List<String>, workingDirectory: Path, environment: Map<String, String>): Boolean {
+        Diagnostics.Logging.info("Kira", "Running ${command.joinToString(" ")}")
+        val process = process(command, environment)
+            .directory(workingDirectory.toFile())
+            .redirectErrorStream(true)
+            .start()
+        // through System.err rather than inherited, so a daemon build hands it to the client
+        process.inputStream.copyTo(System.err)
+        System.err.flush()
+        return process.waitFor() == 0
+    }
+
+    /**
+     * A [ProcessBuilder] for [command] that sees exactly [environment]. The
+     * JVM looks a bare program name up on its own `PATH`, not the child's,
+     * so that is resolved here first.
+     */
+    private fun process(command: List<String>, environment: Map<String, String>): ProcessBuilder {
+        val builder = ProcessBuilder(listOf(executable(command.first(), environment)) + command.drop(1))
+        builder.environment().apply {
+            clear()
+            putAll(environment)
+        }
+        return builder
+    }
+
+    /** [program] found on [environment]'s `PATH`, or [program] as given when it is a path or is not found there. */
+    private fun executable(program: String, environment: Map<String, String>): String {
+        if (program.contains('/') || program.contains(File.separatorChar)) {
+            return program
+        }
+        val names = if (isWindows()) listOf("$program.exe", program) else listOf(program)
+        return environment["PATH"].orEmpty().split(File.pathSeparator)
+            .filter { it.isNotEmpty() }
+            .flatMap { directory -> names.map { Path.of(directory, it) } }
+            .firstOrNull { Files.isRegularFile(it) && Files.isExecutable(it) }
+            ?.toString()
+            ?: program
+    }
+
+    private fun prune(cacheDir: Path, keep: Int) {
+        cacheDir.listDirectoryEntries()
+            .filter { (it.isRegularFile() || it.isDirectory()) && !it.fileName.toString().endsWith(".tmp") }
+            .sortedByDescending { Files.getLastModifiedTime(it) }
+            .drop(keep)
+            .forEach { it.toFile().deleteRecursively() }
+    }
+}
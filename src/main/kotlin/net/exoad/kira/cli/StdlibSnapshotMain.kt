@@ -0,0 +1,18 @@
+package net.exoad.kira.cli
+
+import net.exoad.kira.compiler.StdlibSnapshot
+import java.nio.file.Path
+import kotlin.system.exitProcess
+
+/**
+ * Build-time entrypoint behind the `stdlibSnapshot` Gradle task:
+ * `StdlibSnapshotMainKt <kira stdlib dir> <output file>`.
+ */
+fun main(args: Array<String>) {
+    if (args.size != 2) {
+        System.err.println("usage: StdlibSnapshotMainKt <stdlib-dir> <output>")
+        exitProcess(2)
+    }
+    val written = StdlibSnapshot.write(Path.of(args[0]), Path.of(args[1]))
+    println("Wrote $written stdlib entries to ${args[1]}")
+}
@@ -13,33 +13,57 @@ import net.exoad.kira.compiler.frontend.lexer.KiraLexer
 import net.exoad.kira.compiler.frontend.lexer.Token
 import net.exoad.kira.compiler.frontend.parser.KiraSourceParsers
 import net.exoad.kira.compiler.frontend.parser.LegacyKiraSourceParser
-import net.exoad.kira.compiler.frontend.preprocessor.KiraPreprocessor
+import net.exoad.kira.core.Identifiers
 import net.exoad.kira.source.SourceContext
-import java.io.File
 
-class CompilationUnit {
-    private val sources = mutableMapOf<String, SourceContext>()
+/**
+ * @param session settings this unit is compiled with; the backends read their
+ * options from it.
+ * @param bootstrapStdlib load the session's [CompilerSession.stdlibRoot] up
+ * front (from the session's [FrontendWorkspace] or its [StdlibSnapshot]
+ * when they have the module, otherwise by parsing it). Only the snapshot writer itself turns this off.
+ */
+class CompilationUnit(
+    val session: CompilerSession = CompilerSession(),
+    bootstrapStdlib: Boolean = true,
+) {
+    /**
+     * Insertion-ordered; the analyzer walks modules in this order. Guarded by
+     * its own monitor because [FrontendService] parses files concurrently.
+     */
+    private val sources = linkedMapOf<String, SourceContext>()
+    /** Raw text of each module the bootstrap loaded, so a later request for the same file is free. */
+    private val bootstrappedText = mutableMapOf<String, String>()
     private val magicTypeNames = mutableSetOf<String>()
     /** Foreign opaque class names → C pointer handles (no Kira ARC). */
     private val opaqueTypeNames = mutableSetOf<String>()
     /** Kira function name → C symbol for @_extern stubs. */
     private val externFunctions = linkedMapOf<String, String>()
-    val symbolTable = KiraSymbolTable()
+    /** Names of every module in the unit: its lexers intern into it and [symbolTable] is keyed by it. */
+    val identifiers = Identifiers()
+    val symbolTable = KiraSymbolTable(identifiers)
 
     init {
         try {
-            val kiraRoot = File("kira")
-            if (kiraRoot.exists() && kiraRoot.isDirectory) {
+            val kiraRoot = session.stdlibRoot?.toFile()
+            if (bootstrapStdlib && kiraRoot != null && kiraRoot.isDirectory) {
                 kiraRoot.walkTopDown()
                     .filter { it.isFile && it.extension == "kira" }
                     .forEach { sourceFile ->
-                        val pre = KiraPreprocessor(sourceFile.readText())
-                        val processed = pre.process()
-                        val ctx = addSource(sourceFile.canonicalPath, processed.processedContent, emptyList())
-                        val lexer = KiraLexer(ctx)
-                        val tokens = lexer.tokenize()
-                        addSource(sourceFile.canonicalPath, ctx.content, tokens)
-                        LegacyKiraSourceParser(getSource(sourceFile.canonicalPath)!!).parse()
+                        val path = sourceFile.canonicalPath
+                        val rawText = sourceFile.readText()
+                        val workspace = session.workspace
+                        if (workspace?.install(this, path, rawText) == null) {
+                            if (session.stdlibSnapshot?.installSource(this, path, rawText) != true) {
+                                val ctx = addSource(path, rawText, emptyList())
+                                val lexer = KiraLexer(ctx, identifiers)
+                                val tokens = lexer.tokenize()
+                                addSource(path, ctx.content, tokens)
+                                LegacyKiraSourceParser(getSource(path)!!).parse()
+                            }
+                            workspace?.remember(path, rawText, getSource(path)!!)
+                        }
+                        bootstrappedText[path] = rawText
                     }
             }
         } catch (_: Exception) {
@@ -47,22 +71,61 @@ class CompilationUnit {
         }
     }
 
+    /**
+     * Stand-in for lex / parse of [file]: the context the
+     * bootstrap already built for it, or the session's [StdlibSnapshot] entry for
+     * [rawText]. Null means the caller has to parse.
+     */
+    fun loadPrebuiltSource(file: String, rawText: String): SourceContext? {
+        synchronized(sources) {
+            if (bootstrappedText[file] == rawText) {
+                return sources[file]
+            }
+        }
+        if (session.stdlibSnapshot?.installSource(this, file, rawText) == true) {
+            return getSource(file)
+        }
+        return null
+    }
+
     fun addSource(file: String, content: String, tokens: List<Token>): SourceContext {
         val ctx = SourceContext(content, file, tokens)
-        sources[file] = ctx
+        synchronized(sources) {
+            sources[file] = ctx
+            bootstrappedText.remove(file)
+        }
         return ctx
     }
 
     fun getSource(file: String): SourceContext? {
-        return sources[file]
+        return synchronized(sources) { sources[file] }
     }
 
     fun getSourcesLength(): Int {
-        return sources.size
+        return synchronized(sources) { sources.size }
     }
 
     fun allSources(): Collection<SourceContext> {
-        return sources.values
+        return synchronized(sources) { sources.values.toList() }
+    }
+
+    fun allSourcePaths(): List<String> {
+        return synchronized(sources) { sources.keys.toList() }
+    }
+
+    /**
+     * Put the sources in [order] (paths not loaded are skipped; loaded paths
+     * not listed keep their relative order at the end). Used after a
+     * concurrent parse so the analyzer sees the same order as a serial one.
+     */
+    fun orderSources(order: List<String>) {
+        synchronized(sources) {
+            val reordered = linkedMapOf<String, SourceContext>()
+            order.forEach { path -> sources[path]?.let { reordered[path] = it } }
+            reordered.putAll(sources.filterKeys { it !in reordered })
+            sources.clear()
+            sources.putAll(reordered)
+        }
     }
 
     fun resolveSymbol(name: String): SemanticSymbol? {
@@ -116,7 +179,7 @@ class CompilationUnit {
      *
      * [sourceFilter] narrows the scan to a subset of sources -- useful when a
      * caller needs to know which *file* a magic type came from, since the
-     * `kira/` bootstrap in [CompilationUnit.init] means the stdlib is always
+     * stdlib bootstrap in [CompilationUnit.init] means the stdlib is always
      * present in a unit whether or not the caller asked for it.
      */
     fun collectIntrinsicMarkedTypeNames(
@@ -125,8 +188,8 @@ class CompilationUnit {
     ): Set<String> {
         val collected = mutableSetOf<String>()
         allSources().filter(sourceFilter).forEach { source ->
-            val marks = runCatching { source.astIntrinsicMarked }.getOrNull() ?: return@forEach
-            marks.forEach { (node, intrinsics) ->
+            source.intrinsified.forEach { node ->
+                val intrinsics = node.intrinsicMarks ?: return@forEach
                 if (intrinsics.none { it.name == intrinsicName }) {
                     return@forEach
                 }
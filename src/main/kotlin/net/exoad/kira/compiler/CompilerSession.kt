@@ -0,0 +1,104 @@
+package net.exoad.kira.compiler
+
+import net.exoad.kira.compiler.backend.codegen.OutputMinifier
+import net.exoad.kira.compiler.backend.codegen.c.CMagicBindingTable
+import net.exoad.kira.compiler.backend.targets.GeneratedProvider
+import java.nio.file.Files
+import java.nio.file.Path
+import java.util.concurrent.CancellationException
+import java.util.concurrent.ConcurrentHashMap
+
+/**
+ * The settings one compilation runs with: target, output options, which
+ * stdlib it loads and how many threads it may use.
+ *
+ * None of this is process-global. The CLI builds a session from its flags and
+ * the manifest, and the language server and tests build their own, so two
+ * projects can compile side by side in one JVM without seeing each other's
+ * settings. A session is immutable; derive a changed one with [copy].
+ *
+ * It also owns what the backends load from the stdlib on first use (runtime
+ * files, the C magic bindings), since that depends on which stdlib the
+ * session points at. A [copy] starts with those caches empty.
+ */
+data class CompilerSession(
+    val outputMode: GeneratedProvider.OutputTarget = GeneratedProvider.OutputTarget.NONE,
+    /** Minify and obfuscate the user layer of generated C/JS. `--readable` or `build.minify: false` turn it off. */
+    val minifyOutput: Boolean = true,
+    /**
+     * Wrap every user function and method in entry/exit probes and link the
+     * prelude profiler (`KIRA_INSTRUMENT`). Set via `--instrument`; ignored by
+     * the JS backend.
+     */
+    val instrument: Boolean = false,
+    /** Read and write the `.kira/cache` [FrontendCache]; `--no-cache` turns it off. */
+    val useIncrementalCache: Boolean = true,
+    /** Worker threads for parsing and for checking function bodies; `kira --jobs N` sets it. */
+    val jobs: Int = Runtime.getRuntime().availableProcessors(),
+    /** Stdlib `.kira` files, resolved from the manifest's `kira:` dependencies. */
+    val stdlibSources: List<String> = emptyList(),
+    /**
+     * The `kira/` folder [CompilationUnit] bootstraps before anything else,
+     * and the fallback runtime directory when [stdlibSources] is empty.
+     * Defaults to the one in the working directory the session was made in.
+     */
+    val stdlibRoot: Path? = workingDirectoryStdlib(),
+    /**
+     * Prebuilt stdlib parses, bindings and prelude identifiers, consulted
+     * before parsing any of them. Defaults to the snapshot shipped next to
+     * the compiler jar; null parses everything (tests pass their own).
+     */
+    val stdlibSnapshot: StdlibSnapshot? = StdlibSnapshot.shipped(),
+    /** Where phases record their timings (`--time-passes`, `--trace`); null when nobody asked. */
+    val trace: PassTrace? = null,
+    /** Parse results and the last verdict kept between compilations; the language server sets one per workspace. */
+    val workspace: FrontendWorkspace? = null,
+    /**
+     * Polled at every [traced] phase; once it returns true the compilation
+     * stops with a [CancellationException]. The language server sets it so
+     * a newer edit abandons a run that has gone stale.
+     */
+    val cancelled: (() -> Boolean)? = null,
+) {
+    private val runtimeTexts = ConcurrentHashMap<String, String>()
+    private val runtimeIdentifiers = ConcurrentHashMap<String, Set<String>>()
+
+    /** `*.bind.yaml` bindings of the stdlib this session loads. */
+    val magicBindings: CMagicBindingTable by lazy { CMagicBindingTable.load(this) }
+
+    /** Run the phase [name] (of [file], if it is per file), recording it when the session traces. */
+    inline fun <T> traced(name: String, file: String? = null, crossinline block: () -> T): T {
+        checkCancelled()
+        val trace = trace ?: return block()
+        return trace.span(name, file) { block() }
+    }
+
+    fun checkCancelled() {
+        if (cancelled?.invoke() == true) {
+            throw CancellationException("compilation cancelled")
+        }
+    }
+
+    /** [load] once per session and [name]; backends read their runtime files through this. */
+    fun runtimeText(name: String, load: () -> String): String {
+        return runtimeTexts.computeIfAbsent(name) { load() }
+    }
+
+    /**
+     * Identifiers of the runtime file [name] read as [text], which the
+     * minifier reserves. Taken from the stdlib snapshot when it has them,
+     * otherwise scanned for once per session.
+     */
+    fun runtimeIdentifiers(name: String, text: String): Set<String> {
+        return runtimeIdentifiers.computeIfAbsent(name) {
+            stdlibSnapshot?.identifiersOrNull(text) ?: OutputMinifier.extractIdentifiers(text)
+        }
+    }
+
+    companion object {
+        fun workingDirectoryStdlib(): Path? {
+            val root = Path.of("kira").toAbsolutePath().normalize()
+            return if (Files.isDirectory(root)) root else null
+        }
+    }
+}
@@ -0,0 +1,317 @@
+package net.exoad.kira.compiler
+
+import net.exoad.kira.compiler.analysis.semantic.BodyVerdicts
+import net.exoad.kira.compiler.frontend.lexer.Token
+import net.exoad.kira.compiler.frontend.lexer.TokenStream
+import net.exoad.kira.compiler.frontend.parser.ast.ASTNode
+import net.exoad.kira.compiler.frontend.parser.ast.RootASTNode
+import net.exoad.kira.source.SourceContext
+import java.io.BufferedInputStream
+import java.io.BufferedOutputStream
+import java.io.File
+import java.io.ObjectInputStream
+import java.io.ObjectOutputStream
+import java.io.Serializable
+import java.nio.file.AtomicMoveNotSupportedException
+import java.nio.file.Files
+import java.nio.file.Path
+import java.nio.file.StandardCopyOption
+import java.nio.file.attribute.FileTime
+import java.security.MessageDigest
+import java.time.Duration
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.atomic.AtomicInteger
+
+/**
+ * Persistent incremental cache for the frontend, stored under
+ * `<project>/.kira/cache`.
+ *
+ * **Per file:** what lexing and parsing produce for one source -- the
+ * text, the token stream and the AST, which carries its own positions and
+ * intrinsic markers, plus [SourceContext.intrinsified]. The
+ * key is a SHA-256 over the compiler fingerprint, the canonical path and the
+ * raw file text. Parsing never looks at another file, so an edit invalidates
+ * exactly one entry.
+ *
+ * **Per unit:** the analyzer walks every module through one shared scope
+ * stack, so its result is cached for the whole unit. The key combines every
+ * file key. Only clean runs are recorded, together with what the analyzer
+ * registers on the [CompilationUnit] (magic / opaque types, extern
+ * bindings). A no-op rebuild then replays those instead of re-analyzing.
+ *
+ * **Per module:** when the unit did change, [bodyVerdicts] lets the analyzer
+ * skip the function bodies of every module that checked clean last time. The
+ * key is the module's file key plus what the declaration pass saw across the
+ * unit, so an edit inside a body re-checks only that module's bodies.
+ *
+ * Entries are plain Java serialization written through a temp file and an
+ * atomic rename, so a concurrent CLI build and language server never see a
+ * torn entry. A corrupt or incompatible entry is treated as a miss and
+ * deleted. A hit refreshes the entry's modification time, which is what
+ * [prune] ages entries by.
+ */
+class FrontendCache(val directory: Path) {
+    /**
+     * Everything lex / parse leave on one [SourceContext]. Also the [StdlibSnapshot] entry.
+     * The [TokenStream] slices [content] and does not store it again; it gets it back on load.
+     */
+    internal class ParsedSource(
+        val content: String,
+        val tokens: List<Token>,
+        val ast: RootASTNode,
+        val intrinsified: List<ASTNode>,
+    ) : Serializable {
+        private fun readResolve(): Any {
+            (tokens as? TokenStream)?.attachSource(content)
+            return this
+        }
+
+        fun installInto(compilationUnit: CompilationUnit, path: String): SourceContext {
+            val ctx = compilationUnit.addSource(path, content, tokens)
+            ctx.ast = ast
+            ctx.intrinsified.addAll(intrinsified)
+            return ctx
+        }
+
+        companion object {
+            fun of(ctx: SourceContext): ParsedSource {
+                return ParsedSource(ctx.content, ctx.tokens, ctx.ast, ArrayList(ctx.intrinsified))
+            }
+        }
+    }
+
+    /** What a clean semantic pass left on the [CompilationUnit], besides the symbol table. */
+    class SemanticSummary(
+        val magicTypes: Set<String>,
+        val opaqueTypes: Set<String>,
+        val externFunctions: Map<String, String>,
+    ) : Serializable {
+        fun replayInto(compilationUnit: CompilationUnit) {
+            magicTypes.forEach { compilationUnit.registerMagicType(it) }
+            opaqueTypes.forEach { compilationUnit.registerOpaqueType(it) }
+            externFunctions.forEach { (kiraName, cName) -> compilationUnit.registerExternFunction(kiraName, cName) }
+        }
+
+        companion object {
+            fun of(compilationUnit: CompilationUnit): SemanticSummary {
+                return SemanticSummary(
+                    compilationUnit.allMagicTypes(),
+                    compilationUnit.allOpaqueTypes(),
+                    compilationUnit.allExternFunctions(),
+                )
+            }
+        }
+    }
+
+    private val hitCount = AtomicInteger()
+    private val missCount = AtomicInteger()
+    val hits: Int get() = hitCount.get()
+    val misses: Int get() = missCount.get()
+
+    private val bodyHitCount = AtomicInteger()
+
+    /** Modules whose bodies the analyzer skipped on a [bodyVerdicts] hit. */
+    val bodyHits: Int get() = bodyHitCount.get()
+
+    /** Every file key looked up through this instance. Files are parsed concurrently, so this is a concurrent set. */
+    private val usedKeys: MutableSet<String> = ConcurrentHashMap.newKeySet()
+
+    /** The key of every path looked up, for [bodyVerdicts]. */
+    private val keysByPath = ConcurrentHashMap<String, String>()
+
+    /** Body verdicts read or written by this instance. */
+    private val usedModuleKeys: MutableSet<String> = ConcurrentHashMap.newKeySet()
+
+    fun keyFor(path: String, rawText: String): String {
+        val key = sha256(fingerprint, path, rawText)
+        usedKeys += key
+        keysByPath[path] = key
+        return key
+    }
+
+    /**
+     * Install the cached parse of [path] into [compilationUnit], or return null
+     * on a miss. The returned context is exactly what a fresh lex / parse would have
+     * registered.
+     */
+    fun loadSource(compilationUnit: CompilationUnit, path: String, key: String): SourceContext? {
+        val parsed = read<ParsedSource>(entryFile(key))
+        if (parsed == null) {
+            missCount.incrementAndGet()
+            return null
+        }
+        hitCount.incrementAndGet()
+        touch(entryFile(key))
+        return parsed.installInto(compilationUnit, path)
+    }
+
+    fun storeSource(key: String, ctx: SourceContext) {
+        write(entryFile(key), ParsedSource.of(ctx))
+    }
+
+    /** Key for the whole unit: every file key seen so far, order-independent. */
+    fun unitKey(): String {
+        return sha256(fingerprint, *usedKeys.sorted().toTypedArray())
+    }
+
+    fun loadSemantic(unitKey: String): SemanticSummary? {
+        val file = unitFile(unitKey)
+        return read<SemanticSummary>(file)?.also { touch(file) }
+    }
+
+    fun storeSemantic(unitKey: String, summary: SemanticSummary) {
+        write(unitFile(unitKey), summary)
+    }
+
+    /**
+     * Per-module verdicts for [net.exoad.kira.compiler.analysis.semantic.KiraSemanticAnalyzer.validateAST]. Only
+     * modules read through [keyFor] have one; the entries hold nothing but the path, for whoever looks.
+     */
+    fun bodyVerdicts(): BodyVerdicts {
+        return object : BodyVerdicts {
+            /** The last declarations seen and their digest; the analyzer passes the same text for every module. */
+            private var digested: Pair<String, String>? = null
+
+            private fun moduleKey(source: SourceContext, declarations: String): String? {
+                val fileKey = keysByPath[source.file] ?: return null
+                val digest = digested?.takeIf { it.first === declarations }?.second
+                    ?: sha256(declarations).also { digested = declarations to it }
+                return sha256(fingerprint, fileKey, digest).also { usedModuleKeys += it }
+            }
+
+            override fun wasClean(source: SourceContext, declarations: String): Boolean {
+                val file = moduleFile(moduleKey(source, declarations) ?: return false)
+                if (read<String>(file) == null) {
+                    return false
+                }
+                bodyHitCount.incrementAndGet()
+                touch(file)
+                return true
+            }
+
+            override fun recordClean(source: SourceContext, declarations: String) {
+                write(moduleFile(moduleKey(source, declarations) ?: return), source.file)
+            }
+        }
+    }
+
+    /**
+     * Drop entries this build did not use and nobody else has used for
+     * [maxAge]: older revisions of edited files, earlier unit verdicts and
+     * body verdicts under declarations that have since changed.
+     * Entries another build still wants -- the saved text of a file whose
+     * buffer is being edited, another checkout of the project -- are recent,
+     * so two builds sharing the directory never evict each other.
+     */
+    fun prune(unitKey: String, maxAge: Duration = STALE_AFTER) {
+        val live = usedKeys.toSet()
+        val liveModules = usedModuleKeys.toSet()
+        val cutoff = System.currentTimeMillis() - maxAge.toMillis()
+        val files = directory.toFile().listFiles() ?: return
+        files.forEach { file ->
+            val used = when (file.extension) {
+                SOURCE_EXTENSION -> file.nameWithoutExtension in live
+                UNIT_EXTENSION -> file.nameWithoutExtension == unitKey
+                MODULE_EXTENSION -> file.nameWithoutExtension in liveModules
+                else -> true
+            }
+            if (!used && file.lastModified() < cutoff) {
+                file.delete()
+            }
+        }
+    }
+
+    private fun entryFile(key: String): Path = directory.resolve("$key.$SOURCE_EXTENSION")
+
+    private fun unitFile(key: String): Path = directory.resolve("$key.$UNIT_EXTENSION")
+
+    private fun moduleFile(key: String): Path = directory.resolve("$key.$MODULE_EXTENSION")
+
+    private fun touch(file: Path) {
+        runCatching { Files.setLastModifiedTime(file, FileTime.fromMillis(System.currentTimeMillis())) }
+    }
+
+    private inline fun <reified T> read(file: Path): T? {
+        if (!Files.isRegularFile(file)) {
+            return null
+        }
+        return try {
+            ObjectInputStream(BufferedInputStream(Files.newInputStream(file))).use { input ->
+                input.readObject() as T
+            }
+        } catch (_: Exception) {
+            // Torn, corrupt, or written by an incompatible build: drop it.
+            runCatching { Files.deleteIfExists(file) }
+            null
+        }
+    }
+
+    private fun write(file: Path, value: Serializable) {
+        try {
+            Files.createDirectories(directory)
+            val temp = Files.createTempFile(directory, "entry", ".tmp")
+            try {
+                ObjectOutputStream(BufferedOutputStream(Files.newOutputStream(temp))).use { output ->
+                    output.writeObject(value)
+                }
+                try {
+                    Files.move(temp, file, StandardCopyOption.ATOMIC_MOVE, StandardCopyOption.REPLACE_EXISTING)
+                } catch (_: AtomicMoveNotSupportedException) {
+                    Files.move(temp, file, StandardCopyOption.REPLACE_EXISTING)
+                }
+            } finally {
+                Files.deleteIfExists(temp)
+            }
+        } catch (_: Exception) {
+            // A cache that cannot be written is just a slower build.
+        }
+    }
+
+    companion object {
+        /** Bump whenever a cached class changes shape in a way serialization would not catch. */
+        private const val FORMAT = 2
+        private const val SOURCE_EXTENSION = "ast"
+        private const val UNIT_EXTENSION = "unit"
+        private const val MODULE_EXTENSION = "body"
+
+        /** How long an entry nobody looked up survives [prune]. */
+        val STALE_AFTER: Duration = Duration.ofDays(1)
+
+        /** `.kira/cache` under [projectRoot], or null when the session has the cache off (`--no-cache`). */
+        fun forProject(projectRoot: Path, session: CompilerSession): FrontendCache? {
+            if (!session.useIncrementalCache) {
+                return null
+            }
+            return FrontendCache(projectRoot.resolve(".kira").resolve("cache"))
+        }
+
+        /**
+         * Identifies the compiler build: the cache format plus the size and
+         * timestamp of the jar (or the newest class file when running from a
+         * build directory), so any rebuilt compiler starts from a clean cache.
+         */
+        val fingerprint: String by lazy {
+            val location = runCatching {
+                File(FrontendCache::class.java.protectionDomain.codeSource.location.toURI())
+            }.getOrNull()
+            val stamp = when {
+                location == null -> "unknown"
+                location.isFile -> "${location.length()}:${location.lastModified()}"
+                else -> location.walkTopDown()
+                    .filter { it.isFile && it.extension == "class" }
+                    .maxOfOrNull { it.lastModified() }
+                    ?.toString() ?: "unknown"
+            }
+            "kira-frontend-cache/$FORMAT/$stamp"
+        }
+
+        internal fun sha256(vararg parts: String): String {
+            val digest = MessageDigest.getInstance("SHA-256")
+            parts.forEach { part ->
+                digest.update(part.toByteArray(Charsets.UTF_8))
+                digest.update(0.toByte())
+            }
+            return digest.digest().joinToString("") { "%02x".format(it) }
+        }
+    }
+}
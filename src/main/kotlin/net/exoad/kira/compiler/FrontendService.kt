@@ -1,12 +1,10 @@
 package net.exoad.kira.compiler
 
-import net.exoad.kira.Public
 import net.exoad.kira.compiler.analysis.diagnostics.DiagnosticsException
 import net.exoad.kira.compiler.analysis.semantic.KiraSemanticAnalyzer
 import net.exoad.kira.compiler.analysis.semantic.SemanticAnalyzerResults
 import net.exoad.kira.compiler.frontend.lexer.KiraLexer
 import net.exoad.kira.compiler.frontend.parser.KiraSourceParsers
-import net.exoad.kira.compiler.frontend.preprocessor.KiraPreprocessor
 import net.exoad.kira.kim.DependencyResolver
 import net.exoad.kira.kim.ManifestLoader
 import net.exoad.kira.kim.ManifestValidator
@@ -14,9 +12,15 @@ import net.exoad.kira.kim.ProjectManifest
 import net.exoad.kira.source.SourceContext
 import net.exoad.kira.source.SourcePosition
 import java.io.File
+import java.io.FileNotFoundException
 import java.nio.file.Files
 import java.nio.file.Path
 import java.nio.file.Paths
+import java.util.concurrent.Callable
+import java.util.concurrent.CancellationException
+import java.util.concurrent.ForkJoinPool
+import kotlin.time.Duration
+import kotlin.time.Duration.Companion.nanoseconds
 
 /**
  * Shared frontend pipeline used by the CLI and the language server.
@@ -51,18 +55,23 @@ object FrontendService {
      * Compile a project rooted at [projectRoot] (directory containing `kira.yaml`
      * or a folder of `.kira` files). [overlays] maps absolute/canonical paths to
      * unsaved buffer text -- used by the language server for open documents.
+     * The stdlib the project resolves replaces [session]'s
+     * [CompilerSession.stdlibSources] for this compilation.
      */
     fun compileProject(
         projectRoot: Path,
         overlays: Map<String, String> = emptyMap(),
+        session: CompilerSession = CompilerSession(),
     ): FrontendResult {
+        session.checkCancelled()
         val root = projectRoot.toAbsolutePath().normalize()
         val diagnostics = mutableListOf<Diagnostic>()
 
         val yamlPath = root.resolve("kira.yaml")
         val manifest: ProjectManifest? = if (Files.exists(yamlPath)) {
             try {
-                val loaded = ManifestLoader.loadFromPath(yamlPath)
+                val loaded = session.workspace?.manifest(Files.readString(yamlPath))
+                    ?: ManifestLoader.loadFromPath(yamlPath)
                 val issues = ManifestValidator.validate(loaded, root)
                 issues.forEach { issue ->
                     diagnostics += Diagnostic(
@@ -93,16 +102,15 @@ object FrontendService {
 
         val stdlib = DependencyResolver.resolveDependencySources(manifest, root).toMutableList()
         if (stdlib.isEmpty()) {
-            // Fall back relative to project, then process cwd.
+            // Fall back relative to project, then the session's stdlib root.
             val local = root.resolve("kira")
             if (Files.isDirectory(local)) {
                 stdlib.addAll(scanKira(local))
             } else {
-                stdlib.addAll(Public.Builtin.discoverLegacyKiraFolder().toList())
+                session.stdlibRoot?.let { stdlib.addAll(scanKira(it)) }
             }
         }
-        Public.Builtin.intrinsicalStandardLibrarySources =
-            stdlib.distinct().sorted().toTypedArray()
+        val projectSession = session.copy(stdlibSources = stdlib.distinct().sorted())
 
         val workspace = DependencyResolver.resolveProjectSources(manifest, root)
         if (workspace.isEmpty() && stdlib.isEmpty()) {
@@ -117,12 +125,27 @@ object FrontendService {
         }
 
         val sources = (stdlib + workspace).distinct().sorted()
-        return compileSources(sources, overlays, root, manifest, diagnostics)
+        return compileSources(
+            sources,
+            overlays,
+            root,
+            manifest,
+            diagnostics,
+            FrontendCache.forProject(root, projectSession),
+            projectSession,
+        )
     }
 
     /**
      * Compile an explicit list of source paths (absolute). Overlays replace
      * disk content when present. Useful for single-file smoke checks.
+     *
+     * With a [cache], unchanged files skip lexing and parsing,
+     * and an unchanged unit that analyzed clean last time skips the analyzer.
+     * In a changed unit, modules whose bodies checked clean under the same
+     * declarations skip the body pass.
+     * The session's [CompilerSession.workspace] does the same in memory, and
+     * also remembers the diagnostics of a unit that did not analyze clean.
      */
     fun compileSources(
         sourcePaths: List<String>,
@@ -130,39 +153,41 @@ object FrontendService {
         projectRoot: Path? = null,
         manifest: ProjectManifest? = null,
         seedDiagnostics: MutableList<Diagnostic> = mutableListOf(),
+        cache: FrontendCache? = null,
+        session: CompilerSession = CompilerSession(),
     ): FrontendResult {
         val diagnostics = seedDiagnostics
-        val compilationUnit = CompilationUnit()
+        val compilationUnit = CompilationUnit(session)
         val overlayByCanonical = overlays.mapKeys { canonicalize(it.key) }
 
-        for (sourcePath in sourcePaths) {
-            val canonical = canonicalize(sourcePath)
-            val text = overlayByCanonical[canonical] ?: readFileOrNull(canonical)
-            if (text == null) {
-                diagnostics += Diagnostic(
-                    file = canonical,
-                    message = "Source file not found: $canonical",
+        // Overlay-only files (e.g. a brand-new unsaved buffer under the
+        // project) are parsed after everything on the disk source list.
+        val canonicalPaths = sourcePaths.map { canonicalize(it) }
+        val known = canonicalPaths.toSet()
+        val overlayOnly = overlayByCanonical.keys.filter { it !in known && it.endsWith(".kira") }
+        val parsed = parseAll(compilationUnit, canonicalPaths + overlayOnly, cache) { path ->
+            overlayByCanonical[path] ?: readFileOrNull(path)
+        }
+        parsed.sortedBy { it.path }.forEach { file ->
+            when (val e = file.failure) {
+                null -> {}
+                is FileNotFoundException -> diagnostics += Diagnostic(
+                    file = file.path,
+                    message = "Source file not found: ${file.path}",
                     tag = "Frontend",
                     start = SourcePosition(1, 1),
                     end = SourcePosition(1, 1),
                 )
-                continue
-            }
-            try {
-                parseOne(compilationUnit, canonical, text)
-            } catch (e: DiagnosticsException) {
-                diagnostics += fromException(e)
-            } catch (e: IllegalStateException) {
-                diagnostics += Diagnostic(
-                    file = canonical,
+                is DiagnosticsException -> diagnostics += fromException(e)
+                is IllegalStateException -> diagnostics += Diagnostic(
+                    file = file.path,
                     message = e.message ?: e.toString(),
                     tag = "Panic",
                     start = SourcePosition(1, 1),
                     end = SourcePosition(1, 1),
                 )
-            } catch (e: Exception) {
-                diagnostics += Diagnostic(
-                    file = canonical,
+                else -> diagnostics += Diagnostic(
+                    file = file.path,
                     message = e.message ?: e.toString(),
                     tag = e.javaClass.simpleName,
                     start = SourcePosition(1, 1),
@@ -171,37 +196,31 @@ object FrontendService {
             }
         }
 
-        // Also parse overlay-only files that are not on the disk source list
-        // (e.g. a brand-new unsaved buffer under the project).
-        val known = sourcePaths.map { canonicalize(it) }.toSet()
-        for ((path, text) in overlayByCanonical) {
-            if (path in known) continue
-            if (!path.endsWith(".kira")) continue
-            try {
-                parseOne(compilationUnit, path, text)
-            } catch (e: DiagnosticsException) {
-                diagnostics += fromException(e)
-            } catch (e: IllegalStateException) {
-                diagnostics += Diagnostic(
-                    file = path,
-                    message = e.message ?: e.toString(),
-                    tag = "Panic",
-                    start = SourcePosition(1, 1),
-                    end = SourcePosition(1, 1),
-                )
-            } catch (e: Exception) {
-                diagnostics += Diagnostic(
-                    file = path,
-                    message = e.message ?: e.toString(),
-                    tag = e.javaClass.simpleName,
-                    start = SourcePosition(1, 1),
-                    end = SourcePosition(1, 1),
-                )
-            }
+        val workspace = session.workspace
+        val workspaceKey = workspace?.unitKey(compilationUnit.allSourcePaths())
+        val verdict = workspace?.verdict?.takeIf { it.unitKey == workspaceKey }
+        if (verdict != null) {
+            verdict.summary.replayInto(compilationUnit)
+            diagnostics += verdict.diagnostics
+            return FrontendResult(compilationUnit, diagnostics.toList(), projectRoot, manifest)
+        }
+        val parseDiagnostics = diagnostics.size
+
+        // Only a unit whose every file parsed can match a recorded clean run.
+        val unitKey = if (cache != null && diagnostics.isEmpty()) cache.unitKey() else null
+        val summary = unitKey?.let { cache?.loadSemantic(it) }
+        if (cache != null && unitKey != null && summary != null) {
+            summary.replayInto(compilationUnit)
+            cache.prune(unitKey)
+            return FrontendResult(compilationUnit, diagnostics.toList(), projectRoot, manifest)
         }
 
+        // A changed unit still skips the bodies of the modules that checked clean under the same declarations.
+        val verdicts = if (unitKey != null) cache?.bodyVerdicts() else null
         val semantic: SemanticAnalyzerResults? = try {
-            KiraSemanticAnalyzer(compilationUnit).validateAST()
+            session.traced("semantic") { KiraSemanticAnalyzer(compilationUnit, session.jobs).validateAST(verdicts) }
+        } catch (e: CancellationException) {
+            throw e
         } catch (e: DiagnosticsException) {
             diagnostics += fromException(e)
             null
@@ -218,15 +237,112 @@ object FrontendService {
 
         semantic?.diagnostics?.forEach { diagnostics += fromException(it) }
 
+        if (cache != null && unitKey != null) {
+            if (semantic != null && diagnostics.isEmpty()) {
+                cache.storeSemantic(unitKey, FrontendCache.SemanticSummary.of(compilationUnit))
+            }
+            cache.prune(unitKey)
+        }
+        if (workspace != null && workspaceKey != null) {
+            workspace.verdict = FrontendWorkspace.Verdict(
+                workspaceKey,
+                FrontendCache.SemanticSummary.of(compilationUnit),
+                diagnostics.drop(parseDiagnostics),
+            )
+            workspace.retainOnly(compilationUnit.allSourcePaths())
+        }
+
         return FrontendResult(compilationUnit, diagnostics.toList(), projectRoot, manifest)
     }
 
-    private fun parseOne(cu: CompilationUnit, path: String, text: String) {
-        val processed = KiraPreprocessor(text).process().processedContent
-        var ctx = cu.addSource(path, processed, emptyList())
-        val tokens = KiraLexer(ctx).tokenize()
-        ctx = cu.addSource(path, ctx.content, tokens)
-        KiraSourceParsers.from(ctx).parse()
+    /** Outcome of one file in [parseAll]; [failure] is null when it parsed. */
+    class ParsedFile(val path: String, val origin: Origin, val duration: Duration, val failure: Exception?) {
+        /** [RETAINED]: unchanged since the last run over the session's [CompilerSession.workspace]. */
+        enum class Origin { PARSED, PREBUILT, CACHED, RETAINED }
+    }
+
+    /**
+     * Lex and parse every path in [paths] into [cu], the session's
+     * [CompilerSession.jobs] files at a time. Lexing and parsing only touch
+     * their own [SourceContext], so files are independent until the analyzer
+     * runs. [textOf] returns a file's text, or null when it does not
+     * exist (reported as a [FileNotFoundException] failure). Results come back
+     * in [paths] order, and the unit's sources end up in the order a serial
+     * loop would have added them, whichever worker finished first.
+     * A cancelled session rethrows its [CancellationException] once every
+     * worker has stopped.
+     */
+    fun parseAll(
+        cu: CompilationUnit,
+        paths: List<String>,
+        cache: FrontendCache? = null,
+        textOf: (String) -> String?,
+    ): List<ParsedFile> {
+        val order = (cu.allSourcePaths() + paths).distinct()
+        val session = cu.session
+        val work = paths.map { path ->
+            Callable {
+                val start = System.nanoTime()
+                val (origin, failure) = try {
+                    val text = session.traced("read", path) { textOf(path) } ?: throw FileNotFoundException(path)
+                    parseOne(cu, path, text, cache) to null
+                } catch (e: Exception) {
+                    ParsedFile.Origin.PARSED to e
+                }
+                ParsedFile(path, origin, (System.nanoTime() - start).nanoseconds, failure)
+            }
+        }
+        val workers = session.jobs.coerceIn(1, paths.size.coerceAtLeast(1))
+        val results = session.traced("frontend") {
+            if (workers == 1) {
+                work.map { it.call() }
+            } else {
+                val pool = ForkJoinPool(workers)
+                try {
+                    pool.invokeAll(work).map { it.get() }
+                } finally {
+                    pool.shutdown()
+                }
+            }
+        }
+        results.firstOrNull { it.failure is CancellationException }?.let { throw it.failure!! }
+        cu.orderSources(order)
+        return results
+    }
+
+    private fun parseOne(cu: CompilationUnit, path: String, text: String, cache: FrontendCache?): ParsedFile.Origin {
+        val key = cache?.keyFor(path, text)
+        val session = cu.session
+        val workspace = session.workspace
+        if (workspace != null && workspace.install(cu, path, text) != null) {
+            return ParsedFile.Origin.RETAINED
+        }
+        if (cu.loadPrebuiltSource(path, text) != null) {
+            workspace?.remember(path, text, cu.getSource(path)!!)
+            return ParsedFile.Origin.PREBUILT
+        }
+        if (cache != null && key != null && session.traced("cache load", path) { cache.loadSource(cu, path, key) } != null) {
+            workspace?.remember(path, text, cu.getSource(path)!!)
+            return ParsedFile.Origin.CACHED
+        }
+        val ctx = cu.addSource(path, text, emptyList())
+        val parsed = try {
+            val tokens = session.traced("lex", path) {
+                workspace?.tokenize(ctx, cu.identifiers) ?: KiraLexer(ctx, cu.identifiers).tokenize()
+            }
+            val lexed = cu.addSource(path, ctx.content, tokens)
+            session.traced("parse", path) { KiraSourceParsers.from(lexed).parse() }
+            lexed
+        } catch (e: Exception) {
+            // Still counts toward the workspace's unit key, and its tokens seed the next run's lexing.
+            workspace?.remember(path, text, cu.getSource(path)!!)
+            throw e
+        }
+        workspace?.remember(path, text, parsed)
+        if (cache != null && key != null) {
+            session.traced("cache store", path) { cache.storeSource(key, parsed) }
+        }
+        return ParsedFile.Origin.PARSED
     }
 
     fun fromException(e: DiagnosticsException): Diagnostic {
@@ -0,0 +1,160 @@
+package net.exoad.kira.compiler
+
+import net.exoad.kira.compiler.frontend.lexer.KiraLexer
+import net.exoad.kira.compiler.frontend.lexer.TokenStream
+import net.exoad.kira.core.Identifiers
+import net.exoad.kira.kim.ManifestLoader
+import net.exoad.kira.kim.ProjectManifest
+import net.exoad.kira.source.SourceContext
+import java.util.IdentityHashMap
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.atomic.AtomicInteger
+
+/**
+ * In-memory frontend state for one project that outlives a single
+ * compilation: the language server keeps one per workspace and hands it to
+ * every run through [CompilerSession.workspace].
+ *
+ * **Per file:** the last parse of every module (stdlib included), keyed by
+ * path and the SHA-256 of its raw text. A file whose buffer did not change
+ * since the last run is installed into the new [CompilationUnit] as-is --
+ * no lexing, no parsing, no deserializing. One that did change is re-lexed
+ * from its last tokens ([tokenize]), even when it did not parse last time;
+ * only the parser starts over. The analyzer only reads the
+ * tree, so sharing nodes between consecutive units is safe; the runs of one
+ * workspace must not overlap, which the language server guarantees by
+ * diagnosing on a single thread.
+ *
+ * **Per unit:** like [FrontendCache], the analyzer walks every module
+ * through one shared scope stack, so its verdict is remembered for the
+ * whole unit. Unlike the disk cache, dirty verdicts are kept too: the
+ * diagnostics are a function of the file texts, so re-diagnosing an
+ * unchanged unit (a save, opening another file, undoing back to the last
+ * state) skips the analyzer.
+ */
+class FrontendWorkspace {
+    private class Entry(
+        val digest: String,
+        /** What [tokens] were lexed from. */
+        val content: String,
+        val tokens: TokenStream?,
+        val parsed: FrontendCache.ParsedSource?,
+    )
+
+    /**
+     * One change the editor reported: `[start, start + removed)` of [before]
+     * became `[start, start + inserted)` of [after]. Both texts are the very
+     * objects that were compiled, so [tokenize] can tell by identity whether
+     * the edit is the one between its last tokens and the text at hand.
+     */
+    class Edit(val before: String, val after: String, val start: Int, val removed: Int, val inserted: Int)
+
+    /** The last analysis, and the unit it ran on. */
+    internal class Verdict(
+        val unitKey: String,
+        val summary: FrontendCache.SemanticSummary,
+        val diagnostics: List<FrontendService.Diagnostic>,
+    )
+
+    private val files = ConcurrentHashMap<String, Entry>()
+    private val hitCount = AtomicInteger()
+    private val missCount = AtomicInteger()
+
+    /** Files installed from memory. */
+    val hits: Int get() = hitCount.get()
+
+    /** Files it did not have: parsed, or taken from the stdlib snapshot or disk cache. */
+    val misses: Int get() = missCount.get()
+
+    @Volatile
+    private var manifest: Pair<String, ProjectManifest>? = null
+
+    @Volatile
+    internal var verdict: Verdict? = null
+
+    /** [Edit]s for the next run, by [Edit.after]; replaced wholesale, never mutated once published. */
+    @Volatile
+    private var edits: Map<String, Edit> = emptyMap()
+
+    /**
+     * The edits behind the texts the next run compiles, so [tokenize] re-lexes
+     * from the spans the editor reported. Replaces those of the previous run.
+     */
+    fun expectEdits(edits: Collection<Edit>) {
+        this.edits = edits.associateByTo(IdentityHashMap()) { it.after }
+    }
+
+    /**
+     * Install the last parse of [path] into [compilationUnit] when it was
+     * parsed from exactly [rawText]; null means the caller has to parse and
+     * then [remember] the result.
+     */
+    fun install(compilationUnit: CompilationUnit, path: String, rawText: String): SourceContext? {
+        val entry = files[path]
+        val parsed = entry?.parsed
+        if (parsed == null || entry.digest != FrontendCache.sha256(rawText)) {
+            missCount.incrementAndGet()
+            return null
+        }
+        hitCount.incrementAndGet()
+        return parsed.installInto(compilationUnit, path)
+    }
+
+    /**
+     * Record what lexing and parsing left on [ctx], the context of [path] read as [rawText]. A file that failed
+     * to lex or parse is recorded too: it still counts toward [unitKey], and its tokens seed the next [tokenize].
+     */
+    fun remember(path: String, rawText: String, ctx: SourceContext) {
+        val tokens = (ctx.tokens as? TokenStream)?.takeIf { it.isNotEmpty() }
+        val parsed = if (ctx.isParsed) FrontendCache.ParsedSource.of(ctx) else null
+        files[path] = Entry(FrontendCache.sha256(rawText), ctx.content, tokens, parsed)
+    }
+
+    /**
+     * Tokens for [ctx]: re-lexed from the last tokens of the same file when there are any
+     * ([KiraLexer.relex]), otherwise lexed from scratch. The edit comes from [expectEdits] when one
+     * leads from exactly the last text to this one. Otherwise (a file changed on disk, a run that
+     * was cancelled before it remembered its texts, a buffer another project's run read first) it
+     * is found by comparing the two texts from both ends, a single pass over the characters that
+     * is still far cheaper than lexing them. Names are interned into [identifiers], the unit's table.
+     */
+    fun tokenize(ctx: SourceContext, identifiers: Identifiers): TokenStream {
+        val entry = files[ctx.file]
+        val previous = entry?.tokens ?: return KiraLexer(ctx, identifiers).tokenize()
+        val old = entry.content
+        val new = ctx.content
+        val edit = edits[new]
+        if (edit != null && edit.before === old) {
+            return KiraLexer(ctx, identifiers).relex(previous, edit.start, edit.removed, edit.inserted)
+        }
+        val limit = minOf(old.length, new.length)
+        var prefix = 0
+        while (prefix < limit && old[prefix] == new[prefix]) {
+            prefix++
+        }
+        var suffix = 0
+        while (suffix < limit - prefix && old[old.length - 1 - suffix] == new[new.length - 1 - suffix]) {
+            suffix++
+        }
+        return KiraLexer(ctx, identifiers).relex(previous, prefix, old.length - prefix - suffix, new.length - prefix - suffix)
+    }
+
+    /** Key for a unit of [paths]: each path with the digest of the text it was last read with. */
+    fun unitKey(paths: Collection<String>): String {
+        val parts = paths.sorted().flatMap { path -> listOf(path, files[path]?.digest ?: "") }
+        return FrontendCache.sha256(*parts.toTypedArray())
+    }
+
+    /** Forget files that are no longer part of the project (deleted, or an unsaved buffer that was closed). */
+    fun retainOnly(paths: Collection<String>) {
+        val live = paths.toSet()
+        files.keys.retainAll(live)
+    }
+
+    /** `kira.yaml` parsed from [text], reusing the last parse while the text is unchanged. */
+    fun manifest(text: String): ProjectManifest {
+        val digest = FrontendCache.sha256(text)
+        manifest?.let { (last, parsed) -> if (last == digest) return parsed }
+        return ManifestLoader.parse(text).also { manifest = digest to it }
+    }
+}
@@ -0,0 +1,185 @@
+package net.exoad.kira.compiler
+
+import java.io.Writer
+import java.lang.management.ManagementFactory
+import java.util.concurrent.ConcurrentLinkedQueue
+
+/**
+ * Wall time, CPU time and allocation of every compiler phase, per file where
+ * the phase works file by file. `kira --time-passes` prints the totals and
+ * `kira --trace out.json` writes the spans as Chrome trace events, for
+ * `chrome://tracing` or Perfetto.
+ *
+ * A [CompilerSession] carries at most one; phases record through
+ * [CompilerSession.traced], which costs nothing when tracing is off. Spans
+ * may come from any thread (files are parsed and bodies checked in
+ * parallel) and nest per thread in the trace viewer.
+ */
+class PassTrace {
+    class Span(
+        val name: String,
+        val file: String?,
+        val threadId: Long,
+        val threadName: String,
+        /** Nanoseconds since the trace started. */
+        val start: Long,
+        val wallNanos: Long,
+        /** -1 when the JVM does not measure it. */
+        val cpuNanos: Long,
+        /** -1 when the JVM does not measure it. */
+        val allocatedBytes: Long,
+    )
+
+    private val origin = System.nanoTime()
+    private val recorded = ConcurrentLinkedQueue<Span>()
+
+    val spans: List<Span> get() = recorded.sortedBy { it.start }
+
+    fun <T> span(name: String, file: String?, block: () -> T): T {
+        val cpuBefore = cpuTime()
+        val allocatedBefore = allocatedBytes()
+        val start = System.nanoTime()
+        try {
+            return block()
+        } finally {
+            val end = System.nanoTime()
+            val cpuAfter = cpuTime()
+            val allocatedAfter = allocatedBytes()
+            val thread = Thread.currentThread()
+            recorded.add(
+                Span(
+                    name,
+                    file,
+                    thread.id,
+                    thread.name,
+                    start - origin,
+                    end - start,
+                    if (cpuBefore < 0 || cpuAfter < 0) -1 else cpuAfter - cpuBefore,
+                    if (allocatedBefore < 0 || allocatedAfter < 0) -1 else allocatedAfter - allocatedBefore,
+                )
+            )
+        }
+    }
+
+    /**
+     * The `--time-passes` table: one row per phase, then the files that took
+     * longest. Phases nest (the parse of a file sits inside the frontend), so
+     * the rows do not add up to the total.
+     */
+    fun report(slowestFiles: Int = 10): String {
+        val all = spans
+        return buildString {
+            appendLine(String.format("%-28s %6s %12s %12s %14s", "phase", "count", "wall ms", "cpu ms", "allocated"))
+            all.groupBy { it.name }.forEach { (name, group) ->
+                appendLine(
+                    String.format(
+                        "%-28s %6d %12.2f %12s %14s",
+                        name,
+                        group.size,
+                        group.sumOf { it.wallNanos } / 1e6,
+                        millis(group.map { it.cpuNanos }),
+                        bytes(group.map { it.allocatedBytes }),
+                    )
+                )
+            }
+            val files = all.filter { it.file != null }.groupBy { it.file!! }
+            if (files.isNotEmpty()) {
+                appendLine()
+                appendLine(String.format("%-60s %12s %12s %14s", "file", "wall ms", "cpu ms", "allocated"))
+                files.entries.sortedByDescending { (_, group) -> group.sumOf { it.wallNanos } }
+                    .take(slowestFiles)
+                    .forEach { (file, group) ->
+                        appendLine(
+                            String.format(
+                                "%-60s %12.2f %12s %14s",
+                                file.takeLast(60),
+                                group.sumOf { it.wallNanos } / 1e6,
+                                millis(group.map { it.cpuNanos }),
+                                bytes(group.map { it.allocatedBytes }),
+                            )
+                        )
+                    }
+            }
+        }.trimEnd()
+    }
+
+    /** Chrome trace-event JSON: one complete (`"X"`) event per span plus thread names. */
+    fun writeChromeTrace(out: Writer) {
+        val all = spans
+        out.write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[")
+        var first = true
+        fun event(json: String) {
+            if (!first) out.write(",")
+            first = false
+            out.write("\n")
+            out.write(json)
+        }
+        all.distinctBy { it.threadId }.forEach { span ->
+            event(
+                "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":${span.threadId}," +
+                    "\"args\":{\"name\":${quote(span.threadName)}}}"
+            )
+        }
+        all.forEach { span ->
+            val args = buildList {
+                span.file?.let { add("\"file\":${quote(it)}") }
+                if (span.cpuNanos >= 0) add("\"cpu_us\":${span.cpuNanos / 1000}")
+                if (span.allocatedBytes >= 0) add("\"allocated_bytes\":${span.allocatedBytes}")
+            }
+            val label = if (span.file == null) span.name else "${span.name} ${span.file.substringAfterLast('/')}"
+            event(
+                "{\"name\":${quote(label)},\"cat\":${quote(span.name)},\"ph\":\"X\",\"pid\":1," +
+                    "\"tid\":${span.threadId},\"ts\":${span.start / 1000},\"dur\":${span.wallNanos / 1000}," +
+                    "\"args\":{${args.joinToString(",")}}}"
+            )
+        }
+        out.write("\n]}\n")
+        out.flush()
+    }
+
+    companion object {
+        private val threads = ManagementFactory.getThreadMXBean()
+
+        /** HotSpot's extension, which also counts allocation per thread. */
+        private val hotspotThreads = threads as? com.sun.management.ThreadMXBean
+
+        private fun cpuTime(): Long {
+            return if (threads.isCurrentThreadCpuTimeSupported) threads.currentThreadCpuTime else -1
+        }
+
+        private fun allocatedBytes(): Long {
+            val bean = hotspotThreads ?: return -1
+            return if (bean.isThreadAllocatedMemorySupported) bean.currentThreadAllocatedBytes else -1
+        }
+
+        private fun millis(values: List<Long>): String {
+            return if (values.any { it < 0 }) "-" else String.format("%.2f", values.sum() / 1e6)
+        }
+
+        private fun bytes(values: List<Long>): String {
+            if (values.any { it < 0 }) return "-"
+            val total = values.sum().toDouble()
+            return when {
+                total >= 1 shl 30 -> String.format("%.1f GiB", total / (1 shl 30))
+                total >= 1 shl 20 -> String.format("%.1f MiB", total / (1 shl 20))
+                total >= 1 shl 10 -> String.format("%.1f KiB", total / (1 shl 10))
+                else -> "${total.toLong()} B"
+            }
+        }
+
+        private fun quote(text: String): String {
+            return buildString {
+                append('"')
+                text.forEach { c ->
+                    when {
+                        c == '"' -> append("\\\"")
+                        c == '\\' -> append("\\\\")
+                        c < ' ' -> append(String.format("\\u%04x", c.code))
+                        else -> append(c)
+                    }
+                }
+                append('"')
+            }
+        }
+    }
+}
@@ -0,0 +1,206 @@
+package net.exoad.kira.compiler
+
+import net.exoad.kira.compiler.backend.codegen.OutputMinifier
+import net.exoad.kira.compiler.backend.codegen.c.CMagicBindingTable
+import net.exoad.kira.compiler.frontend.lexer.KiraLexer
+import net.exoad.kira.compiler.frontend.parser.KiraSourceParsers
+import java.io.ByteArrayOutputStream
+import java.io.DataOutputStream
+import java.io.File
+import java.io.InputStream
+import java.io.ObjectInputStream
+import java.io.ObjectOutputStream
+import java.io.Serializable
+import java.nio.ByteBuffer
+import java.nio.channels.FileChannel
+import java.nio.file.Files
+import java.nio.file.Path
+import java.nio.file.StandardOpenOption
+
+/**
+ * Prebuilt frontend state for the `kira/` stdlib, written by `installDist`
+ * next to the compiler jar (`lib/kira-stdlib.snapshot`).
+ *
+ * Every compile -- and every language server restart -- used to lex and
+ * parse the whole stdlib before touching a single user file. The
+ * snapshot holds what those passes produce for each stdlib module (see
+ * [FrontendCache.ParsedSource]) plus the parsed `*.bind.yaml` tables, so
+ * startup is one `mmap` of the file and a deserialize per module. The
+ * identifiers of the `c/` and `js/` runtime preludes ride along too: the
+ * minifier must never rename onto them, and scanning the whole prelude for
+ * them on every build cost more than minifying the user layer.
+ *
+ * The stdlib directory stays authoritative: entries are keyed by the SHA-256
+ * of the raw file text, never by path. A stdlib path overridden in
+ * `kira.yaml` with identical modules still hits; an edited module simply
+ * misses and is parsed as before. Each lookup deserializes a fresh copy, so
+ * no two [CompilationUnit]s ever share AST nodes.
+ *
+ * Layout: `KIRASNAP`, format, entry count, then per entry a 32-byte digest,
+ * a length and that many bytes of Java serialization.
+ */
+class StdlibSnapshot private constructor(private val buffer: ByteBuffer) {
+    /** Parsed `*.bind.yaml` manifest. */
+    internal class BindingManifest(val bindings: Map<String, CMagicBindingTable.Binding>) : Serializable
+
+    /** Every identifier in a runtime prelude file ([OutputMinifier.extractIdentifiers]). */
+    internal class RuntimeIdentifiers(val names: Set<String>) : Serializable
+
+    private val index: Map<String, Pair<Int, Int>> = readIndex()
+
+    val size: Int get() = index.size
+
+    private fun readIndex(): Map<String, Pair<Int, Int>> {
+        val view = buffer.duplicate()
+        val magic = ByteArray(MAGIC.size)
+        view.get(magic)
+        require(magic.contentEquals(MAGIC)) { "not a Kira stdlib snapshot" }
+        require(view.int == FORMAT) { "stdlib snapshot format mismatch" }
+        val count = view.int
+        val digest = ByteArray(DIGEST_BYTES)
+        val out = HashMap<String, Pair<Int, Int>>(count * 2)
+        repeat(count) {
+            view.get(digest)
+            val length = view.int
+            out[digest.joinToString("") { "%02x".format(it) }] = view.position() to length
+            view.position(view.position() + length)
+        }
+        return out
+    }
+
+    private fun <T> entry(rawText: String): T? {
+        val (offset, length) = index[FrontendCache.sha256(rawText)] ?: return null
+        val slice = buffer.duplicate().position(offset).limit(offset + length)
+        return try {
+            ObjectInputStream(ByteBufferInputStream(slice)).use { input ->
+                @Suppress("UNCHECKED_CAST")
+                input.readObject() as T
+            }
+        } catch (_: Exception) {
+            // Written by a different compiler build: fall back to parsing.
+            null
+        }
+    }
+
+    /** Install the prebuilt parse of a stdlib module whose text is [rawText], or null when it is not in the snapshot. */
+    fun installSource(compilationUnit: CompilationUnit, path: String, rawText: String): Boolean {
+        val parsed = entry<FrontendCache.ParsedSource>(rawText) ?: return false
+        parsed.installInto(compilationUnit, path)
+        return true
+    }
+
+    /** Prebuilt bindings of a `*.bind.yaml` manifest whose text is [rawText]. */
+    fun bindingsOrNull(rawText: String): Map<String, CMagicBindingTable.Binding>? {
+        return entry<BindingManifest>(rawText)?.bindings
+    }
+
+    /** Prebuilt identifiers of a runtime prelude file whose text is [rawText]. */
+    fun identifiersOrNull(rawText: String): Set<String>? {
+        return entry<RuntimeIdentifiers>(rawText)?.names
+    }
+
+    private class ByteBufferInputStream(private val buffer: ByteBuffer) : InputStream() {
+        override fun read(): Int = if (buffer.hasRemaining()) buffer.get().toInt() and 0xFF else -1
+
+        override fun read(b: ByteArray, off: Int, len: Int): Int {
+            if (!buffer.hasRemaining()) {
+                return -1
+            }
+            val n = minOf(len, buffer.remaining())
+            buffer.get(b, off, n)
+            return n
+        }
+
+        override fun available(): Int = buffer.remaining()
+    }
+
+    companion object {
+        const val FILE_NAME = "kira-stdlib.snapshot"
+        private const val FORMAT = 2
+        private const val DIGEST_BYTES = 32
+        private val MAGIC = "KIRASNAP".toByteArray(Charsets.US_ASCII)
+        private val RUNTIME_EXTENSIONS = setOf("c", "h", "js")
+
+        fun open(file: Path): StdlibSnapshot? {
+            return try {
+                FileChannel.open(file, StandardOpenOption.READ).use { channel ->
+                    StdlibSnapshot(channel.map(FileChannel.MapMode.READ_ONLY, 0, channel.size()))
+                }
+            } catch (_: Exception) {
+                null
+            }
+        }
+
+        /** Mapped once, on the first session that asks; the file does not change under a running compiler. */
+        private val shippedSnapshot: StdlibSnapshot? by lazy { findShipped() }
+
+        /**
+         * The snapshot shipped next to the compiler jar, the default
+         * [CompilerSession.stdlibSnapshot]. Null when running from a build
+         * directory or when the file is missing or unreadable.
+         */
+        fun shipped(): StdlibSnapshot? {
+            return shippedSnapshot
+        }
+
+        private fun findShipped(): StdlibSnapshot? {
+            val jar = runCatching {
+                File(StdlibSnapshot::class.java.protectionDomain.codeSource.location.toURI())
+            }.getOrNull() ?: return null
+            if (!jar.isFile) {
+                return null
+            }
+            val file = jar.resolveSibling(FILE_NAME).toPath()
+            return if (Files.isRegularFile(file)) open(file) else null
+        }
+
+        /**
+         * Parse every `.kira` module and `*.bind.yaml` manifest under
+         * [stdlibRoot], collect the identifiers of every runtime prelude file,
+         * and write the snapshot to [output]. Modules that do not parse are
+         * left out and get parsed at compile time instead.
+         */
+        fun write(stdlibRoot: Path, output: Path): Int {
+            val files = stdlibRoot.toFile().walkTopDown()
+                .filter {
+                    it.isFile && (it.extension == "kira" || it.name.endsWith(".bind.yaml") ||
+                        it.extension in RUNTIME_EXTENSIONS)
+                }
+                .sortedBy { it.path }
+                .toList()
+            val entries = linkedMapOf<String, ByteArray>()
+            files.forEach { file ->
+                val rawText = file.readText()
+                val value: Serializable = if (file.extension in RUNTIME_EXTENSIONS) {
+                    RuntimeIdentifiers(OutputMinifier.extractIdentifiers(rawText))
+                } else if (file.extension == "kira") {
+                    val compilationUnit = CompilationUnit(bootstrapStdlib = false)
+                    var ctx = compilationUnit.addSource(file.canonicalPath, rawText, emptyList())
+                    ctx = compilationUnit.addSource(file.canonicalPath, ctx.content, KiraLexer(ctx, compilationUnit.identifiers).tokenize())
+                    val parsed = runCatching { KiraSourceParsers.from(ctx).parse() }
+                    if (parsed.isFailure) {
+                        return@forEach
+                    }
+                    FrontendCache.ParsedSource.of(ctx)
+                } else {
+                    BindingManifest(CMagicBindingTable.parseManifest(rawText))
+                }
+                val bytes = ByteArrayOutputStream()
+                ObjectOutputStream(bytes).use { it.writeObject(value) }
+                entries[FrontendCache.sha256(rawText)] = bytes.toByteArray()
+            }
+            Files.createDirectories(output.toAbsolutePath().parent)
+            DataOutputStream(Files.newOutputStream(output).buffered()).use { out ->
+                out.write(MAGIC)
+                out.writeInt(FORMAT)
+                out.writeInt(entries.size)
+                entries.forEach { (digest, bytes) ->
+                    out.write(digest.chunked(2).map { it.toInt(16).toByte() }.toByteArray())
+                    out.writeInt(bytes.size)
+                    out.write(bytes)
+                }
+            }
+            return entries.size
+        }
+    }
+}
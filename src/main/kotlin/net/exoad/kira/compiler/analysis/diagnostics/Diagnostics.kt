@@ -3,8 +3,9 @@ package net.exoad.kira.compiler.analysis.diagnostics
 import net.exoad.kira.Public
 import net.exoad.kira.source.SourceContext
 import net.exoad.kira.source.SourcePosition
-import java.util.logging.ConsoleHandler
+import java.util.logging.Handler
 import java.util.logging.Level
+import java.util.logging.LogRecord
 import java.util.logging.Logger
 import java.util.logging.SimpleFormatter
 
@@ -24,7 +25,7 @@ object Diagnostics {
             "java.util.logging.SimpleFormatter.format",
             "%5\$s%n" // get rid of all the garbage produced by the default java logger including things like method site, a long time stamp.
         )
-        val consoleHandler = ConsoleHandler().apply {
+        val consoleHandler = StderrHandler().apply {
             formatter = SimpleFormatter()
         }
         logger.addHandler(consoleHandler)
@@ -33,6 +34,26 @@ object Diagnostics {
         logger.useParentHandlers = false
     }
 
+    /**
+     * A ConsoleHandler binds `System.err` once when it is made; this one looks
+     * it up on every record, so the compiler daemon can send each build's log
+     * to the client that asked for it.
+     */
+    private class StderrHandler : Handler() {
+        override fun publish(record: LogRecord) {
+            if (isLoggable(record)) {
+                System.err.print(formatter.format(record))
+                System.err.flush()
+            }
+        }
+
+        override fun flush() {
+            System.err.flush()
+        }
+
+        override fun close() {}
+    }
+
 //    fun useDiagnostics() {
 //        logger.level = Level.ALL
 //        // i learned it the hard way that just setting the logger's level doesnt work.
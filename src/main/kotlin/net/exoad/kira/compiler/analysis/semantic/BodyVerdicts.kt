@@ -0,0 +1,19 @@
+package net.exoad.kira.compiler.analysis.semantic
+
+import net.exoad.kira.source.SourceContext
+
+/**
+ * Which modules' function bodies checked clean on an earlier run, so
+ * [KiraSemanticAnalyzer] can skip them. A verdict holds for a module's exact
+ * text under the exact [declarations] of the unit: what every module
+ * declared and registered in the declaration pass. A body can bind to
+ * anything declared before it, and a missing type is forgiven when any
+ * module declares it, so a verdict depends on every module's declarations,
+ * not only its imports. An edit that leaves them alone (the usual edit to
+ * a function body) re-checks just the edited module.
+ */
+interface BodyVerdicts {
+    fun wasClean(source: SourceContext, declarations: String): Boolean
+
+    fun recordClean(source: SourceContext, declarations: String)
+}
@@ -1,6 +1,41 @@
 package net.exoad.kira.compiler.analysis.semantic
 
-data class KiraScopeFrame(
-    val kind: SemanticScope,
-    val symbols: MutableMap<String, SemanticSymbol> = mutableMapOf(),
-)
\ No newline at end of file
+import net.exoad.kira.core.Identifiers
+
+/**
+ * One scope on a [KiraSymbolTable]. Symbols are keyed by their id in the
+ * table's [Identifiers]; [symbols] is a read-only, name-keyed view in
+ * declaration order. Declare through the table so its resolution index stays
+ * in step.
+ */
+class KiraScopeFrame(val kind: SemanticScope, private val identifiers: Identifiers) {
+    internal val byId = LinkedHashMap<Int, SemanticSymbol>()
+
+    /** Position on the owning table's stack; the global frame is 0. */
+    internal var depth = 0
+
+    val symbols: Map<String, SemanticSymbol> = object : AbstractMap<String, SemanticSymbol>() {
+        override val size: Int get() = byId.size
+
+        override val entries: Set<Map.Entry<String, SemanticSymbol>>
+            get() = byId.entries.mapTo(LinkedHashSet()) { (id, symbol) ->
+                java.util.AbstractMap.SimpleImmutableEntry(identifiers.name(id), symbol)
+            }
+
+        override val values: Collection<SemanticSymbol> get() = byId.values
+
+        override fun containsKey(key: String): Boolean {
+            val id = identifiers.find(key)
+            return id >= 0 && byId.containsKey(id)
+        }
+
+        override fun get(key: String): SemanticSymbol? {
+            val id = identifiers.find(key)
+            return if (id >= 0) byId[id] else null
+        }
+    }
+
+    override fun toString(): String {
+        return "KiraScopeFrame(kind=$kind, symbols=$symbols)"
+    }
+}
@@ -19,26 +19,88 @@ import net.exoad.kira.source.SourceContext
 import net.exoad.kira.source.SourceLocation
 import net.exoad.kira.source.SourcePosition
 import net.exoad.kira.utils.EnglishUtils
+import java.util.Collections
+import java.util.IdentityHashMap
+import java.util.concurrent.Callable
+import java.util.concurrent.CancellationException
+import java.util.concurrent.ExecutionException
+import java.util.concurrent.ForkJoinPool
 
 /**
  * The 4th phase after the parsing process that traverses the generated AST by the [net.exoad.kira.compiler.frontend.parser.KiraParser]
  * to make sure everything follows the rules of the language and everything makes sense.
+ *
+ * Runs in two phases. The declaration pass walks every module in source order
+ * on the calling thread and fills the shared [KiraSymbolTable]; function
+ * bodies are only recorded, each with a [KiraSymbolTable.fork] of the scope
+ * chain visible at that point. Bodies never declare anything outside their
+ * own frames, so the body pass then checks each module's bodies on up to
+ * [jobs] threads and splices their diagnostics back where a serial walk would
+ * have reported them. A module with intrinsics inside its bodies is checked
+ * on the calling thread instead, before the others, so each intrinsic still
+ * runs when the walk reaches it and later statements see what it declared.
+ *
+ * Given [BodyVerdicts], the body pass leaves out modules whose bodies checked
+ * clean last time under the same declarations, and records the ones that
+ * check clean now.
  */
-class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraASTVisitor(), IntrinsicTreeWalker {
+class KiraSemanticAnalyzer private constructor(
+    private val compilationUnit: CompilationUnit,
+    private val jobs: Int,
+    /** Top-level value types from the declaration pass; read-only in body workers. */
+    private val inheritedValueTypes: Map<String, String>,
+    /** Set on parallel body workers, which queue intrinsic applications for the caller's thread. */
+    private val queuedIntrinsics: MutableList<Pair<ASTNode, SourceContext>>?,
+) : KiraASTVisitor(), IntrinsicTreeWalker {
+    constructor(compilationUnit: CompilationUnit, jobs: Int = 1) : this(compilationUnit, jobs, emptyMap(), null)
+
     private val diagnosticsPump = mutableListOf<DiagnosticsException>()
     lateinit var context: SourceContext
 
+    /** The table being resolved against: the unit's own, or a body's fork. */
+    private var symbols: KiraSymbolTable = compilationUnit.symbolTable
+
+    /** A function body held back by the declaration pass. */
+    private class DeferredBody(
+        val decl: FunctionDecl,
+        val context: SourceContext,
+        val scopes: KiraSymbolTable,
+        /** Size of the diagnostics pump when the serial walk would have reached this body. */
+        val pumpIndex: Int,
+    )
+
+    /** The bodies of one module, and whether any of them carries an intrinsic. */
+    private class DeferredModule(
+        val source: SourceContext,
+        val bodies: List<DeferredBody>,
+        val intrinsicsInBodies: Boolean,
+    ) {
+        /** Whether a [BodyVerdicts] entry can stand in for checking [bodies]: intrinsics in them must still run. */
+        val skippable: Boolean get() = bodies.isNotEmpty() && !intrinsicsInBodies
+    }
+
+    private class BodyResults(
+        val diagnostics: List<Pair<Int, List<DiagnosticsException>>>,
+        val intrinsics: List<Pair<ASTNode, SourceContext>>,
+    )
+
+    /** Bodies of the module being declared; null outside the declaration pass. */
+    private var pendingBodies: MutableList<DeferredBody>? = null
+
+    /** Nodes whose intrinsics the declaration pass ran; any other marked node sits in a body. */
+    private val declarationIntrinsics: MutableSet<ASTNode> = Collections.newSetFromMap(IdentityHashMap())
+
     private fun registerSingleTypeParameter(typeParam: Type) {
         if (typeParam.identifier is Identifier) {
             val typeParamName = (typeParam.identifier as Identifier).value
-            compilationUnit.symbolTable.declare(
-                typeParamName,
+            symbols.declare(
+                typeParam.identifier as Identifier,
                 SemanticSymbol(
                     typeParamName,
                     SemanticSymbolKind.TYPE_SPECIFIER,
                     Token.Type.IDENTIFIER,
                     SourceLocation.fromPosition(
-                        context.astOrigins[typeParam.identifier] ?: SourcePosition.UNKNOWN,
+                        context.originOf(typeParam.identifier) ?: SourcePosition.UNKNOWN,
                         context.file
                     ),
                     relativelyVisible = false
@@ -51,14 +113,14 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
         for (child in type.children) {
             if (child.identifier is Identifier) {
                 val typeParamName = (child.identifier as Identifier).value
-                compilationUnit.symbolTable.declare(
-                    typeParamName,
+                symbols.declare(
+                    child.identifier as Identifier,
                     SemanticSymbol(
                         typeParamName,
                         SemanticSymbolKind.TYPE_SPECIFIER,
                         Token.Type.IDENTIFIER,
                         SourceLocation.fromPosition(
-                            context.astOrigins[child.identifier] ?: SourcePosition.UNKNOWN,
+                            context.originOf(child.identifier) ?: SourcePosition.UNKNOWN,
                             context.file
                         ),
                         relativelyVisible = false
@@ -71,49 +133,72 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
         }
     }
 
-    fun validateAST(): SemanticAnalyzerResults {
+    fun validateAST(verdicts: BodyVerdicts? = null): SemanticAnalyzerResults {
         try {
             // Pass 1: declare every module and its top-level types/functions so
             // later `use` imports can see them regardless of source file order.
+            val session = compilationUnit.session
+            val deferred = mutableListOf<DeferredModule>()
             for (source in compilationUnit.allSources()) {
-                context = source
-                val moduleName = try {
-                    context.getModuleUri()
-                } catch (_: Exception) {
-                    "(unknown):(unknown)"
+                session.traced("semantic declarations", source.file) {
+                    context = source
+                    val moduleName = try {
+                        context.getModuleUri()
+                    } catch (_: Exception) {
+                        "(unknown):(unknown)"
+                    }
+                    symbols.enter(SemanticScope.Module(moduleName))
+                    val bodies = mutableListOf<DeferredBody>()
+                    pendingBodies = bodies
+                    try {
+                        source.ast.accept(this)
+                    } finally {
+                        pendingBodies = null
+                    }
+                    deferred += DeferredModule(
+                        source,
+                        bodies,
+                        source.intrinsified.any { it !in declarationIntrinsics },
+                    )
                 }
-                compilationUnit.symbolTable.enter(SemanticScope.Module(moduleName))
-                source.ast.accept(this)
             }
+            val declarations = if (verdicts != null) declarationDigest() else null
+            val unchanged = Collections.newSetFromMap<DeferredModule>(IdentityHashMap())
+            if (verdicts != null && declarations != null) {
+                deferred.filterTo(unchanged) { it.skippable && verdicts.wasClean(it.source, declarations) }
+            }
+            session.traced("semantic bodies") { checkDeferredBodies(deferred.filter { it !in unchanged }) }
 
             // Pass 2: re-apply `use` imports now that every module scope exists.
             // Type-not-found diagnostics from pass 1 that become resolvable after
             // import are filtered out below.
             for (source in compilationUnit.allSources()) {
-                context = source
-                val moduleName = try {
-                    context.getModuleUri()
-                } catch (_: Exception) {
-                    continue
-                }
-                val moduleFrame = compilationUnit.symbolTable.findScope(SemanticScope.Module(moduleName))
-                    ?: continue
-                source.ast.statements.forEach { node ->
-                    // UseStatement is itself a Statement; root lists hold them directly.
-                    val use = node as? UseStatement ?: return@forEach
-                    val foreign = compilationUnit.symbolTable.findScope(
-                        SemanticScope.Module(use.uri.value)
-                    ) ?: return@forEach
-                    foreign.symbols.values
-                        .filter {
-                            it.relativelyVisible && (
-                                it.kind == SemanticSymbolKind.TYPE_SPECIFIER ||
-                                    it.kind == SemanticSymbolKind.TYPE_ALIAS
-                                )
-                        }
-                        .forEach { symbol ->
-                            moduleFrame.symbols.putIfAbsent(symbol.name, symbol)
-                        }
+                session.traced("semantic imports", source.file) {
+                    context = source
+                    val moduleName = try {
+                        context.getModuleUri()
+                    } catch (_: Exception) {
+                        return@traced
+                    }
+                    val moduleFrame = symbols.findScope(SemanticScope.Module(moduleName))
+                        ?: return@traced
+                    source.ast.statements.forEach { node ->
+                        // UseStatement is itself a Statement; root lists hold them directly.
+                        val use = node as? UseStatement ?: return@forEach
+                        val foreign = symbols.findScope(
+                            SemanticScope.Module(use.uri.value)
+                        ) ?: return@forEach
+                        foreign.symbols.values
+                            .filter {
+                                it.relativelyVisible && (
+                                    it.kind == SemanticSymbolKind.TYPE_SPECIFIER ||
+                                        it.kind == SemanticSymbolKind.TYPE_ALIAS
+                                    )
+                            }
+                            .forEach { symbol ->
+                                symbols.declareInto(moduleFrame, symbol.name, symbol)
+                            }
+                    }
                 }
             }
 
@@ -122,8 +207,19 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
                 val match = Regex("The type '([^']+)' was not found").find(diag.message)
                     ?: return@removeAll false
                 val typeName = match.groupValues[1]
-                compilationUnit.symbolTable.any { frame -> frame.symbols.containsKey(typeName) }
+                symbols.any { frame -> frame.symbols.containsKey(typeName) }
+            }
+            if (verdicts != null && declarations != null) {
+                val dirty = diagnosticsPump.mapTo(HashSet()) { it.context.file }
+                deferred.forEach { module ->
+                    if (module.skippable && module !in unchanged && module.source.file !in dirty) {
+                        verdicts.recordClean(module.source, declarations)
+                    }
+                }
             }
+        } catch (e: CancellationException) {
+            // the session gave up on this run; there is nothing to report
+            throw e
         } catch (e: Exception) {
             // choose a context to attach the diagnostic to; prefer the current one if available
             diagnosticsPump.add(
@@ -137,10 +233,102 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
                         ?: throw e
                 )
             )
-            return SemanticAnalyzerResults(diagnosticsPump, compilationUnit.symbolTable, false)
+            return SemanticAnalyzerResults(diagnosticsPump, symbols, false)
         }
 
-        return SemanticAnalyzerResults(diagnosticsPump, compilationUnit.symbolTable, diagnosticsPump.isEmpty())
+        return SemanticAnalyzerResults(diagnosticsPump, symbols, diagnosticsPump.isEmpty())
+    }
+
+    /**
+     * What the declaration pass left for bodies to see, as text: every open
+     * frame's symbols, the top-level value types and what intrinsics have
+     * registered on the unit so far. [BodyVerdicts] are keyed on it.
+     * Positions are left out, so moving a declaration keeps the verdicts.
+     */
+    private fun declarationDigest(): String {
+        return buildString {
+            for (frame in symbols) {
+                append(frame.kind::class.simpleName).append(' ').append(frame.kind.name).append('\n')
+                frame.symbols.values.forEach { symbol ->
+                    append(' ').append(symbol.name)
+                    append(' ').append(symbol.kind)
+                    append(' ').append(symbol.type)
+                    append(' ').append(symbol.relativelyVisible)
+                    append(' ').append(symbol.aliasedType)
+                    append('\n')
+                }
+            }
+            declaredValueTypes.toSortedMap().forEach { (name, type) -> append(name).append(": ").append(type).append('\n') }
+            append(compilationUnit.allMagicTypes().sorted()).append('\n')
+            append(compilationUnit.allOpaqueTypes().sorted()).append('\n')
+            append(compilationUnit.allExternFunctions().toSortedMap()).append('\n')
+        }
+    }
+
+    /**
+     * The body pass: one task per module, since locals' value types carry
+     * from one body to the next within a module exactly as in a serial walk.
+     */
+    private fun checkDeferredBodies(modules: List<DeferredModule>) {
+        val (inPlace, queued) = modules.filter { it.bodies.isNotEmpty() }.partition { it.intrinsicsInBodies }
+        // An intrinsic in a body can declare a global the rest of the body
+        // resolves, so those modules apply them as they go, on this thread.
+        val serial = inPlace.map { checkModuleBodies(it.bodies, null) }
+        val work = queued.map { module ->
+            Callable { checkModuleBodies(module.bodies, mutableListOf()) }
+        }
+        val parallel = if (jobs <= 1 || work.size <= 1) {
+            work.map { it.call() }
+        } else {
+            val pool = ForkJoinPool(jobs.coerceAtMost(work.size))
+            try {
+                pool.invokeAll(work).map { future ->
+                    try {
+                        future.get()
+                    } catch (e: ExecutionException) {
+                        throw e.cause as? Exception ?: e
+                    }
+                }
+            } finally {
+                pool.shutdown()
+            }
+        }
+        val results = serial + parallel
+        // Back to front so earlier splice points stay valid; bodies sharing a
+        // splice point go in reverse so they end up in walk order.
+        results.flatMap { it.diagnostics }
+            .withIndex()
+            .sortedWith(compareByDescending<IndexedValue<Pair<Int, List<DiagnosticsException>>>> { it.value.first }
+                .thenByDescending { it.index })
+            .forEach { (_, spliced) -> diagnosticsPump.addAll(spliced.first, spliced.second) }
+        // Intrinsics can register types and globals on the unit, so queued ones run here, in module order.
+        parallel.forEach { result ->
+            result.intrinsics.forEach { (node, owner) ->
+                context = owner
+                runIntrinsicsIfPresent(node)
+            }
+        }
+    }
+
+    /** Check one module's [bodies]; a null [queue] applies their intrinsics in place. */
+    private fun checkModuleBodies(
+        bodies: List<DeferredBody>,
+        queue: MutableList<Pair<ASTNode, SourceContext>>?,
+    ): BodyResults {
+        return compilationUnit.session.traced("semantic module bodies", bodies.first().context.file) {
+            KiraSemanticAnalyzer(compilationUnit, 1, declaredValueTypes.toMap(), queue).checkBodies(bodies)
+        }
+    }
+
+    private fun checkBodies(bodies: List<DeferredBody>): BodyResults {
+        val spliced = bodies.map { body ->
+            context = body.context
+            symbols = body.scopes
+            val start = diagnosticsPump.size
+            checkFunctionBody(body.decl)
+            body.pumpIndex to diagnosticsPump.subList(start, diagnosticsPump.size).toList()
+        }
+        return BodyResults(spliced, queuedIntrinsics?.toList().orEmpty())
     }
 
     private fun pump(message: String, location: SourcePosition, selectorLength: Int = 1, help: String = "") {
@@ -168,7 +356,7 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
     }
 
     fun expectSymbol(symbolName: String, symbolKind: SemanticSymbolKind) {
-        val res = compilationUnit.symbolTable.resolve(symbolName)
+        val res = symbols.resolve(symbolName)
         pumpOnTrue(
             res == null || res.kind != symbolKind, "Expected a $symbolKind for '$symbolName', but got '$res'",
             location = res?.declaredAt?.toPosition() ?: SourcePosition.UNKNOWN,
@@ -181,7 +369,7 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
         location: SourcePosition?,
         helpMessage: String = "'$symbolName' is not available at this scope. Or it has not been declared.",
     ) {
-        val res = compilationUnit.symbolTable.resolve(symbolName)
+        val res = symbols.resolve(symbolName)
         if (res == null) {
             pump(
                 "'${symbolName}' is an unknown symbol here.",
@@ -194,7 +382,7 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
 
     fun expectTypeNotDeclaredInModule(symbolName: String, location: SourcePosition?) {
         val moduleScope = try {
-            compilationUnit.symbolTable.findScope(SemanticScope.Module(context.getModuleUri()))
+            symbols.findScope(SemanticScope.Module(context.getModuleUri()))
         } catch (e: Exception) {
             null
         }
@@ -214,7 +402,7 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
         location: SourcePosition?,
         helpMessage: String = "Shadowing is not allowed. Rename this or the previous declaration.",
     ) {
-        val res = compilationUnit.symbolTable.resolve(symbolName)
+        val res = symbols.resolve(symbolName)
         if (res != null) {
             pump(
                 "'${symbolName}' was already declared at ${res.declaredAt}",
@@ -226,7 +414,7 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
     }
 
     fun expectType(symbolName: String, typeName: String) {
-        val res = compilationUnit.symbolTable.resolve(symbolName)
+        val res = symbols.resolve(symbolName)
         if (res == null || res.kind != SemanticSymbolKind.TYPE_SPECIFIER || res.name == typeName) {
             pump(
                 "Expected ${EnglishUtils.prependIndefiniteArticle(typeName)} for $symbolName, but got '$res'",
@@ -271,7 +459,7 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
         // Import public type symbols from the named module into the current module scope.
         // Baseline: only TYPE_SPECIFIER / TYPE_ALIAS / enums that were marked relativelyVisible.
         val uri = useStatement.uri.value
-        val foreignModule = compilationUnit.symbolTable.findScope(SemanticScope.Module(uri))
+        val foreignModule = symbols.findScope(SemanticScope.Module(uri))
         if (foreignModule == null) {
             // Module may not have been analyzed yet (source order). Soft-skip:
             // a later multipass would fix this; for now record nothing so we do
@@ -286,7 +474,7 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
             .forEach { symbol ->
                 // Re-declare into the current module scope (top of stack under any function).
                 // declare() no-ops on collision, which is fine.
-                compilationUnit.symbolTable.declare(symbol.name, symbol)
+                symbols.declare(symbol.name, symbol)
             }
     }
 
@@ -352,7 +540,7 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
         // Null safety: a Maybe<T> must be unwrapped before its payload is
         // reachable, so only the Maybe API itself may be accessed on one.
         val receiver = memberAccessExpr.origin as? Identifier ?: return
-        if (declaredValueTypes[receiver.value] != "Maybe") {
+        if ((declaredValueTypes[receiver.value] ?: inheritedValueTypes[receiver.value]) != "Maybe") {
             return
         }
         val member = (memberAccessExpr.member as? Identifier)?.value
@@ -365,7 +553,7 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
         }
         pump(
             "'$member' is not available on a 'Maybe' -- the value may be absent",
-            location = context.astOrigins[memberAccessExpr.member] ?: SourcePosition.UNKNOWN,
+            location = context.originOf(memberAccessExpr.member) ?: SourcePosition.UNKNOWN,
             selectorLength = member.length,
             help = "Unwrap it first: '${receiver.value}.unwrapOr(default).$member', " +
                 "or guard with 'if ${receiver.value}.isSome() { ... ${receiver.value}.unwrap().$member ... }'."
@@ -492,33 +680,34 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
         // Run any intrinsics attached to the variable declaration before semantic checks
         runIntrinsicsIfPresent(variableDecl)
         val varName = variableDecl.name.value
-        if (compilationUnit.symbolTable.containsInCurrentScope(varName)) {
+        if (symbols.containsInCurrentScope(variableDecl.name)) {
             pump(
                 "Variable '$varName' is already declared in this scope",
-                location = context.astOrigins[variableDecl.name] ?: SourcePosition.UNKNOWN,
+                location = context.originOf(variableDecl.name) ?: SourcePosition.UNKNOWN,
                 selectorLength = varName.length,
                 help = "Rename this variable or remove the previous declaration."
             )
         } else {
-            compilationUnit.symbolTable.declare(
-                varName,
+            symbols.declare(
+                variableDecl.name,
                 SemanticSymbol(
                     varName,
                     SemanticSymbolKind.VARIABLE,
                     Token.Type.IDENTIFIER,
                     SourceLocation.fromPosition(
-                        context.astOrigins[variableDecl.name] ?: SourcePosition.UNKNOWN,
+                        context.originOf(variableDecl.name) ?: SourcePosition.UNKNOWN,
                         context.file
                     )
                 )
             )
         }
         if (variableDecl.type.identifier is Identifier) {
-            val typeName = (variableDecl.type.identifier as Identifier).value
-            if (compilationUnit.symbolTable.resolve(typeName) == null) {
+            val typeIdentifier = variableDecl.type.identifier as Identifier
+            val typeName = typeIdentifier.value
+            if (symbols.resolve(typeIdentifier) == null) {
                 pump(
-                    "The type '$typeName' was not found at this scope (${compilationUnit.symbolTable.where().name.lowercase()})",
-                    location = context.astOrigins[variableDecl.type] ?: SourcePosition.UNKNOWN,
+                    "The type '$typeName' was not found at this scope (${symbols.where().name.lowercase()})",
+                    location = context.originOf(variableDecl.type) ?: SourcePosition.UNKNOWN,
                     selectorLength = typeName.length
                 )
             }
@@ -526,7 +715,7 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
             if (variableDecl.value != null) {
                 variableDecl.value!!.accept(this)
                 val literalClass = variableDecl.value!!::class
-                val resolvedSymbol = compilationUnit.symbolTable.resolveType(typeName)
+                val resolvedSymbol = symbols.resolveType(typeIdentifier)
                 val actualTypeName = if (resolvedSymbol != null && resolvedSymbol.name != typeName) {
                     resolvedSymbol.name
                 } else {
@@ -545,14 +734,14 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
                     "Type mismatch. Got a ${
                         literalClass.simpleName?.removeSuffix("Literal")?.lowercase()
                     } literal, but expected a '$expectedTypeName'",
-                    context.astOrigins[variableDecl.value],
+                    context.originOf(variableDecl.value),
                     help = "Correct the declaration type or the value itself.",
                 )
                 // Null safety: every type except Maybe<T> is non-nullable.
                 pumpOnTrue(
                     isNullValue(variableDecl.value) && typeName != "Maybe",
                     "'null' cannot be assigned to the non-nullable type '$typeName'",
-                    context.astOrigins[variableDecl.value],
+                    context.originOf(variableDecl.value),
                     selectorLength = 4,
                     help = "Types are non-nullable in Kira. Declare it as 'Maybe<$typeName>' " +
                         "to allow absence, then read it with unwrapOr(...) or guard on isSome()."
@@ -569,11 +758,20 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
         if (functionDecl.isStub()) {
             return
         }
+        val pending = pendingBodies
+        if (pending != null) {
+            pending += DeferredBody(functionDecl, context, symbols.fork(), diagnosticsPump.size)
+            return
+        }
+        checkFunctionBody(functionDecl)
+    }
+
+    private fun checkFunctionBody(functionDecl: FunctionDecl) {
         val funcName = when (functionDecl.name) {
             is Identifier -> (functionDecl.name as Identifier).value
             else -> "(anonymous)"
         }
-        compilationUnit.symbolTable.enter(SemanticScope.Function(funcName))
+        symbols.enter(SemanticScope.Function(funcName))
         if (functionDecl.generics.isNotEmpty()) {
             functionDecl.generics.forEach { typeParam ->
                 registerSingleTypeParameter(typeParam)
@@ -588,30 +786,31 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
                 stmt.accept(this)
             }
         }
-        compilationUnit.symbolTable.exit()
+        symbols.exit()
     }
 
     override fun visitClassDecl(classDecl: ClassDecl) {
         // Run intrinsics attached to class declarations (e.g., magic/global markers)
         runIntrinsicsIfPresent(classDecl)
         if (classDecl.name.identifier is Identifier) {
-            val typeName = (classDecl.name.identifier as Identifier).value
-            val existingSymbol = compilationUnit.symbolTable.resolve(typeName)
+            val typeIdentifier = classDecl.name.identifier as Identifier
+            val typeName = typeIdentifier.value
+            val existingSymbol = symbols.resolve(typeIdentifier)
             if (existingSymbol != null && existingSymbol.kind == SemanticSymbolKind.TYPE_SPECIFIER) {
                 if (classDecl.members.isNotEmpty()) {
-                    compilationUnit.symbolTable.enter(SemanticScope.Class(typeName))
+                    symbols.enter(SemanticScope.Class(typeName))
                     // Register generic type parameters in the class scope
                     registerGenericTypeParameters(classDecl.name)
                     classDecl.members.forEach { it.accept(this) }
-                    compilationUnit.symbolTable.exit()
+                    symbols.exit()
                 }
                 return
             }
             // TODO: fix this so that it uses the current intrinsic registry to check for this
             val hasGlobalIntrinsic = false
 //            val hasGlobalIntrinsic = try {
-//                context.astIntrinsicMarked.containsKey(classDecl) &&
-//                        context.astIntrinsicMarked[classDecl]?.contains(net.exoad.kira.core.IntrinsicRegistry.GLOBAL) == true
+//                context.isIntrinsified(classDecl) &&
+//                        classDecl.intrinsicMarks?.contains(net.exoad.kira.core.IntrinsicRegistry.GLOBAL) == true
 //            } catch (_: UninitializedPropertyAccessException) {
 //                false
 //            }
@@ -620,23 +819,23 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
                 SemanticSymbolKind.TYPE_SPECIFIER,
                 Token.Type.K_CLASS,
                 SourceLocation.fromPosition(
-                    context.astOrigins[classDecl] ?: SourcePosition.UNKNOWN,
+                    context.originOf(classDecl) ?: SourcePosition.UNKNOWN,
                     context.file
                 ),
                 relativelyVisible = classDecl.modifiers.contains(Modifier.PUBLIC)
             )
 
             if (hasGlobalIntrinsic) {
-                compilationUnit.symbolTable.declareGlobal(typeName, symbol)
+                symbols.declareGlobal(typeName, symbol)
             } else {
-                expectTypeNotDeclaredInModule(typeName, context.astOrigins[classDecl])
-                compilationUnit.symbolTable.declare(typeName, symbol)
+                expectTypeNotDeclaredInModule(typeName, context.originOf(classDecl))
+                symbols.declare(typeIdentifier, symbol)
             }
             if (classDecl.members.isNotEmpty()) {
-                compilationUnit.symbolTable.enter(SemanticScope.Class(typeName))
+                symbols.enter(SemanticScope.Class(typeName))
                 registerGenericTypeParameters(classDecl.name)
                 classDecl.members.forEach { it.accept(this) }
-                compilationUnit.symbolTable.exit()
+                symbols.exit()
             }
         }
     }
@@ -647,7 +846,7 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
         // Run intrinsics attached to the module declaration
         runIntrinsicsIfPresent(moduleDecl)
         val uri = moduleDecl.uri.value
-        val originPos = context.astOrigins[moduleDecl.name] ?: SourcePosition.UNKNOWN
+        val originPos = context.originOf(moduleDecl.name) ?: SourcePosition.UNKNOWN
         pumpOnTrue(
             !uri.matches(moduleUriMatcher),
             "A module URI must be in the format 'package:folder1.folder2.file' using [a-zA-Z0-9_] tokens.",
@@ -694,14 +893,14 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
             SemanticSymbolKind.TYPE_SPECIFIER,
             Token.Type.K_ENUM,
             SourceLocation.fromPosition(
-                context.astOrigins[enumDecl] ?: SourcePosition.UNKNOWN,
+                context.originOf(enumDecl) ?: SourcePosition.UNKNOWN,
                 context.file
             ),
             relativelyVisible = enumDecl.modifiers.contains(Modifier.PUBLIC)
         )
 
-        expectTypeNotDeclaredInModule(typeName, context.astOrigins[enumDecl])
-        compilationUnit.symbolTable.declare(typeName, symbol)
+        expectTypeNotDeclaredInModule(typeName, context.originOf(enumDecl))
+        symbols.declare(enumDecl.name, symbol)
     }
 
     override fun visitTraitDecl(traitDecl: TraitDecl) {
@@ -714,18 +913,18 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
                 SemanticSymbolKind.TYPE_SPECIFIER,
                 Token.Type.K_TRAIT,
                 SourceLocation.fromPosition(
-                    context.astOrigins[traitDecl] ?: SourcePosition.UNKNOWN,
+                    context.originOf(traitDecl) ?: SourcePosition.UNKNOWN,
                     context.file
                 ),
                 relativelyVisible = traitDecl.modifiers.contains(Modifier.PUBLIC)
             )
-            expectTypeNotDeclaredInModule(typeName, context.astOrigins[traitDecl])
-            compilationUnit.symbolTable.declare(typeName, symbol)
+            expectTypeNotDeclaredInModule(typeName, context.originOf(traitDecl))
+            symbols.declare(traitDecl.name.identifier as Identifier, symbol)
             if (traitDecl.members.isNotEmpty()) {
-                compilationUnit.symbolTable.enter(SemanticScope.Class(typeName))
+                symbols.enter(SemanticScope.Class(typeName))
                 registerGenericTypeParameters(traitDecl.name)
                 traitDecl.members.forEach { it.accept(this) }
-                compilationUnit.symbolTable.exit()
+                symbols.exit()
             }
         }
     }
@@ -740,19 +939,19 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
                 SemanticSymbolKind.TYPE_SPECIFIER,
                 Token.Type.K_VARIANT,
                 SourceLocation.fromPosition(
-                    context.astOrigins[variantDecl] ?: SourcePosition.UNKNOWN,
+                    context.originOf(variantDecl) ?: SourcePosition.UNKNOWN,
                     context.file
                 ),
                 relativelyVisible = variantDecl.modifiers.contains(Modifier.PUBLIC)
             )
-            expectTypeNotDeclaredInModule(typeName, context.astOrigins[variantDecl])
-            compilationUnit.symbolTable.declare(typeName, symbol)
+            expectTypeNotDeclaredInModule(typeName, context.originOf(variantDecl))
+            symbols.declare(variantDecl.name.identifier as Identifier, symbol)
             if (variantDecl.variants.isNotEmpty() || variantDecl.members.isNotEmpty()) {
-                compilationUnit.symbolTable.enter(SemanticScope.Class(typeName))
+                symbols.enter(SemanticScope.Class(typeName))
                 registerGenericTypeParameters(variantDecl.name)
                 variantDecl.variants.forEach { it.accept(this) }
                 variantDecl.members.forEach { it.accept(this) }
-                compilationUnit.symbolTable.exit()
+                symbols.exit()
             }
         }
     }
@@ -765,18 +964,18 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
         } else {
             pump(
                 "Type alias name must be a simple identifier",
-                location = context.astOrigins[typeAliasDecl.alias] ?: SourcePosition.UNKNOWN,
+                location = context.originOf(typeAliasDecl.alias) ?: SourcePosition.UNKNOWN,
                 selectorLength = 1
             )
             return
         }
-        expectTypeNotDeclaredInModule(aliasName, context.astOrigins[typeAliasDecl.alias.identifier])
+        expectTypeNotDeclaredInModule(aliasName, context.originOf(typeAliasDecl.alias.identifier))
         if (typeAliasDecl.target.identifier is Identifier) {
             val targetTypeName = (typeAliasDecl.target.identifier as Identifier).value
-            if (compilationUnit.symbolTable.resolve(targetTypeName) == null) {
+            if (symbols.resolve(typeAliasDecl.target.identifier as Identifier) == null) {
                 pump(
                     "The target type '$targetTypeName' for alias '$aliasName' was not found",
-                    location = context.astOrigins[typeAliasDecl.target] ?: SourcePosition.UNKNOWN,
+                    location = context.originOf(typeAliasDecl.target) ?: SourcePosition.UNKNOWN,
                     selectorLength = targetTypeName.length,
                     help = "Ensure the target type is declared before the alias, or check for typos."
                 )
@@ -787,20 +986,20 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
             SemanticSymbolKind.TYPE_ALIAS,
             Token.Type.K_ALIAS,
             SourceLocation.fromPosition(
-                context.astOrigins[typeAliasDecl.alias] ?: SourcePosition.UNKNOWN,
+                context.originOf(typeAliasDecl.alias) ?: SourcePosition.UNKNOWN,
                 context.file
             ),
             relativelyVisible = typeAliasDecl.modifiers.contains(Modifier.PUBLIC),
             aliasedType = typeAliasDecl.target
         )
-        compilationUnit.symbolTable.declare(aliasName, symbol)
+        symbols.declare(typeAliasDecl.alias.identifier as Identifier, symbol)
         if (typeAliasDecl.alias.children.isNotEmpty()) {
-            compilationUnit.symbolTable.enter(SemanticScope.Class(aliasName))
+            symbols.enter(SemanticScope.Class(aliasName))
             typeAliasDecl.alias.children.forEach { typeParam ->
                 registerSingleTypeParameter(typeParam)
             }
             typeAliasDecl.target.accept(this)
-            compilationUnit.symbolTable.exit()
+            symbols.exit()
         } else {
             typeAliasDecl.target.accept(this)
         }
@@ -819,6 +1018,13 @@ class KiraSemanticAnalyzer(private val compilationUnit: CompilationUnit) : KiraA
                 node.attachedIntrinsics
             }
             if (intrinsicsToApply.isEmpty()) return
+            if (pendingBodies != null) {
+                declarationIntrinsics += node
+            }
+            if (queuedIntrinsics != null) {
+                queuedIntrinsics += node to context
+                return
+            }
             for (intrinsic in intrinsicsToApply) {
                 val srcLoc = try {
                     SourceLocation.fromPosition(context.relativeOriginOf(node), context.file)
@@ -1,86 +1,253 @@
 package net.exoad.kira.compiler.analysis.semantic
 
-class KiraSymbolTable : Iterable<KiraScopeFrame> {
-
-    private val scopeStack = ArrayDeque<KiraScopeFrame>()
+import net.exoad.kira.compiler.frontend.parser.ast.elements.Identifier
+import net.exoad.kira.core.Identifiers
+
+/**
+ * The analyzer's scope stack. Names are keyed by their id in the unit's
+ * [Identifiers], the table its lexers interned them into, so an [Identifier]
+ * the parser bound to a token resolves without hashing its name again.
+ * Names without such an id (synthesized nodes, a tree from a cache, names
+ * the analyzer builds) are looked up by their text.
+ *
+ * Besides the frames themselves, the table keeps one binding chain per name:
+ * the innermost declaration first, each link pointing at the declaration it
+ * shadows. [resolve] is a single hash lookup however many scopes are open --
+ * every module stays open on top of the previous ones during analysis, so
+ * walking the frames grew with the size of the project. Leaving a scope pops
+ * its names off their chains.
+ */
+class KiraSymbolTable private constructor(
+    /** The table this one was [fork]ed from, or null for the analyzer's own table. */
+    private val parent: KiraSymbolTable?,
+    /** The parent's frames when the fork was made, bottom first; a fork sees these and nothing declared since. */
+    private val visible: List<KiraScopeFrame>,
+    private val identifiers: Identifiers,
+) : Iterable<KiraScopeFrame> {
+
+    /** @param identifiers the table the unit's lexers intern into */
+    constructor(identifiers: Identifiers = Identifiers()) : this(null, emptyList(), identifiers)
+
+    private class Binding(val symbol: SemanticSymbol, val frame: KiraScopeFrame, var shadowed: Binding?)
+
+    /** Innermost binding of every name declared in this table's own frames. */
+    private val bindings = HashMap<Int, Binding>()
+
+    /** Frames pushed on this table, bottom first. A [fork] starts with none and reads through [visible]. */
+    private val frames = ArrayList<KiraScopeFrame>()
+
+    /** Depth of the first frame this table owns. */
+    private val baseDepth: Int = visible.size
+
+    private val depth: Int get() = baseDepth + frames.size
 
     init {
         // ensure there is always at least one global module scope to avoid empty-stack access
-        enter(SemanticScope.Global)
+        if (parent == null) {
+            enter(SemanticScope.Global)
+        }
+    }
+
+    /**
+     * A table that resolves through the current scope chain but pushes its
+     * own frames on top. The analyzer hands one to each function body it
+     * checks off-thread; the shared frames must not change while forks read
+     * them.
+     *
+     * The fork sees exactly the frames open now. The declaration pass goes
+     * on to open later modules on top of them, and a body must not bind to
+     * a name one of those declares; it also closes the class a method was
+     * declared in, whose names the method body still needs.
+     */
+    fun fork(): KiraSymbolTable {
+        if (parent != null) {
+            throw KiraRuntimeException("Cannot fork a forked table")
+        }
+        return KiraSymbolTable(this, ArrayList(frames), identifiers)
     }
 
     fun enter(kind: SemanticScope) {
-        if (kind == SemanticScope.Global && scopeStack.any { it.kind == SemanticScope.Global }) {
+        if (kind == SemanticScope.Global && findScope(SemanticScope.Global) != null) {
             throw KiraRuntimeException("Cannot enter global scope: already exists!")
         }
-        scopeStack.addFirst(KiraScopeFrame(kind))
+        val frame = KiraScopeFrame(kind, identifiers)
+        frame.depth = depth
+        frames.add(frame)
     }
 
     fun totalSymbols(): Int {
-        return scopeStack.sumOf { it.symbols.size }
+        return sumOf { it.symbols.size }
     }
 
     fun clean() {
-        scopeStack.clear()
+        frames.clear()
+        bindings.clear()
     }
 
     fun exit() {
-        if (scopeStack.isEmpty()) {
+        if (frames.isEmpty()) {
             throw IllegalStateException("Cannot exit scope: no scope to exit!")
         }
-        scopeStack.removeFirst()
+        val frame = frames.removeAt(frames.lastIndex)
+        // the top frame is the deepest one, so its bindings head every chain they are on
+        for (id in frame.byId.keys) {
+            val shadowed = bindings[id]?.shadowed
+            if (shadowed == null) {
+                bindings.remove(id)
+            } else {
+                bindings[id] = shadowed
+            }
+        }
     }
 
     fun findScope(kind: SemanticScope): KiraScopeFrame? {
-        return scopeStack.find { it.kind == kind }
+        for (i in frames.indices.reversed()) {
+            if (frames[i].kind == kind) {
+                return frames[i]
+            }
+        }
+        for (i in visible.indices.reversed()) {
+            if (visible[i].kind == kind) {
+                return visible[i]
+            }
+        }
+        return null
+    }
+
+    private fun current(): KiraScopeFrame {
+        return frames.lastOrNull() ?: visible.last()
     }
 
     fun declare(identifier: String, symbol: SemanticSymbol): Boolean {
-        val current = scopeStack.first().symbols
-        if (current.containsKey(identifier)) return false
-        current[identifier] = symbol
-        return true
+        if (frames.isEmpty()) {
+            throw KiraRuntimeException("Cannot declare '$identifier' into a shared scope")
+        }
+        return declareIn(frames.last(), identifiers.intern(identifier), symbol)
+    }
+
+    fun declare(identifier: Identifier, symbol: SemanticSymbol): Boolean {
+        if (frames.isEmpty()) {
+            throw KiraRuntimeException("Cannot declare '${identifier.value}' into a shared scope")
+        }
+        val id = identifier.symbolIdIn(identifiers).takeIf { it >= 0 } ?: identifiers.intern(identifier.value)
+        return declareIn(frames.last(), id, symbol)
     }
 
     fun declareGlobal(identifier: String, symbol: SemanticSymbol): Boolean {
-        for (scope in scopeStack) {
-            if (scope.symbols.containsKey(identifier)) return false
+        if (parent != null) {
+            throw KiraRuntimeException("Cannot declare global '$identifier' from a forked table")
+        }
+        val id = identifiers.intern(identifier)
+        if (bindings.containsKey(id)) return false
+        return declareIn(frames.first(), id, symbol)
+    }
+
+    /**
+     * Declare [symbol] into [frame], which need not be the top one (pass 2
+     * copies imported types into module frames further down). Returns false
+     * when [frame] already has [identifier].
+     */
+    fun declareInto(frame: KiraScopeFrame, identifier: String, symbol: SemanticSymbol): Boolean {
+        val index = frame.depth - baseDepth
+        if (index !in frames.indices || frames[index] !== frame) {
+            throw KiraRuntimeException("Cannot declare '$identifier' into a scope this table does not own")
+        }
+        return declareIn(frame, identifiers.intern(identifier), symbol)
+    }
+
+    private fun declareIn(frame: KiraScopeFrame, id: Int, symbol: SemanticSymbol): Boolean {
+        if (frame.byId.containsKey(id)) return false
+        frame.byId[id] = symbol
+        // keep the chain innermost-first: link in below every deeper declaration of the same name
+        var deeper: Binding? = null
+        var next = bindings[id]
+        while (next != null && next.frame.depth > frame.depth) {
+            deeper = next
+            next = next.shadowed
+        }
+        val binding = Binding(symbol, frame, next)
+        if (deeper == null) {
+            bindings[id] = binding
+        } else {
+            deeper.shadowed = binding
         }
-        scopeStack.last().symbols[identifier] = symbol
         return true
     }
 
     fun resolve(identifier: String): SemanticSymbol? {
-        for (scope in scopeStack) {
-            scope.symbols[identifier]?.let { return it }
+        val id = identifiers.find(identifier)
+        return if (id < 0) null else resolve(id)
+    }
+
+    fun resolve(identifier: Identifier): SemanticSymbol? {
+        val id = identifier.symbolIdIn(identifiers)
+        return if (id < 0) resolve(identifier.value) else resolve(id)
+    }
+
+    private fun resolve(id: Int): SemanticSymbol? {
+        bindings[id]?.let { return it.symbol }
+        val parent = parent ?: return null
+        // Frames the parent closed since the fork (the class around a method)
+        // left its chains, so look in them directly. They sit above every
+        // frame it still has open, which is where this stops.
+        for (depth in visible.indices.reversed()) {
+            val frame = visible[depth]
+            if (parent.frames.getOrNull(depth) === frame) {
+                break
+            }
+            frame.byId[id]?.let { return it }
         }
-        return null
+        // Below that, the parent's chain; skip what was declared in frames opened after the fork.
+        var binding = parent.bindings[id]
+        while (binding != null && visible.getOrNull(binding.frame.depth) !== binding.frame) {
+            binding = binding.shadowed
+        }
+        return binding?.symbol
     }
 
     fun resolveType(identifier: String): SemanticSymbol? {
-        val symbol = resolve(identifier) ?: return null
+        return followAlias(resolve(identifier) ?: return null)
+    }
+
+    fun resolveType(identifier: Identifier): SemanticSymbol? {
+        return followAlias(resolve(identifier) ?: return null)
+    }
+
+    private fun followAlias(symbol: SemanticSymbol): SemanticSymbol {
         if (symbol.kind == SemanticSymbolKind.TYPE_ALIAS && symbol.aliasedType != null) {
             val targetIdentifier = symbol.aliasedType.identifier
-            if (targetIdentifier is net.exoad.kira.compiler.frontend.parser.ast.elements.Identifier) {
-                return resolveType(targetIdentifier.value) ?: symbol
+            if (targetIdentifier is Identifier) {
+                return resolveType(targetIdentifier) ?: symbol
             }
         }
         return symbol
     }
 
     fun containsInCurrentScope(identifier: String): Boolean {
-        return scopeStack.first().symbols.containsKey(identifier)
+        return current().symbols.containsKey(identifier)
+    }
+
+    fun containsInCurrentScope(identifier: Identifier): Boolean {
+        val id = identifier.symbolIdIn(identifiers)
+        return if (id < 0) containsInCurrentScope(identifier.value) else current().byId.containsKey(id)
     }
 
     fun peek(): Map<String, SemanticSymbol> {
-        return scopeStack.first().symbols.toMap()
+        return current().symbols.toMap()
     }
 
     fun where(): SemanticScope {
-        return scopeStack.first().kind
+        return current().kind
     }
 
+    /** Frames from the innermost out, including the ones shared with the table this was forked from. */
     override fun iterator(): Iterator<KiraScopeFrame> {
-        return scopeStack.iterator()
+        val own = frames.asReversed().iterator()
+        val shared = visible.asReversed().iterator()
+        return object : Iterator<KiraScopeFrame> {
+            override fun hasNext(): Boolean = own.hasNext() || shared.hasNext()
+
+            override fun next(): KiraScopeFrame = if (own.hasNext()) own.next() else shared.next()
+        }
     }
-}
\ No newline at end of file
+}
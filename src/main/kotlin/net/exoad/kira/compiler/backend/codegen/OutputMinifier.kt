@@ -57,35 +57,74 @@ object OutputMinifier {
      * The output ends with exactly one newline.
      */
     fun minify(language: MinifyLanguage, source: String, rename: Map<String, String> = emptyMap()): String {
-        val tokens = tokenize(language, source)
-        val ops = OPERATORS.getValue(language)
-        val out = StringBuilder()
-        var prev: Token? = null
-        var i = 0
-        while (i < tokens.size) {
-            val tok = tokens[i]
+        return buildString { minify(language, listOf(source), rename, this) }
+    }
+
+    /**
+     * Streaming form of [minify]: [parts] are scanned in order as one source
+     * and every token goes straight from the scanner through the filter into
+     * [out] -- no token list and no intermediate string, so a code generator
+     * can minify its buffers directly into the output file. A token must not
+     * straddle two parts.
+     */
+    fun minify(language: MinifyLanguage, parts: List<CharSequence>, rename: Map<String, String>, out: Appendable) {
+        val filter = Filter(OPERATORS.getValue(language), rename, out)
+        val scanner = Scanner(language)
+        parts.forEach { scanner.scan(it, filter::accept) }
+        filter.finish()
+    }
+
+    /** Drops comments and whitespace, renames identifiers and separates tokens that would otherwise merge. */
+    private class Filter(
+        private val ops: Set<String>,
+        private val rename: Map<String, String>,
+        private val out: Appendable,
+    ) {
+        private var prev: Token? = null
+
+        /** A comment came after [prev]; it separates [prev] from the next token a second time. */
+        private var afterComment = false
+
+        /** Whitespace held back until something follows it, so the output never ends in more than one newline. */
+        private val pending = StringBuilder()
+
+        fun accept(tok: Token) {
             if (tok.kind == Kind.COMMENT) {
-                if (prev != null && i + 1 < tokens.size && needsSpace(prev, tokens[i + 1], ops)) {
-                    out.append(' ')
-                }
-                i++
-                continue
+                afterComment = true
+                return
             }
-            if (prev != null && needsSpace(prev, tok, ops)) {
-                out.append(' ')
+            val last = prev
+            if (last != null && needsSpace(last, tok, ops)) {
+                if (afterComment) {
+                    pending.append(' ')
+                }
+                pending.append(' ')
             }
+            afterComment = false
             when (tok.kind) {
-                Kind.IDENT -> out.append(rename[tok.text] ?: tok.text)
+                Kind.IDENT -> write(rename[tok.text] ?: tok.text)
                 Kind.PREPROC -> {
-                    out.append(tok.text)
-                    out.append('\n')
+                    write(tok.text)
+                    pending.append('\n')
                 }
-                else -> out.append(tok.text)
+                else -> write(tok.text)
             }
             prev = tok
-            i++
         }
-        return out.toString().trimEnd() + "\n"
+
+        fun finish() {
+            out.append('\n')
+        }
+
+        private fun write(text: String) {
+            val end = text.indexOfLast { !it.isWhitespace() } + 1
+            if (end > 0) {
+                out.append(pending)
+                pending.setLength(0)
+                out.append(text, 0, end)
+            }
+            pending.append(text, end, text.length)
+        }
     }
 
     /**
@@ -165,158 +204,160 @@ object OutputMinifier {
         return ""
     }
 
-    private fun tokenize(language: MinifyLanguage, source: String): List<Token> {
-        val tokens = mutableListOf<Token>()
-        val s = source
-        val n = s.length
-        var i = 0
-        var atLineStart = true
+    /** Splits source text into tokens, handing each to the filter as soon as it is complete. */
+    private class Scanner(private val language: MinifyLanguage) {
+        /** Carried across parts: a part that starts a line may start with a directive. */
+        private var atLineStart = true
 
-        while (i < n) {
-            val c = s[i]
-            if (c.isWhitespace()) {
-                if (c == '\n') atLineStart = true
-                i++
-                continue
-            }
-            // C preprocessor directive: the whole line is opaque (e.g. the
-            // `#include <math.h>` lines the backend inserts for intrinsics).
-            if (language == MinifyLanguage.C && atLineStart && c == '#') {
-                var end = i
-                while (end < n && s[end] != '\n') end++
-                tokens.add(Token(Kind.PREPROC, s.substring(i, end).trimEnd()))
-                i = end
-                continue
-            }
-            atLineStart = false
+        fun scan(s: CharSequence, emit: (Token) -> Unit) {
+            val n = s.length
+            var i = 0
 
-            // Comments.
-            if (c == '/' && i + 1 < n) {
-                val d = s[i + 1]
-                if (d == '/') {
-                    var end = i + 2
-                    while (end < n && s[end] != '\n') end++
-                    tokens.add(Token(Kind.COMMENT, s.substring(i, end)))
-                    i = end
+            while (i < n) {
+                val c = s[i]
+                if (c.isWhitespace()) {
+                    if (c == '\n') atLineStart = true
+                    i++
                     continue
                 }
-                if (d == '*') {
-                    var end = i + 2
-                    while (end + 1 < n && !(s[end] == '*' && s[end + 1] == '/')) end++
-                    end = minOf(end + 2, n)
-                    tokens.add(Token(Kind.COMMENT, s.substring(i, end)))
+                // C preprocessor directive: the whole line is opaque (e.g. the
+                // `#include <math.h>` lines the backend inserts for intrinsics).
+                if (language == MinifyLanguage.C && atLineStart && c == '#') {
+                    var end = i
+                    while (end < n && s[end] != '\n') end++
+                    emit(Token(Kind.PREPROC, s.substring(i, end).trimEnd()))
                     i = end
                     continue
                 }
-            }
+                atLineStart = false
 
-            // Strings and char literals (both quote styles).
-            if (c == '"' || c == '\'') {
-                val quote = c
-                var end = i + 1
-                while (end < n) {
-                    if (s[end] == '\\') {
-                        end += 2
+                // Comments.
+                if (c == '/' && i + 1 < n) {
+                    val d = s[i + 1]
+                    if (d == '/') {
+                        var end = i + 2
+                        while (end < n && s[end] != '\n') end++
+                        emit(Token(Kind.COMMENT, s.substring(i, end)))
+                        i = end
                         continue
                     }
-                    if (s[end] == quote) {
-                        end++
-                        break
+                    if (d == '*') {
+                        var end = i + 2
+                        while (end + 1 < n && !(s[end] == '*' && s[end + 1] == '/')) end++
+                        end = minOf(end + 2, n)
+                        emit(Token(Kind.COMMENT, s.substring(i, end)))
+                        i = end
+                        continue
                     }
-                    end++
                 }
-                tokens.add(Token(Kind.STRING, s.substring(i, minOf(end, n))))
-                i = minOf(end, n)
-                continue
-            }
 
-            // JS template literals -- kept opaque. Codegen does not emit these
-            // today (interpolation lowers to concatenation), but an escaped
-            // backtick must not derail the scan if one ever appears.
-            if (language == MinifyLanguage.JS && c == '`') {
-                var end = i + 1
-                while (end < n) {
-                    if (s[end] == '\\') {
-                        end += 2
-                        continue
+                // Strings and char literals (both quote styles).
+                if (c == '"' || c == '\'') {
+                    val quote = c
+                    var end = i + 1
+                    while (end < n) {
+                        if (s[end] == '\\') {
+                            end += 2
+                            continue
+                        }
+                        if (s[end] == quote) {
+                            end++
+                            break
+                        }
+                        end++
                     }
-                    if (s[end] == '`') {
+                    emit(Token(Kind.STRING, s.substring(i, minOf(end, n))))
+                    i = minOf(end, n)
+                    continue
+                }
+
+                // JS template literals -- kept opaque. Codegen does not emit these
+                // today (interpolation lowers to concatenation), but an escaped
+                // backtick must not derail the scan if one ever appears.
+                if (language == MinifyLanguage.JS && c == '`') {
+                    var end = i + 1
+                    while (end < n) {
+                        if (s[end] == '\\') {
+                            end += 2
+                            continue
+                        }
+                        if (s[end] == '`') {
+                            end++
+                            break
+                        }
                         end++
-                        break
                     }
-                    end++
+                    emit(Token(Kind.TEMPLATE, s.substring(i, minOf(end, n))))
+                    i = minOf(end, n)
+                    continue
                 }
-                tokens.add(Token(Kind.TEMPLATE, s.substring(i, minOf(end, n))))
-                i = minOf(end, n)
-                continue
-            }
 
-            // Numbers (C and JS shapes overlap; suffixes ride along so `1U`
-            // stays one token and does not get split as `1 U`).
-            if (c.isDigit() || (c == '.' && i + 1 < n && s[i + 1].isDigit())) {
-                val start = i
-                if (c == '0' && i + 1 < n && (s[i + 1] == 'x' || s[i + 1] == 'X')) {
-                    i += 2
-                    while (i < n && (s[i].isDigit() || s[i] in 'a'..'f' || s[i] in 'A'..'F' || s[i] == '_')) i++
-                    if (i < n && s[i] == '.') {
-                        i++
+                // Numbers (C and JS shapes overlap; suffixes ride along so `1U`
+                // stays one token and does not get split as `1 U`).
+                if (c.isDigit() || (c == '.' && i + 1 < n && s[i + 1].isDigit())) {
+                    val start = i
+                    if (c == '0' && i + 1 < n && (s[i + 1] == 'x' || s[i + 1] == 'X')) {
+                        i += 2
                         while (i < n && (s[i].isDigit() || s[i] in 'a'..'f' || s[i] in 'A'..'F' || s[i] == '_')) i++
-                    }
-                    if (i < n && (s[i] == 'p' || s[i] == 'P')) {
-                        i++
-                        if (i < n && (s[i] == '+' || s[i] == '-')) i++
-                        while (i < n && (s[i].isDigit() || s[i] == '_')) i++
-                    }
-                } else if (c == '0' && i + 1 < n && (s[i + 1] == 'b' || s[i + 1] == 'B' || s[i + 1] == 'o' || s[i + 1] == 'O')) {
-                    i += 2
-                    while (i < n && (s[i].isDigit() || s[i] in 'a'..'f' || s[i] in 'A'..'F' || s[i] == '_')) i++
-                } else {
-                    while (i < n && (s[i].isDigit() || s[i] == '_')) i++
-                    if (i < n && s[i] == '.') {
-                        i++
-                        while (i < n && (s[i].isDigit() || s[i] == '_')) i++
-                    }
-                    if (i < n && (s[i] == 'e' || s[i] == 'E')) {
-                        i++
-                        if (i < n && (s[i] == '+' || s[i] == '-')) i++
+                        if (i < n && s[i] == '.') {
+                            i++
+                            while (i < n && (s[i].isDigit() || s[i] in 'a'..'f' || s[i] in 'A'..'F' || s[i] == '_')) i++
+                        }
+                        if (i < n && (s[i] == 'p' || s[i] == 'P')) {
+                            i++
+                            if (i < n && (s[i] == '+' || s[i] == '-')) i++
+                            while (i < n && (s[i].isDigit() || s[i] == '_')) i++
+                        }
+                    } else if (c == '0' && i + 1 < n && (s[i + 1] == 'b' || s[i + 1] == 'B' || s[i + 1] == 'o' || s[i + 1] == 'O')) {
+                        i += 2
+                        while (i < n && (s[i].isDigit() || s[i] in 'a'..'f' || s[i] in 'A'..'F' || s[i] == '_')) i++
+                    } else {
                         while (i < n && (s[i].isDigit() || s[i] == '_')) i++
+                        if (i < n && s[i] == '.') {
+                            i++
+                            while (i < n && (s[i].isDigit() || s[i] == '_')) i++
+                        }
+                        if (i < n && (s[i] == 'e' || s[i] == 'E')) {
+                            i++
+                            if (i < n && (s[i] == '+' || s[i] == '-')) i++
+                            while (i < n && (s[i].isDigit() || s[i] == '_')) i++
+                        }
+                        while (i < n && (s[i] in "uUlLfFn")) i++
                     }
-                    while (i < n && (s[i] in "uUlLfFn")) i++
+                    emit(Token(Kind.NUMBER, s.substring(start, i)))
+                    continue
                 }
-                tokens.add(Token(Kind.NUMBER, s.substring(start, i)))
-                continue
-            }
 
-            // Identifiers (and keywords -- they are identifier-shaped tokens
-            // that simply never appear in the rename map).
-            if (isIdentStart(c)) {
-                val start = i
-                while (i < n && isIdentPart(s[i])) i++
-                tokens.add(Token(Kind.IDENT, s.substring(start, i)))
-                continue
-            }
+                // Identifiers (and keywords -- they are identifier-shaped tokens
+                // that simply never appear in the rename map).
+                if (isIdentStart(c)) {
+                    val start = i
+                    while (i < n && isIdentPart(s[i])) i++
+                    emit(Token(Kind.IDENT, s.substring(start, i)))
+                    continue
+                }
 
-            // Multi-char operators, longest match first.
-            val multi = if (language == MinifyLanguage.C) C_MULTI else JS_MULTI
-            var matched: String? = null
-            for (len in 4 downTo 1) {
-                if (i + len <= n) {
-                    val cand = s.substring(i, i + len)
-                    if (cand in multi) {
-                        matched = cand
-                        break
+                // Multi-char operators, longest match first.
+                val multi = if (language == MinifyLanguage.C) C_MULTI else JS_MULTI
+                var matched: String? = null
+                for (len in 4 downTo 1) {
+                    if (i + len <= n) {
+                        val cand = s.substring(i, i + len)
+                        if (cand in multi) {
+                            matched = cand
+                            break
+                        }
                     }
                 }
-            }
-            if (matched != null) {
-                tokens.add(Token(Kind.PUNCT, matched))
-                i += matched.length
-                continue
-            }
+                if (matched != null) {
+                    emit(Token(Kind.PUNCT, matched))
+                    i += matched.length
+                    continue
+                }
 
-            tokens.add(Token(Kind.PUNCT, c.toString()))
-            i++
+                emit(Token(Kind.PUNCT, c.toString()))
+                i++
+            }
         }
-        return tokens
     }
 }
@@ -1,6 +1,6 @@
 package net.exoad.kira.compiler.backend.codegen
 
-import net.exoad.kira.Public
+import net.exoad.kira.compiler.CompilerSession
 import java.nio.file.Files
 import java.nio.file.Path
 
@@ -14,32 +14,34 @@ import java.nio.file.Path
  * asks [StdlibLayout] where its runtime file lives, next to the modules it
  * was asked to compile.
  *
- * Resolution order:
- *  1. The directory holding the loaded stdlib `.kira` sources (from
- *     [Public.Builtin.intrinsicalStandardLibrarySources], populated by the
- *     frontend from the resolved `kira:` dependencies).
- *  2. A `kira/` directory in the process working directory (test / dev
- *     fallback when the registry was never populated).
+ * Resolution order, for a given [CompilerSession]:
+ *  1. The directory holding the session's stdlib `.kira` sources
+ *     ([CompilerSession.stdlibSources], resolved by the frontend from the
+ *     `kira:` dependencies).
+ *  2. The session's [CompilerSession.stdlibRoot] (test / dev fallback when no
+ *     dependency was resolved).
  */
 object StdlibLayout {
-    fun stdlibRoot(): Path? {
-        val fromSources = Public.Builtin.intrinsicalStandardLibrarySources
+    fun stdlibRoot(session: CompilerSession = CompilerSession()): Path? {
+        val fromSources = session.stdlibSources
             .firstOrNull { it.endsWith(".kira") }
             ?.let { Path.of(it).parent }
         if (fromSources != null && Files.isDirectory(fromSources)) {
             return fromSources
         }
-        val cwd = Path.of("kira").toAbsolutePath().normalize()
-        return if (Files.isDirectory(cwd)) cwd else null
+        return session.stdlibRoot?.takeIf { Files.isDirectory(it) }
     }
 
     /** A runtime implementation file under `kira/<backend>/`, or null. */
-    fun runtimeFile(backend: String, fileName: String): Path? {
-        val root = stdlibRoot() ?: return null
+    fun runtimeFile(backend: String, fileName: String, session: CompilerSession = CompilerSession()): Path? {
+        val root = stdlibRoot(session) ?: return null
         val file = root.resolve(backend).resolve(fileName).normalize()
         return if (Files.isRegularFile(file)) file else null
     }
 
-    fun cFile(fileName: String): Path? = runtimeFile("c", fileName)
-    fun jsFile(fileName: String): Path? = runtimeFile("js", fileName)
+    fun cFile(fileName: String, session: CompilerSession = CompilerSession()): Path? =
+        runtimeFile("c", fileName, session)
+
+    fun jsFile(fileName: String, session: CompilerSession = CompilerSession()): Path? =
+        runtimeFile("js", fileName, session)
 }
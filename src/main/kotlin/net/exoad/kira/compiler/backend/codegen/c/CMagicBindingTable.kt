@@ -1,7 +1,9 @@
 package net.exoad.kira.compiler.backend.codegen.c
 
-import net.exoad.kira.Public
+import net.exoad.kira.compiler.CompilerSession
+import net.exoad.kira.compiler.StdlibSnapshot
 import org.yaml.snakeyaml.Yaml
+import java.io.Serializable
 import java.nio.file.Files
 import java.nio.file.Path
 
@@ -23,14 +25,15 @@ import java.nio.file.Path
  * Resolution is keyed by the canonical Kira name -- lowercased, with a leading
  * `@` and surrounding `_` stripped -- the same canonicalization
  * [KiraCCodeGenerator.mapIntrinsicName] applies to intrinsic spellings.
+ *
+ * One table per [CompilerSession] ([CompilerSession.magicBindings]), since
+ * the manifests come from whichever stdlib that session loads.
  */
-object CMagicBindingTable {
+class CMagicBindingTable private constructor(private val bindings: Map<String, Binding>) {
     data class Binding(
         val symbol: String,
         val includes: Set<String> = emptySet()
-    )
-
-    private val bindings: Map<String, Binding> by lazy { load() }
+    ) : Serializable
 
     /** C symbol a magic name lowers to, or null when the name is unbound. */
     fun resolveFunctionOrNull(name: String): String? {
@@ -48,59 +51,66 @@ object CMagicBindingTable {
         return bindings[name]?.includes
     }
 
-    private fun load(): Map<String, Binding> {
-        val out = mutableMapOf<String, Binding>()
-        val candidates = linkedSetOf<Path>()
-        candidates.addAll(bindFilesInStdlibSources())
-        candidates.addAll(bindFilesInCwdKiraDir())
-        candidates.forEach { out.putAll(parse(it)) }
-        return out
-    }
+    companion object {
+        fun load(session: CompilerSession): CMagicBindingTable {
+            val out = mutableMapOf<String, Binding>()
+            val candidates = linkedSetOf<Path>()
+            candidates.addAll(bindFilesInStdlibSources(session))
+            candidates.addAll(bindFilesInStdlibRoot(session))
+            candidates.forEach { out.putAll(parse(it, session.stdlibSnapshot)) }
+            return CMagicBindingTable(out)
+        }
+
+        /** Sibling `*.bind.yaml` files next to every discovered stdlib `.kira` module. */
+        private fun bindFilesInStdlibSources(session: CompilerSession): List<Path> {
+            return session.stdlibSources
+                .mapNotNull { sourcePath ->
+                    val kira = Path.of(sourcePath)
+                    if (!kira.fileName.toString().endsWith(".kira")) return@mapNotNull null
+                    val moduleBase = kira.fileName.toString().removeSuffix(".kira")
+                    kira.resolveSibling("$moduleBase.bind.yaml")
+                }
+                .filter { Files.isRegularFile(it) }
+        }
 
-    /** Sibling `*.bind.yaml` files next to every discovered stdlib `.kira` module. */
-    private fun bindFilesInStdlibSources(): List<Path> {
-        return Public.Builtin.intrinsicalStandardLibrarySources
-            .mapNotNull { sourcePath ->
-                val kira = Path.of(sourcePath)
-                if (!kira.fileName.toString().endsWith(".kira")) return@mapNotNull null
-                val moduleBase = kira.fileName.toString().removeSuffix(".kira")
-                kira.resolveSibling("$moduleBase.bind.yaml")
+        /** Fallback for test / CLI runs that resolved no stdlib dependency. */
+        private fun bindFilesInStdlibRoot(session: CompilerSession): List<Path> {
+            val root = session.stdlibRoot ?: return emptyList()
+            if (!Files.isDirectory(root)) return emptyList()
+            return Files.walk(root).use { stream ->
+                stream
+                    .filter { Files.isRegularFile(it) && it.toString().endsWith(".bind.yaml") }
+                    .toList()
             }
-            .filter { Files.isRegularFile(it) }
-    }
+        }
 
-    /** Fallback for test / CLI runs that never populated the stdlib registry. */
-    private fun bindFilesInCwdKiraDir(): List<Path> {
-        val root = Path.of("kira").toAbsolutePath().normalize()
-        if (!Files.isDirectory(root)) return emptyList()
-        return Files.walk(root).use { stream ->
-            stream
-                .filter { Files.isRegularFile(it) && it.toString().endsWith(".bind.yaml") }
-                .toList()
+        private fun parse(path: Path, snapshot: StdlibSnapshot?): Map<String, Binding> {
+            val text = runCatching { Files.readString(path) }.getOrNull() ?: return emptyMap()
+            return snapshot?.bindingsOrNull(text) ?: parseManifest(text)
         }
-    }
 
-    private fun parse(path: Path): Map<String, Binding> {
-        val out = mutableMapOf<String, Binding>()
-        val text = runCatching { Files.readString(path) }.getOrNull() ?: return out
-        val yaml = runCatching { Yaml().load<Any>(text) }.getOrNull() ?: return out
-        if (yaml !is Map<*, *>) return out
-        yaml.forEach { (key, value) ->
-            val name = key?.toString() ?: return@forEach
-            val binding = when (value) {
-                is String -> Binding(value)
-                is Map<*, *> -> {
-                    val symbol = value["symbol"]?.toString() ?: return@forEach
-                    val includes = (value["includes"] as? List<*>)
-                        ?.mapNotNull { it?.toString() }
-                        ?.toSet()
-                        ?: emptySet()
-                    Binding(symbol, includes)
+        /** Bindings declared by one `*.bind.yaml` manifest's [text]. */
+        fun parseManifest(text: String): Map<String, Binding> {
+            val out = mutableMapOf<String, Binding>()
+            val yaml = runCatching { Yaml().load<Any>(text) }.getOrNull() ?: return out
+            if (yaml !is Map<*, *>) return out
+            yaml.forEach { (key, value) ->
+                val name = key?.toString() ?: return@forEach
+                val binding = when (value) {
+                    is String -> Binding(value)
+                    is Map<*, *> -> {
+                        val symbol = value["symbol"]?.toString() ?: return@forEach
+                        val includes = (value["includes"] as? List<*>)
+                            ?.mapNotNull { it?.toString() }
+                            ?.toSet()
+                            ?: emptySet()
+                        Binding(symbol, includes)
+                    }
+                    else -> return@forEach
                 }
-                else -> return@forEach
+                out[name] = binding
             }
-            out[name] = binding
+            return out
         }
-        return out
     }
 }
@@ -36,6 +36,10 @@ object CMagicTypeLowering {
         // Fallible values -- slot payloads, unwrapped back to the declared type
         "Maybe" to CMagicTypeBinding("Maybe"),
         "Result" to CMagicTypeBinding("Result"),
+        // Buffered input reader -- by-value struct, methods take &scanner
+        "Scanner" to CMagicTypeBinding("Scanner"),
+        // Non-owning class reference -- Int64 side-table handle, upgrade() -> Maybe
+        "Weak" to CMagicTypeBinding("Weak"),
     )
 
     /** Container / wrapper types whose elements are erased to `KiraSlot`. */
@@ -6,7 +6,6 @@ import net.exoad.kira.compiler.backend.codegen.KiraCodeGenerator
 import net.exoad.kira.compiler.backend.codegen.MinifyLanguage
 import net.exoad.kira.compiler.backend.codegen.OutputMinifier
 import net.exoad.kira.compiler.backend.codegen.StdlibLayout
-import net.exoad.kira.compiler.backend.targets.GeneratedProvider
 import net.exoad.kira.compiler.frontend.parser.ast.RootASTNode
 import net.exoad.kira.compiler.frontend.parser.ast.declarations.*
 import net.exoad.kira.compiler.frontend.parser.ast.elements.BinaryOp
@@ -40,6 +39,8 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
         /** Layer 1 -- Kira facade types + thin Arr/Map runtime. */
         const val TEMPLATE_FILE = "c_generator.c"
         const val DEFAULT_OUTPUT = "out.kira.c"
+        /** Last line of [TEMPLATE_FILE]; everything after it is the user layer. */
+        private const val PRELUDE_END = "#endif /* KIRA_RUNTIME_H */"
         /** C keywords: never renamed by the minifier. */
         private val C_KEYWORDS = setOf(
             "auto", "break", "case", "char", "const", "continue", "default", "do",
@@ -50,34 +51,27 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
             "_Imaginary", "_Alignas", "_Alignof", "_Atomic", "_Generic",
             "_Noreturn", "_Static_assert", "_Thread_local",
         )
-        private lateinit var bundleFileContents: String
-        private lateinit var templateFileContents: String
+    }
 
-        fun fetchBundleFileContents(): String {
-            if (!::bundleFileContents.isInitialized) {
-                // The stdlib owns its runtime: kira/c/ sits next to the modules
-                // (see StdlibLayout). Resources remain a fallback for packaged jars.
-                val fromStdlib = StdlibLayout.cFile(BUNDLE_FILE)
-                val resource = Public::class.java.getResource("/$BUNDLE_FILE")
-                    ?: Public::class.java.getResource(BUNDLE_FILE)
-                bundleFileContents = fromStdlib?.let { Files.readString(it) }
-                    ?: resource?.readText()
-                    ?: File("src/main/resources/$BUNDLE_FILE").readText()
-            }
-            return bundleFileContents
-        }
+    private val session = compilationUnit.session
 
-        fun fetchTemplateFileContents(): String {
-            if (!::templateFileContents.isInitialized) {
-                val fromStdlib = StdlibLayout.cFile(TEMPLATE_FILE)
-                val resource = Public::class.java.getResource("/$TEMPLATE_FILE")
-                    ?: Public::class.java.getResource(TEMPLATE_FILE)
-                templateFileContents = fromStdlib?.let { Files.readString(it) }
-                    ?: resource?.readText()
-                    ?: File("src/main/resources/$TEMPLATE_FILE").readText()
-            }
-            return templateFileContents
-        }
+    private fun fetchBundleFileContents(): String {
+        // The stdlib owns its runtime: kira/c/ sits next to the modules
+        // (see StdlibLayout). Resources remain a fallback for packaged jars.
+        return session.runtimeText(BUNDLE_FILE) { readRuntimeFile(BUNDLE_FILE) }
+    }
+
+    private fun fetchTemplateFileContents(): String {
+        return session.runtimeText(TEMPLATE_FILE) { readRuntimeFile(TEMPLATE_FILE) }
+    }
+
+    private fun readRuntimeFile(name: String): String {
+        val fromStdlib = StdlibLayout.cFile(name, session)
+        val resource = Public::class.java.getResource("/$name")
+            ?: Public::class.java.getResource(name)
+        return fromStdlib?.let { Files.readString(it) }
+            ?: resource?.readText()
+            ?: File("src/main/resources/$name").readText()
     }
 
     private val buffer = StringBuilder()
@@ -180,8 +174,8 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
         arcScopes.lastOrNull()?.add(name to className)
     }
 
-    /** Containers that own heap storage and must be disposed at scope end. */
-    private val disposableContainers = setOf("List", "Map", "Set", "Stack", "Queue", "Deque")
+    /** Containers (and the Scanner buffer) that own heap storage and must be disposed at scope end. */
+    private val disposableContainers = setOf("List", "Map", "Set", "Stack", "Queue", "Deque", "Scanner")
 
     /**
      * Emit the cleanup for one scope entry. Class references are refcounted;
@@ -269,6 +263,12 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
     /** Return type of the function/method body currently being emitted. */
     private var currentReturnType: String? = null
 
+    /** `--instrument`: profiler id + C return type of the body being emitted. */
+    private data class ProfileProbe(val id: Int, val returnCType: String)
+    private var currentProbe: ProfileProbe? = null
+    /** Kira-side display name per probe id, emitted as `kira_prof_names[]`. */
+    private val probeNames = mutableListOf<String>()
+
     /**
      * Discover user traits, their flattened method sets, and which classes
      * implement them (via the class parent list). Generic traits are skipped
@@ -438,35 +438,41 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
 
     /**
      * One-shot emit of the whole compilation unit into [outputPath].
-     * Returns the generated C source (also written to disk).
      *
      * By default the user layer (everything after the runtime prelude) is
      * minified and obfuscated via [OutputMinifier]. The prelude itself stays
-     * byte-identical and readable. `GeneratedProvider.minifyOutput = false`
+     * byte-identical and readable. `minifyOutput = false` on the session
      * (the `--readable` CLI flag, or `build.minify: false`) restores the
      * pretty Jack-style formatting.
+     *
+     * Nothing is assembled in memory: the prelude, the include header and
+     * the user layer are written one after the other through a buffered
+     * writer, and the minifier filters the user layer on its way to the file.
      */
-    fun generate(outputPath: String = DEFAULT_OUTPUT): String {
+    fun generate(outputPath: String = DEFAULT_OUTPUT) {
         clean()
-        val source = buildTranslationUnit()
-        val written = if (GeneratedProvider.minifyOutput) minifyWritten(source) else source
-        File(outputPath).writeText(written)
-        return written
-    }
-
-    /** Minify + obfuscate the user layer, keeping the prelude untouched. */
-    private fun minifyWritten(source: String): String {
-        val marker = "#endif /* KIRA_RUNTIME_H */"
-        val idx = source.lastIndexOf(marker)
-        require(idx >= 0) { "C prelude end marker not found in emitted source" }
-        val cut = idx + marker.length
-        val prelude = source.substring(0, cut)
-        val user = source.substring(cut)
-        val reserved = OutputMinifier.extractIdentifiers(fetchBundleFileContents()) +
-            OutputMinifier.extractIdentifiers(fetchTemplateFileContents()) +
+        session.traced("emit C") { buildUserLayer() }
+        session.traced("write", outputPath) {
+            File(outputPath).bufferedWriter().use { out ->
+                writePrelude(out)
+                if (session.minifyOutput) {
+                    session.traced("minify") { minifyUserLayer(out) }
+                } else {
+                    out.append("\n\n")
+                    writeUserLayer(out)
+                }
+            }
+        }
+    }
+
+    /** Minify + obfuscate the user layer into [out]; the prelude was written untouched. */
+    private fun minifyUserLayer(out: Appendable) {
+        val reserved = session.runtimeIdentifiers(BUNDLE_FILE, fetchBundleFileContents()) +
+            session.runtimeIdentifiers(TEMPLATE_FILE, fetchTemplateFileContents()) +
             C_KEYWORDS + externFunctions.values + opaqueTypes + setOf("main", "this", "_empty")
         val rename = OutputMinifier.buildRenameMap(collectUserSymbols(), reserved)
-        return prelude + "\n" + OutputMinifier.minify(MinifyLanguage.C, user, rename)
+        out.append('\n')
+        OutputMinifier.minify(MinifyLanguage.C, listOf(userLayerHeader(), buffer), rename, out)
     }
 
     /**
@@ -499,32 +505,74 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
      */
     fun emitToString(): String {
         clean()
-        return buildTranslationUnit()
+        session.traced("emit C") { buildUserLayer() }
+        return buildString {
+            writePrelude(this)
+            append("\n\n")
+            writeUserLayer(this)
+        }
     }
 
-    private fun buildTranslationUnit(): String {
+    /**
+     * Layers 0 and 1, up to the `KIRA_RUNTIME_H` guard that closes the
+     * prelude (the marker `regenerate.sh` and the minifier split on).
+     */
+    private fun writePrelude(out: Appendable) {
         // Cupup-style layering: substrate first, then facade/runtime, then user.
+        // `--instrument` compiles the prelude profiler section in.
+        if (session.instrument) {
+            out.append("#define KIRA_INSTRUMENT 1\n")
+        }
         // Layer 0 -- compiler bundle (fixed-width types + named hooks)
-        buffer.appendLine(fetchBundleFileContents().trimEnd())
-        buffer.appendLine()
+        out.append(fetchBundleFileContents().trimEnd()).append("\n\n")
         // Layer 1 -- Kira-facing typedefs + thin collections
-        buffer.appendLine(fetchTemplateFileContents().trimEnd())
-        buffer.appendLine()
+        val template = fetchTemplateFileContents().trimEnd()
+        require(template.endsWith(PRELUDE_END)) { "C prelude end marker not found in $TEMPLATE_FILE" }
+        out.append(template)
+    }
 
-        // Extra includes requested by intrinsics (math.h, etc.)
-        // Collected while walking; prepended after the walk.
-        val bodyStart = buffer.length
+    private fun writeUserLayer(out: Appendable) {
+        out.append(userLayerHeader())
+        out.append(buffer)
+    }
 
+    /**
+     * Extra includes requested by intrinsics (math.h, etc.) and the profiler
+     * probe table. Both are only known once the walk is done, so they are
+     * written ahead of the body rather than spliced into it.
+     */
+    private fun userLayerHeader(): String {
+        if (requiredIncludes.isEmpty() && !session.instrument) {
+            return ""
+        }
+        return buildString {
+            requiredIncludes.forEach { appendLine("#include <$it>") }
+            appendLine()
+            if (session.instrument) {
+                // String literals survive minification, so the report
+                // always shows Kira names rather than renamed C symbols.
+                append("static Str const kira_prof_names[] = { ")
+                append(probeNames.joinToString(", ") { "\"${it.replace("\"", "\\\"")}\"" })
+                appendLine(" };")
+                appendLine("#define KIRA_PROF_COUNT ${probeNames.size}")
+                appendLine()
+            }
+        }
+    }
+
+    /** Layer 2 -- walk the user program into [buffer]. */
+    private fun buildUserLayer() {
         // Ensure @_opaque / @_extern marks are registered even if semantics skipped apply().
         harvestForeignMarks()
 
         // Discover generic templates + monomorphization sites before any emit.
-        collectGenericTemplates()
-        collectSpecializationSites()
-        collectUserClasses()
-        collectTraits()
+        session.traced("collect specializations") {
+            collectGenericTemplates()
+            collectSpecializationSites()
+            collectUserClasses()
+            collectTraits()
+        }
 
-        // Layer 2 -- user program
         // 1) Forward-declare structs (concrete + specialized)
         // 2) Emit full struct + enum bodies (complete types before prototypes)
         // 3) Trait interface + vtable structs
@@ -543,20 +591,6 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
         emittableSources().forEach { source ->
             visitRootASTNodeSkippingTypes(source.ast)
         }
-
-        if (requiredIncludes.isNotEmpty()) {
-            val body = buffer.substring(bodyStart)
-            val header = buildString {
-                requiredIncludes.forEach { appendLine("#include <$it>") }
-                appendLine()
-            }
-            buffer.delete(bodyStart, buffer.length)
-            buffer.insert(bodyStart, header)
-            // body already appended after delete+insert? no -- re-append
-            buffer.append(body)
-        }
-
-        return buffer.toString()
     }
 
     private fun eachClassDecl(action: (ClassDecl) -> Unit) {
@@ -582,8 +616,8 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
     private fun harvestForeignMarks() {
         compilationUnit.allSources().forEach { source ->
             if (shouldSkipSource(source)) return@forEach
-            val marks = runCatching { source.astIntrinsicMarked }.getOrNull() ?: return@forEach
-            marks.forEach { (node, intrinsics) ->
+            source.intrinsified.forEach { node ->
+                val intrinsics = node.intrinsicMarks ?: return@forEach
                 val names = intrinsics.map { it.name }.toSet()
                 if ("_opaque" in names) {
                     when (node) {
@@ -945,7 +979,12 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
             currentMethodClass = mangled
             val savedReturnType = currentReturnType
             currentReturnType = returnTypeName
+            val savedProbe = beginProfileProbe(
+                "${baseTypeNameOf(template.name)}<${args.joinToString(", ")}>.$methodName",
+                mapTypeName(returnTypeName)
+            )
             method.def.body?.forEach { it.accept(this) }
+            endProfileProbe(savedProbe, terminated = endsWithReturn(method.def.body))
             currentReturnType = savedReturnType
             currentMethodClass = null
             method.def.parameters.forEach { param ->
@@ -988,6 +1027,8 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
             buffer.append(mangled)
             buffer.append("), ")
             buffer.append(if (ownedM.isEmpty()) "null" else "${mangled}_finalize")
+            // Allocation tag: the Kira spelling, read by KIRA_RC_STATS builds.
+            buffer.append(", \"${baseTypeNameOf(template.name)}<${args.joinToString(", ")}>\"")
             buffer.appendLine(");")
             fields.forEach { field ->
                 appendIndented("self->")
@@ -1049,7 +1090,12 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
         buffer.appendLine()
         appendIndentedLine("{")
         indentLevel++
+        val savedProbe = beginProfileProbe(
+            "${functionLikeName(template.name)}<${args.joinToString(", ")}>",
+            mapTypeName(returnTypeName)
+        )
         template.def.body!!.forEach { it.accept(this) }
+        endProfileProbe(savedProbe, terminated = endsWithReturn(template.def.body))
         indentLevel--
         appendIndentedLine("}")
         buffer.appendLine()
@@ -1310,14 +1356,14 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
         // Magic names resolve through the loaded binding manifest first; the
         // intrinsic table remains as a fallback for unbound names (print family
         // is handled before this point, so it never arrives here in practice).
-        return CMagicBindingTable.resolveFunctionOrNull(canonical)
+        return session.magicBindings.resolveFunctionOrNull(canonical)
             ?: CIntrinsicsTable.resolveFunctionOrNull(canonical)
             ?: rawName.removePrefix("@")
     }
 
     private fun includeForIntrinsic(rawName: String) {
         val canonical = rawName.removePrefix("@").trim('_').lowercase()
-        val includes = CMagicBindingTable.includesOrNull(canonical)
+        val includes = session.magicBindings.includesOrNull(canonical)
             ?: CIntrinsicsTable.resolveIncludes(canonical)
         requiredIncludes.addAll(includes)
     }
@@ -1404,9 +1450,20 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
             userClassNames.contains(kiraType) || opaqueTypes.contains(kiraType)
     }
 
+    /** Float types slot by bit pattern; an integer cast would drop the fraction. */
+    private fun isFloatSlotType(kiraType: String?): Boolean {
+        return kiraType == "Float" || kiraType == "Float32" || kiraType == "Float64"
+    }
+
     /** Wrap an element as it goes *into* a slot container. */
     private fun emitSlotIn(elementType: String?, value: Expr) {
-        buffer.append(if (isPointerSlotType(elementType)) "KIRA_SLOT_PTR(" else "KIRA_SLOT(")
+        buffer.append(
+            when {
+                isPointerSlotType(elementType) -> "KIRA_SLOT_PTR("
+                isFloatSlotType(elementType) -> "KIRA_SLOT_FLT("
+                else -> "KIRA_SLOT("
+            }
+        )
         value.accept(this)
         buffer.append(")")
     }
@@ -1418,7 +1475,13 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
             return
         }
         val cType = mapTypeName(elementType)
-        buffer.append(if (isPointerSlotType(elementType)) "KIRA_UNSLOT_PTR(" else "KIRA_UNSLOT(")
+        buffer.append(
+            when {
+                isPointerSlotType(elementType) -> "KIRA_UNSLOT_PTR("
+                isFloatSlotType(elementType) -> "KIRA_UNSLOT_FLT("
+                else -> "KIRA_UNSLOT("
+            }
+        )
         buffer.append(cType)
         buffer.append(", ")
         inner()
@@ -1475,6 +1538,8 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
             "Stack", "Queue", "Deque" -> emitLinearAdtMethod(methodName, recvType, receiver, args, targs.getOrNull(0))
             "Maybe" -> emitMaybeMethod(methodName, receiver, args, targs.getOrNull(0))
             "Result" -> emitResultMethod(methodName, receiver, args, targs.getOrNull(0), targs.getOrNull(1))
+            "Scanner" -> emitScannerMethod(methodName, receiver, args)
+            "Weak" -> emitWeakMethod(methodName, receiver, args)
             else -> false
         }
     }
@@ -1483,7 +1548,7 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
 
     private fun emitStrMethod(methodName: String, receiver: Expr, args: List<Expr>): Boolean {
         val arity = when (methodName) {
-            "length", "isEmpty", "trim", "toLower", "toUpper", "hashCode" -> 0
+            "length", "isEmpty", "trim", "toLower", "toUpper", "hashCode", "toInt32", "toFloat64" -> 0
             "charAt", "contains", "startsWith", "endsWith", "equals", "split" -> 1
             "substring" -> 2
             else -> return false
@@ -1771,8 +1836,38 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
         }
     }
 
+    // ---- Scanner ---------------------------------------------------------
+
+    private fun emitScannerMethod(methodName: String, receiver: Expr, args: List<Expr>): Boolean {
+        when (methodName) {
+            "hasNext", "hasNextLine", "nextInt32", "nextInt64", "nextFloat64", "nextToken", "nextLine" -> {
+                if (args.isNotEmpty()) return false
+                emitRuntimeCall("Scanner_$methodName", receiver)
+                return true
+            }
+            else -> return false
+        }
+    }
+
+    // ---- Weak ------------------------------------------------------------
+
+    /**
+     * `upgrade()` hands back a strong (+1) reference inside the Maybe, so the
+     * local it is unwrapped into owns it; bare `isAlive()` takes no reference.
+     */
+    private fun emitWeakMethod(methodName: String, receiver: Expr, args: List<Expr>): Boolean {
+        when (methodName) {
+            "upgrade", "isAlive" -> {
+                if (args.isNotEmpty()) return false
+                emitRuntimeCall("Weak_$methodName", receiver)
+                return true
+            }
+            else -> return false
+        }
+    }
+
     private fun isMagicDecl(decl: Decl): Boolean {
-        // Marks live on SourceContext.astIntrinsicMarked, not decl.attachedIntrinsics
+        // Marks live on decl.intrinsicMarks, not decl.attachedIntrinsics
         // (that list is rarely populated). Treat @_magic only -- not @_opaque/@_extern.
         if (declHasIntrinsic(decl, "_magic")) {
             return true
@@ -1795,14 +1890,7 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
     }
 
     private fun declHasIntrinsic(decl: Decl, intrinsicName: String): Boolean {
-        compilationUnit.allSources().forEach { source ->
-            val marks = runCatching { source.astIntrinsicMarked }.getOrNull() ?: return@forEach
-            val arr = marks[decl] ?: return@forEach
-            if (arr.any { it.name == intrinsicName }) {
-                return true
-            }
-        }
-        return false
+        return decl.intrinsicMarks?.any { it.name == intrinsicName } == true
     }
 
     private fun toScreamingSnake(name: String): String {
@@ -1836,6 +1924,8 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
         emittingClassMembers = false
         currentMethodClass = null
         suppressThisRewrite = false
+        currentProbe = null
+        probeNames.clear()
     }
 
     private fun mangleMethodName(className: String, methodName: String): String {
@@ -1947,12 +2037,9 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
         if (buffer.isEmpty()) {
             return emitToString()
         }
-        // If someone only walked a root without prelude, prepend it
-        val text = buffer.toString()
-        if (!text.contains("KIRA_RUNTIME_H") && !text.contains("typedef int32_t Int32")) {
-            return fetchTemplateFileContents().trimEnd() + "\n\n" + text
-        }
-        return text
+        // The buffer only ever holds the user layer (the prelude is written
+        // straight to the output), so put the prelude in front of it.
+        return fetchTemplateFileContents().trimEnd() + "\n\n" + buffer
     }
 
     override fun visitRootASTNode(node: RootASTNode) {
@@ -2062,19 +2149,72 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
             null
         }
         emitArcReleasesBeforeReturn(moved)
+        val probe = currentProbe
+        if (probe != null) {
+            // Evaluate the value inside the probe so callee time is charged
+            // to this frame, then close the frame before leaving.
+            if (returnStatement.expr is NoExpr) {
+                appendIndentedLine("kira_prof_exit();")
+                appendIndentedLine("return;")
+                return
+            }
+            appendIndentedLine("{")
+            indentLevel++
+            appendIndented(probe.returnCType)
+            buffer.append(" kira_prof_ret = ")
+            emitReturnValue(returnStatement.expr)
+            buffer.appendLine(";")
+            appendIndentedLine("kira_prof_exit();")
+            appendIndentedLine("return kira_prof_ret;")
+            indentLevel--
+            appendIndentedLine("}")
+            return
+        }
         appendIndented("return")
         if (returnStatement.expr !is NoExpr) {
             buffer.append(" ")
-            val rt = currentReturnType
-            if (rt != null && rt in traitNames) {
-                emitCoercedTraitValue(returnStatement.expr, rt)
-            } else {
-                returnStatement.expr.accept(this)
-            }
+            emitReturnValue(returnStatement.expr)
         }
         buffer.appendLine(";")
     }
 
+    private fun emitReturnValue(expr: Expr) {
+        val rt = currentReturnType
+        if (rt != null && rt in traitNames) {
+            emitCoercedTraitValue(expr, rt)
+        } else {
+            expr.accept(this)
+        }
+    }
+
+    /**
+     * `--instrument`: open a profiler frame for the body about to be emitted
+     * and return the enclosing probe, to hand back to [endProfileProbe]. The
+     * program entry also installs the profiler (names table + atexit report).
+     */
+    private fun beginProfileProbe(displayName: String, returnCType: String, isEntry: Boolean = false): ProfileProbe? {
+        val saved = currentProbe
+        if (!session.instrument) {
+            return saved
+        }
+        if (isEntry) {
+            appendIndentedLine("kira_prof_install(kira_prof_names, KIRA_PROF_COUNT);")
+        }
+        val probe = ProfileProbe(probeNames.size, returnCType)
+        probeNames.add(displayName)
+        appendIndentedLine("kira_prof_enter(${probe.id});")
+        currentProbe = probe
+        return saved
+    }
+
+    /** Close the frame on the fall-through path; `return` closes its own. */
+    private fun endProfileProbe(saved: ProfileProbe?, terminated: Boolean) {
+        if (currentProbe != null && currentProbe !== saved && !terminated) {
+            appendIndentedLine("kira_prof_exit();")
+        }
+        currentProbe = saved
+    }
+
     override fun visitForIterationStatement(forIterationStatement: ForIterationStatement) {
         val iterExpr = forIterationStatement.forIterationExpr
         if (iterExpr.target is RangeExpr) {
@@ -2263,6 +2403,7 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
                 "substring", "charAt", "trim", "toLower", "toUpper" -> "Str"
                 "hashCode" -> "Int64"
                 "split" -> "List"
+                "toInt32", "toFloat64" -> "Result"
                 else -> null
             }
             "Num", "Int", "Int8", "Int16", "Int32", "Int64",
@@ -2311,6 +2452,19 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
                 "unwrapErr" -> typeArgs.getOrNull(1)
                 else -> null
             }
+            "Scanner" -> when (methodName) {
+                "hasNext", "hasNextLine" -> "Bool"
+                "nextInt32" -> "Int32"
+                "nextInt64" -> "Int64"
+                "nextFloat64" -> "Float64"
+                "nextToken", "nextLine" -> "Str"
+                else -> null
+            }
+            "Weak" -> when (methodName) {
+                "upgrade" -> "Maybe"
+                "isAlive" -> "Bool"
+                else -> null
+            }
             else -> null
         }
     }
@@ -2621,8 +2775,29 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
                     buffer.append("${baseName}_new()")
                     return
                 }
+                "Scanner" -> {
+                    buffer.append("Scanner_stdin()")
+                    return
+                }
+                "Weak" -> {
+                    buffer.append("Weak_empty()")
+                    return
+                }
             }
         }
+        if (baseName == "Weak" && objectInitExpr.positionalArgs.size == 1) {
+            // Borrows its target: a weak handle never takes a strong count.
+            buffer.append("Weak_of(")
+            objectInitExpr.positionalArgs[0].accept(this)
+            buffer.append(")")
+            return
+        }
+        if (baseName == "Scanner" && objectInitExpr.positionalArgs.size == 1) {
+            buffer.append("Scanner_open(")
+            objectInitExpr.positionalArgs[0].accept(this)
+            buffer.append(")")
+            return
+        }
         buffer.append("(")
         buffer.append(mapTypeName(typeName))
         buffer.append(") { ")
@@ -2744,8 +2919,10 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
         }
         knownValueTypes[variableDecl.name.value] = typeName
         // Track locals needing scope-end cleanup: class references (refcounted)
-        // and containers (own a heap buffer).
-        if (userClassNames.contains(typeName) || typeName in disposableContainers) {
+        // and containers (own a heap buffer). `b: Scanner = a` copies a struct
+        // that shares a's buffer, so only a disposes it.
+        val scannerCopy = typeName == "Scanner" && variableDecl.value?.let { isBorrowedRef(it) } == true
+        if (userClassNames.contains(typeName) || (typeName in disposableContainers && !scannerCopy)) {
             registerArcLocal(variableDecl.name.value, typeName)
         }
         appendIndented("")
@@ -2787,6 +2964,11 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
                 "Result" -> buffer.append("Result_err(0)")
                 else -> buffer.append("${typeName}_new()")
             }
+        } else if (typeName == "Scanner") {
+            // Empty until assigned; disposing it frees nothing.
+            buffer.append(" = Scanner_empty()")
+        } else if (typeName == "Weak") {
+            buffer.append(" = Weak_empty()")
         } else if (userClassNames.contains(typeName)) {
             // Uninitialized class-typed local: null-init so scope-end release is safe.
             buffer.append(" = null")
@@ -2856,16 +3038,24 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
         pushArcScope()
         val savedReturnType = currentReturnType
         currentReturnType = returnTypeName
+        // Any `main` is the program entry, so it installs the profiler whatever
+        // it returns; only a Void main is given the host's Int32 and `return 0`.
+        val isEntry = functionName == "main"
+        val hostsVoidMain = isEntry && returnsVoid
+        val savedProbe = beginProfileProbe(
+            functionName,
+            if (hostsVoidMain) "Int32" else mapTypeName(returnTypeName),
+            isEntry
+        )
         functionDecl.def.body!!.forEach { it.accept(this) }
         currentReturnType = savedReturnType
         // Fall-through path: an explicit `return` already emitted its own
         // releases, so this only covers reaching the closing brace.
         val bodyTerminated = endsWithReturn(functionDecl.def.body)
-        if (functionName == "main" && returnsVoid) {
-            popArcScope(terminated = bodyTerminated)
+        popArcScope(terminated = bodyTerminated)
+        endProfileProbe(savedProbe, terminated = bodyTerminated)
+        if (hostsVoidMain) {
             appendIndentedLine("return 0;")
-        } else {
-            popArcScope(terminated = bodyTerminated)
         }
         indentLevel--
         appendIndentedLine("}")
@@ -2943,10 +3133,12 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
             currentMethodClass = className
             val savedReturnType = currentReturnType
             currentReturnType = returnTypeName
+            val savedProbe = beginProfileProbe("$className.$methodName", mapTypeName(returnTypeName))
             method.def.body?.forEach { it.accept(this) }
             currentReturnType = savedReturnType
             currentMethodClass = null
             popArcScope(terminated = endsWithReturn(method.def.body))
+            endProfileProbe(savedProbe, terminated = endsWithReturn(method.def.body))
             // Drop param locals so they don't leak
             method.def.parameters.forEach { param ->
                 knownValueTypes.remove(param.name.value)
@@ -2988,6 +3180,8 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
             buffer.append(className)
             buffer.append("), ")
             buffer.append(if (owned.isEmpty()) "null" else "${className}_finalize")
+            // Allocation tag: the Kira class name, read by KIRA_RC_STATS builds.
+            buffer.append(", \"$className\"")
             buffer.appendLine(");")
             fields.forEach { field ->
                 appendIndented("self->")
@@ -3009,12 +3203,14 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
      *
      * Constructor arguments arrive borrowed, so the factory retains each owned
      * field; the finalizer releases them when the owner's count hits zero.
+     * It hands each field to a visitor rather than calling kira_rc_release
+     * itself, so the prelude cycle collector reuses it as the class's tracer.
      */
     private fun emitClassFinalizer(cName: String, ownedFields: List<String>): String {
         if (ownedFields.isEmpty()) return "null"
         appendIndented("static Void ")
         buffer.append(cName)
-        buffer.appendLine("_finalize(Void* p)")
+        buffer.appendLine("_finalize(Void* p, KiraRcVisitor visit)")
         appendIndentedLine("{")
         indentLevel++
         appendIndented("")
@@ -3023,7 +3219,7 @@ class KiraCCodeGenerator(override val compilationUnit: CompilationUnit) : KiraCo
         buffer.append(cName)
         buffer.appendLine("*)p;")
         ownedFields.forEach { field ->
-            appendIndented("kira_rc_release(self->")
+            appendIndented("visit(self->")
             buffer.append(field)
             buffer.appendLine(");")
         }
@@ -6,7 +6,7 @@ import net.exoad.kira.compiler.backend.codegen.KiraCodeGenerator
 import net.exoad.kira.compiler.backend.codegen.MinifyLanguage
 import net.exoad.kira.compiler.backend.codegen.OutputMinifier
 import net.exoad.kira.compiler.backend.codegen.StdlibLayout
-import net.exoad.kira.compiler.backend.targets.GeneratedProvider
+import net.exoad.kira.compiler.frontend.parser.ast.ASTNode
 import net.exoad.kira.compiler.frontend.parser.ast.RootASTNode
 import net.exoad.kira.compiler.frontend.parser.ast.declarations.*
 import net.exoad.kira.compiler.frontend.parser.ast.elements.BinaryOp
@@ -46,6 +46,8 @@ class KiraJSCodeGenerator(override val compilationUnit: CompilationUnit) : KiraC
         /** Layer 1 -- Kira stdlib surface as plain JS (see js_generator.js). */
         const val TEMPLATE_FILE = "js_generator.js"
         const val DEFAULT_OUTPUT = "out.kira.js"
+        /** Last line of [TEMPLATE_FILE]; everything after it is the user layer. */
+        private const val PRELUDE_END = "// __KIRA_JS_PRELUDE_END__"
         /**
          * JS keywords + globals/builtins the codegen or runtime may reference
          * literally (Math.*, Object.freeze, process, ...): never renamed.
@@ -59,7 +61,7 @@ class KiraJSCodeGenerator(override val compilationUnit: CompilationUnit) : KiraC
             "yield", "let", "static", "await", "async",
             "Object", "Array", "Function", "String", "Number", "Boolean",
             "Symbol", "BigInt", "Math", "JSON", "Date", "RegExp", "Error",
-            "Promise", "Map", "Set", "WeakMap", "WeakSet", "Proxy", "Reflect",
+            "Promise", "Map", "Set", "WeakMap", "WeakSet", "WeakRef", "Proxy", "Reflect",
             "Intl", "ArrayBuffer", "DataView", "undefined", "NaN", "Infinity",
             "globalThis", "process", "require", "module", "exports", "console",
             "Buffer", "arguments", "freeze",
@@ -67,20 +69,20 @@ class KiraJSCodeGenerator(override val compilationUnit: CompilationUnit) : KiraC
             "random", "trunc", "sign", "hypot", "cbrt", "clz32", "exp", "log",
             "main",
         )
-        private lateinit var templateFileContents: String
-
-        fun fetchTemplateFileContents(): String {
-            if (!::templateFileContents.isInitialized) {
-                // The stdlib owns its runtime: kira/js/ sits next to the modules
-                // (see StdlibLayout). Resources remain a fallback for packaged jars.
-                val fromStdlib = StdlibLayout.jsFile(TEMPLATE_FILE)
-                val resource = Public::class.java.getResource("/$TEMPLATE_FILE")
-                    ?: Public::class.java.getResource(TEMPLATE_FILE)
-                templateFileContents = fromStdlib?.let { Files.readString(it) }
-                    ?: resource?.readText()
-                    ?: File("src/main/resources/$TEMPLATE_FILE").readText()
-            }
-            return templateFileContents
+    }
+
+    private val session = compilationUnit.session
+
+    private fun fetchTemplateFileContents(): String {
+        // The stdlib owns its runtime: kira/js/ sits next to the modules
+        // (see StdlibLayout). Resources remain a fallback for packaged jars.
+        return session.runtimeText(TEMPLATE_FILE) {
+            val fromStdlib = StdlibLayout.jsFile(TEMPLATE_FILE, session)
+            val resource = Public::class.java.getResource("/$TEMPLATE_FILE")
+                ?: Public::class.java.getResource(TEMPLATE_FILE)
+            fromStdlib?.let { Files.readString(it) }
+                ?: resource?.readText()
+                ?: File("src/main/resources/$TEMPLATE_FILE").readText()
         }
     }
 
@@ -125,7 +127,7 @@ class KiraJSCodeGenerator(override val compilationUnit: CompilationUnit) : KiraC
     private val strMethods = setOf(
         "length", "isEmpty", "substring", "charAt", "contains",
         "startsWith", "endsWith", "split", "trim", "toLower", "toUpper",
-        "equals", "hashCode",
+        "equals", "hashCode", "toInt32", "toFloat64",
     )
     private val numMethods = setOf("toInt32", "toInt64", "toFloat32", "toFloat64", "abs")
     private val numScalarTypes = setOf(
@@ -184,30 +186,33 @@ class KiraJSCodeGenerator(override val compilationUnit: CompilationUnit) : KiraC
      *
      * By default the user layer (everything after the runtime prelude) is
      * minified and obfuscated via [OutputMinifier]; the prelude stays
-     * byte-identical and readable. `GeneratedProvider.minifyOutput = false`
+     * byte-identical and readable. `minifyOutput = false` on the session
      * (the `--readable` CLI flag, or `build.minify: false`) restores the
-     * pretty formatting.
+     * pretty formatting. Like the C backend, the prelude and the user layer
+     * are written straight through a buffered writer.
      */
-    fun generate(outputPath: String = DEFAULT_OUTPUT): String {
+    fun generate(outputPath: String = DEFAULT_OUTPUT) {
         clean()
-        val source = buildTranslationUnit()
-        val written = if (GeneratedProvider.minifyOutput) minifyWritten(source) else source
-        File(outputPath).writeText(written)
-        return written
-    }
-
-    /** Minify + obfuscate the user layer, keeping the prelude untouched. */
-    private fun minifyWritten(source: String): String {
-        val marker = "// __KIRA_JS_PRELUDE_END__"
-        val idx = source.lastIndexOf(marker)
-        require(idx >= 0) { "JS prelude end marker not found in emitted source" }
-        val cut = idx + marker.length
-        val prelude = source.substring(0, cut)
-        val user = source.substring(cut)
-        val reserved = OutputMinifier.extractIdentifiers(fetchTemplateFileContents()) +
+        session.traced("emit JS") { buildUserLayer() }
+        session.traced("write", outputPath) {
+            File(outputPath).bufferedWriter().use { out ->
+                writePrelude(out)
+                if (session.minifyOutput) {
+                    session.traced("minify") { minifyUserLayer(out) }
+                } else {
+                    out.append("\n\n").append(buffer)
+                }
+            }
+        }
+    }
+
+    /** Minify + obfuscate the user layer into [out]; the prelude was written untouched. */
+    private fun minifyUserLayer(out: Appendable) {
+        val reserved = session.runtimeIdentifiers(TEMPLATE_FILE, fetchTemplateFileContents()) +
             JS_RESERVED
         val rename = OutputMinifier.buildRenameMap(collectUserSymbols(), reserved)
-        return prelude + "\n" + OutputMinifier.minify(MinifyLanguage.JS, user, rename)
+        out.append('\n')
+        OutputMinifier.minify(MinifyLanguage.JS, listOf(buffer), rename, out)
     }
 
     /**
@@ -225,7 +230,18 @@ class KiraJSCodeGenerator(override val compilationUnit: CompilationUnit) : KiraC
     /** Build JS text without writing a file -- used by tests. */
     fun emitToString(): String {
         clean()
-        return buildTranslationUnit()
+        session.traced("emit JS") { buildUserLayer() }
+        return buildString {
+            writePrelude(this)
+            append("\n\n").append(buffer)
+        }
+    }
+
+    /** Layer 1 -- the stdlib runtime, up to the marker the minifier splits on. */
+    private fun writePrelude(out: Appendable) {
+        val template = fetchTemplateFileContents().trimEnd()
+        require(template.endsWith(PRELUDE_END)) { "JS prelude end marker not found in $TEMPLATE_FILE" }
+        out.append(template)
     }
 
     /**
@@ -248,12 +264,8 @@ class KiraJSCodeGenerator(override val compilationUnit: CompilationUnit) : KiraC
         }
     }
 
-    private fun buildTranslationUnit(): String {
-        // Layer 1 -- stdlib runtime, then Layer 2 -- user program.
-        buffer.append(fetchTemplateFileContents().trimEnd())
-        buffer.appendLine()
-        buffer.appendLine()
-
+    /** Layer 2 -- walk the user program into [buffer]. */
+    private fun buildUserLayer() {
         // Ensure @_opaque / @_extern marks are registered even if semantics skipped apply().
         harvestForeignMarks()
         collectSignatures()
@@ -269,16 +281,14 @@ class KiraJSCodeGenerator(override val compilationUnit: CompilationUnit) : KiraC
             buffer.appendLine()
             appendIndentedLine("main();")
         }
-
-        return buffer.toString()
     }
 
     /** Pull @_opaque / @_extern from parser marks into CompilationUnit registries. */
     private fun harvestForeignMarks() {
         compilationUnit.allSources().forEach { source ->
             if (shouldSkipSource(source)) return@forEach
-            val marks = runCatching { source.astIntrinsicMarked }.getOrNull() ?: return@forEach
-            marks.forEach { (node, intrinsics) ->
+            source.intrinsified.forEach { node ->
+                val intrinsics = node.intrinsicMarks ?: return@forEach
                 val names = intrinsics.map { it.name }.toSet()
                 if ("_opaque" in names) {
                     when (node) {
@@ -305,13 +315,7 @@ class KiraJSCodeGenerator(override val compilationUnit: CompilationUnit) : KiraC
                     else -> null
                 }
                 val node = expr ?: return@forEach
-                val nodeMarks = runCatching {
-                    compilationUnit.allSources().flatMap { s ->
-                        runCatching { s.astIntrinsicMarked }.getOrNull().orEmpty().entries
-                            .filter { it.key === node }
-                            .flatMap { it.value.map { m -> m.name } }
-                    }
-                }.getOrNull().orEmpty()
+                val nodeMarks = (node as? ASTNode)?.intrinsicMarks?.map { it.name }.orEmpty()
                 if ("_opaque" in nodeMarks && node is ClassDecl) {
                     compilationUnit.registerOpaqueType(baseTypeNameOf(node.name))
                 }
@@ -376,14 +380,7 @@ class KiraJSCodeGenerator(override val compilationUnit: CompilationUnit) : KiraC
     }
 
     private fun declHasIntrinsic(decl: Decl, intrinsicName: String): Boolean {
-        compilationUnit.allSources().forEach { source ->
-            val marks = runCatching { source.astIntrinsicMarked }.getOrNull() ?: return@forEach
-            val arr = marks[decl] ?: return@forEach
-            if (arr.any { it.name == intrinsicName }) {
-                return true
-            }
-        }
-        return false
+        return decl.intrinsicMarks?.any { it.name == intrinsicName } == true
     }
 
     private fun isOpaqueTypeName(typeName: String): Boolean = opaqueTypes.contains(typeName)
@@ -552,7 +549,7 @@ class KiraJSCodeGenerator(override val compilationUnit: CompilationUnit) : KiraC
         buffer.append(")")
     }
 
-    /** Math intrinsics lower straight to Math.* (no prelude helper needed). */
+    /** Math intrinsics lower straight to Math.*; kira:debug to prelude stubs. */
     private fun jsIntrinsic(rawName: String): String? {
         val canonical = rawName.removePrefix("@").trim('_').lowercase()
         return when (canonical) {
@@ -567,6 +564,11 @@ class KiraJSCodeGenerator(override val compilationUnit: CompilationUnit) : KiraC
             "abs" -> "Math.abs"
             "min" -> "Math.min"
             "max" -> "Math.max"
+            // kira:debug: no RC heap under GC, so every counter reads 0.
+            "rcstatsenabled" -> "kira_rc_stats_enabled"
+            "rcallocations", "rcfrees", "rcretains", "rcreleases", "rclive", "rcpeak" -> "kira_rc_stats_counter"
+            "rcdump" -> "kira_rc_stats_dump"
+            "collectcycles" -> "kira_rc_collect_cycles"
             else -> null
         }
     }
@@ -1138,6 +1140,8 @@ class KiraJSCodeGenerator(override val compilationUnit: CompilationUnit) : KiraC
             "Tuple8" -> "KiraTuple8"
             "Tuple9" -> "KiraTuple9"
             "Exception" -> "KiraException"
+            "Scanner" -> "KiraScanner"
+            "Weak" -> "KiraWeak"
             else -> baseName
         }
         buffer.append("new ")
@@ -1263,7 +1267,8 @@ class KiraJSCodeGenerator(override val compilationUnit: CompilationUnit) : KiraC
         "Map" to setOf("get", "remove"),
         "Stack" to setOf("pop", "peek"),
         "Queue" to setOf("dequeue", "peek"),
-        "Deque" to setOf("popFront", "popBack")
+        "Deque" to setOf("popFront", "popBack"),
+        "Weak" to setOf("upgrade")
     )
 
     /** True when [expr] already evaluates to a `Maybe`, so wrapping would nest one. */
@@ -1319,6 +1324,9 @@ class KiraJSCodeGenerator(override val compilationUnit: CompilationUnit) : KiraC
             userClassNames.contains(typeName) -> {
                 buffer.append(" = null")
             }
+            typeName == "Weak" -> {
+                buffer.append(" = new KiraWeak()")
+            }
             else -> {
                 // Scalars stay undefined until assigned.
             }
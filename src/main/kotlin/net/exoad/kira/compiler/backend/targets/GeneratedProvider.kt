@@ -3,7 +3,8 @@ package net.exoad.kira.compiler.backend.targets
 /**
  * Holds the information on the information necessary to output the final generated output format.
  *
- * Things like the compilation format with [OutputTarget]
+ * Things like the compilation format with [OutputTarget]. The target a
+ * compilation actually uses is chosen per [net.exoad.kira.compiler.CompilerSession].
  */
 object GeneratedProvider {
     enum class OutputTarget {
@@ -15,16 +16,4 @@ object GeneratedProvider {
         JS,
         NONE
     }
-
-    /**
-     * Represents where a generated output should go to
-     */
-    lateinit var outputFile: String
-    var outputMode: OutputTarget = OutputTarget.NONE
-
-    /**
-     * When true (default), the user layer of generated C/JS is minified and
-     * obfuscated. Set false via `--readable` or `build.minify: false`.
-     */
-    var minifyOutput: Boolean = true
-}
\ No newline at end of file
+}
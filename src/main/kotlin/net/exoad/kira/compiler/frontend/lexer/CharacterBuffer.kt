@@ -1,18 +1,27 @@
 package net.exoad.kira.compiler.frontend.lexer
 
-class CharacterBuffer(content: String) {
-    private val chars = (content + '\u0000').toCharArray()
+/**
+ * Reads [content] in place; anything at or past the end reads as `'\u0000'`, so
+ * no terminated copy of the file is made.
+ */
+class CharacterBuffer(private val content: String) {
     private var position = 0
-    val current: Char get() = chars[position]
-    val isAtEnd: Boolean get() = chars[position] == '\u0000'
+    val current: Char get() = peek()
+    val isAtEnd: Boolean get() = position >= content.length
 
     fun advance(): Char {
-        val char = chars[position]
+        val char = peek()
         if (char != '\u0000') position++
         return char
     }
 
+    /** Jump to [offset]; only [KiraLexer.relex] resumes mid-file. */
+    fun seek(offset: Int) {
+        position = offset
+    }
+
     fun peek(offset: Int = 0): Char {
-        return chars[position + offset]
+        val index = position + offset
+        return if (index < content.length) content[index] else '\u0000'
     }
-}
\ No newline at end of file
+}
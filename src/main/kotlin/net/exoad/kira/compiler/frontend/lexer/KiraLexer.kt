@@ -1,21 +1,26 @@
 package net.exoad.kira.compiler.frontend.lexer
 
 import net.exoad.kira.compiler.analysis.diagnostics.Diagnostics
+import net.exoad.kira.core.Identifiers
 import net.exoad.kira.core.Keywords
 import net.exoad.kira.core.Symbols
 import net.exoad.kira.core.isHexChar
 import net.exoad.kira.source.SourceContext
 import net.exoad.kira.source.SourcePosition
-import kotlin.properties.Delegates
 
 /**
- * The lexers turns the input string received from [net.exoad.kira.compiler.frontend.preprocessor.KiraPreprocessor] into [Token]s
- * and assigns them based on the symbol.
+ * The lexers turns the raw source text of a [SourceContext] into [Token]s and assigns them based on the symbol. Comments
+ * are skipped along with whitespace, see [skipWhitespace].
  *
- * It passes this list of symbols onto the [net.exoad.kira.compiler.frontend.parser.KiraParser]
+ * Tokens are appended to a [TokenStream] as offsets into [SourceContext.content] rather than allocated one by one; it is
+ * passed onto the [net.exoad.kira.compiler.frontend.parser.KiraParser]
+ *
+ * @param identifiers the table names are interned into; pass the owning
+ * [net.exoad.kira.compiler.CompilationUnit.identifiers] so the ids carry through to its symbol table
  */
-class KiraLexer(private val context: SourceContext) {
+class KiraLexer(private val context: SourceContext, identifiers: Identifiers = Identifiers()) {
     private val buffer = CharacterBuffer(context.content)
+    private val tokens = TokenStream.Builder(context.content, identifiers)
 
     // it is ill-advised to modify any of these on their owns
     private var pointer = 0
@@ -38,9 +43,37 @@ class KiraLexer(private val context: SourceContext) {
         buffer.advance()
     }
 
+    /**
+     * Lines (1-based) that hold nothing but a `//` comment, filled in as [tokenize] runs.
+     */
+    val lineComments: List<Int> get() = commentOnlyLines
+
+    private val commentOnlyLines = mutableListOf<Int>()
+
+    /** Line of the last token emitted, so a comment can tell whether it trails code. */
+    private var lastTokenLine = 0
+
+    /**
+     * Skips whitespace and `//` comments. Comments run up to the end of the line and are dropped here instead of in a
+     * separate preprocessing pass; string literals never reach this, so `//` inside quotes is left alone.
+     */
     fun skipWhitespace() {
-        while (peek() != Symbols.NULL.rep && peek().isWhitespace()) {
-            advancePointer()
+        while (true) {
+            val char = peek()
+            when {
+                char == Symbols.NULL.rep -> return
+                char.isWhitespace() -> advancePointer()
+                char == Symbols.SLASH.rep && peek(1) == Symbols.SLASH.rep -> {
+                    if (lastTokenLine != lineNumber) {
+                        commentOnlyLines.add(lineNumber)
+                    }
+                    while (peek() != Symbols.NULL.rep && peek() != Symbols.NEWLINE.rep) {
+                        advancePointer()
+                    }
+                }
+
+                else -> return
+            }
         }
     }
 
@@ -51,32 +84,50 @@ class KiraLexer(private val context: SourceContext) {
         return buffer.peek(k)
     }
 
-    private fun lexHexNumberLiteral(): Token {
+    /**
+     * Records a token spanning from [start] up to [pointer] that began at [startLine]:[startColumn]. [text] is only
+     * given when the token's text is not that slice of the source.
+     */
+    private fun emit(
+        type: Token.Type,
+        start: Int,
+        startLine: Int,
+        startColumn: Int,
+        text: String? = null,
+        symbolId: Int = -1,
+    ): Token.Type {
+        tokens.add(type, start, pointer - start, startLine, startColumn, text, symbolId)
+        lastTokenLine = startLine
+        return type
+    }
+
+    private fun lexHexNumberLiteral(): Token.Type {
         val start = pointer
-        val startLoc = SourcePosition(lineNumber, column)
+        val startLine = lineNumber
+        val startColumn = column
         while (peek().isHexChar()) {
             advancePointer()
         }
-        var content by Delegates.notNull<String>()
-        try {
-            content = context.content.substring(start, pointer).toInt(16).toString(10) // check
+        val digits = context.content.substring(start, pointer)
+        val content = try {
+            digits.toInt(16).toString(10) // check
         } catch (_: Exception) {
             Diagnostics.panic(
                 "KiraLexer::lexHexNumberLiteral",
-                "'$content' is not a valid hex literal.",
-                location = startLoc,
-                selectorLength = content.length,
+                "'$digits' is not a valid hex literal.",
+                location = SourcePosition(startLine, startColumn),
+                selectorLength = maxOf(1, digits.length),
                 context = context
             )
         }
-        return Token.Raw(Token.Type.L_INTEGER, content, start, startLoc)
+        return emit(Token.Type.L_INTEGER, start, startLine, startColumn, content)
     }
 
     /**
      * Maximal Munch approach to reading floating point and integer types by preferring
      * reading floating point first
      */
-    fun lexNumberLiteral(): Token {
+    fun lexNumberLiteral(): Token.Type {
         if (peek() == '0' && peek(1) == 'x') // hex parsing!
         {
             advancePointer()
@@ -84,7 +135,8 @@ class KiraLexer(private val context: SourceContext) {
             return lexHexNumberLiteral()
         }
         val start = pointer
-        val startLoc = SourcePosition(lineNumber, column)
+        val startLine = lineNumber
+        val startColumn = column
         var isFloat = false
         while (peek().isDigit()) {
             advancePointer()
@@ -99,18 +151,17 @@ class KiraLexer(private val context: SourceContext) {
                 }
             }
         }
-        val content = context.content.substring(start, pointer)
         return when {
-            isFloat -> Token.Raw(Token.Type.L_FLOAT, content, start, startLoc)
-            else -> Token.Raw(Token.Type.L_INTEGER, content, start, startLoc)
+            isFloat -> emit(Token.Type.L_FLOAT, start, startLine, startColumn)
+            else -> emit(Token.Type.L_INTEGER, start, startLine, startColumn)
         }
     }
 
-    fun lexStringLiteral(): Token {
+    fun lexStringLiteral(): Token.Type {
         val start = pointer
-        val startLoc = SourcePosition(lineNumber, column)
+        val startLine = lineNumber
+        val startColumn = column
         advancePointer() // skip opening "
-        val contentStart = pointer
         while (peek() != Symbols.NULL.rep && peek() != Symbols.DOUBLE_QUOTE.rep && peek() != '\n') {
             // escaped sequences are passed "as is" to the parser
             advancePointer()
@@ -125,18 +176,22 @@ class KiraLexer(private val context: SourceContext) {
                     append(Symbols.DOUBLE_QUOTE.rep)
                     append("' to terminate it")
                 },
-                location = startLoc,
+                location = SourcePosition(startLine, startColumn),
                 context = context
             )
         }
-        val content = String(context.content.toCharArray(), contentStart, pointer - contentStart)
+        // the token points at the opening quote but its text is only what is between the quotes; [TokenStream] knows
+        // to skip the quote for string literals
+        tokens.add(Token.Type.L_STRING, start, pointer - start - 1, startLine, startColumn)
+        lastTokenLine = startLine
         advancePointer()
-        return Token.Raw(Token.Type.L_STRING, content, start, startLoc)
+        return Token.Type.L_STRING
     }
 
-    fun lexIdentifier(): Token {
+    fun lexIdentifier(): Token.Type {
         val start = pointer
-        val startLoc = SourcePosition(lineNumber, column)
+        val startLine = lineNumber
+        val startColumn = column
         while (peek() != Symbols.NULL.rep) {
             val c = peek()
             if (c.isLetterOrDigit()) {
@@ -151,7 +206,7 @@ class KiraLexer(private val context: SourceContext) {
                     Diagnostics.panic(
                         "KiraLexer::lexIdentifier",
                         "Underscores are not allowed in identifiers. Only intrinsics may contain underscores; use camelCase or PascalCase for identifiers.",
-                        location = startLoc,
+                        location = SourcePosition(startLine, startColumn),
                         selectorLength = pointer - start,
                         context = context
                     )
@@ -159,21 +214,19 @@ class KiraLexer(private val context: SourceContext) {
             }
             break
         }
-        return Token.Raw(Token.Type.IDENTIFIER, context.content.substring(start, pointer), start, startLoc)
+        // the name is interned straight from the source; it is only copied out the first time it is seen
+        val symbolId = tokens.identifiers.intern(context.content, start, pointer)
+        val type = KEYWORD_TYPES.getOrNull(symbolId) ?: Token.Type.IDENTIFIER
+        return emit(type, start, startLine, startColumn, symbolId = symbolId)
     }
 
-    private val pendingClosingAngleBrackets: ArrayDeque<Token> = ArrayDeque()
-
     private var isInIntrinsic = false
 
-    fun nextToken(): Token {
-        if (pendingClosingAngleBrackets.isNotEmpty()) {
-            return pendingClosingAngleBrackets.removeFirst()
-        }
+    fun nextToken(): Token.Type {
         while (peek() != Symbols.NULL.rep) {
             skipWhitespace()
             if (peek() == Symbols.NULL.rep) {
-                return Token.Symbol(Token.Type.S_EOF, Symbols.NULL, pointer, SourcePosition(lineNumber, column))
+                return emit(Token.Type.S_EOF, pointer, lineNumber, column)
             }
             val char = peek()
             val start = pointer
@@ -193,43 +246,18 @@ class KiraLexer(private val context: SourceContext) {
                 }
             }
 
-            val startLoc = SourcePosition(lineNumber, column)
-            if (char.isLetter() || (isInIntrinsic && char == Symbols.UNDERSCORE.rep)) {  // identifiers and keywords usually have the same stuffs
-                val identifier = lexIdentifier()
-                val keywordTokenType = Keywords.reserved[identifier.content]
-                if (keywordTokenType != null) {
-                    return Token.Raw(
-                        keywordTokenType,
-                        identifier.content,
-                        identifier.pointerPosition,
-                        identifier.canonicalLocation
-                    )
-                }
-                // defensive fallback for keywords that may not be present due to build ordering or map issues
-                when (identifier.content) {
-                    "try" -> return Token.Raw(
-                        Token.Type.K_TRY,
-                        identifier.content,
-                        identifier.pointerPosition,
-                        identifier.canonicalLocation
-                    )
-
-                    "throw" -> return Token.Raw(
-                        Token.Type.K_THROW,
-                        identifier.content,
-                        identifier.pointerPosition,
-                        identifier.canonicalLocation
-                    )
+            val startLine = lineNumber
+            val startColumn = column
 
-                    "on" -> return Token.Raw(
-                        Token.Type.K_ON,
-                        identifier.content,
-                        identifier.pointerPosition,
-                        identifier.canonicalLocation
-                    )
+            /**
+             * Emits the symbol that started at [start] and ends at [pointer]
+             */
+            fun symbol(type: Token.Type): Token.Type {
+                return emit(type, start, startLine, startColumn)
+            }
 
-                    else -> return identifier
-                }
+            if (char.isLetter() || (isInIntrinsic && char == Symbols.UNDERSCORE.rep)) {  // identifiers and keywords usually have the same stuffs
+                return lexIdentifier()
             }
             if (char.isDigit()) {
                 return lexNumberLiteral()
@@ -243,19 +271,19 @@ class KiraLexer(private val context: SourceContext) {
                     Diagnostics.panic(
                         "KiraLexer::nextToken",
                         "Expected identifier after '@' for intrinsic marking.",
-                        location = startLoc,
+                        location = SourcePosition(startLine, startColumn),
                         context = context
                     )
                 }
                 // consume the character already advanced (the '@' was consumed by advancePointer above)
                 // now lex the following identifier characters (letters, digits, underscores)
                 val identStart = pointer
-                val identStartLoc = SourcePosition(lineNumber, column)
+                val identStartLine = lineNumber
+                val identStartColumn = column
                 while (localPeek(pointer - start).isLetterOrDigit() || localPeek(pointer - start) == Symbols.UNDERSCORE.rep) {
                     advancePointer()
                 }
-                val content = context.content.substring(identStart, pointer)
-                return Token.Raw(Token.Type.INTRINSIC_IDENTIFIER, content, identStart, identStartLoc)
+                return emit(Token.Type.INTRINSIC_IDENTIFIER, identStart, identStartLine, identStartColumn)
             }
             // i want to say this when statement looks great, but like man covering conditional, is just pure hell to my eyes to look at.
             //
@@ -276,12 +304,7 @@ class KiraLexer(private val context: SourceContext) {
                     when (localPeek(1)) {
                         Symbols.EQUALS.rep -> {
                             advancePointer()
-                            Token.LinkedSymbols(
-                                Token.Type.OP_CMP_LEQ,
-                                arrayOf(Symbols.OPEN_ANGLE, Symbols.EQUALS),
-                                start,
-                                startLoc
-                            )
+                            symbol(Token.Type.OP_CMP_LEQ)
                         }
 
                         Symbols.OPEN_ANGLE.rep -> {
@@ -289,383 +312,260 @@ class KiraLexer(private val context: SourceContext) {
                             when (localPeek(2)) {
                                 Symbols.EQUALS.rep -> {
                                     advancePointer()
-                                    Token.LinkedSymbols(
-                                        Token.Type.OP_ASSIGN_BIT_SHL,
-                                        arrayOf(Symbols.OPEN_ANGLE, Symbols.OPEN_ANGLE, Symbols.EQUALS),
-                                        start,
-                                        startLoc
-                                    )
+                                    symbol(Token.Type.OP_ASSIGN_BIT_SHL)
                                 }
 
-                                else -> Token.LinkedSymbols(
-                                    Token.Type.OP_BIT_SHL,
-                                    arrayOf(Symbols.OPEN_ANGLE, Symbols.OPEN_ANGLE),
-                                    start,
-                                    startLoc
-                                )
+                                else -> symbol(Token.Type.OP_BIT_SHL)
                             }
                         }
 
-                        else -> Token.Symbol(
-                            Token.Type.S_OPEN_ANGLE,
-                            Symbols.OPEN_ANGLE,
-                            start,
-                            startLoc
-                        )
+                        else -> symbol(Token.Type.S_OPEN_ANGLE)
                     }
 
-                Symbols.CLOSE_ANGLE.rep -> Token.Symbol(
-                    Token.Type.S_CLOSE_ANGLE,
-                    Symbols.CLOSE_ANGLE,
-                    start,
-                    startLoc
-                )
+                Symbols.CLOSE_ANGLE.rep -> symbol(Token.Type.S_CLOSE_ANGLE)
 
-                Symbols.HASH_MARK.rep -> Token.Symbol(
-                    Token.Type.OP_HASH_MARK,
-                    Symbols.HASH_MARK,
-                    start,
-                    startLoc
-                )
+                Symbols.HASH_MARK.rep -> symbol(Token.Type.OP_HASH_MARK)
 
                 Symbols.COLON.rep ->
                     when (localPeek(1)) {
                         Symbols.COLON.rep -> {
                             advancePointer()
-                            Token.LinkedSymbols(
-                                Token.Type.OP_SCOPE,
-                                arrayOf(Symbols.COLON, Symbols.COLON),
-                                start,
-                                startLoc
-                            )
+                            symbol(Token.Type.OP_SCOPE)
                         }
 
-                        else -> Token.Symbol(
-                            Token.Type.S_COLON,
-                            Symbols.COLON,
-                            start,
-                            startLoc
-                        )
+                        else -> symbol(Token.Type.S_COLON)
                     }
 
-                Symbols.QUESTION_MARK.rep -> Token.Symbol(
-                    Token.Type.S_QUESTION_MARK,
-                    Symbols.QUESTION_MARK,
-                    start,
-                    startLoc
-                )
+                Symbols.QUESTION_MARK.rep -> symbol(Token.Type.S_QUESTION_MARK)
 
-                Symbols.UNDERSCORE.rep -> Token.Symbol(
-                    Token.Type.S_UNDERSCORE,
-                    Symbols.UNDERSCORE,
-                    start,
-                    startLoc
-                )
+                Symbols.UNDERSCORE.rep -> symbol(Token.Type.S_UNDERSCORE)
 
                 Symbols.EXCLAMATION.rep ->
                     when (localPeek(1)) {
                         Symbols.EQUALS.rep -> {
                             advancePointer()
-                            Token.LinkedSymbols(
-                                Token.Type.OP_CMP_NEQ,
-                                arrayOf(Symbols.EXCLAMATION, Symbols.EQUALS),
-                                start,
-                                startLoc
-                            )
+                            symbol(Token.Type.OP_CMP_NEQ)
                         }
 
-                        else -> Token.Symbol(Token.Type.S_BANG, Symbols.EXCLAMATION, start, startLoc)
+                        else -> symbol(Token.Type.S_BANG)
                     }
 
                 Symbols.PLUS.rep ->
                     when (localPeek(1)) {
                         Symbols.EQUALS.rep -> {
                             advancePointer()
-                            Token.LinkedSymbols(
-                                Token.Type.OP_ASSIGN_ADD, arrayOf(
-                                    Symbols.PLUS,
-                                    Symbols.EQUALS
-                                ), start, startLoc
-                            )
+                            symbol(Token.Type.OP_ASSIGN_ADD)
                         }
 
-                        else -> Token.Symbol(Token.Type.OP_ADD, Symbols.PLUS, start, startLoc)
+                        else -> symbol(Token.Type.OP_ADD)
                     }
 
                 Symbols.HYPHEN.rep ->
                     when (localPeek(1)) {
                         Symbols.EQUALS.rep -> {
                             advancePointer()
-                            Token.LinkedSymbols(
-                                Token.Type.OP_ASSIGN_SUB, arrayOf(
-                                    Symbols.HYPHEN,
-                                    Symbols.EQUALS
-                                ), start, startLoc
-                            )
+                            symbol(Token.Type.OP_ASSIGN_SUB)
                         }
 
-                        else -> Token.Symbol(Token.Type.OP_SUB, Symbols.HYPHEN, start, startLoc)
+                        else -> symbol(Token.Type.OP_SUB)
                     }
 
                 Symbols.ASTERISK.rep ->
                     when (localPeek(1)) {
                         Symbols.EQUALS.rep -> {
                             advancePointer()
-                            Token.LinkedSymbols(
-                                Token.Type.OP_ASSIGN_MUL, arrayOf(
-                                    Symbols.ASTERISK,
-                                    Symbols.EQUALS
-                                ), start, startLoc
-                            )
+                            symbol(Token.Type.OP_ASSIGN_MUL)
                         }
 
-                        else -> Token.Symbol(Token.Type.OP_MUL, Symbols.ASTERISK, start, startLoc)
+                        else -> symbol(Token.Type.OP_MUL)
                     }
 
                 Symbols.SLASH.rep ->
                     when (localPeek(1)) {
                         Symbols.EQUALS.rep -> {
                             advancePointer()
-                            Token.LinkedSymbols(
-                                Token.Type.OP_ASSIGN_DIV, arrayOf(
-                                    Symbols.SLASH,
-                                    Symbols.EQUALS
-                                ), start, startLoc
-                            )
+                            symbol(Token.Type.OP_ASSIGN_DIV)
                         }
 
-                        else -> Token.Symbol(Token.Type.OP_DIV, Symbols.SLASH, start, startLoc)
+                        else -> symbol(Token.Type.OP_DIV)
                     }
 
                 Symbols.PERCENT.rep ->
                     when (localPeek(1)) {
                         Symbols.EQUALS.rep -> {
                             advancePointer()
-                            Token.LinkedSymbols(
-                                Token.Type.OP_ASSIGN_MOD, arrayOf(
-                                    Symbols.PERCENT,
-                                    Symbols.EQUALS
-                                ), start, startLoc
-                            )
+                            symbol(Token.Type.OP_ASSIGN_MOD)
                         }
 
-                        else -> Token.Symbol(Token.Type.OP_MOD, Symbols.PERIOD, start, startLoc)
+                        else -> symbol(Token.Type.OP_MOD)
                     }
 
-                Symbols.OPEN_BRACE.rep -> Token.Symbol(
-                    Token.Type.S_OPEN_BRACE,
-                    Symbols.OPEN_BRACE,
-                    start,
-                    startLoc
-                )
+                Symbols.OPEN_BRACE.rep -> symbol(Token.Type.S_OPEN_BRACE)
 
                 Symbols.PERIOD.rep ->
                     when (localPeek(1)) {
                         Symbols.PERIOD.rep -> {
                             advancePointer()
-                            Token.LinkedSymbols(
-                                Token.Type.OP_RANGE,
-                                arrayOf(Symbols.PERIOD, Symbols.PERIOD),
-                                start,
-                                startLoc
-                            )
+                            symbol(Token.Type.OP_RANGE)
                         }
 
-                        else -> Token.Symbol(Token.Type.S_DOT, Symbols.PERIOD, start, startLoc)
+                        else -> symbol(Token.Type.S_DOT)
                     }
 
-                Symbols.COMMA.rep -> Token.Symbol(
-                    Token.Type.S_COMMA,
-                    Symbols.COMMA,
-                    start,
-                    startLoc
-                )
+                Symbols.COMMA.rep -> symbol(Token.Type.S_COMMA)
 
                 Symbols.PERCENT.rep ->
                     when (localPeek(1)) {
                         Symbols.EQUALS.rep -> {
                             advancePointer()
-                            Token.LinkedSymbols(
-                                Token.Type.OP_ASSIGN_MOD,
-                                arrayOf(Symbols.PERCENT, Symbols.EQUALS),
-                                start,
-                                startLoc
-                            )
+                            symbol(Token.Type.OP_ASSIGN_MOD)
                         }
 
-                        else -> Token.Symbol(
-                            Token.Type.OP_MOD,
-                            Symbols.PERCENT,
-                            start,
-                            startLoc
-                        )
+                        else -> symbol(Token.Type.OP_MOD)
                     }
 
                 Symbols.CARET.rep ->
                     when (localPeek(1)) {
                         Symbols.EQUALS.rep -> {
                             advancePointer()
-                            Token.LinkedSymbols(
-                                Token.Type.OP_ASSIGN_BIT_XOR,
-                                arrayOf(Symbols.CARET, Symbols.EQUALS),
-                                start,
-                                startLoc
-                            )
+                            symbol(Token.Type.OP_ASSIGN_BIT_XOR)
                         }
 
-                        else -> Token.Symbol(
-                            Token.Type.OP_BIT_XOR,
-                            Symbols.CARET,
-                            start,
-                            startLoc
-                        )
+                        else -> symbol(Token.Type.OP_BIT_XOR)
                     }
 
                 Symbols.PIPE.rep ->
                     when (localPeek(1)) {
                         Symbols.PIPE.rep -> {
                             advancePointer()
-                            Token.LinkedSymbols(
-                                Token.Type.OP_CMP_OR,
-                                arrayOf(Symbols.PIPE, Symbols.PIPE),
-                                start,
-                                startLoc
-                            )
+                            symbol(Token.Type.OP_CMP_OR)
                         }
 
                         Symbols.EQUALS.rep -> {
                             advancePointer()
-                            Token.LinkedSymbols(
-                                Token.Type.OP_ASSIGN_BIT_OR,
-                                arrayOf(Symbols.PIPE, Symbols.EQUALS),
-                                start,
-                                startLoc
-                            )
+                            symbol(Token.Type.OP_ASSIGN_BIT_OR)
                         }
 
-                        else -> Token.Symbol(Token.Type.S_PIPE, Symbols.PIPE, start, startLoc)
+                        else -> symbol(Token.Type.S_PIPE)
                     }
 
                 Symbols.AMPERSAND.rep ->
                     when (localPeek(1)) {
                         Symbols.AMPERSAND.rep -> {
                             advancePointer()
-                            Token.LinkedSymbols(
-                                Token.Type.OP_CMP_AND,
-                                arrayOf(Symbols.AMPERSAND, Symbols.AMPERSAND),
-                                start,
-                                startLoc
-                            )
+                            symbol(Token.Type.OP_CMP_AND)
                         }
 
                         Symbols.EQUALS.rep -> {
                             advancePointer()
-                            Token.LinkedSymbols(
-                                Token.Type.OP_ASSIGN_BIT_AND,
-                                arrayOf(Symbols.AMPERSAND, Symbols.EQUALS),
-                                start,
-                                startLoc
-                            )
+                            symbol(Token.Type.OP_ASSIGN_BIT_AND)
                         }
 
-                        else -> Token.Symbol(
-                            Token.Type.S_AND,
-                            Symbols.AMPERSAND,
-                            start,
-                            startLoc
-                        )
+                        else -> symbol(Token.Type.S_AND)
                     }
 
-                Symbols.CLOSE_BRACE.rep -> Token.Symbol(
-                    Token.Type.S_CLOSE_BRACE,
-                    Symbols.CLOSE_BRACE,
-                    start,
-                    startLoc
-                )
+                Symbols.CLOSE_BRACE.rep -> symbol(Token.Type.S_CLOSE_BRACE)
 
-                Symbols.OPEN_BRACKET.rep -> Token.Symbol(
-                    Token.Type.S_OPEN_BRACKET,
-                    Symbols.OPEN_BRACKET,
-                    start,
-                    startLoc
-                )
+                Symbols.OPEN_BRACKET.rep -> symbol(Token.Type.S_OPEN_BRACKET)
 
-                Symbols.CLOSE_BRACKET.rep -> Token.Symbol(
-                    Token.Type.S_CLOSE_BRACKET,
-                    Symbols.CLOSE_BRACKET,
-                    start,
-                    startLoc
-                )
+                Symbols.CLOSE_BRACKET.rep -> symbol(Token.Type.S_CLOSE_BRACKET)
 
-                Symbols.TILDE.rep -> Token.Symbol(
-                    Token.Type.S_TILDE,
-                    Symbols.TILDE,
-                    start,
-                    startLoc
-                )
+                Symbols.TILDE.rep -> symbol(Token.Type.S_TILDE)
 
-                Symbols.OPEN_PARENTHESIS.rep -> Token.Symbol(
-                    Token.Type.S_OPEN_PARENTHESIS,
-                    Symbols.OPEN_PARENTHESIS,
-                    start,
-                    startLoc
-                )
+                Symbols.OPEN_PARENTHESIS.rep -> symbol(Token.Type.S_OPEN_PARENTHESIS)
 
-                Symbols.CLOSE_PARENTHESIS.rep -> Token.Symbol(
-                    Token.Type.S_CLOSE_PARENTHESIS,
-                    Symbols.CLOSE_PARENTHESIS,
-                    start,
-                    startLoc
-                )
+                Symbols.CLOSE_PARENTHESIS.rep -> symbol(Token.Type.S_CLOSE_PARENTHESIS)
 
-                Symbols.NEWLINE.rep -> Token.Symbol( // treat new lines as optional semicolons or statement delimiters ;) just like kotlin!
-                    Token.Type.S_SEMICOLON,
-                    Symbols.NEWLINE, // just an adhoc case
-                    start,
-                    startLoc
-                )
+                // treat new lines as optional semicolons or statement delimiters ;) just like kotlin!
+                Symbols.NEWLINE.rep -> symbol(Token.Type.S_SEMICOLON)
 
-                Symbols.STATEMENT_DELIMITER.rep -> Token.Symbol(
-                    Token.Type.S_SEMICOLON,
-                    Symbols.STATEMENT_DELIMITER,
-                    start,
-                    startLoc
-                )
+                Symbols.STATEMENT_DELIMITER.rep -> symbol(Token.Type.S_SEMICOLON)
 
                 Symbols.EQUALS.rep ->
                     when (localPeek(1)) {
                         Symbols.EQUALS.rep -> {
                             advancePointer()
-                            return Token.LinkedSymbols(
-                                Token.Type.OP_CMP_EQL,
-                                arrayOf(Symbols.EQUALS, Symbols.EQUALS),
-                                start,
-                                startLoc
-                            )
+                            return symbol(Token.Type.OP_CMP_EQL)
                         }
 
                         else ->
-                            return Token.Symbol(Token.Type.S_EQUAL, Symbols.EQUALS, start, startLoc)
+                            return symbol(Token.Type.S_EQUAL)
                     }
 
                 else -> Diagnostics.panic(
                     "KiraLexer::nextToken",
                     "Symbol '$char' is not known at Line $lineNumber, Column $column",
-                    location = startLoc,
+                    location = SourcePosition(startLine, startColumn),
                     context = context
                 )
             }
         }
-        return Token.Symbol(Token.Type.S_EOF, Symbols.NULL, pointer, SourcePosition(lineNumber, column))
+        return emit(Token.Type.S_EOF, pointer, lineNumber, column)
+    }
+
+    fun tokenize(): TokenStream {
+        while (nextToken() != Token.Type.S_EOF) {
+            // every token is recorded into [tokens] as it is lexed
+        }
+        return tokens.build()
+    }
+
+    /**
+     * Tokenize [context] again after one edit to the text [previous] was lexed from: [start] is where the edit
+     * begins, [removed] how many characters of the old text it replaced and [inserted] how many took their place.
+     * The result equals what [tokenize] would produce.
+     *
+     * No token spans a line (string literals and comments both stop at one) and nothing else carries from one line
+     * to the next, so lexing restarts at the start of the edited line. As soon as a token starts on a line after the
+     * edit where [previous] also had one, the two streams agree from there on and the rest of [previous] is copied
+     * over, shifted. [lineComments] only covers the lines actually re-lexed.
+     */
+    fun relex(previous: TokenStream, start: Int, removed: Int, inserted: Int): TokenStream {
+        val content = context.content
+        val delta = inserted - removed
+        val lineStart = content.lastIndexOf(Symbols.NEWLINE.rep, start - 1) + 1
+        val kept = previous.firstAtOrAfter(lineStart)
+        tokens.copy(previous, 0, kept)
+        lineNumber = when (kept) {
+            0 -> 1 + countNewlines(0, lineStart)
+            else -> previous.line(kept - 1) + countNewlines(previous.pointer(kept - 1), lineStart)
+        }
+        lastTokenLine = if (kept == 0) 0 else previous.line(kept - 1)
+        column = 1
+        pointer = lineStart
+        buffer.seek(lineStart)
+        val editEndLine = lineNumber + countNewlines(lineStart, start + inserted)
+        while (true) {
+            val type = nextToken()
+            if (type == Token.Type.S_EOF) {
+                return tokens.build()
+            }
+            val index = tokens.size - 1
+            val line = tokens.line(index)
+            if (line <= editEndLine) {
+                continue
+            }
+            val old = previous.firstAtOrAfter(tokens.start(index) - delta)
+            if (old < previous.size && previous.pointer(old) == tokens.start(index) - delta && previous.type(old) == type) {
+                tokens.copy(previous, old + 1, previous.size, delta, line - previous.line(old))
+                return tokens.build()
+            }
+        }
+    }
+
+    private fun countNewlines(from: Int, to: Int): Int {
+        var count = 0
+        for (i in from..<to) {
+            if (context.content[i] == Symbols.NEWLINE.rep) {
+                count++
+            }
+        }
+        return count
     }
 
-    fun tokenize(): List<Token> {
-        val res = mutableListOf<Token>()
-        var token by Delegates.notNull<Token>()
-        do {
-            token = nextToken()
-            res.add(token)
-        } while (token.type != Token.Type.S_EOF)
-        return res
+    companion object {
+        /** Keyword token types indexed by the keyword's id ([Identifiers.KEYWORDS]); any id past the end is a plain identifier. */
+        private val KEYWORD_TYPES: Array<Token.Type> =
+            Identifiers.KEYWORDS.map { Keywords.reserved.getValue(it) }.toTypedArray()
     }
-}
\ No newline at end of file
+}
@@ -2,6 +2,7 @@ package net.exoad.kira.compiler.frontend.lexer
 
 import net.exoad.kira.core.Symbols
 import net.exoad.kira.source.SourcePosition
+import java.io.Serializable
 
 /**
  * Semantical tokens representing each part of text that was parsed
@@ -11,7 +12,7 @@ sealed class Token(
     val content: String,
     val pointerPosition: Int,
     val canonicalLocation: SourcePosition
-) {
+) : Serializable {
     enum class Type(val rawDiagnosticsRepresentation: String) {
         X_ANY("X_ANY"), // reserved for [BuiltinTypes]
         L_INTEGER("Integer Literal"),
@@ -0,0 +1,302 @@
+package net.exoad.kira.compiler.frontend.lexer
+
+import net.exoad.kira.core.Identifiers
+import net.exoad.kira.core.Keywords
+import net.exoad.kira.core.Symbols
+import net.exoad.kira.source.SourcePosition
+import java.io.Serializable
+
+/**
+ * The token stream [KiraLexer] produces, stored as parallel arrays over the
+ * source text instead of one heap object per token:
+ *
+ * - `types`: the [Token.Type] ordinal
+ * - `starts` / `lengths`: the token's slice of the source
+ * - `positions`: line and column packed into one `Int`
+ * - `symbolIds`: the id of identifiers and keywords in the [Identifiers] it was lexed into
+ *
+ * Text is only sliced out of the source when something asks for it
+ * ([text]), so lexing a file allocates a handful of arrays rather than a
+ * token, a string and a [SourcePosition] per token. [KiraParser] reads the
+ * stream through the index API; [get] still materializes a [Token] for
+ * callers that want one (dumps, tests, diagnostics).
+ *
+ * @see net.exoad.kira.compiler.frontend.parser.TokenBuffer
+ */
+class TokenStream private constructor(
+    source: String,
+    private val types: IntArray,
+    private val starts: IntArray,
+    private val lengths: IntArray,
+    private val positions: IntArray,
+    override val size: Int,
+    /** Token text that is not a slice of [source] (hex literals are normalized to decimal). */
+    private val texts: Map<Int, String>,
+    /** Positions that do not fit the packed layout. */
+    private val widePositions: Map<Int, SourcePosition>,
+    identifiers: Identifiers,
+    ids: IntArray,
+) : AbstractList<Token>(), RandomAccess, Serializable {
+    /**
+     * The text the tokens slice. Not serialized: whoever stores a stream
+     * already stores its text ([net.exoad.kira.compiler.FrontendCache.ParsedSource.content])
+     * and hands it back through [attachSource] on load.
+     */
+    @Transient
+    private var source: String = source
+
+    /** Give a deserialized stream back the text it was lexed from. */
+    internal fun attachSource(source: String) {
+        this.source = source
+    }
+
+    /** The ids and the table they index, set together so no reader pairs one with the other's replacement. */
+    private class Interned(val identifiers: Identifiers, val ids: IntArray)
+
+    /**
+     * Neither is serialized, so a deserialized stream interns its names again
+     * into a table of its own on first use. Set once: [identifiers] and
+     * [symbolId] must keep agreeing for as long as the stream is read.
+     */
+    @Transient
+    @Volatile
+    private var interned: Interned? = Interned(identifiers, ids)
+
+    private fun interned(): Interned {
+        interned?.let { return it }
+        synchronized(this) {
+            interned?.let { return it }
+            val identifiers = Identifiers()
+            val ids = IntArray(size) { i ->
+                when {
+                    !INTERNED[types[i]] -> -1
+                    else -> texts[i]?.let { identifiers.intern(it) }
+                        ?: identifiers.intern(source, starts[i], starts[i] + lengths[i])
+                }
+            }
+            return Interned(identifiers, ids).also { interned = it }
+        }
+    }
+
+    /** The table [symbolId] indexes: the unit's the stream was lexed for. */
+    val identifiers: Identifiers get() = interned().identifiers
+
+    fun type(index: Int): Token.Type {
+        return TYPES[types[index]]
+    }
+
+    /** Interned name of an identifier or keyword token in [identifiers], -1 for any other token. */
+    fun symbolId(index: Int): Int {
+        return interned().ids[index]
+    }
+
+    fun text(index: Int): String {
+        texts[index]?.let { return it }
+        if (INTERNED[types[index]]) {
+            // every occurrence of a name shares the one interned string
+            val interned = interned()
+            return interned.identifiers.name(interned.ids[index])
+        }
+        val start = starts[index]
+        return when (TYPES[types[index]]) {
+            // the slice starts at the opening quote; the text does not
+            Token.Type.L_STRING -> source.substring(start + 1, start + 1 + lengths[index])
+            Token.Type.S_EOF -> Symbols.NULL.rep.toString()
+            else -> source.substring(start, start + lengths[index])
+        }
+    }
+
+    /** Offset of the token in the source, [Token.pointerPosition]. */
+    fun pointer(index: Int): Int {
+        return starts[index]
+    }
+
+    fun line(index: Int): Int {
+        val packed = positions[index]
+        return if (packed == WIDE) widePositions.getValue(index).lineNumber else packed ushr COLUMN_BITS
+    }
+
+    fun column(index: Int): Int {
+        val packed = positions[index]
+        return if (packed == WIDE) widePositions.getValue(index).column else packed and COLUMN_MASK
+    }
+
+    fun position(index: Int): SourcePosition {
+        val packed = positions[index]
+        return if (packed == WIDE) {
+            widePositions.getValue(index)
+        } else {
+            SourcePosition(packed ushr COLUMN_BITS, packed and COLUMN_MASK)
+        }
+    }
+
+    /** Index of the first token starting at or after [offset], [size] when there is none. Starts only ever grow. */
+    fun firstAtOrAfter(offset: Int): Int {
+        var low = 0
+        var high = size
+        while (low < high) {
+            val mid = (low + high) ushr 1
+            if (starts[mid] < offset) low = mid + 1 else high = mid
+        }
+        return low
+    }
+
+    override fun get(index: Int): Token {
+        if (index !in 0..<size) {
+            throw IndexOutOfBoundsException("Token $index is out of bounds for $size tokens")
+        }
+        return Token.Raw(type(index), text(index), pointer(index), position(index))
+    }
+
+    /**
+     * Append-only builder used by [KiraLexer]. Arrays grow by doubling, so a
+     * file costs `O(log n)` array allocations however many tokens it holds.
+     */
+    class Builder(private val source: String, val identifiers: Identifiers = Identifiers()) {
+        private var types = IntArray(INITIAL_CAPACITY)
+        private var starts = IntArray(INITIAL_CAPACITY)
+        private var lengths = IntArray(INITIAL_CAPACITY)
+        private var positions = IntArray(INITIAL_CAPACITY)
+        private var ids = IntArray(INITIAL_CAPACITY)
+        private var texts: HashMap<Int, String>? = null
+        private var widePositions: HashMap<Int, SourcePosition>? = null
+        var size = 0
+            private set
+
+        /**
+         * Appends a token covering `source[start, start + length)` and returns its index. [symbolId] is the name of
+         * identifiers and keywords, interned in [identifiers].
+         */
+        fun add(
+            type: Token.Type,
+            start: Int,
+            length: Int,
+            lineNumber: Int,
+            column: Int,
+            text: String? = null,
+            symbolId: Int = -1,
+        ): Int {
+            if (size == types.size) {
+                val capacity = size * 2
+                types = types.copyOf(capacity)
+                starts = starts.copyOf(capacity)
+                lengths = lengths.copyOf(capacity)
+                positions = positions.copyOf(capacity)
+                ids = ids.copyOf(capacity)
+            }
+            val index = size++
+            types[index] = type.ordinal
+            starts[index] = start
+            lengths[index] = length
+            ids[index] = symbolId
+            if (lineNumber in 0..MAX_LINE && column in 0..COLUMN_MASK) {
+                positions[index] = (lineNumber shl COLUMN_BITS) or column
+            } else {
+                positions[index] = WIDE
+                (widePositions ?: HashMap<Int, SourcePosition>().also { widePositions = it })[index] =
+                    SourcePosition(lineNumber, column)
+            }
+            if (text != null) {
+                (texts ?: HashMap<Int, String>().also { texts = it })[index] = text
+            }
+            return index
+        }
+
+        fun type(index: Int): Token.Type {
+            return TYPES[types[index]]
+        }
+
+        fun start(index: Int): Int {
+            return starts[index]
+        }
+
+        fun line(index: Int): Int {
+            val packed = positions[index]
+            return if (packed == WIDE) widePositions!!.getValue(index).lineNumber else packed ushr COLUMN_BITS
+        }
+
+        /**
+         * Appends tokens `[from, to)` of [stream], moved [offsetDelta] characters and [lineDelta] lines; columns
+         * stay as they were. Used by [KiraLexer.relex] to keep the tokens an edit did not touch. A stream lexed for
+         * another unit has its names interned again into [identifiers], so the new stream does not keep the old
+         * table (and every name that unit ever saw) alive.
+         */
+        fun copy(stream: TokenStream, from: Int, to: Int, offsetDelta: Int = 0, lineDelta: Int = 0) {
+            val interned = stream.interned()
+            val sameTable = interned.identifiers === identifiers
+            for (i in from..<to) {
+                val type = TYPES[stream.types[i]]
+                add(
+                    type,
+                    stream.starts[i] + offsetDelta,
+                    stream.lengths[i],
+                    stream.line(i) + lineDelta,
+                    stream.column(i),
+                    stream.texts[i],
+                    when {
+                        !INTERNED[stream.types[i]] -> -1
+                        sameTable -> interned.ids[i]
+                        else -> identifiers.intern(stream.text(i))
+                    },
+                )
+            }
+        }
+
+        fun build(): TokenStream {
+            return TokenStream(
+                source,
+                types.copyOf(size),
+                starts.copyOf(size),
+                lengths.copyOf(size),
+                positions.copyOf(size),
+                size,
+                texts ?: emptyMap(),
+                widePositions ?: emptyMap(),
+                identifiers,
+                ids.copyOf(size),
+            )
+        }
+    }
+
+    companion object {
+        private const val INITIAL_CAPACITY = 256
+
+        /** Columns get the low 12 bits, lines the remaining 19 (the sign bit marks [WIDE]). */
+        private const val COLUMN_BITS = 12
+        private const val COLUMN_MASK = (1 shl COLUMN_BITS) - 1
+        private const val MAX_LINE = (1 shl (31 - COLUMN_BITS)) - 1
+        private const val WIDE = -1
+
+        private val TYPES = Token.Type.entries.toTypedArray()
+
+        /** Token types whose text is a name: identifiers and keywords. */
+        private val INTERNED = BooleanArray(TYPES.size) { i ->
+            TYPES[i] == Token.Type.IDENTIFIER || TYPES[i] in Keywords.reserved.values
+        }
+
+        /**
+         * Wraps tokens that did not come from [KiraLexer] (an empty list for a
+         * context that was never lexed, mostly). Text is kept per token since
+         * there is no source to slice.
+         */
+        fun of(tokens: List<Token>): TokenStream {
+            if (tokens is TokenStream) {
+                return tokens
+            }
+            val builder = Builder("")
+            tokens.forEach { token ->
+                val position = token.canonicalLocation
+                builder.add(
+                    token.type,
+                    token.pointerPosition,
+                    0,
+                    position.lineNumber,
+                    position.column,
+                    token.content,
+                    if (INTERNED[token.type.ordinal]) builder.identifiers.intern(token.content) else -1,
+                )
+            }
+            return builder.build()
+        }
+    }
+}
@@ -2,6 +2,7 @@ package net.exoad.kira.compiler.frontend.parser
 
 import net.exoad.kira.compiler.analysis.diagnostics.Diagnostics
 import net.exoad.kira.compiler.frontend.lexer.Token
+import net.exoad.kira.compiler.frontend.lexer.TokenStream
 import net.exoad.kira.compiler.frontend.parser.ast.ASTNode
 import net.exoad.kira.compiler.frontend.parser.ast.RootASTNode
 import net.exoad.kira.compiler.frontend.parser.ast.declarations.*
@@ -26,24 +27,49 @@ import kotlin.properties.Delegates
  * valid grammar.
  */
 class KiraParser(private val context: SourceContext) {
-    private val buffer = TokenBuffer(context.tokens)
+    private val buffer = TokenBuffer(TokenStream.of(context.tokens))
 
     init {
-        context.astOrigins = IdentityHashMap()
-        context.astIntrinsicMarked = IdentityHashMap()
+        context.intrinsified.clear()
+    }
+
+    /** Records the current token's position on [node]; reads the packed position without building a [SourcePosition]. */
+    fun <T : ASTNode> putOrigin(node: T): T {
+        return putOrigin(node, buffer.lineAt(), buffer.columnAt())
     }
 
     fun <T : ASTNode> putOrigin(
         node: T,
-        location: SourcePosition = here(),
+        location: SourcePosition,
     ): T // returns the original value to facilitate with easier refactoring
     {
-        context.astOrigins[node] = location
+        return putOrigin(node, location.lineNumber, location.column)
+    }
+
+    private fun <T : ASTNode> putOrigin(node: T, lineNumber: Int, column: Int): T {
+        // the singleton nodes are shared by every source (and every parser thread), so they carry no position
+        if (!isSharedNode(node)) {
+            node.packedOrigin = ASTNode.packOrigin(lineNumber, column)
+        }
         return node
     }
 
+    private fun isSharedNode(node: ASTNode): Boolean {
+        return node === NoExpr || node === NullLiteral || node === AnonymousIdentifier
+    }
+
+    private fun markIntrinsics(node: ASTNode, intrinsics: Array<net.exoad.kira.core.CompilerIntrinsic>) {
+        if (isSharedNode(node)) {
+            return
+        }
+        if (node.intrinsicMarks == null) {
+            context.intrinsified.add(node)
+        }
+        node.intrinsicMarks = intrinsics
+    }
+
     fun here(): SourcePosition {
-        return peek().canonicalLocation
+        return peekPosition()
     }
 
     /**
@@ -86,6 +112,21 @@ class KiraParser(private val context: SourceContext) {
         return buffer.peek(k)
     }
 
+    /**
+     * [peek] for when only part of the token is needed; none of these materialize a [Token].
+     */
+    private fun peekType(k: Int = 0): Token.Type {
+        return buffer.typeAt(k)
+    }
+
+    private fun peekText(k: Int = 0): String {
+        return buffer.textAt(k)
+    }
+
+    private fun peekPosition(k: Int = 0): SourcePosition {
+        return buffer.positionAt(k)
+    }
+
     /**
      * Moves the pointer forward to the next token and thus "consumes" the current token
      */
@@ -100,14 +141,14 @@ class KiraParser(private val context: SourceContext) {
         if (candidates.size == 1) {
             val candidate = candidates[0]
             for (i in candidate.indices) {
-                if (candidate[i] != peek(i + peekOffset).type) return null
+                if (candidate[i] != peekType(i + peekOffset)) return null
             }
             return candidate
         }
         for (candidate in candidates) {
             var match = true
             for (i in candidate.indices) {
-                if (candidate[i] != peek(i + peekOffset).type) {
+                if (candidate[i] != peekType(i + peekOffset)) {
                     match = false
                     break
                 }
@@ -126,7 +167,7 @@ class KiraParser(private val context: SourceContext) {
     }
 
     private fun at(type: Token.Type): Boolean {
-        return type == peek().type
+        return type == peekType()
     }
 
     private fun expectModifiers(modifier: Map<Modifier, SourcePosition>?, scopes: WrappingContext) {
@@ -167,7 +208,7 @@ class KiraParser(private val context: SourceContext) {
                 val helpMessage = buildString {
                     when (token) {
                         Token.Type.S_OPEN_PARENTHESIS -> {
-                            when (peek().type) {
+                            when (peekType()) {
                                 Token.Type.S_OPEN_BRACE -> {
                                     append("Did you mean to use '(' instead of '{'? Function declarations require parentheses for parameters.")
                                 }
@@ -195,7 +236,7 @@ class KiraParser(private val context: SourceContext) {
                         }
 
                         Token.Type.S_COLON -> {
-                            when (peek().type) {
+                            when (peekType()) {
                                 Token.Type.S_EQUAL -> {
                                     append("Use ':' for type annotations, not '='. Syntax: name: Type = value")
                                 }
@@ -223,7 +264,7 @@ class KiraParser(private val context: SourceContext) {
                         }
 
                         Token.Type.IDENTIFIER -> {
-                            if (peek().type == Token.Type.S_OPEN_PARENTHESIS) {
+                            if (peekType() == Token.Type.S_OPEN_PARENTHESIS) {
                                 append("Expected an identifier (variable or function name) here, not '('. Did you forget the name?")
                             } else {
                                 append("Expected an identifier (a name) here. Identifiers must start with a letter and use camelCase or PascalCase.")
@@ -250,15 +291,15 @@ class KiraParser(private val context: SourceContext) {
                         append("Expected ")
                         append(EnglishUtils.prependIndefiniteArticle(token.diagnosticsName().lowercase()))
                         append(" but got ")
-                        append(EnglishUtils.prependIndefiniteArticle(peek().type.diagnosticsName()))
-                        if (peek().type == Token.Type.IDENTIFIER || peek().type == Token.Type.L_STRING) {
-                            append(" '${peek().content}'")
+                        append(EnglishUtils.prependIndefiniteArticle(peekType().diagnosticsName()))
+                        if (peekType() == Token.Type.IDENTIFIER || peekType() == Token.Type.L_STRING) {
+                            append(" '${peekText()}'")
                         }
                         append("\n\nHelp: ")
                         append(helpMessage)
                     },
-                    location = peek().canonicalLocation,
-                    selectorLength = peek().content.length,
+                    location = peekPosition(),
+                    selectorLength = peekText().length,
                     context = context
                 )
             }
@@ -269,16 +310,16 @@ class KiraParser(private val context: SourceContext) {
 
     private inline fun expectAnyOfThenAdvance(tokens: Array<Token.Type>, ifOk: () -> Unit = { advancePointer() }) {
         when {
-            !tokens.contains(peek().type) ->
+            !tokens.contains(peekType()) ->
                 Diagnostics.panic(
                     "KiraParser::expect",
                     buildString {
                         append("Expected any of ")
                         append(tokens.map { it.diagnosticsName() })
                         append(" but got ")
-                        append(EnglishUtils.prependIndefiniteArticle(peek().type.diagnosticsName()))
+                        append(EnglishUtils.prependIndefiniteArticle(peekType().diagnosticsName()))
                     },
-                    location = peek().canonicalLocation,
+                    location = peekPosition(),
                     context = context
                 )
 
@@ -290,7 +331,7 @@ class KiraParser(private val context: SourceContext) {
         fun parseWithModifiers(): Statement {
             val baseLocation = here()
             val modifiers = parseModifiers()
-            var expr = when (peek().type) {
+            var expr = when (peekType()) {
                 Token.Type.K_CLASS -> parseClassDecl(modifiers)
                 Token.Type.K_ENUM -> parseEnumDecl(modifiers)
                 Token.Type.K_ALIAS -> parseTypeAliasExpr(modifiers)
@@ -306,8 +347,8 @@ class KiraParser(private val context: SourceContext) {
             return parseWithModifiers()
         }
         // If keywords were lexed as simple identifiers (e.g., 'try' or 'throw'), handle them here too
-        if (peek().type == Token.Type.IDENTIFIER) {
-            val txt = peek().content
+        if (peekType() == Token.Type.IDENTIFIER) {
+            val txt = peekText()
             if (txt == "throw") {
                 return parseThrowStatement()
             }
@@ -316,7 +357,7 @@ class KiraParser(private val context: SourceContext) {
             }
         }
 
-        return when (peek().type) {
+        return when (peekType()) {
             // parse keywords stuffs first if possible (like keyword first statements)
             Token.Type.K_RETURN -> parseReturnStatement()
             Token.Type.K_IF -> parseIfSelectionStatement()
@@ -331,7 +372,7 @@ class KiraParser(private val context: SourceContext) {
             // Leading known decl intrinsics (@_opaque / @_extern / @_magic) before pub/class/fx.
             // Callable intrinsics (@op_add, @_trace_) parse as expression statements.
             Token.Type.INTRINSIC_IDENTIFIER -> {
-                val raw = peek().content.removePrefix("@")
+                val raw = peekText().removePrefix("@")
                 if (IntrinsicRegistry.isDeclMarker(raw)) {
                     parseWithModifiers()
                 } else {
@@ -386,9 +427,9 @@ class KiraParser(private val context: SourceContext) {
 //                {
 //                    Diagnostics.panic(
 //                        "KiraParser::parseStatement",
-//                        "Unexpected token '${peek().content}'",
-//                        location = peek().canonicalLocation,
-//                        selectorLength = peek().content.length,
+//                        "Unexpected token '${peekText()}'",
+//                        location = peekPosition(),
+//                        selectorLength = peekText().length,
 //                        context = context
 //                    )
 //                }
@@ -450,7 +491,7 @@ class KiraParser(private val context: SourceContext) {
 //                "KiraParser::parseForIterationStatement",
 //                "For iteration statements may only use identifiers.",
 //                context = context,
-//                location = context.astOrigins[identifier] ?: origin,
+//                location = context.originOf(identifier) ?: origin,
 //            )
 //        }
         return putOrigin(ForIterationStatement(ForIterationExpr(identifier, target, emptyList()), body), origin)
@@ -490,11 +531,11 @@ class KiraParser(private val context: SourceContext) {
         val branches = mutableListOf<IfElseBranchStatementNode>()
         while (at(Token.Type.K_ELSE)) {
             advancePointer() // consume "else" part: not useful
-            when (peek().type) // before i started with always making that "else-if" part was just "elif" which made parsing a lot easier, but i can see why it really isnt that necessary LOL
+            when (peekType()) // before i started with always making that "else-if" part was just "elif" which made parsing a lot easier, but i can see why it really isnt that necessary LOL
             {
                 Token.Type.K_IF -> // "else-if" part
                 {
-                    val subOrigin = peek().canonicalLocation
+                    val subOrigin = peekPosition()
                     advancePointer()
                     val deepCondition = if (at(Token.Type.S_OPEN_PARENTHESIS)) {
                         expectThenAdvance(Token.Type.S_OPEN_PARENTHESIS)
@@ -530,7 +571,7 @@ class KiraParser(private val context: SourceContext) {
         var left: Expr = parsePrimaryOrUnaryExpr()
         left = parsePostfix(left)
         while (true) {
-            val binOpTokens = tryBinaryOps() ?: arrayOf(peek().type)
+            val binOpTokens = tryBinaryOps() ?: arrayOf(peekType())
             val binaryOpType = BinaryOp.byTokenTypeMaybe(binOpTokens)
             if (binaryOpType == null || binaryOpType.precedence < minPrecedence) {
                 break
@@ -611,31 +652,47 @@ class KiraParser(private val context: SourceContext) {
         if (!at(Token.Type.S_OPEN_ANGLE)) {
             return false
         }
-        var depth = 0
-        // TokenBuffer only allows peeks inside its window (size 16). Stay inside
-        // that window: offsets 0..14, and check offset+1 for the following '('.
-        val maxOffset = 14
-        var i = 0
-        while (i <= maxOffset) {
-            when (peek(i).type) {
-                Token.Type.S_OPEN_ANGLE -> depth++
+        val closing = closingAngleOf(0)
+        return closing >= 0 && peekType(closing + 1) == Token.Type.S_OPEN_PARENTHESIS
+    }
+
+    /**
+     * Memo for [closingAngleOf], keyed by the absolute index of a `<`: the
+     * absolute index of the `>` that closes it, or -1 when what follows is not a
+     * type-argument list.
+     */
+    private val closingAngles = HashMap<Int, Int>()
+
+    /**
+     * Offset of the `>` closing the type-argument list that the `<` at [offset]
+     * opens, or -1 when it does not open one (a comparison, mostly).
+     *
+     * The scan stops at the first token a type cannot contain, and every `<` it
+     * crosses gets its answer memoized on the way. So a chain of comparisons
+     * like `a < b < c < d` is scanned once, not once per `<`.
+     */
+    private fun closingAngleOf(offset: Int): Int {
+        val start = buffer.position + offset
+        closingAngles[start]?.let { return if (it < 0) -1 else it - buffer.position }
+        val open = ArrayList<Int>()
+        var index = start
+        scan@ while (true) {
+            when (buffer.typeAt(index - buffer.position)) {
+                Token.Type.S_OPEN_ANGLE -> open.add(index)
                 Token.Type.S_CLOSE_ANGLE -> {
-                    depth--
-                    if (depth == 0) {
-                        // Need one more token for the '(' check.
-                        if (i + 1 > maxOffset + 1) {
-                            return false
-                        }
-                        // i+1 is at most 15 -- still inside the window.
-                        return peek(i + 1).type == Token.Type.S_OPEN_PARENTHESIS
+                    closingAngles[open.removeAt(open.lastIndex)] = index
+                    if (open.isEmpty()) {
+                        return index - buffer.position
                     }
                 }
-                Token.Type.S_EOF -> return false
-                else -> {}
+
+                Token.Type.IDENTIFIER, Token.Type.S_COMMA -> {}
+                else -> break@scan
             }
-            i++
+            index++
         }
-        return false
+        open.forEach { closingAngles[it] = -1 }
+        return -1
     }
 
     /** Parse `<T, U>` type-argument list; pointer must be on `<`. */
@@ -654,13 +711,13 @@ class KiraParser(private val context: SourceContext) {
 
     private fun parsePrimaryOrUnaryExpr(): Expr {
         return when {
-            UnaryOp.byTokenTypeMaybe(peek().type) != null -> parseUnaryExpr()
+            UnaryOp.byTokenTypeMaybe(peekType()) != null -> parseUnaryExpr()
             else -> parsePrimaryExpr(null)
         }
     }
 
     fun parsePrimaryExpr(modifier: Map<Modifier, SourcePosition>?): Expr {
-        return when (peek().type) {
+        return when (peekType()) {
             // lowkey this hard coded switch statement seems like the best approach, but i get that
             // itch that it will be like redundancy and edge case hell
             Token.Type.L_FLOAT -> parseFloatLiteral()
@@ -669,8 +726,8 @@ class KiraParser(private val context: SourceContext) {
             Token.Type.S_OPEN_BRACKET -> parseArrayLiteral()
             Token.Type.INTRINSIC_IDENTIFIER -> {
                 // intrinsic tokens are lexed as a single token by the lexer
-                val startLoc = peek().canonicalLocation
-                val identifier = peek().content
+                val startLoc = peekPosition()
+                val identifier = peekText()
                 advancePointer()
                 // if followed by '(' parse call-like parameters for intrinsics
                 var parameters: List<Expr>? = null
@@ -709,7 +766,7 @@ class KiraParser(private val context: SourceContext) {
             Token.Type.K_MODULE -> parseModuleDecl()
             Token.Type.K_FX -> parseFunctionDecl(modifier)
             Token.Type.IDENTIFIER ->
-                when (peek(1).type) {
+                when (peekType(1)) {
                     Token.Type.S_OPEN_PARENTHESIS -> {
                         if (modifier?.isNotEmpty() ?: false) {
                             Diagnostics.panic(
@@ -725,7 +782,7 @@ class KiraParser(private val context: SourceContext) {
 
                     Token.Type.S_OPEN_BRACE -> {
                         // Type initialization: only treat as object init if the identifier looks like a type (PascalCase)
-                        val ident = peek().content
+                        val ident = peekText()
                         return if (ident.isNotEmpty() && ident[0].isUpperCase()) {
                             parseObjectInit()
                         } else {
@@ -734,26 +791,10 @@ class KiraParser(private val context: SourceContext) {
                     }
 
                     Token.Type.S_OPEN_ANGLE -> {
-                        val ident = peek().content
+                        val ident = peekText()
                         if (ident.isNotEmpty() && ident[0].isUpperCase()) {
-                            var depth = 0
-                            var i = 1
-                            var foundBrace = false
-                            while (i < 100) { // reasonable lookahead limit
-                                val t = peek(i).type
-                                if (t == Token.Type.S_OPEN_ANGLE) depth++
-                                else if (t == Token.Type.S_CLOSE_ANGLE) {
-                                    depth--
-                                    if (depth == 0) {
-                                        if (peek(i + 1).type == Token.Type.S_OPEN_BRACE) {
-                                            foundBrace = true
-                                        }
-                                        break
-                                    }
-                                } else if (t == Token.Type.S_EOF) break
-                                i++
-                            }
-
+                            val closing = closingAngleOf(1)
+                            val foundBrace = closing >= 0 && peekType(closing + 1) == Token.Type.S_OPEN_BRACE
                             return if (foundBrace) {
                                 parseObjectInit()
                             } else {
@@ -778,9 +819,9 @@ class KiraParser(private val context: SourceContext) {
             else ->
                 Diagnostics.panic(
                     "KiraParser::parsePrimaryExpr",
-                    "${EnglishUtils.prependIndefiniteArticle(peek().type.diagnosticsName())} is not allowed here.",
-                    location = peek().canonicalLocation,
-                    selectorLength = peek().content.length,
+                    "${EnglishUtils.prependIndefiniteArticle(peekType().diagnosticsName())} is not allowed here.",
+                    location = peekPosition(),
+                    selectorLength = peekText().length,
                     context = context
                 )
         }
@@ -819,7 +860,7 @@ class KiraParser(private val context: SourceContext) {
             if (members.isNotEmpty()) {
                 expectThenAdvance(Token.Type.S_COMMA)
             }
-            val subOrigin = peek().canonicalLocation
+            val subOrigin = peekPosition()
             val identifier = parseIdentifier()
             expectThenAdvance(Token.Type.S_EQUAL)
             val expr = parseExpr()
@@ -838,12 +879,12 @@ class KiraParser(private val context: SourceContext) {
             identifier = parseIdentifier()
         }
         val parameters = parseFunctionCallParameter()
-        return putOrigin(FunctionCallExpr(identifier, parameters.second, parameters.first), location = origin)
+        return putOrigin(FunctionCallExpr(identifier, parameters.second, parameters.first), origin)
     }
 
     fun parseIntrinsicExpr(isFunctionContext: Boolean = false): Expr {
-        val startLoc = peek().canonicalLocation
-        val identifier = peek().content
+        val startLoc = peekPosition()
+        val identifier = peekText()
         // intrinsic identifiers are lexed as INTRINSIC_IDENTIFIER by the lexer
         expectThenAdvance(Token.Type.INTRINSIC_IDENTIFIER)
         val findVal = IntrinsicRegistry.find(identifier)
@@ -929,7 +970,7 @@ class KiraParser(private val context: SourceContext) {
             generics,
         )
         if (functionIntrinsics != null) {
-            context.astIntrinsicMarked[decl] = functionIntrinsics
+            markIntrinsics(decl, functionIntrinsics)
         }
         attachIntrinsics(decl)
         return putOrigin(decl, origin)
@@ -946,7 +987,7 @@ class KiraParser(private val context: SourceContext) {
                 expectThenAdvance(Token.Type.S_COMMA)
             }
             val startToken = peek()
-            if (at(Token.Type.IDENTIFIER) && peek(1).type == Token.Type.S_EQUAL) {
+            if (at(Token.Type.IDENTIFIER) && peekType(1) == Token.Type.S_EQUAL) {
                 seenNamed = true
                 val origin = here()
                 val identifier = parseIdentifier()
@@ -1000,11 +1041,11 @@ class KiraParser(private val context: SourceContext) {
         // them must route here; parseExpr would otherwise read `a += b` as a
         // plain BinaryExpr and silently drop the assignment.
         if (tryCompoundAssignmentOperators(1) != null ||
-            peek(1).type in compoundAssignmentTokenTypes
+            peekType(1) in compoundAssignmentTokenTypes
         ) {
             return parseCompoundAssignmentExpr()
         }
-        return when (peek(1).type) {
+        return when (peekType(1)) {
             Token.Type.S_EQUAL -> parseAssignmentExpr()
             Token.Type.S_COLON -> parseVariableDecl(modifier)
             else -> parseIdentifier()
@@ -1047,7 +1088,7 @@ class KiraParser(private val context: SourceContext) {
     fun parseCompoundAssignmentExpr(): CompoundAssignmentExpr {
         val origin = here()
         val left = parseIdentifier() // todo: allow for more than just identifiers for now
-        val opTokens: Array<Token.Type> = tryCompoundAssignmentOperators() ?: arrayOf(peek().type)
+        val opTokens: Array<Token.Type> = tryCompoundAssignmentOperators() ?: arrayOf(peekType())
         val op = CompoundAssignmentExpr.findBinaryOp(opTokens)
         repeat(opTokens.size) { advancePointer() }
         val right = parseExpr()
@@ -1069,7 +1110,7 @@ class KiraParser(private val context: SourceContext) {
 //                "KiraParser::parseAssignmentExpr",
 //                "Assignment expressions can only use identifiers for l-value.",
 //                context = context,
-//                location = context.astOrigins[identifier] ?: origin,
+//                location = context.originOf(identifier) ?: origin,
 //            )
 //        }
         return putOrigin(AssignmentExpr(identifier, value), origin)
@@ -1099,7 +1140,7 @@ class KiraParser(private val context: SourceContext) {
 //                "KiraParser::parseEnumMemberExpr",
 //                "Enum members can only be named using identifiers.",
 //                context = context,
-//                location = context.astOrigins[name] ?: origin,
+//                location = context.originOf(name) ?: origin,
 //            )
 //        }
         return putOrigin(EnumMemberExpr(name, value), origin)
@@ -1124,7 +1165,7 @@ class KiraParser(private val context: SourceContext) {
 //                "KiraParser::parseEnumDecl",
 //                "Enum declarations can only use identifiers for their name.",
 //                context = context,
-//                location = context.astOrigins[name] ?: origin,
+//                location = context.originOf(name) ?: origin,
 //            )
 //        }
         val decl = EnumDecl(name, members.toTypedArray(), modifier?.keys?.toList() ?: emptyList())
@@ -1175,7 +1216,7 @@ class KiraParser(private val context: SourceContext) {
             val classDecl = ClassDecl(className, modifier?.keys?.toList() ?: emptyList(), emptyList(), parenTypes)
             val marks = classIntrinsicsEarly ?: pendingIntrinsics
             if (marks != null) {
-                context.astIntrinsicMarked[classDecl] = marks
+                markIntrinsics(classDecl, marks)
                 pendingIntrinsics = null
             }
             attachIntrinsics(classDecl)
@@ -1194,11 +1235,11 @@ class KiraParser(private val context: SourceContext) {
                     Diagnostics.panic(
                         "KiraParser::parseClassDecl",
                         "Anonymous Function Literals are not allowed by themselves in a class.",
-                        location = peek().canonicalLocation,
-                        selectorLength = peek().content.length,
+                        location = peekPosition(),
+                        selectorLength = peekText().length,
                         context = context
                     )
-                } else if (peek(1).type == Token.Type.S_COLON) {
+                } else if (peekType(1) == Token.Type.S_COLON) {
                     val valDecl = parseVariableDecl(memberModifiers)
                     expectOptionalThenAdvance(Token.Type.S_SEMICOLON)
                     valDecl
@@ -1212,7 +1253,7 @@ class KiraParser(private val context: SourceContext) {
         expectThenAdvance(Token.Type.S_CLOSE_BRACE)
         val classDecl = ClassDecl(className, modifier?.keys?.toList() ?: emptyList(), members, parenTypes)
         if (classIntrinsics != null) {
-            context.astIntrinsicMarked[classDecl] = classIntrinsics
+            markIntrinsics(classDecl, classIntrinsics)
         }
         attachIntrinsics(classDecl)
         return putOrigin(classDecl, origin)
@@ -1259,7 +1300,7 @@ class KiraParser(private val context: SourceContext) {
                 // parse inner class which acts as a variant
                 val classDecl = parseClassDecl(memberModifiers)
                 variants.add(classDecl)
-            } else if (peek(1).type == Token.Type.S_COLON) {
+            } else if (peekType(1) == Token.Type.S_COLON) {
                 val valDecl = parseVariableDecl(memberModifiers)
                 expectOptionalThenAdvance(Token.Type.S_SEMICOLON)
                 members.add(valDecl)
@@ -1271,7 +1312,7 @@ class KiraParser(private val context: SourceContext) {
         expectThenAdvance(Token.Type.S_CLOSE_BRACE)
         val decl = VariantDecl(variantName, modifier?.keys?.toList() ?: emptyList(), variants, members, parenTypes)
         if (variantIntrinsics != null) {
-            context.astIntrinsicMarked[decl] = variantIntrinsics
+            markIntrinsics(decl, variantIntrinsics)
         }
         attachIntrinsics(decl)
         return putOrigin(decl, origin)
@@ -1311,8 +1352,8 @@ class KiraParser(private val context: SourceContext) {
                         "KiraParser::parseTraitDecl",
                         "Traits only allow 1 anonymous function. Either give this function name or remove others.",
                         context = context,
-                        location = context.astOrigins[memberExpr],
-                        selectorLength = context.findCanonicalLine(context.astOrigins[memberExpr]!!.lineNumber).length
+                        location = context.originOf(memberExpr),
+                        selectorLength = context.findCanonicalLine(context.relativeOriginOf(memberExpr).lineNumber).length
                     )
                 }
                 seenAnonymous = true
@@ -1329,7 +1370,7 @@ class KiraParser(private val context: SourceContext) {
         }
         val traitDecl = TraitDecl(name, modifier?.keys?.toTypedArray() ?: emptyArray(), members, parenTypes)
         if (traitIntrinsics != null) {
-            context.astIntrinsicMarked[traitDecl] = traitIntrinsics
+            markIntrinsics(traitDecl, traitIntrinsics)
         }
         return putOrigin(traitDecl, baseLocation)
     }
@@ -1353,7 +1394,7 @@ class KiraParser(private val context: SourceContext) {
 
 
     fun parseStringLiteral(): StringLiteral {
-        val value = peek().content
+        val value = peekText()
         val origin = here()
         expectThenAdvance(Token.Type.L_STRING)
         return putOrigin(StringLiteral(value), origin)
@@ -1377,14 +1418,14 @@ class KiraParser(private val context: SourceContext) {
         var value by Delegates.notNull<Long>()
         val origin = here()
         try {
-            value = peek().content.toLong()
+            value = peekText().toLong()
         } catch (e: Exception) {
             Diagnostics.panic(
                 "KiraParser::parseIntegerLiteral",
-                "Unable to read '${peek().content}' as an integer literal",
+                "Unable to read '${peekText()}' as an integer literal",
                 cause = e,
                 location = origin,
-                selectorLength = peek().content.length,
+                selectorLength = peekText().length,
                 context = context
             )
         }
@@ -1396,14 +1437,14 @@ class KiraParser(private val context: SourceContext) {
         var value by Delegates.notNull<Double>()
         val origin = here()
         try {
-            value = peek().content.toDouble()
+            value = peekText().toDouble()
         } catch (e: Exception) {
             Diagnostics.panic(
                 "KiraParser::parseIntegerLiteral",
-                "Unable to read '${peek().content}' as an integer literal",
+                "Unable to read '${peekText()}' as an integer literal",
                 cause = e,
-                location = peek().canonicalLocation,
-                selectorLength = peek().content.length,
+                location = peekPosition(),
+                selectorLength = peekText().length,
                 context = context
             )
         }
@@ -1412,10 +1453,12 @@ class KiraParser(private val context: SourceContext) {
     }
 
     fun parseIdentifier(): Identifier {
-        val loc = peek().canonicalLocation
-        val value = peek().content
+        val loc = peekPosition()
+        val identifier = Identifier(peekText())
+        // the analyzer resolves the node by the id the lexer gave the name
+        identifier.bind(buffer.identifiers, buffer.symbolIdAt())
         expectThenAdvance(Token.Type.IDENTIFIER)
-        return putOrigin(Identifier(value), loc)
+        return putOrigin(identifier, loc)
     }
 
     private fun parseTypeParameter(): Type {
@@ -1474,7 +1517,7 @@ class KiraParser(private val context: SourceContext) {
         while (true) {
             when {
                 at(Token.Type.INTRINSIC_IDENTIFIER) -> {
-                    val intrinsicName = peek().content
+                    val intrinsicName = peekText()
                     val intrinsic = IntrinsicRegistry.find(intrinsicName)
                     if (intrinsic != null) {
                         intrinsics.add(intrinsic)
@@ -1483,32 +1526,32 @@ class KiraParser(private val context: SourceContext) {
                             "KiraParser::parseModifiers",
                             "Unknown intrinsic: @$intrinsicName",
                             context = context,
-                            location = peek().canonicalLocation,
-                            selectorLength = peek().content.length,
+                            location = peekPosition(),
+                            selectorLength = peekText().length,
                         )
                     }
                     advancePointer()
                 }
 
-                peek().type in Token.Type.modifiers -> {
-                    val currentModifier = Modifier.byTokenTypeMaybe(peek().type) {
+                peekType() in Token.Type.modifiers -> {
+                    val currentModifier = Modifier.byTokenTypeMaybe(peekType()) {
                         Diagnostics.panic(
                             "KiraParser::parseModifiers",
                             "${peek()} is not a valid modifier",
                             context = context,
-                            location = peek().canonicalLocation,
-                            selectorLength = peek().content.length,
+                            location = peekPosition(),
+                            selectorLength = peekText().length,
                         )
                     }
                     modifier[currentModifier]?.let {
                         Diagnostics.panic(
-                            "KiraParser::parseModifiers", "Duplicate modifier at ${peek().canonicalLocation}",
+                            "KiraParser::parseModifiers", "Duplicate modifier at ${peekPosition()}",
                             context = context,
-                            location = peek().canonicalLocation,
-                            selectorLength = peek().content.length,
+                            location = peekPosition(),
+                            selectorLength = peekText().length,
                         )
                     }
-                    modifier[currentModifier!!] = peek().canonicalLocation
+                    modifier[currentModifier!!] = peekPosition()
                     advancePointer()
                 }
 
@@ -1525,7 +1568,7 @@ class KiraParser(private val context: SourceContext) {
 
     private fun <T : ASTNode> attachIntrinsics(node: T): T {
         if (pendingIntrinsics != null) {
-            context.astIntrinsicMarked[node] = pendingIntrinsics!!
+            markIntrinsics(node, pendingIntrinsics!!)
             pendingIntrinsics = null
         }
         return node
@@ -1555,7 +1598,7 @@ class KiraParser(private val context: SourceContext) {
         val origin = here()
         if (at(Token.Type.K_THROW)) {
             expectThenAdvance(Token.Type.K_THROW)
-        } else if (at(Token.Type.IDENTIFIER) && peek().content == "throw") {
+        } else if (at(Token.Type.IDENTIFIER) && peekText() == "throw") {
             advancePointer()
         } else {
             Diagnostics.panic(
@@ -1575,7 +1618,7 @@ class KiraParser(private val context: SourceContext) {
         val origin = here()
         if (at(Token.Type.K_TRY)) {
             expectThenAdvance(Token.Type.K_TRY)
-        } else if (at(Token.Type.IDENTIFIER) && peek().content == "try") {
+        } else if (at(Token.Type.IDENTIFIER) && peekText() == "try") {
             advancePointer()
         } else {
             Diagnostics.panic(
@@ -1586,7 +1629,7 @@ class KiraParser(private val context: SourceContext) {
             )
         }
         val tryBlock = parseStatementBlock()
-        if (at(Token.Type.K_ON) || (at(Token.Type.IDENTIFIER) && peek().content == "on")) {
+        if (at(Token.Type.K_ON) || (at(Token.Type.IDENTIFIER) && peekText() == "on")) {
             if (at(Token.Type.K_ON)) expectThenAdvance(Token.Type.K_ON) else advancePointer()
             val name = parseIdentifier()
             expectThenAdvance(Token.Type.S_COLON)
@@ -1,97 +1,81 @@
 package net.exoad.kira.compiler.frontend.parser
 
 import net.exoad.kira.compiler.frontend.lexer.Token
+import net.exoad.kira.compiler.frontend.lexer.TokenStream
+import net.exoad.kira.core.Identifiers
 import net.exoad.kira.core.Symbols
 import net.exoad.kira.source.SourcePosition
 
-class TokenBuffer(
-    private val tokens: List<Token>,
-    private val windowSize: Int = 16,
-) {
-    private val window = Array<Token?>(windowSize) { null }
-    private val windowMask = windowSize - 1
-    private var position = 0
+/**
+ * Cursor over a [TokenStream]. The stream is already random access, so this is
+ * just an index into it: any offset can be peeked and a checkpoint can be
+ * restored however far the parser has moved since.
+ *
+ * The parser's hot paths only ask for a token's [typeAt], [textAt],
+ * [positionAt], [lineAt] or [columnAt], which read straight out of the
+ * stream's arrays; [peek] materializes a whole [Token] for the few places that
+ * keep one around.
+ */
+class TokenBuffer(private val tokens: TokenStream) {
+    /** Absolute index of the current token. */
+    var position = 0
+        private set
     private val eofToken = Token.Symbol(Token.Type.S_EOF, Symbols.NULL, 0, SourcePosition(1, 1))
-    private var windowFilled = 0
 
-    init {
-        require(windowSize in 4..64) { "Window size must be between 4 and 64!" }
-        require(windowSize and (windowSize - 1) == 0) { "Window size must be a power of 2!" }
-        fillInitialWindow()
+    private fun indexOf(offset: Int): Int {
+        require(offset >= 0) { "Negative offset not supported: $offset" }
+        return position + offset
     }
 
-    private fun fillInitialWindow() {
-        val tokensToLoad = minOf(windowSize, tokens.size)
-        for (i in 0 until tokensToLoad) {
-            window[i] = tokens[i]
-        }
-        windowFilled = tokensToLoad
+    fun typeAt(offset: Int = 0): Token.Type {
+        val index = indexOf(offset)
+        return if (index < tokens.size) tokens.type(index) else eofToken.type
     }
 
-    fun peek(offset: Int = 0): Token {
-        require(offset >= 0) { "Negative offset not supported: $offset" }
-        require(offset < windowSize) {
-            "Offset $offset exceeds window size $windowSize"
-        }
-        val absoluteIndex = position + offset
-        if (absoluteIndex >= tokens.size) {
-            return eofToken
-        }
-        val cachedToken = window[absoluteIndex and windowMask]
-        if (cachedToken != null && absoluteIndex < position + windowFilled) {
-            return cachedToken
-        }
-        return loadToken(absoluteIndex)
+    fun textAt(offset: Int = 0): String {
+        val index = indexOf(offset)
+        return if (index < tokens.size) tokens.text(index) else eofToken.content
     }
 
-    private fun loadToken(absoluteIndex: Int): Token {
-        if (absoluteIndex >= tokens.size) {
-            return eofToken
-        }
-        val token = tokens[absoluteIndex]
-        window[absoluteIndex and windowMask] = token
-        return token
+    /** Id of the name at [offset] in [identifiers], -1 for anything that is not a name. */
+    fun symbolIdAt(offset: Int = 0): Int {
+        val index = indexOf(offset)
+        return if (index < tokens.size) tokens.symbolId(index) else -1
+    }
+
+    val identifiers: Identifiers get() = tokens.identifiers
+
+    fun positionAt(offset: Int = 0): SourcePosition {
+        val index = indexOf(offset)
+        return if (index < tokens.size) tokens.position(index) else eofToken.canonicalLocation
+    }
+
+    fun lineAt(offset: Int = 0): Int {
+        val index = indexOf(offset)
+        return if (index < tokens.size) tokens.line(index) else eofToken.canonicalLocation.lineNumber
+    }
+
+    fun columnAt(offset: Int = 0): Int {
+        val index = indexOf(offset)
+        return if (index < tokens.size) tokens.column(index) else eofToken.canonicalLocation.column
+    }
+
+    fun peek(offset: Int = 0): Token {
+        val index = indexOf(offset)
+        return if (index < tokens.size) tokens[index] else eofToken
     }
 
     fun advance(): Token {
         val currentToken = peek(0)
         if (position < tokens.size) {
             position++
-            val nextTokenIndex = position + windowSize - 1
-            if (nextTokenIndex < tokens.size) {
-                window[nextTokenIndex and windowMask] = tokens[nextTokenIndex]
-            }
         }
-
         return currentToken
     }
 
-    fun advance(count: Int): Token {
+    fun advance(count: Int) {
         require(count > 0) { "Advancement count must be positive! Got: $count" }
-        val oldPosition = position
         position = minOf(position + count, tokens.size)
-        if (count >= windowSize / 2) {
-            reloadWindow()
-        } else {
-            for (i in 1..count) {
-                val nextTokenIndex = oldPosition + windowSize - 1 + i
-                if (nextTokenIndex < tokens.size) {
-                    val windowIndex = nextTokenIndex and windowMask
-                    window[windowIndex] = tokens[nextTokenIndex]
-                }
-            }
-        }
-        return peek(0)
-    }
-
-    private fun reloadWindow() {
-        window.fill(null)
-        val startIndex = position
-        val endIndex = minOf(position + windowSize, tokens.size)
-        for (i in startIndex until endIndex) {
-            window[i and windowMask] = tokens[i]
-        }
-        windowFilled = endIndex - startIndex
     }
 
     fun isAtEnd(): Boolean {
@@ -106,14 +90,8 @@ class TokenBuffer(
         return TokenBufferCheckpoint(position)
     }
 
-    fun restoreCheckpoint(checkpoint: TokenBufferCheckpoint): Boolean {
-        val targetPosition = checkpoint.position
-        val positionDiff = position - targetPosition
-        if (positionDiff >= 0 && positionDiff < windowSize) {
-            position = targetPosition
-            return true
-        }
-        return false
+    fun restoreCheckpoint(checkpoint: TokenBufferCheckpoint) {
+        require(checkpoint.position in 0..tokens.size) { "Checkpoint ${checkpoint.position} is not in this buffer" }
+        position = checkpoint.position
     }
 }
-
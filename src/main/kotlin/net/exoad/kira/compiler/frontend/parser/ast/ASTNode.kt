@@ -1,12 +1,70 @@
 package net.exoad.kira.compiler.frontend.parser.ast
 
+import net.exoad.kira.compiler.frontend.parser.ast.elements.AnonymousIdentifier
+import net.exoad.kira.compiler.frontend.parser.ast.expressions.NoExpr
+import net.exoad.kira.compiler.frontend.parser.ast.literals.NullLiteral
 import net.exoad.kira.core.CompilerIntrinsic
+import net.exoad.kira.source.SourcePosition
+import java.io.Serializable
+
+/**
+ * Serializable so a parsed tree, positions and intrinsic markers included, can
+ * be written to the frontend cache in one stream; see [net.exoad.kira.compiler.FrontendCache].
+ */
+abstract class ASTNode : Serializable {
+    /**
+     * Where the parser found this node, packed by [packOrigin]; [NO_ORIGIN] until
+     * it is recorded. Read it through [net.exoad.kira.source.SourceContext.originOf].
+     *
+     * Positions used to live in an identity map on the source context, which
+     * cost a hash probe per lookup and a [SourcePosition] per node.
+     */
+    @JvmField
+    var packedOrigin: Long = NO_ORIGIN
+
+    /** Markers the parser attached to this node (`@_magic`, `@_extern`, ...); null for the nodes that have none. */
+    @JvmField
+    var intrinsicMarks: Array<CompilerIntrinsic>? = null
 
-abstract class ASTNode {
     abstract fun accept(visitor: KiraASTVisitor)
 
     // Default empty list implementation so implementations don't have to
     // declare/forward attachedIntrinsics unless they need a specific value.
     open val attachedIntrinsics: List<CompilerIntrinsic>
         get() = emptyList()
+
+    companion object {
+        const val NO_ORIGIN = Long.MIN_VALUE
+
+        /** Line in the high 32 bits, column in the low 32. */
+        fun packOrigin(lineNumber: Int, column: Int): Long {
+            return (lineNumber.toLong() shl 32) or (column.toLong() and 0xFFFFFFFFL)
+        }
+
+        fun unpackOrigin(packed: Long): SourcePosition? {
+            return if (packed == NO_ORIGIN) null else SourcePosition((packed shr 32).toInt(), packed.toInt())
+        }
+    }
+}
+
+/**
+ * Written in place of the singleton nodes ([NoExpr], [NullLiteral],
+ * [AnonymousIdentifier]) so a deserialized tree points back at the one
+ * instance instead of a copy.
+ */
+class ASTSingletonRef(private val key: String) : Serializable {
+    private fun readResolve(): Any {
+        return when (key) {
+            NO_EXPR -> NoExpr
+            NULL_LITERAL -> NullLiteral
+            ANONYMOUS_IDENTIFIER -> AnonymousIdentifier
+            else -> throw IllegalStateException("Unknown AST singleton '$key'")
+        }
+    }
+
+    companion object {
+        const val NO_EXPR = "NoExpr"
+        const val NULL_LITERAL = "NullLiteral"
+        const val ANONYMOUS_IDENTIFIER = "AnonymousIdentifier"
+    }
 }
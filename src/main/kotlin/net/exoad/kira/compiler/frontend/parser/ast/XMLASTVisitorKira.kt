@@ -611,6 +611,8 @@ object XMLASTVisitorKira :
         }
     }
 
+    // one shared builder, so concurrent compilations take turns
+    @Synchronized
     fun build(node: ASTNode): String {
         builder.clear()
         currentIndent.clear()
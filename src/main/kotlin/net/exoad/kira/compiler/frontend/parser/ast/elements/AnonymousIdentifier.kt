@@ -1,6 +1,7 @@
 package net.exoad.kira.compiler.frontend.parser.ast.elements
 
 import net.exoad.kira.compiler.analysis.diagnostics.DiagnosticsSymbols
+import net.exoad.kira.compiler.frontend.parser.ast.ASTSingletonRef
 
 object AnonymousIdentifier : Identifier(DiagnosticsSymbols.NOT_REPRESENTABLE) {
     override fun toString(): String {
@@ -20,4 +21,6 @@ object AnonymousIdentifier : Identifier(DiagnosticsSymbols.NOT_REPRESENTABLE) {
         }
         return true
     }
+
+    private fun writeReplace(): Any = ASTSingletonRef(ASTSingletonRef.ANONYMOUS_IDENTIFIER)
 }
\ No newline at end of file
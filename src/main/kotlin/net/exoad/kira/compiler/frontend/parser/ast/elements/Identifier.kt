@@ -2,8 +2,30 @@ package net.exoad.kira.compiler.frontend.parser.ast.elements
 
 import net.exoad.kira.compiler.frontend.parser.ast.KiraASTVisitor
 import net.exoad.kira.compiler.frontend.parser.ast.expressions.Expr
+import net.exoad.kira.core.Identifiers
 
 open class Identifier(open val value: String) : Expr() {
+    /**
+     * The table the parser took [symbolId] from. Not serialized, nor set on
+     * nodes the compiler makes itself: those resolve by [value].
+     */
+    @Transient
+    private var table: Identifiers? = null
+
+    @Transient
+    private var symbolId = -1
+
+    /** Record the id the lexer interned [value] as in [table]. */
+    fun bind(table: Identifiers, symbolId: Int) {
+        this.table = table
+        this.symbolId = symbolId
+    }
+
+    /** Id of [value] in [table] when the node was parsed against it, -1 otherwise. */
+    fun symbolIdIn(table: Identifiers): Int {
+        return if (this.table === table) symbolId else -1
+    }
+
     override fun accept(visitor: KiraASTVisitor) {
         visitor.visitIdentifier(this)
     }
@@ -1,6 +1,7 @@
 package net.exoad.kira.compiler.frontend.parser.ast.expressions
 
 import net.exoad.kira.compiler.frontend.parser.ast.ASTNode
+import net.exoad.kira.compiler.frontend.parser.ast.ASTSingletonRef
 import net.exoad.kira.compiler.frontend.parser.ast.KiraASTVisitor
 import net.exoad.kira.core.CompilerIntrinsic
 
@@ -22,4 +23,6 @@ object NoExpr : Expr() {
     override fun toString(): String {
         return "_{ }"
     }
+
+    private fun writeReplace(): Any = ASTSingletonRef(ASTSingletonRef.NO_EXPR)
 }
\ No newline at end of file
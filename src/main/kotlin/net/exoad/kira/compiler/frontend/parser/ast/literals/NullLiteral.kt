@@ -1,5 +1,6 @@
 package net.exoad.kira.compiler.frontend.parser.ast.literals
 
+import net.exoad.kira.compiler.frontend.parser.ast.ASTSingletonRef
 import net.exoad.kira.compiler.frontend.parser.ast.KiraASTVisitor
 
 private val nullRep = Any()
@@ -12,4 +13,7 @@ object NullLiteral : DataLiteral<Any>(nullRep) {
     override fun toString(): String {
         return "LNull{ }"
     }
+
+    // nullRep is a bare Any(), which cannot be serialized; write a reference instead.
+    private fun writeReplace(): Any = ASTSingletonRef(ASTSingletonRef.NULL_LITERAL)
 }
\ No newline at end of file
@@ -1,10 +1,11 @@
 package net.exoad.kira.compiler.frontend.preprocessor
 
 /**
- * The first process in the frontend compilation process by which certain
- * elements are either removed like comments and preprocessor directives.
+ * Strips `//` comments from a whole file, line by line.
  *
- * The results are passed onto [net.exoad.kira.compiler.frontend.lexer.KiraLexer].
+ * The compiler no longer runs this before lexing: [net.exoad.kira.compiler.frontend.lexer.KiraLexer] skips comments
+ * itself and records [PreprocessorResult.lineComments] as it goes. This is kept for tools that want the comment-free
+ * text on its own.
  */
 class KiraPreprocessor(private val rawContent: String) {
     fun process(): PreprocessorResult {
@@ -4,9 +4,10 @@ import net.exoad.kira.compiler.CompilationUnit
 import net.exoad.kira.compiler.frontend.parser.ast.ASTNode
 import net.exoad.kira.compiler.frontend.parser.ast.expressions.IntrinsicExpr
 import net.exoad.kira.source.SourceContext
+import java.io.Serializable
 import kotlin.reflect.KClass
 
-abstract class CompilerIntrinsic(val name: String, val validTargets: Set<KClass<out ASTNode>>) {
+abstract class CompilerIntrinsic(val name: String, val validTargets: Set<KClass<out ASTNode>>) : Serializable {
     abstract fun validate(invocation: IntrinsicExpr, compilationUnit: CompilationUnit, context: SourceContext)
 
     abstract fun apply(
@@ -15,4 +16,14 @@ abstract class CompilerIntrinsic(val name: String, val validTargets: Set<KClass<
         compilationUnit: CompilationUnit,
         context: SourceContext
     ): ASTNode
+
+    /** Intrinsics are registry singletons; a cached AST stores the name and resolves it on load. */
+    protected fun writeReplace(): Any = Ref(name)
+
+    private class Ref(private val name: String) : Serializable {
+        private fun readResolve(): Any {
+            return IntrinsicRegistry.find(name)
+                ?: throw IllegalStateException("Unknown intrinsic '@$name' in cached AST")
+        }
+    }
 }
\ No newline at end of file
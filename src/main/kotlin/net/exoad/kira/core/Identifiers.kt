@@ -0,0 +1,103 @@
+package net.exoad.kira.core
+
+import java.util.concurrent.ConcurrentHashMap
+
+/**
+ * Interns identifier names to dense `Int` ids.
+ *
+ * There is no process-wide table: each one lives as long as the
+ * [net.exoad.kira.compiler.CompilationUnit] that owns it. The unit's lexers
+ * intern every identifier into it as they lex it, straight from the source
+ * text, so each distinct name is allocated and hashed once however often it
+ * appears; the parser hands the token's id to its
+ * [net.exoad.kira.compiler.frontend.parser.ast.elements.Identifier], and the
+ * unit's [net.exoad.kira.compiler.analysis.semantic.KiraSymbolTable] keys
+ * its scopes by the same ids, so resolving a name is an `Int` lookup. A
+ * language server or daemon that runs for days therefore only keeps the
+ * names of the units it still holds, not every name it ever lexed.
+ *
+ * Ids are only comparable between lookups on the same table. Every table
+ * starts with the [KEYWORDS], so a keyword's id is its index there in any
+ * of them.
+ */
+class Identifiers {
+    private val ids = ConcurrentHashMap<Name, Int>()
+
+    /** Written under the lock, always before the id is published through [ids]. */
+    @Volatile
+    private var names = arrayOfNulls<String>(KEYWORDS.size * 2)
+    private var count = 0
+    private val lock = Any()
+
+    init {
+        KEYWORDS.forEach { insert(it) }
+    }
+
+    val size: Int get() = ids.size
+
+    fun intern(name: String): Int {
+        return ids[Name(name, 0, name.length)] ?: insert(name)
+    }
+
+    /** Intern `text[start, end)` without slicing it unless the name is new. */
+    fun intern(text: CharSequence, start: Int, end: Int): Int {
+        return ids[Name(text, start, end)] ?: insert(text.subSequence(start, end).toString())
+    }
+
+    /** Id of [name], or -1 when nothing by that name was ever interned. */
+    fun find(name: String): Int {
+        return ids[Name(name, 0, name.length)] ?: -1
+    }
+
+    fun name(id: Int): String {
+        return names[id] ?: throw IllegalArgumentException("No identifier was interned as $id")
+    }
+
+    private fun insert(name: String): Int {
+        synchronized(lock) {
+            val key = Name(name, 0, name.length)
+            ids[key]?.let { return it }
+            val id = count++
+            if (id == names.size) {
+                names = names.copyOf(id * 2)
+            }
+            names[id] = name
+            ids[key] = id
+            return id
+        }
+    }
+
+    /** A slice of some text, compared and hashed like the [String] it stands for. */
+    private class Name(private val text: CharSequence, private val start: Int, private val end: Int) {
+        private val hash: Int = if (text is String && start == 0 && end == text.length) {
+            text.hashCode()
+        } else {
+            var h = 0
+            for (i in start until end) {
+                h = 31 * h + text[i].code
+            }
+            h
+        }
+
+        override fun hashCode(): Int {
+            return hash
+        }
+
+        override fun equals(other: Any?): Boolean {
+            if (other !is Name || other.hash != hash || other.end - other.start != end - start) {
+                return false
+            }
+            for (i in 0 until end - start) {
+                if (text[start + i] != other.text[other.start + i]) {
+                    return false
+                }
+            }
+            return true
+        }
+    }
+
+    companion object {
+        /** Interned first into every table, in this order. */
+        val KEYWORDS: List<String> = Keywords.reserved.keys.toList()
+    }
+}
@@ -4,6 +4,11 @@ data class ProjectSpec(
     val name: String
 )
 
+data class PgoOptions(
+    /** Shell command run in the project root against the instrumented `app` by `kira build --pgo`. */
+    val train: String? = null,
+)
+
 data class BuildOptions(
     val target: String = "c",
     /** Extra .c/.o files linked with out.kira.c (paths relative to project root). */
@@ -12,6 +17,9 @@ data class BuildOptions(
     val linkFlags: List<String> = emptyList(),
     /** When true (default), generated C/JS user code is minified + obfuscated. */
     val minify: Boolean = true,
+    /** C compiler `kira build` runs (default `cc`; `--cc` overrides it). */
+    val cc: String = "cc",
+    val pgo: PgoOptions = PgoOptions(),
 )
 
 data class CompilerOptions(
@@ -30,6 +30,8 @@ object ManifestLoader {
             ?: buildMap?.optionalStringList("link_flags")
             ?: emptyList()
         val minify = buildMap?.optionalBoolean("minify") ?: true
+        val cc = buildMap?.optionalString("cc")?.takeIf { it.isNotEmpty() } ?: "cc"
+        val pgoTrain = buildMap?.optionalMap("pgo")?.optionalString("train")?.takeIf { it.isNotEmpty() }
 
         val compilerMap = root.optionalMap("compiler")
         val emitIr = compilerMap?.optionalString("emitIr") ?: compilerMap?.optionalString("emit_ir")
@@ -42,7 +44,14 @@ object ManifestLoader {
         return ProjectManifest(
             project = ProjectSpec(name = projectName),
             srcDir = srcDir,
-            build = BuildOptions(target = target, cSources = cSources, linkFlags = linkFlags, minify = minify),
+            build = BuildOptions(
+                target = target,
+                cSources = cSources,
+                linkFlags = linkFlags,
+                minify = minify,
+                cc = cc,
+                pgo = PgoOptions(train = pgoTrain),
+            ),
             compiler = CompilerOptions(emitIr = emitIr),
             dependencies = dependencies
         )
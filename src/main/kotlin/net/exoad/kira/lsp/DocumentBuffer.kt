@@ -0,0 +1,228 @@
+package net.exoad.kira.lsp
+
+import net.exoad.kira.compiler.FrontendWorkspace
+import org.eclipse.lsp4j.Position
+import org.eclipse.lsp4j.Range
+
+/**
+ * The text of one open document as a piece table: the text it was opened
+ * (or last [compact]ed) with, an append-only buffer of everything typed
+ * since, and the pieces that stitch the two together in order.
+ *
+ * An incremental `didChange` is then a split of at most two pieces and an
+ * append, however large the file. Offsets are UTF-16 code units, which is
+ * both what LSP positions count by default and what a Kotlin [String]
+ * indexes, so an offset here is an offset into [toString] and into the
+ * lexer's tokens.
+ *
+ * The buffer also folds the edits since the last [read] into the one span
+ * they touched, which the language server hands to the
+ * [FrontendWorkspace], so re-lexing starts where the editor says the text
+ * changed instead of comparing the whole file with its last version.
+ */
+class DocumentBuffer(initial: String) {
+    private class Piece(val added: Boolean, val start: Int, val length: Int, val newlines: Int)
+
+    /** The text now and, when it is known, what changed since the previous [read]. */
+    class Read(val text: String, val edit: FrontendWorkspace.Edit?)
+
+    private var original = ""
+    private val added = StringBuilder()
+    private var pieces = mutableListOf<Piece>()
+
+    /** [toString], until the next edit. */
+    private var text: String? = null
+
+    /** What the last [read] returned; null before the first one, and after a whole-text replace. */
+    private var lastRead: String? = null
+
+    /**
+     * Every edit since the last [read] as one span: `[spanStart, spanStart + spanRemoved)` of [lastRead]
+     * is now `[spanStart, spanStart + spanInserted)`. [spanStart] is -1 while nothing has changed.
+     */
+    private var spanStart = -1
+    private var spanRemoved = 0
+    private var spanInserted = 0
+
+    var length: Int = 0
+        private set
+
+    init {
+        reset(initial)
+    }
+
+    /**
+     * Offset of an LSP [position]. A line past the end maps to the end of
+     * the text, a character past the end of its line to the end of the line.
+     */
+    fun offsetOf(position: Position): Int {
+        var line = 0
+        var offset = 0
+        var index = 0
+        // whole pieces that end before the line starts
+        while (index < pieces.size && line + pieces[index].newlines < position.line) {
+            line += pieces[index].newlines
+            offset += pieces[index].length
+            index++
+        }
+        // then characters up to the line start, and along the line
+        var column = 0
+        while (index < pieces.size) {
+            val piece = pieces[index]
+            val source = sourceOf(piece)
+            for (i in piece.start..<piece.start + piece.length) {
+                val char = source[i]
+                if (line < position.line) {
+                    if (char == '\n') {
+                        line++
+                    }
+                } else if (char == '\n' || column == position.character) {
+                    return offset
+                } else {
+                    column++
+                }
+                offset++
+            }
+            index++
+        }
+        return offset
+    }
+
+    /** Apply one `contentChanges` entry; a null [range] replaces the whole text. */
+    fun apply(range: Range?, newText: String) {
+        if (range == null) {
+            reset(newText)
+            lastRead = null
+            return
+        }
+        val start = offsetOf(range.start)
+        replace(start, offsetOf(range.end).coerceAtLeast(start), newText)
+    }
+
+    /** Replace `[start, end)` with [newText]. */
+    fun replace(start: Int, end: Int, newText: String) {
+        val next = ArrayList<Piece>(pieces.size + 2)
+        var offset = 0
+        var inserted = false
+        fun insert() {
+            if (!inserted && newText.isNotEmpty()) {
+                next += Piece(true, added.length, newText.length, newlinesIn(newText, 0, newText.length))
+                added.append(newText)
+            }
+            inserted = true
+        }
+        for (piece in pieces) {
+            val pieceEnd = offset + piece.length
+            when {
+                pieceEnd <= start -> next += piece
+                offset >= end -> {
+                    insert()
+                    next += piece
+                }
+                else -> {
+                    // the piece overlaps the replaced range: keep what lies outside it
+                    if (offset < start) {
+                        next += slice(piece, 0, start - offset)
+                    }
+                    insert()
+                    if (pieceEnd > end) {
+                        next += slice(piece, end - offset, piece.length)
+                    }
+                }
+            }
+            offset = pieceEnd
+        }
+        insert()
+        pieces = next
+        length += newText.length - (end - start)
+        text = null
+        widenSpan(start, end, newText.length)
+        if (pieces.size > MAX_PIECES) {
+            compact()
+        }
+    }
+
+    /**
+     * Fold every piece back into one, so lookups stay cheap however many
+     * edits came in. [replace] does this once the pieces pile up; reading
+     * the text does not, so a diagnosis does not rebuild the table.
+     */
+    fun compact() {
+        reset(toString())
+    }
+
+    /**
+     * The current text, and the span edited since the previous call relative
+     * to the text that call returned. The edit is null on the first read,
+     * after a whole-text replace, and when nothing changed.
+     */
+    fun read(): Read {
+        val current = toString()
+        val before = lastRead
+        val edit = if (before == null || spanStart < 0) {
+            null
+        } else {
+            FrontendWorkspace.Edit(before, current, spanStart, spanRemoved, spanInserted)
+        }
+        lastRead = current
+        spanStart = -1
+        return Read(current, edit)
+    }
+
+    /** Grow the pending span to cover `[start, end)` (in the text before this edit) replaced by [inserted] characters. */
+    private fun widenSpan(start: Int, end: Int, inserted: Int) {
+        if (spanStart < 0) {
+            spanStart = start
+            spanRemoved = end - start
+            spanInserted = inserted
+            return
+        }
+        // text before the span is as it was at the last read; text after it is only shifted
+        val spanEnd = spanStart + spanInserted
+        val from = minOf(spanStart, start)
+        val to = maxOf(spanEnd, end)
+        spanRemoved += (spanStart - from) + (to - spanEnd)
+        spanInserted = (to - from) - (end - start) + inserted
+        spanStart = from
+    }
+
+    override fun toString(): String {
+        text?.let { return it }
+        val out = StringBuilder(length)
+        pieces.forEach { piece -> out.append(sourceOf(piece), piece.start, piece.start + piece.length) }
+        return out.toString().also { text = it }
+    }
+
+    private fun reset(newText: String) {
+        original = newText
+        added.setLength(0)
+        pieces = mutableListOf()
+        if (newText.isNotEmpty()) {
+            pieces += Piece(false, 0, newText.length, newlinesIn(newText, 0, newText.length))
+        }
+        length = newText.length
+        text = newText
+    }
+
+    private fun sourceOf(piece: Piece): CharSequence = if (piece.added) added else original
+
+    private fun slice(piece: Piece, from: Int, to: Int): Piece {
+        val start = piece.start + from
+        return Piece(piece.added, start, to - from, newlinesIn(sourceOf(piece), start, piece.start + to))
+    }
+
+    private fun newlinesIn(source: CharSequence, from: Int, to: Int): Int {
+        var count = 0
+        for (i in from..<to) {
+            if (source[i] == '\n') {
+                count++
+            }
+        }
+        return count
+    }
+
+    companion object {
+        /** Edits between two diagnoses rarely get near this; a flood of them is compacted early. */
+        private const val MAX_PIECES = 1024
+    }
+}
@@ -1,6 +1,7 @@
 package net.exoad.kira.lsp
 
 import org.eclipse.lsp4j.InitializeParams
+import org.eclipse.lsp4j.Range
 import org.eclipse.lsp4j.InitializeResult
 import org.eclipse.lsp4j.ServerCapabilities
 import org.eclipse.lsp4j.TextDocumentSyncKind
@@ -17,13 +18,13 @@ import java.util.concurrent.ConcurrentHashMap
  * Kira language server (LSP 3.x via lsp4j).
  *
  * Baseline surface:
- *  - full document sync for `kira` / `*.kira`
+ *  - incremental document sync for `kira` / `*.kira`, into a [DocumentBuffer] per document
  *  - publishDiagnostics from the shared frontend pipeline
  *
  * Hover / completion / go-to-def land later on the same FrontendService.
  */
 class KiraLanguageServer : LanguageServer, LanguageClientAware {
-    private val documents = ConcurrentHashMap<String, String>()
+    private val documents = ConcurrentHashMap<String, DocumentBuffer>()
     private lateinit var client: LanguageClient
     private val textDocuments = KiraTextDocumentService(this)
     private val workspace = KiraWorkspaceService(this)
@@ -34,17 +35,32 @@ class KiraLanguageServer : LanguageServer, LanguageClientAware {
     fun clientOrNull(): LanguageClient? =
         if (this::client.isInitialized) client else null
 
-    fun openDocuments(): Map<String, String> = documents.toMap()
+    /** The text of every open document. */
+    fun openDocuments(): Map<String, String> = documents.mapValues { (_, buffer) ->
+        synchronized(buffer) { buffer.toString() }
+    }
+
+    /** The text of every open document with what was edited since the last call ([DocumentBuffer.read]). */
+    fun readDocuments(): Map<String, DocumentBuffer.Read> = documents.mapValues { (_, buffer) ->
+        synchronized(buffer) { buffer.read() }
+    }
 
     fun putDocument(uri: String, text: String) {
-        documents[uri] = text
+        documents[uri] = DocumentBuffer(text)
+    }
+
+    /** Apply one `contentChanges` entry to [uri]; false when the document is not open. */
+    fun editDocument(uri: String, range: Range?, text: String): Boolean {
+        val buffer = documents[uri] ?: return false
+        synchronized(buffer) { buffer.apply(range, text) }
+        return true
     }
 
     fun removeDocument(uri: String) {
         documents.remove(uri)
     }
 
-    fun getDocument(uri: String): String? = documents[uri]
+    fun getDocument(uri: String): String? = documents[uri]?.let { buffer -> synchronized(buffer) { buffer.toString() } }
 
     override fun initialize(params: InitializeParams): CompletableFuture<InitializeResult> {
         workspaceRoot = params.workspaceFolders
@@ -56,7 +72,7 @@ class KiraLanguageServer : LanguageServer, LanguageClientAware {
 
         val sync = TextDocumentSyncOptions().apply {
             openClose = true
-            change = TextDocumentSyncKind.Full
+            change = TextDocumentSyncKind.Incremental
             save = org.eclipse.lsp4j.jsonrpc.messages.Either.forLeft(false)
         }
         val capabilities = ServerCapabilities().apply {
@@ -1,6 +1,8 @@
 package net.exoad.kira.lsp
 
+import net.exoad.kira.compiler.CompilerSession
 import net.exoad.kira.compiler.FrontendService
+import net.exoad.kira.compiler.FrontendWorkspace
 import org.eclipse.lsp4j.DidChangeTextDocumentParams
 import org.eclipse.lsp4j.DidCloseTextDocumentParams
 import org.eclipse.lsp4j.DidOpenTextDocumentParams
@@ -12,18 +14,38 @@ import org.eclipse.lsp4j.PublishDiagnosticsParams
 import org.eclipse.lsp4j.Range
 import org.eclipse.lsp4j.services.TextDocumentService
 import java.nio.file.Path
+import java.util.concurrent.CancellationException
 import java.util.concurrent.ConcurrentHashMap
 import java.util.concurrent.Executors
 import java.util.concurrent.ScheduledFuture
 import java.util.concurrent.TimeUnit
+import java.util.concurrent.atomic.AtomicLong
 
+/**
+ * Diagnoses whole projects, one run at a time on the `kira-lsp-diagnose`
+ * thread. Each project keeps a [FrontendWorkspace], so a run only lexes and
+ * parses the buffers whose text changed and skips the analyzer when the
+ * unit is unchanged. An edit bumps its project's generation, which the
+ * in-flight run polls between phases: a stale run stops at the next file
+ * or module instead of finishing and publishing old diagnostics.
+ */
 class KiraTextDocumentService(
     private val server: KiraLanguageServer,
 ) : TextDocumentService {
+    private class Project {
+        val workspace = FrontendWorkspace()
+        val generation = AtomicLong()
+
+        /** URIs the last run published diagnostics for, cleared by the next run that no longer reports them. */
+        @Volatile
+        var published: Set<String> = emptySet()
+    }
+
     private val scheduler = Executors.newSingleThreadScheduledExecutor { r ->
         Thread(r, "kira-lsp-diagnose").apply { isDaemon = true }
     }
-    private val pending = ConcurrentHashMap<String, ScheduledFuture<*>>()
+    private val projects = ConcurrentHashMap<Path, Project>()
+    private val pending = ConcurrentHashMap<Path, ScheduledFuture<*>>()
     private val debounceMs = 250L
 
     override fun didOpen(params: DidOpenTextDocumentParams) {
@@ -34,16 +56,20 @@ class KiraTextDocumentService(
 
     override fun didChange(params: DidChangeTextDocumentParams) {
         val uri = params.textDocument.uri
-        // Full sync: the client sends the entire buffer in changes[0].text
-        val text = params.contentChanges.firstOrNull()?.text ?: return
-        server.putDocument(uri, text)
+        // Incremental sync: ranged edits in order, each against the text the one before left;
+        // an entry without a range replaces the whole buffer.
+        params.contentChanges.forEach { change ->
+            if (!server.editDocument(uri, change.range, change.text) && change.range == null) {
+                server.putDocument(uri, change.text)
+            }
+        }
         scheduleDiagnose(uri)
     }
 
     override fun didClose(params: DidCloseTextDocumentParams) {
         val uri = params.textDocument.uri
-        pending.remove(uri)?.cancel(false)
         server.removeDocument(uri)
+        projects.values.forEach { it.published -= uri }
         // Clear diagnostics for the closed file
         server.clientOrNull()?.publishDiagnostics(
             PublishDiagnosticsParams(uri, emptyList())
@@ -55,10 +81,16 @@ class KiraTextDocumentService(
     }
 
     private fun scheduleDiagnose(uri: String) {
-        pending.remove(uri)?.cancel(false)
-        pending[uri] = scheduler.schedule({
+        val projectRoot = projectRootOf(uri) ?: return
+        val project = projects.computeIfAbsent(projectRoot) { Project() }
+        // Cancels the run in flight, if any; it is about to be stale.
+        val run = project.generation.incrementAndGet()
+        pending.remove(projectRoot)?.cancel(false)
+        pending[projectRoot] = scheduler.schedule({
             try {
-                diagnose(uri)
+                diagnose(uri, projectRoot, project, run)
+            } catch (_: CancellationException) {
+                // a newer edit superseded this run; its own run publishes
             } catch (_: Exception) {
                 // never crash the server thread on a bad buffer
             }
@@ -66,23 +98,38 @@ class KiraTextDocumentService(
     }
 
     internal fun diagnose(uri: String) {
+        val projectRoot = projectRootOf(uri) ?: return
+        val project = projects.computeIfAbsent(projectRoot) { Project() }
+        diagnose(uri, projectRoot, project, project.generation.get())
+    }
+
+    private fun diagnose(uri: String, projectRoot: Path, project: Project, run: Long) {
         val client = server.clientOrNull() ?: return
-        val path = LspPaths.uriToPath(uri)
-        if (!path.toString().endsWith(".kira") && !uri.endsWith(".kira")) {
-            return
+        val documents = server.readDocuments()
+        val overlays = documents.entries.associate { (docUri, read) ->
+            LspPaths.uriToPath(docUri).toString() to read.text
         }
+        // the spans the editor changed, so the workspace re-lexes from there instead of diffing every buffer
+        project.workspace.expectEdits(documents.values.mapNotNull { it.edit })
+        // The workspace keeps every parse in memory. The disk cache would only
+        // serialize unsaved buffers into .kira/cache on every keystroke and
+        // crowd out the entries the CLI built from the saved files.
+        val session = CompilerSession(
+            useIncrementalCache = false,
+            workspace = project.workspace,
+            cancelled = { project.generation.get() != run },
+        )
 
-        val projectRoot = resolveProjectRoot(path)
-        val overlays = server.openDocuments().mapKeys { (docUri, _) ->
-            LspPaths.uriToPath(docUri).toString()
+        val result = FrontendService.compileProject(projectRoot, overlays, session)
+        if (project.generation.get() != run) {
+            return
         }
 
-        val result = FrontendService.compileProject(projectRoot, overlays)
-
         // Group diagnostics by file URI and publish (including empty lists to clear).
         val byUri = linkedMapOf<String, MutableList<Diagnostic>>()
-        // Always clear the triggering document first.
+        // Always clear the triggering document first, then whatever the last run reported.
         byUri[uri] = mutableListOf()
+        project.published.forEach { byUri[it] = mutableListOf() }
 
         for (d in result.diagnostics) {
             val dUri = if (d.file.isBlank()) uri else LspPaths.pathToUri(d.file)
@@ -93,6 +140,15 @@ class KiraTextDocumentService(
         for ((docUri, diags) in byUri) {
             client.publishDiagnostics(PublishDiagnosticsParams(docUri, diags))
         }
+        project.published = byUri.filterValues { it.isNotEmpty() }.keys.toSet()
+    }
+
+    private fun projectRootOf(uri: String): Path? {
+        val path = LspPaths.uriToPath(uri)
+        if (!path.toString().endsWith(".kira") && !uri.endsWith(".kira")) {
+            return null
+        }
+        return resolveProjectRoot(path).toAbsolutePath().normalize()
     }
 
     private fun resolveProjectRoot(filePath: Path): Path {
@@ -8,21 +8,42 @@ import net.exoad.kira.compiler.frontend.parser.ast.ASTNode
 import net.exoad.kira.compiler.frontend.parser.ast.RootASTNode
 import net.exoad.kira.compiler.frontend.parser.ast.declarations.ModuleDecl
 import net.exoad.kira.core.CompilerIntrinsic
-import java.util.*
 
 /**
  * a source context represents a single source file and contains all the processed information for that source file
  * this includes information like:
  *
- * 1. the raw preprocessed content (everything after [net.exoad.kira.compiler.frontend.preprocessor.KiraPreprocessor])
+ * 1. the raw source text; comments are only skipped by the lexer
  * 2. the lexical tokens generated by [net.exoad.kira.compiler.frontend.lexer.KiraLexer]
  * 3. the [ast] generated by [net.exoad.kira.compiler.frontend.parser.KiraParser]
  */
 class SourceContext(val content: String, val file: String, val tokens: List<Token>) {
-    private val lines: List<String> = content.lines()
+    /**
+     * Offset of the first character of every line, built on the first diagnostic that needs a line rather than
+     * splitting [content] up front.
+     */
+    private val lineStarts: IntArray by lazy {
+        val starts = ArrayList<Int>()
+        starts.add(0)
+        for (i in content.indices) {
+            if (content[i] == '\n') {
+                starts.add(i + 1)
+            }
+        }
+        starts.toIntArray()
+    }
     lateinit var ast: RootASTNode
-    lateinit var astOrigins: IdentityHashMap<ASTNode, SourcePosition>
-    lateinit var astIntrinsicMarked: IdentityHashMap<ASTNode, Array<CompilerIntrinsic>>
+
+    /** Whether the parser got as far as setting [ast]. */
+    val isParsed: Boolean get() = ::ast.isInitialized
+
+    /**
+     * Nodes of [ast] that carry intrinsic markers, in parse order. The markers
+     * and every node's position live on the node itself
+     * ([ASTNode.intrinsicMarks], [ASTNode.packedOrigin]); this list only exists
+     * so the backends can visit the few marked nodes without walking the tree.
+     */
+    val intrinsified = ArrayList<ASTNode>()
 
     /**
      * Returns the module declaration representing this source module
@@ -54,7 +75,7 @@ class SourceContext(val content: String, val file: String, val tokens: List<Toke
 
 
     fun getLines(): List<String> {
-        return lines
+        return List(lineStarts.size) { findCanonicalLine(it + 1) }
     }
 
     fun with(content: String, tokens: List<Token>? = null): SourceContext {
@@ -62,28 +83,39 @@ class SourceContext(val content: String, val file: String, val tokens: List<Toke
     }
 
     fun <T : ASTNode> isIntrinsified(node: T): Boolean {
-        return astIntrinsicMarked[node]?.isNotEmpty() ?: false
+        return node.intrinsicMarks?.isNotEmpty() ?: false
     }
 
     fun <T : ASTNode> intrinsicsOf(node: T): Array<CompilerIntrinsic> {
         if (!isIntrinsified(node)) {
             Diagnostics.panic("Kira", "$node has no intrinsic markers.", context = this)
         }
-        return astIntrinsicMarked[node]!!
+        return node.intrinsicMarks!!
+    }
+
+    /** Where the parser recorded [node], or null when it recorded nothing (synthesized and singleton nodes). */
+    fun originOf(node: ASTNode?): SourcePosition? {
+        return if (node == null) null else ASTNode.unpackOrigin(node.packedOrigin)
     }
 
     fun <T : ASTNode> relativeOriginOf(node: T): SourcePosition {
-        if (!astOrigins.containsKey(node)) {
-            Diagnostics.panic("Kira", "Could not find a saved location for $node", context = this)
-        }
-        return astOrigins[node]!!
+        return originOf(node) ?: Diagnostics.panic(
+            "Kira",
+            "Could not find a saved location for $node",
+            context = this
+        )
     }
 
     /**
      * 1-based indexing (is this lua? when anything refers to canonicity in my code, it often just means the way that ordinary folks (users of the language) would refer to things or like things
      */
     fun findCanonicalLine(lineNumber: Int): String {
-        return lines[lineNumber - 1]
+        val start = lineStarts[lineNumber - 1]
+        var end = if (lineNumber < lineStarts.size) lineStarts[lineNumber] - 1 else content.length
+        if (end > start && content[end - 1] == '\r') {
+            end--
+        }
+        return content.substring(start, end)
     }
 
     /**
@@ -1,9 +1,11 @@
 package net.exoad.kira.source
 
+import java.io.Serializable
+
 /**
  * Represents not just a position, but also the containing source file
  */
-open class SourceLocation(val lineNumber: Int, val column: Int, val srcFile: String) {
+open class SourceLocation(val lineNumber: Int, val column: Int, val srcFile: String) : Serializable {
     companion object {
         fun bakedIn(): SourceLocation {
             return object : SourceLocation(0, 0, "builtin") {
@@ -1,9 +1,11 @@
 package net.exoad.kira.source
 
+import java.io.Serializable
+
 /**
  * Represents position within a source file
  */
-data class SourcePosition(val lineNumber: Int, val column: Int) : Comparable<SourcePosition> {
+data class SourcePosition(val lineNumber: Int, val column: Int) : Comparable<SourcePosition>, Serializable {
     companion object {
         val UNKNOWN = SourcePosition(-1, -1)
     }
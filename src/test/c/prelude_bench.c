@@ -0,0 +1,500 @@
+/*
+ * Microbenchmarks for the C runtime prelude (kira/c/c_generator.c).
+ *
+ * Includes the prelude exactly as emitted programs do (bundle, then runtime)
+ * and times its containers, Str helpers and ARC allocation on synthetic
+ * workloads at 1e3 .. 1e7 elements. Every row reports ns/op and heap bytes /
+ * allocations per op. The heap numbers count what the prelude asks malloc /
+ * calloc / realloc for, so they do not depend on the libc. Each row is the
+ * fastest of a few repetitions.
+ *
+ * With a thresholds file, a row slower or hungrier than its configured
+ * limit fails the run (exit 1). That catches a regression in the runtime's
+ * data structures before it ships in every program.
+ *
+ *   cc -std=c17 -O2 -Ikira/c -o prelude_bench src/test/c/prelude_bench.c
+ *   ./prelude_bench [--max N] [--thresholds FILE]
+ *
+ * `./gradlew preludeBench` does both with the thresholds next to this file.
+ * ISO C17 only (timespec_get for the clock).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/* ---- allocation accounting ---------------------------------------------- */
+
+static int64_t bench_bytes;
+static int64_t bench_allocs;
+
+static void* bench_malloc(size_t n)
+{
+    bench_bytes += (int64_t)n;
+    bench_allocs++;
+    return malloc(n);
+}
+
+static void* bench_calloc(size_t count, size_t n)
+{
+    bench_bytes += (int64_t)(count * n);
+    bench_allocs++;
+    return calloc(count, n);
+}
+
+/* A grow counts its full new size: that is what the copy costs. */
+static void* bench_realloc(void* p, size_t n)
+{
+    bench_bytes += (int64_t)n;
+    bench_allocs++;
+    return realloc(p, n);
+}
+
+static void bench_free(void* p)
+{
+    free(p);
+}
+
+/* The libc headers are already in, so only the prelude's own calls are rewritten. */
+#define malloc(n)     bench_malloc(n)
+#define calloc(c, n)  bench_calloc((c), (n))
+#define realloc(p, n) bench_realloc((p), (n))
+#define free(p)       bench_free(p)
+
+#include "c_bundle.h"
+#include "c_generator.c"
+
+#undef malloc
+#undef calloc
+#undef realloc
+#undef free
+
+/* ---- measurement --------------------------------------------------------- */
+
+typedef struct Bench
+{
+    Int64 ops;
+    Int64 startNs;
+    Int64 startBytes;
+    Int64 startAllocs;
+    Int64 ns;
+    Int64 bytes;
+    Int64 allocs;
+} Bench;
+
+static Int64 bench_now(Void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (Int64)ts.tv_sec * 1000000000LL + (Int64)ts.tv_nsec;
+}
+
+/* Only the work between start and stop counts; setup and teardown stay outside. */
+static Void bench_start(Bench* b)
+{
+    b->startBytes  = bench_bytes;
+    b->startAllocs = bench_allocs;
+    b->startNs     = bench_now();
+}
+
+static Void bench_stop(Bench* b, Int64 ops)
+{
+    b->ns     += bench_now() - b->startNs;
+    b->bytes  += bench_bytes - b->startBytes;
+    b->allocs += bench_allocs - b->startAllocs;
+    b->ops    += ops;
+}
+
+/* Keeps results alive so the optimizer cannot drop the work. */
+static volatile Int64 bench_sink;
+
+/* ---- inputs --------------------------------------------------------------- */
+
+/* Deterministic, distinct, not sequential: sequential keys flatter a hash. */
+static Int64 bench_key(Int64 i)
+{
+    return (i * 2654435761LL) ^ (i >> 7);
+}
+
+/* "key-<n>" for every i < n, in one block so building them is not measured as map work. */
+static Str* bench_str_keys(Int64 n, Utf8** block)
+{
+    Str* keys = (Str*)malloc((size_t)n * sizeof(Str));
+    Utf8* text = (Utf8*)malloc((size_t)n * 24);
+    if (keys == NULL || text == NULL) abort();
+    Int64 i;
+    for (i = 0; i < n; i++)
+    {
+        Utf8* at = text + i * 24;
+        snprintf(at, 24, "key-%lld", (long long)bench_key(i));
+        keys[i] = at;
+    }
+    *block = text;
+    return keys;
+}
+
+/* ---- workloads ------------------------------------------------------------ */
+
+static Void map_put_int(Bench* b, Int64 n)
+{
+    Map m = Map_new_i();
+    bench_start(b);
+    Int64 i;
+    for (i = 0; i < n; i++) Map_put(&m, KIRA_SLOT(bench_key(i)), KIRA_SLOT(i));
+    bench_stop(b, n);
+    bench_sink = Map_size(&m);
+    Map_dispose(&m);
+}
+
+static Void map_get_int(Bench* b, Int64 n)
+{
+    Map m = Map_new_i();
+    Int64 i;
+    for (i = 0; i < n; i++) Map_put(&m, KIRA_SLOT(bench_key(i)), KIRA_SLOT(i));
+    Int64 found = 0;
+    bench_start(b);
+    /* every other lookup misses */
+    for (i = 0; i < n; i++)
+    {
+        Maybe hit = Map_get(&m, KIRA_SLOT(bench_key(i / 2 + (i & 1) * n)));
+        found += hit.present;
+    }
+    bench_stop(b, n);
+    bench_sink = found;
+    Map_dispose(&m);
+}
+
+static Void map_put_str(Bench* b, Int64 n)
+{
+    Utf8* block;
+    Str* keys = bench_str_keys(n, &block);
+    Map m = Map_new_s();
+    bench_start(b);
+    Int64 i;
+    for (i = 0; i < n; i++) Map_put(&m, KIRA_SLOT_PTR(keys[i]), KIRA_SLOT(i));
+    bench_stop(b, n);
+    bench_sink = Map_size(&m);
+    Map_dispose(&m);
+    free(keys);
+    free(block);
+}
+
+static Void map_get_str(Bench* b, Int64 n)
+{
+    Utf8* block;
+    Str* keys = bench_str_keys(n, &block);
+    Map m = Map_new_s();
+    Int64 i;
+    /* half the keys go in, so half the lookups miss */
+    for (i = 0; i < n; i += 2) Map_put(&m, KIRA_SLOT_PTR(keys[i]), KIRA_SLOT(i));
+    Int64 found = 0;
+    bench_start(b);
+    for (i = 0; i < n; i++)
+    {
+        Maybe hit = Map_get(&m, KIRA_SLOT_PTR(keys[i]));
+        found += hit.present;
+    }
+    bench_stop(b, n);
+    bench_sink = found;
+    Map_dispose(&m);
+    free(keys);
+    free(block);
+}
+
+static Void list_add(Bench* b, Int64 n)
+{
+    List l = List_new();
+    bench_start(b);
+    Int64 i;
+    for (i = 0; i < n; i++) List_add(&l, KIRA_SLOT(i));
+    bench_stop(b, n);
+    bench_sink = List_size(&l);
+    List_dispose(&l);
+}
+
+static Void set_contains(Bench* b, Int64 n)
+{
+    Set s = Set_new();
+    Int64 i;
+    for (i = 0; i < n; i += 2) Set_add(&s, KIRA_SLOT(bench_key(i)));
+    Int64 found = 0;
+    bench_start(b);
+    for (i = 0; i < n; i++) found += Set_contains(&s, KIRA_SLOT(bench_key(i)));
+    bench_stop(b, n);
+    bench_sink = found;
+    Set_dispose(&s);
+}
+
+/* A queue that never drains: n enqueue + dequeue pairs behind 64 waiting items. */
+static Void queue_churn(Bench* b, Int64 n)
+{
+    Queue q = Queue_new();
+    Int64 i;
+    for (i = 0; i < 64; i++) Queue_enqueue(&q, KIRA_SLOT(i));
+    Int64 sum = 0;
+    bench_start(b);
+    for (i = 0; i < n; i++)
+    {
+        Queue_enqueue(&q, KIRA_SLOT(i));
+        Maybe head = Queue_dequeue(&q);
+        sum += head.value;
+    }
+    bench_stop(b, n);
+    bench_sink = sum;
+    Queue_dispose(&q);
+}
+
+/* Alternates front-in/back-out and back-in/front-out behind 64 waiting items. */
+static Void deque_churn(Bench* b, Int64 n)
+{
+    Deque d = Deque_new();
+    Int64 i;
+    for (i = 0; i < 64; i++) Deque_pushBack(&d, KIRA_SLOT(i));
+    Int64 sum = 0;
+    bench_start(b);
+    for (i = 0; i < n; i++)
+    {
+        Maybe out;
+        if (i & 1)
+        {
+            Deque_pushBack(&d, KIRA_SLOT(i));
+            out = Deque_popFront(&d);
+        }
+        else
+        {
+            Deque_pushFront(&d, KIRA_SLOT(i));
+            out = Deque_popBack(&d);
+        }
+        sum += out.value;
+    }
+    bench_stop(b, n);
+    bench_sink = sum;
+    Deque_dispose(&d);
+}
+
+/* One split of a line with n comma-separated fields; an op is one field. */
+static Void str_split(Bench* b, Int64 n)
+{
+    Utf8* line = (Utf8*)malloc((size_t)n * 8 + 1);
+    if (line == NULL) abort();
+    Utf8* at = line;
+    Int64 i;
+    for (i = 0; i < n; i++)
+    {
+        at += sprintf(at, i + 1 < n ? "f%04d," : "f%04d", (int)(i % 10000));
+    }
+    bench_start(b);
+    List parts = Str_split(line, ",");
+    bench_stop(b, n);
+    bench_sink = List_size(&parts);
+    for (i = 0; i < parts.length; i++) free((Void*)List_get_str(&parts, (Int32)i));
+    List_dispose(&parts);
+    free(line);
+}
+
+static Void str_substring(Bench* b, Int64 n)
+{
+    Str text = "the quick brown fox jumps over the lazy dog, then naps in the sun";
+    Int32 length = Str_length(text);
+    Str* out = (Str*)malloc((size_t)n * sizeof(Str));
+    if (out == NULL) abort();
+    bench_start(b);
+    Int64 i;
+    for (i = 0; i < n; i++)
+    {
+        Int32 start = (Int32)(i % 16);
+        out[i] = Str_substring(text, start, start + 8 + (Int32)(i % (length - 24)));
+    }
+    bench_stop(b, n);
+    Int64 total = 0;
+    for (i = 0; i < n; i++)
+    {
+        total += Str_length(out[i]);
+        free((Void*)out[i]);
+    }
+    bench_sink = total;
+    free(out);
+}
+
+/* Allocate and release one 32-byte object, the lifetime of most temporaries. */
+static Void rc_alloc_release(Bench* b, Int64 n)
+{
+    bench_start(b);
+    Int64 i;
+    for (i = 0; i < n; i++)
+    {
+        Int64* obj = (Int64*)kira_rc_alloc(32);
+        obj[0] = i;
+        bench_sink = obj[0];
+        kira_rc_release(obj);
+    }
+    bench_stop(b, n);
+}
+
+typedef struct Workload
+{
+    Str   name;
+    Void  (*run)(Bench*, Int64);
+    /*
+     * Largest n the workload runs at. Set is a linear scan and Str_split
+     * re-measures the rest of the line for every field, so both are
+     * quadratic and stop early.
+     */
+    Int64 cap;
+} Workload;
+
+static const Workload WORKLOADS[] = {
+    { "map_put_int",      map_put_int,      10000000 },
+    { "map_get_int",      map_get_int,      10000000 },
+    { "map_put_str",      map_put_str,      10000000 },
+    { "map_get_str",      map_get_str,      10000000 },
+    { "list_add",         list_add,         10000000 },
+    { "set_contains",     set_contains,     10000    },
+    { "queue_churn",      queue_churn,      10000000 },
+    { "deque_churn",      deque_churn,      10000000 },
+    { "str_split",        str_split,        100000   },
+    { "str_substring",    str_substring,    1000000  },
+    { "rc_alloc_release", rc_alloc_release, 10000000 },
+};
+
+/* ---- thresholds ----------------------------------------------------------- */
+
+typedef struct Threshold
+{
+    char  name[64];
+    Int64 n;
+    double maxNsPerOp;
+    double maxBytesPerOp;
+} Threshold;
+
+/*
+ * One limit per line: `<workload> <n> <max ns/op> <max bytes/op>`. `#` starts
+ * a comment, and `-` leaves a limit unchecked.
+ */
+static Int32 load_thresholds(Str path, Threshold* out, Int32 capacity)
+{
+    FILE* in = fopen(path, "r");
+    if (in == NULL)
+    {
+        fprintf(stderr, "prelude_bench: cannot read thresholds %s\n", path);
+        exit(2);
+    }
+    char line[256];
+    Int32 count = 0;
+    Int32 lineNo = 0;
+    while (fgets(line, sizeof line, in) != NULL)
+    {
+        lineNo++;
+        char* hash = strchr(line, '#');
+        if (hash != NULL) *hash = '\0';
+        char name[64];
+        long long n;
+        char ns[32];
+        char bytes[32];
+        Int32 fields = sscanf(line, "%63s %lld %31s %31s", name, &n, ns, bytes);
+        if (fields <= 0) continue;
+        if (fields != 4 || count == capacity)
+        {
+            fprintf(stderr, "prelude_bench: %s:%d: expected `<workload> <n> <ns/op> <bytes/op>`\n", path, lineNo);
+            exit(2);
+        }
+        Threshold* t = &out[count++];
+        snprintf(t->name, sizeof t->name, "%s", name);
+        t->n = (Int64)n;
+        t->maxNsPerOp    = strcmp(ns, "-") == 0 ? -1 : atof(ns);
+        t->maxBytesPerOp = strcmp(bytes, "-") == 0 ? -1 : atof(bytes);
+    }
+    fclose(in);
+    return count;
+}
+
+/* ---- driver --------------------------------------------------------------- */
+
+/* Fewer repetitions as rows grow, so the 1e7 rows do not dominate the run. */
+static Int32 repetitions(Int64 n)
+{
+    return n >= 1000000 ? 1 : n >= 100000 ? 3 : 5;
+}
+
+int main(int argc, char** argv)
+{
+    Int64 max = 1000000;
+    Str thresholdsPath = NULL;
+    Int32 a;
+    for (a = 1; a < argc; a++)
+    {
+        if (strcmp(argv[a], "--max") == 0 && a + 1 < argc)
+        {
+            max = atoll(argv[++a]);
+        }
+        else if (strcmp(argv[a], "--thresholds") == 0 && a + 1 < argc)
+        {
+            thresholdsPath = argv[++a];
+        }
+        else
+        {
+            fprintf(stderr, "usage: prelude_bench [--max N] [--thresholds FILE]\n");
+            return 2;
+        }
+    }
+    static Threshold thresholds[256];
+    Int32 thresholdCount = thresholdsPath == NULL ? 0 : load_thresholds(thresholdsPath, thresholds, 256);
+
+    printf("%-18s %10s %12s %12s %12s\n", "workload", "n", "ns/op", "bytes/op", "allocs/op");
+    Int32 failures = 0;
+    size_t w;
+    for (w = 0; w < sizeof WORKLOADS / sizeof WORKLOADS[0]; w++)
+    {
+        const Workload* workload = &WORKLOADS[w];
+        Int64 n;
+        for (n = 1000; n <= workload->cap && n <= max; n *= 10)
+        {
+            double bestNs = -1;
+            Bench best = { 0 };
+            Int32 r;
+            for (r = 0; r < repetitions(n); r++)
+            {
+                Bench b = { 0 };
+                workload->run(&b, n);
+                double perOp = (double)b.ns / (double)b.ops;
+                if (bestNs < 0 || perOp < bestNs)
+                {
+                    bestNs = perOp;
+                    best = b;
+                }
+            }
+            double bytesPerOp  = (double)best.bytes / (double)best.ops;
+            double allocsPerOp = (double)best.allocs / (double)best.ops;
+            printf("%-18s %10lld %12.2f %12.2f %12.4f\n", workload->name, (long long)n, bestNs, bytesPerOp, allocsPerOp);
+            fflush(stdout);
+
+            Int32 t;
+            for (t = 0; t < thresholdCount; t++)
+            {
+                Threshold* limit = &thresholds[t];
+                if (strcmp(limit->name, workload->name) != 0 || limit->n != n) continue;
+                if (limit->maxNsPerOp >= 0 && bestNs > limit->maxNsPerOp)
+                {
+                    fprintf(stderr, "REGRESSION %s n=%lld: %.2f ns/op > %.2f\n",
+                            workload->name, (long long)n, bestNs, limit->maxNsPerOp);
+                    failures++;
+                }
+                if (limit->maxBytesPerOp >= 0 && bytesPerOp > limit->maxBytesPerOp)
+                {
+                    fprintf(stderr, "REGRESSION %s n=%lld: %.2f bytes/op > %.2f\n",
+                            workload->name, (long long)n, bytesPerOp, limit->maxBytesPerOp);
+                    failures++;
+                }
+            }
+        }
+    }
+    if (failures > 0)
+    {
+        fprintf(stderr, "prelude_bench: %d threshold(s) exceeded\n", failures);
+        return 1;
+    }
+    return 0;
+}
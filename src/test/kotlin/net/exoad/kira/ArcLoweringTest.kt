@@ -1,6 +1,10 @@
 package net.exoad.kira
 
+import net.exoad.kira.compiler.backend.codegen.StdlibLayout
 import org.junit.jupiter.api.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertNotNull
 import kotlin.test.assertTrue
 
 /**
@@ -121,8 +125,8 @@ class ArcLoweringTest {
         )
 
         assertTrue(c.contains("Box_finalize"), c)
-        assertTrue(c.contains("kira_rc_alloc_with(sizeof(Box), Box_finalize)"), c)
-        assertTrue(c.contains("kira_rc_release(self->inner)"), c)
+        assertTrue(c.contains("kira_rc_alloc_with(sizeof(Box), Box_finalize, \"Box\")"), c)
+        assertTrue(c.contains("visit(self->inner)"), c)
     }
 
     @Test
@@ -201,4 +205,225 @@ class ArcLoweringTest {
         assertTrue(c.contains("Map_dispose(&m)"), c)
         assertTrue(c.contains("Set_dispose(&s)"), c)
     }
+
+    @Test
+    fun rcStatsCountPerClassTagsAndReportAtExit() {
+        val program = """
+            $pet
+
+            fx main: () Void {
+                a: Pet = Pet { "a" }
+                b: Pet = a
+                c: Pet = Pet { "c" }
+                enabled: Bool = rcStatsEnabled()
+                allocated: Int64 = rcAllocations("Pet")
+                live: Int64 = rcLive("Pet")
+                retained: Int64 = rcRetains("Pet")
+                trace(enabled)
+                trace(allocated)
+                trace(live)
+                trace(retained)
+            }
+            """
+        val c = emit(program, "test:arc.stats")
+        // Class_new tags the allocation with the Kira class name.
+        assertTrue(c.contains("kira_rc_alloc_with(sizeof(Pet), null, \"Pet\")"), c)
+        assertTrue(c.contains("kira_rc_stats_live(\"Pet\")"), c)
+
+        val cc = TestCompileSupport.findCCompiler() ?: return
+        val source = TestCompileSupport.transpileSnippetToC(
+            source = TestCompileSupport.wrapModule("test:arc.stats", program),
+            logicalPath = TestCompileSupport.logicalPathForModule("test:arc.stats")
+        )
+        // Default build: the kira:debug readers still link, and read zero.
+        val plain = TestCompileSupport.compileAndRunC(source, cc)
+        assertEquals(0, plain.compileResult.exitCode, plain.compileResult.stderr)
+        assertEquals("0\n0\n0\n0\n", plain.runResult?.stdout, plain.runResult?.stderr)
+
+        // Stats build: per-class counters, and the exit table shows every Pet freed.
+        val stats = TestCompileSupport.compileAndRunC("#define KIRA_RC_STATS 1\n$source", cc)
+        assertEquals(0, stats.compileResult.exitCode, stats.compileResult.stderr)
+        assertEquals("1\n2\n2\n1\n", stats.runResult?.stdout, stats.runResult?.stderr)
+        val report = stats.runResult?.stderr.orEmpty()
+        assertTrue(report.contains("kira RC stats at exit -- 0 live of 2 allocated, peak 2"), report)
+        assertTrue(Regex("""\nPet\s+2\s+2\s+1\s+3\s+0\s+2\n""").containsMatchIn(report), report)
+        assertFalse(report.contains("LEAK"), report)
+    }
+
+    @Test
+    fun weakUpgradeFollowsTheTargetsLifetime() {
+        val program = """
+            $pet
+
+            fx remember: (name: Str) Weak<Pet> {
+                p: Pet = Pet { name }
+                w: Weak<Pet> = Weak<Pet> { p }
+                trace(w.isAlive())
+                return w
+            }
+
+            fx main: () Void {
+                a: Pet = Pet { "a" }
+                held: Weak<Pet> = Weak<Pet> { a }
+                some: Maybe<Pet> = held.upgrade()
+                trace(some.isSome())
+                strong: Pet = some.unwrap()
+                trace(strong.name)
+                gone: Weak<Pet> = remember("b")
+                trace(gone.isAlive())
+                none: Maybe<Pet> = gone.upgrade()
+                trace(none.isNone())
+            }
+            """
+        val c = emit(program, "test:arc.weak")
+        // A weak handle borrows its target: no retain, and nothing to release.
+        assertTrue(c.contains("Weak w = Weak_of(p)"), c)
+        assertFalse(c.contains("kira_rc_retain(w)"), c)
+        assertFalse(c.contains("Weak_dispose"), c)
+        assertTrue(c.contains("Maybe some = Weak_upgrade(&held)"), c)
+
+        val cc = TestCompileSupport.findCCompiler() ?: return
+        val source = TestCompileSupport.transpileSnippetToC(
+            source = TestCompileSupport.wrapModule("test:arc.weak", program),
+            logicalPath = TestCompileSupport.logicalPathForModule("test:arc.weak")
+        )
+        // `b` dies when remember() returns, so its handle no longer upgrades;
+        // the +1 from upgrade() is released with `strong`, so nothing leaks.
+        val ran = TestCompileSupport.compileAndRunC("#define KIRA_RC_STATS 1\n$source", cc)
+        assertEquals(0, ran.compileResult.exitCode, ran.compileResult.stderr)
+        assertEquals("1\na\n1\n0\n1\n", ran.runResult?.stdout, ran.runResult?.stderr)
+        val report = ran.runResult?.stderr.orEmpty()
+        assertTrue(report.contains("kira RC stats at exit -- 0 live of 2 allocated, peak 2"), report)
+    }
+
+    private val cycleNode = """
+        typedef struct Node Node;
+        struct Node { Node* next; };
+        static Void Node_finalize(Void* p, KiraRcVisitor visit) { visit(((Node*)p)->next); }
+        static Node* node(Void) { return (Node*)kira_rc_alloc_with(sizeof(Node), Node_finalize, "Node"); }
+    """.trimIndent()
+
+    private fun cyclePrelude(): String =
+        listOf("c_bundle.h", "c_generator.c").joinToString("\n") { name ->
+            assertNotNull(StdlibLayout.cFile(name), "kira/c/$name must resolve").toFile().readText()
+        }
+
+    private fun runCollected(prelude: String, program: String, cc: String): String? {
+        val ran = TestCompileSupport.compileAndRunC(
+            "#define KIRA_RC_STATS 1\n#define KIRA_CYCLE_COLLECTOR 1\n$prelude\n$program",
+            cc
+        )
+        assertEquals(0, ran.compileResult.exitCode, ran.compileResult.stderr)
+        assertFalse(ran.runResult?.stderr.orEmpty().contains("LEAK"), ran.runResult?.stderr)
+        return ran.runResult?.stdout
+    }
+
+    /**
+     * Kira source cannot build a cycle yet (every class field is `require`d at
+     * construction), so this drives the prelude collector with a hand-written
+     * class in exactly the shape codegen emits: a `_finalize` visitor over the
+     * class-typed fields, passed to kira_rc_alloc_with.
+     */
+    @Test
+    fun cycleCollectorFreesUnreachableRingsAndSparesHeldOnes() {
+        val cc = TestCompileSupport.findCCompiler() ?: return
+        val prelude = cyclePrelude()
+        val program = """
+            $cycleNode
+            static Node* ring(Int32 size)
+            {
+                Node* head = (Node*)kira_rc_alloc_with(sizeof(Node), Node_finalize, "Node");
+                Node* tail = head;
+                for (Int32 i = 1; i < size; i++)
+                {
+                    tail->next = (Node*)kira_rc_alloc_with(sizeof(Node), Node_finalize, "Node");
+                    tail = tail->next;
+                }
+                tail->next = (Node*)kira_rc_retained(head);
+                return head;
+            }
+            Int32 main(Void)
+            {
+                Node* held = ring(1000);
+                Node* dropped = ring(1000);
+                kira_rc_retain(held);
+                kira_rc_release(held);
+                kira_rc_release(dropped);
+                printf("%lld\n", (long long)kira_rc_collect_cycles());
+                printf("%lld\n", (long long)kira_rc_stats_live("Node"));
+                kira_rc_release(held);
+                printf("%lld\n", (long long)kira_rc_collect_cycles());
+                printf("%lld\n", (long long)kira_rc_stats_live("Node"));
+                return 0;
+            }
+        """.trimIndent()
+
+        // Without the collector both rings leak and collectCycles() is a no-op.
+        val plain = TestCompileSupport.compileAndRunC("#define KIRA_RC_STATS 1\n$prelude\n$program", cc)
+        assertEquals(0, plain.compileResult.exitCode, plain.compileResult.stderr)
+        assertEquals("0\n2000\n0\n2000\n", plain.runResult?.stdout, plain.runResult?.stderr)
+
+        val collected = TestCompileSupport.compileAndRunC(
+            "#define KIRA_RC_STATS 1\n#define KIRA_CYCLE_COLLECTOR 1\n$prelude\n$program",
+            cc
+        )
+        assertEquals(0, collected.compileResult.exitCode, collected.compileResult.stderr)
+        assertEquals("1000\n1000\n1000\n0\n", collected.runResult?.stdout, collected.runResult?.stderr)
+        assertFalse(collected.runResult?.stderr.orEmpty().contains("LEAK"), collected.runResult?.stderr)
+    }
+
+    /**
+     * Every member of the ring is buffered, so the first root's gray walk
+     * reaches the others before the root loop does. They must be left to
+     * that walk, not freed as if released to zero.
+     */
+    @Test
+    fun cycleCollectorHandlesSeveralRootsInOneRing() {
+        val cc = TestCompileSupport.findCCompiler() ?: return
+        val program = """
+            $cycleNode
+            Int32 main(Void)
+            {
+                Node* a = node();
+                Node* b = node();
+                Node* c = node();
+                a->next = (Node*)kira_rc_retained(b);
+                b->next = (Node*)kira_rc_retained(c);
+                c->next = (Node*)kira_rc_retained(a);
+                kira_rc_release(a);
+                kira_rc_release(b);
+                kira_rc_release(c);
+                printf("%lld\n", (long long)kira_rc_collect_cycles());
+                printf("%lld\n", (long long)kira_rc_stats_live("Node"));
+                return 0;
+            }
+        """.trimIndent()
+        assertEquals("3\n0\n", runCollected(cyclePrelude(), program, cc))
+    }
+
+    /** A ring held by a live object survives collection until the holder goes. */
+    @Test
+    fun cycleCollectorSparesRingsReachableFromLiveObjects() {
+        val cc = TestCompileSupport.findCCompiler() ?: return
+        val program = """
+            $cycleNode
+            Int32 main(Void)
+            {
+                Node* owner = node();
+                Node* x = node();
+                Node* y = node();
+                x->next = (Node*)kira_rc_retained(y);
+                y->next = (Node*)kira_rc_retained(x);
+                owner->next = x;
+                kira_rc_release(y);
+                printf("%lld\n", (long long)kira_rc_collect_cycles());
+                printf("%lld\n", (long long)kira_rc_stats_live("Node"));
+                kira_rc_release(owner);
+                printf("%lld\n", (long long)kira_rc_collect_cycles());
+                printf("%lld\n", (long long)kira_rc_stats_live("Node"));
+                return 0;
+            }
+        """.trimIndent()
+        assertEquals("0\n3\n2\n0\n", runCollected(cyclePrelude(), program, cc))
+    }
 }
@@ -1,6 +1,6 @@
 package net.exoad.kira
 
-import net.exoad.kira.compiler.backend.codegen.c.CMagicBindingTable
+import net.exoad.kira.compiler.CompilerSession
 import org.junit.jupiter.api.Assumptions.assumeTrue
 import org.junit.jupiter.api.Test
 import java.io.File
@@ -16,15 +16,17 @@ import kotlin.test.assertTrue
  * the stdlib modules.
  */
 class CMagicBindingTableTest {
+    private val table = CompilerSession().magicBindings
+
     @Test
     fun mathBindingsLoadFromManifestBesideModules() {
         assumeTrue(File("kira/math.bind.yaml").isFile, "stdlib kira/ dir must be at cwd")
 
-        assertEquals("sqrt", CMagicBindingTable.resolveFunctionOrNull("sqrt"))
-        assertEquals(setOf("math.h"), CMagicBindingTable.includesOrNull("sqrt"))
+        assertEquals("sqrt", table.resolveFunctionOrNull("sqrt"))
+        assertEquals(setOf("math.h"), table.includesOrNull("sqrt"))
         // abs lowers to fabs, not C's abs -- that is manifest data, not a guess.
-        assertEquals("fabs", CMagicBindingTable.resolveFunctionOrNull("abs"))
-        assertEquals(setOf("math.h"), CMagicBindingTable.includesOrNull("min"))
+        assertEquals("fabs", table.resolveFunctionOrNull("abs"))
+        assertEquals(setOf("math.h"), table.includesOrNull("min"))
     }
 
     @Test
@@ -33,29 +35,29 @@ class CMagicBindingTableTest {
 
         // C's assert macro takes one argument; Kira's takes a message too, so
         // the binding must point at the prelude helper.
-        assertEquals("kira_assert", CMagicBindingTable.resolveFunctionOrNull("assert"))
+        assertEquals("kira_assert", table.resolveFunctionOrNull("assert"))
         // Empty includes for a bound name must not be confused with unbound.
-        assertEquals(emptySet(), CMagicBindingTable.includesOrNull("assert"))
+        assertEquals(emptySet(), table.includesOrNull("assert"))
     }
 
     @Test
     fun unboundNamesResolveNull() {
-        assertNull(CMagicBindingTable.resolveFunctionOrNull("definitely_not_a_magic_name"))
-        assertNull(CMagicBindingTable.includesOrNull("definitely_not_a_magic_name"))
+        assertNull(table.resolveFunctionOrNull("definitely_not_a_magic_name"))
+        assertNull(table.includesOrNull("definitely_not_a_magic_name"))
     }
 
     @Test
     fun printFamilyIsNotBindable() {
         // print/println/eprint/trace stay codegen intrinsics: their format
         // string is type-directed per call site, so no fixed symbol binding.
-        assertNull(CMagicBindingTable.resolveFunctionOrNull("print"))
-        assertNull(CMagicBindingTable.resolveFunctionOrNull("trace"))
+        assertNull(table.resolveFunctionOrNull("print"))
+        assertNull(table.resolveFunctionOrNull("trace"))
     }
 
     @Test
     fun canonicalizationMatchesCodegen() {
         // Codegen strips a leading @ and surrounding _ then lowercases before
         // lookup (e.g. @_trace_ -> trace); the table keys must line up with that.
-        assertTrue(CMagicBindingTable.resolveFunctionOrNull("sqrt") != null)
+        assertTrue(table.resolveFunctionOrNull("sqrt") != null)
     }
 }
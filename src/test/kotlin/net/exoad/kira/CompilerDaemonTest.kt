@@ -0,0 +1,112 @@
+package net.exoad.kira
+
+import net.exoad.kira.cli.CompilerDaemon
+import org.junit.jupiter.api.Test
+import java.io.ByteArrayOutputStream
+import java.io.File
+import java.io.PrintStream
+import java.nio.file.Files
+import java.nio.file.Path
+import kotlin.concurrent.thread
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+/**
+ * A build forwarded to `kira --daemon` must look like one run in place: same
+ * output on the same streams, same exit code, in the client's directory.
+ */
+class CompilerDaemonTest {
+    private class Captured(val exitCode: Int?, val stdout: String, val stderr: String)
+
+    private fun forward(
+        socket: Path,
+        workingDirectory: Path,
+        vararg args: String,
+        environment: Map<String, String> = System.getenv(),
+    ): Captured {
+        val out = ByteArrayOutputStream()
+        val err = ByteArrayOutputStream()
+        val exitCode = CompilerDaemon.forward(
+            arrayOf(*args),
+            workingDirectory,
+            socket,
+            PrintStream(out, true),
+            PrintStream(err, true),
+            environment,
+        )
+        return Captured(exitCode, out.toString(), err.toString())
+    }
+
+    /** Run [block] against a daemon serving `socket` in a fresh directory `dir`, then stop it. */
+    private fun withDaemon(block: (dir: Path, socket: Path) -> Unit) {
+        val dir = Files.createTempDirectory("kira-daemon-")
+        val socket = dir.resolve("daemon.sock")
+        val server = thread(isDaemon = true, name = "kira-daemon-test") { CompilerDaemon.serve(socket) }
+        try {
+            val deadline = System.nanoTime() + 10_000_000_000L
+            while (!Files.exists(socket) && System.nanoTime() < deadline) {
+                Thread.sleep(20)
+            }
+            assertTrue(Files.exists(socket), "daemon never bound $socket")
+            block(dir, socket)
+        } finally {
+            assertTrue(CompilerDaemon.stop(socket))
+            server.join(10_000)
+            dir.toFile().deleteRecursively()
+        }
+        assertEquals(null, forward(socket, dir).exitCode, "a stopped daemon must not take builds")
+    }
+
+    @Test
+    fun forwardedBuildsReportOutputAndExitCode() {
+        withDaemon { dir, socket ->
+            val hello = Path.of("examples/01-hello").toAbsolutePath().normalize()
+            val built = forward(socket, hello, "--target", "none", "--no-cache")
+            assertEquals(0, built.exitCode, built.stderr)
+            assertTrue(built.stderr.contains("Everything took"), built.stderr)
+
+            val empty = Files.createDirectory(dir.resolve("empty"))
+            val failed = forward(socket, empty)
+            assertEquals(1, failed.exitCode)
+            assertTrue(failed.stderr.contains("No source files"), failed.stderr)
+
+            val help = forward(socket, empty, "--help")
+            assertEquals(0, help.exitCode)
+            assertTrue(help.stdout.startsWith("Usage: kira"), help.stdout)
+        }
+    }
+
+    @Test
+    fun nativeBuildsRunWithTheClientsEnvironment() {
+        withDaemon { dir, socket ->
+            // a project of our own, so the emitted C and the binary land in the temp directory
+            val project = Files.createDirectory(dir.resolve("hello"))
+            val app = Files.createDirectories(project.resolve("src/app"))
+            Files.copy(Path.of("examples/01-hello/src/app/main.kira"), app.resolve("main.kira"))
+            val stdlib = Path.of("kira").toAbsolutePath().normalize()
+            Files.writeString(
+                project.resolve("kira.yaml"),
+                "project:\n  name: hello\n\nsrcDir: src\n\nbuild:\n  target: c\n\n" +
+                    "dependencies:\n  kira_stdlib:\n    path: $stdlib\n",
+            )
+            // a "compiler" only the client's PATH has, which records what it saw and writes its -o
+            val tools = Files.createDirectory(dir.resolve("tools"))
+            val probe = dir.resolve("probe")
+            val cc = tools.resolve("kira-test-cc")
+            Files.writeString(
+                cc,
+                "#!/bin/sh\nprintf '%s' \"\$KIRA_DAEMON_PROBE\" > '$probe'\n" +
+                    "while [ \$# -gt 0 ]; do [ \"\$1\" = -o ] && : > \"\$2\"; shift; done\n",
+            )
+            assertTrue(cc.toFile().setExecutable(true))
+            val environment = System.getenv() + mapOf(
+                "PATH" to tools.toString() + File.pathSeparator + System.getenv("PATH").orEmpty(),
+                "KIRA_DAEMON_PROBE" to "from the client",
+            )
+
+            val built = forward(socket, project, "build", "--cc", "kira-test-cc", "--no-cache", environment = environment)
+            assertEquals(0, built.exitCode, built.stderr)
+            assertEquals("from the client", Files.readString(probe))
+        }
+    }
+}
@@ -0,0 +1,89 @@
+package net.exoad.kira
+
+import net.exoad.kira.compiler.CompilerSession
+import net.exoad.kira.compiler.backend.codegen.c.KiraCCodeGenerator
+import net.exoad.kira.compiler.backend.codegen.js.KiraJSCodeGenerator
+import org.junit.jupiter.api.Test
+import java.io.File
+import java.util.concurrent.Callable
+import java.util.concurrent.Executors
+import kotlin.test.assertEquals
+import kotlin.test.assertNotEquals
+
+/**
+ * Options live on the [CompilerSession] each compilation is handed, so
+ * projects compiled side by side in one JVM (the language server, parallel
+ * tests) must produce exactly what they produce alone.
+ */
+class CompilerSessionTest {
+    private val sessions = listOf(
+        CompilerSession(minifyOutput = true),
+        CompilerSession(minifyOutput = false),
+        CompilerSession(minifyOutput = false, instrument = true),
+        CompilerSession(minifyOutput = true, instrument = true),
+    )
+
+    private fun program(n: Int): String {
+        return TestCompileSupport.wrapModule(
+            "tests:session$n",
+            """
+            class Box$n {
+                require pub value: Int32
+
+                pub fx twice: () Int32 {
+                    return value * 2
+                }
+            }
+
+            fx main: () Void {
+                box: Box$n = Box$n { $n }
+                trace(box.twice())
+            }
+            """
+        )
+    }
+
+    /** The C and JS a [session] writes for program [n], read back from the files `generate()` produced. */
+    private fun emit(n: Int, session: CompilerSession): Pair<String, String> {
+        val result = TestCompileSupport.compileSnippet(
+            program(n),
+            TestCompileSupport.logicalPathForModule("tests:session$n"),
+            runSemantic = true,
+            session = session,
+        )
+        val c = File.createTempFile("kira-session-", ".c")
+        val js = File.createTempFile("kira-session-", ".js")
+        try {
+            KiraCCodeGenerator(result.compilationUnit).generate(c.path)
+            KiraJSCodeGenerator(result.compilationUnit).generate(js.path)
+            return c.readText() to js.readText()
+        } finally {
+            c.delete()
+            js.delete()
+        }
+    }
+
+    @Test
+    fun sessionsCompiledConcurrentlyMatchSerialOutput() {
+        val jobs = sessions.indices.flatMap { s -> (0 until 4).map { n -> s to n } }
+        val serial = jobs.associateWith { (s, n) -> emit(n, sessions[s]) }
+        // the options must actually reach the output, or the comparison below proves nothing
+        assertNotEquals(serial.getValue(0 to 0).first, serial.getValue(1 to 0).first)
+        assertNotEquals(serial.getValue(1 to 0).first, serial.getValue(2 to 0).first)
+
+        val pool = Executors.newFixedThreadPool(jobs.size)
+        try {
+            repeat(3) {
+                val futures = jobs.shuffled().map { job ->
+                    // a fresh session per job, so no two threads share the runtime caches either
+                    job to pool.submit(Callable { emit(job.second, sessions[job.first].copy()) })
+                }
+                for ((job, future) in futures) {
+                    assertEquals(serial.getValue(job), future.get(), "session ${job.first}, program ${job.second}")
+                }
+            }
+        } finally {
+            pool.shutdownNow()
+        }
+    }
+}
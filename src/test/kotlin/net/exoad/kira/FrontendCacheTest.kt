@@ -0,0 +1,164 @@
+package net.exoad.kira
+
+import net.exoad.kira.compiler.FrontendCache
+import net.exoad.kira.compiler.FrontendService
+import net.exoad.kira.compiler.frontend.parser.ast.XMLASTVisitorKira
+import org.junit.jupiter.api.AfterEach
+import org.junit.jupiter.api.BeforeEach
+import org.junit.jupiter.api.Test
+import java.io.File
+import java.nio.file.Files
+import java.nio.file.Path
+import java.nio.file.attribute.FileTime
+import kotlin.io.path.writeText
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+/**
+ * The incremental frontend cache: a warm run must rebuild the exact same unit
+ * from disk, and an edit must only re-parse the edited file.
+ */
+class FrontendCacheTest {
+    private lateinit var dir: Path
+    private lateinit var main: Path
+    private lateinit var sources: List<String>
+
+    @BeforeEach
+    fun setUp() {
+        dir = Files.createTempDirectory("kira-cache-")
+        main = dir.resolve("main.kira")
+        main.writeText(
+            """
+            module "tmp:main"
+
+            class Counter {
+                require pub total: Int32
+            }
+
+            fx main: () Void {
+                counter: Counter = Counter { 3 }
+                trace(counter.total)
+            }
+            """.trimIndent()
+        )
+        sources = Public.Builtin.discoverLegacyKiraFolder().toList() + File(main.toString()).canonicalPath
+    }
+
+    @AfterEach
+    fun tearDown() {
+        dir.toFile().deleteRecursively()
+    }
+
+    private fun compile(cache: FrontendCache): FrontendService.FrontendResult {
+        val result = FrontendService.compileSources(sources, cache = cache)
+        assertTrue(result.isOk, "unexpected diagnostics: ${result.diagnostics}")
+        return result
+    }
+
+    private fun cacheIn(): FrontendCache = FrontendCache(dir.resolve(".kira").resolve("cache"))
+
+    @Test
+    fun warmRunRebuildsTheSameUnitFromDisk() {
+        // The stdlib modules are reused from the unit's own bootstrap, so
+        // only the project file goes through the cache.
+        val cold = cacheIn()
+        val first = compile(cold)
+        assertEquals(0, cold.hits)
+        assertEquals(1, cold.misses)
+
+        val warm = cacheIn()
+        val second = compile(warm)
+        assertEquals(1, warm.hits)
+        assertEquals(0, warm.misses)
+
+        val path = File(main.toString()).canonicalPath
+        val before = first.compilationUnit!!.getSource(path)!!
+        val after = second.compilationUnit!!.getSource(path)!!
+        assertEquals(XMLASTVisitorKira.build(before.ast), XMLASTVisitorKira.build(after.ast))
+        assertEquals(before.tokens.map { it.toString() }, after.tokens.map { it.toString() })
+        // Positions and markers travel on the nodes themselves.
+        assertEquals(
+            before.ast.statements.map { before.originOf(it) },
+            after.ast.statements.map { after.originOf(it) }
+        )
+        assertEquals(before.intrinsified.size, after.intrinsified.size)
+        after.intrinsified.forEach { assertTrue(after.isIntrinsified(it)) }
+        // The semantic pass was replayed, not skipped outright.
+        assertEquals(first.compilationUnit!!.allMagicTypes(), second.compilationUnit!!.allMagicTypes())
+    }
+
+    @Test
+    fun editingOneFileOnlyReparsesThatFile() {
+        compile(cacheIn())
+        main.writeText(Files.readString(main).replace("Counter { 3 }", "Counter { 4 }"))
+
+        val edited = cacheIn()
+        compile(edited)
+        assertEquals(1, edited.misses)
+        assertEquals(0, edited.hits)
+        // The superseded entry is recent, so another build may still want it.
+        assertEquals(2, entries(edited).count { it.endsWith(".ast") })
+
+        // Once nobody has read it for a while, the next build prunes it and the old unit verdict.
+        val old = FileTime.fromMillis(System.currentTimeMillis() - FrontendCache.STALE_AFTER.toMillis() * 2)
+        Files.list(edited.directory).use { stream -> stream.forEach { Files.setLastModifiedTime(it, old) } }
+        val warm = cacheIn()
+        compile(warm)
+        assertEquals(1, warm.hits)
+        val entries = entries(warm)
+        assertEquals(1, entries.count { it.endsWith(".ast") })
+        assertEquals(1, entries.count { it.endsWith(".unit") })
+    }
+
+    @Test
+    fun editingABodyOnlyRechecksThatModulesBodies() {
+        val util = dir.resolve("util.kira")
+        util.writeText(
+            """
+            module "tmp:util"
+
+            fx twice: (n: Int32) Int32 {
+                return n + n
+            }
+            """.trimIndent()
+        )
+        sources = sources + File(util.toString()).canonicalPath
+        compile(cacheIn())
+
+        // A body edit keeps every declaration, so the other modules' bodies are not checked again...
+        main.writeText(Files.readString(main).replace("Counter { 3 }", "Counter { 4 }"))
+        val bodyEdit = cacheIn()
+        compile(bodyEdit)
+        val skipped = bodyEdit.bodyHits
+        assertTrue(skipped >= 1, "util.kira's bodies should have been skipped")
+
+        // ...but the edited module's are: an error in its body is still reported.
+        main.writeText(Files.readString(main).replace("counter: Counter =", "counter: Missing ="))
+        val broken = cacheIn()
+        val result = FrontendService.compileSources(sources, cache = broken)
+        assertTrue(result.diagnostics.any { it.message.contains("'Missing' was not found") }, "${result.diagnostics}")
+        assertEquals(skipped, broken.bodyHits)
+
+        // A new declaration changes what every body may bind to, so nothing is skipped.
+        main.writeText(Files.readString(main).replace("counter: Missing =", "counter: Counter ="))
+        util.writeText(Files.readString(util) + "\n\nclass Extra {\n    require pub n: Int32\n}\n")
+        val declarationEdit = cacheIn()
+        compile(declarationEdit)
+        assertEquals(0, declarationEdit.bodyHits)
+    }
+
+    private fun entries(cache: FrontendCache): List<String> {
+        return Files.list(cache.directory).use { stream -> stream.map { it.fileName.toString() }.toList() }
+    }
+
+    @Test
+    fun corruptEntriesAreTreatedAsMisses() {
+        compile(cacheIn())
+        Files.list(cacheIn().directory).use { stream ->
+            stream.filter { it.toString().endsWith(".ast") }.forEach { Files.write(it, byteArrayOf(1, 2, 3)) }
+        }
+        val recovered = cacheIn()
+        compile(recovered)
+        assertEquals(1, recovered.misses)
+    }
+}
@@ -1,10 +1,12 @@
 package net.exoad.kira
 
+import net.exoad.kira.compiler.CompilerSession
 import net.exoad.kira.compiler.FrontendService
 import org.junit.jupiter.api.Test
 import java.nio.file.Files
 import java.nio.file.Path
 import kotlin.io.path.writeText
+import kotlin.test.assertEquals
 import kotlin.test.assertFalse
 import kotlin.test.assertTrue
 
@@ -65,4 +67,36 @@ class FrontendServiceTest {
             dir.toFile().deleteRecursively()
         }
     }
+
+    @Test
+    fun parallelParseMatchesSerialOrderAndDiagnostics() {
+        val dir = Files.createTempDirectory("kira-frontend-")
+        try {
+            val sources = (1..8).map { n ->
+                val file = dir.resolve("m$n.kira")
+                file.writeText(
+                    if (n % 3 == 0) {
+                        "module \"tmp:m$n\"\nfx f$n: () Void {\n    this is not valid kira !!!\n}\n"
+                    } else {
+                        "module \"tmp:m$n\"\nfx f$n: () Int32 {\n    return $n\n}\n"
+                    }
+                )
+                file.toString()
+            } + dir.resolve("missing.kira").toString()
+
+            fun compile(jobs: Int): Pair<List<String>, List<String>> {
+                val result = FrontendService.compileSources(sources.reversed(), session = CompilerSession(jobs = jobs))
+                return result.compilationUnit!!.allSourcePaths() to
+                    result.diagnostics.map { "${it.file}: ${it.tag}: ${it.message}" }
+            }
+
+            val serial = compile(1)
+            assertEquals(serial, compile(4))
+            // Two broken files and the missing one come first, in path order.
+            val parseFailures = serial.second.take(3).map { Path.of(it.substringBefore(": ")).fileName.toString() }
+            assertEquals(listOf("m3.kira", "m6.kira", "missing.kira"), parseFailures, serial.second.toString())
+        } finally {
+            dir.toFile().deleteRecursively()
+        }
+    }
 }
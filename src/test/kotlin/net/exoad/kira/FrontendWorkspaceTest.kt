@@ -0,0 +1,119 @@
+package net.exoad.kira
+
+import net.exoad.kira.compiler.CompilerSession
+import net.exoad.kira.compiler.FrontendService
+import net.exoad.kira.compiler.FrontendWorkspace
+import net.exoad.kira.compiler.PassTrace
+import org.junit.jupiter.api.AfterEach
+import org.junit.jupiter.api.BeforeEach
+import org.junit.jupiter.api.Test
+import java.io.File
+import java.nio.file.Files
+import java.nio.file.Path
+import java.util.concurrent.CancellationException
+import kotlin.io.path.writeText
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertTrue
+
+/**
+ * The language server's in-memory workspace: consecutive runs reuse every
+ * file whose text did not change, an unchanged unit skips the analyzer, and
+ * a cancelled session stops instead of reporting.
+ */
+class FrontendWorkspaceTest {
+    private lateinit var dir: Path
+    private lateinit var main: String
+    private lateinit var sources: List<String>
+    private val text = """
+        module "tmp:main"
+
+        class Counter {
+            require pub total: Int32
+        }
+
+        fx main: () Void {
+            counter: Counter = Counter { 3 }
+            trace(counter.total)
+        }
+    """.trimIndent()
+
+    @BeforeEach
+    fun setUp() {
+        dir = Files.createTempDirectory("kira-workspace-")
+        val path = dir.resolve("main.kira")
+        path.writeText(text)
+        main = File(path.toString()).canonicalPath
+        sources = Public.Builtin.discoverLegacyKiraFolder().toList() + main
+    }
+
+    @AfterEach
+    fun tearDown() {
+        dir.toFile().deleteRecursively()
+    }
+
+    private fun compile(session: CompilerSession, buffer: String = text): FrontendService.FrontendResult {
+        return FrontendService.compileSources(sources, overlays = mapOf(main to buffer), session = session)
+    }
+
+    @Test
+    fun reportedEditsRelexLikeAFreshCompile() {
+        val workspace = FrontendWorkspace()
+        compile(CompilerSession(workspace = workspace))
+        val old = "Counter { 3 }"
+        val new = "Counter { \"three\" }"
+        val start = text.indexOf(old)
+        val edited = text.replaceRange(start, start + old.length, new)
+        workspace.expectEdits(listOf(FrontendWorkspace.Edit(text, edited, start, old.length, new.length)))
+        val relexed = compile(CompilerSession(workspace = workspace), edited)
+        val fresh = compile(CompilerSession(), edited)
+        assertTrue(fresh.diagnostics.isNotEmpty())
+        assertEquals(fresh.diagnostics.map { it.message to it.start }, relexed.diagnostics.map { it.message to it.start })
+    }
+
+    @Test
+    fun unchangedFilesAreNotParsedAgain() {
+        val workspace = FrontendWorkspace()
+        val first = compile(CompilerSession(workspace = workspace))
+        assertTrue(first.isOk, "unexpected diagnostics: ${first.diagnostics}")
+        val parsed = workspace.misses
+
+        val second = compile(CompilerSession(workspace = workspace))
+        assertEquals(parsed, workspace.misses)
+        assertEquals(first.diagnostics, second.diagnostics)
+
+        compile(CompilerSession(workspace = workspace), text.replace("Counter { 3 }", "Counter { 4 }"))
+        assertEquals(parsed + 1, workspace.misses)
+    }
+
+    @Test
+    fun unchangedUnitSkipsTheAnalyzerAndKeepsItsDiagnostics() {
+        val broken = text.replace("counter: Counter =", "counter: MissingType =")
+        val workspace = FrontendWorkspace()
+        val first = compile(CompilerSession(workspace = workspace), broken)
+        assertTrue(first.diagnostics.any { it.message.contains("'MissingType' was not found") }, first.diagnostics.toString())
+
+        val trace = PassTrace()
+        val second = compile(CompilerSession(workspace = workspace, trace = trace), broken)
+        assertEquals(first.diagnostics, second.diagnostics)
+        assertTrue(trace.spans.none { it.name == "semantic" })
+        assertTrue(trace.spans.none { it.name == "parse" })
+
+        val fixed = compile(CompilerSession(workspace = workspace, trace = trace))
+        assertTrue(fixed.isOk, "unexpected diagnostics: ${fixed.diagnostics}")
+        assertEquals(1, trace.spans.count { it.name == "semantic" })
+    }
+
+    @Test
+    fun cancelledSessionStopsWithoutReporting() {
+        val workspace = FrontendWorkspace()
+        var polls = 0
+        // Let the run get a few phases in before the "newer edit" arrives.
+        val session = CompilerSession(workspace = workspace, cancelled = { ++polls > 3 })
+        assertFailsWith<CancellationException> { compile(session) }
+
+        // The cancelled run left nothing behind that a full run would not redo.
+        val result = compile(CompilerSession(workspace = workspace))
+        assertTrue(result.isOk, "unexpected diagnostics: ${result.diagnostics}")
+    }
+}
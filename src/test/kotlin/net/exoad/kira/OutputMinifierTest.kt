@@ -113,4 +113,20 @@ class OutputMinifierTest {
         assertTrue("process" in ids)
         assertTrue("stdout" in ids)
     }
+
+    @Test
+    fun streamingOverPartsMatchesTheStringForm() {
+        val header = "#include <math.h>\n\n"
+        val body = """
+            /* module app:main */
+            Int32 add(Int32 a, Int32 b) { return a /* sum */ + b; }
+            #define TWICE(x) ((x) + (x))
+            Int32 main(Void) { return add(1, - -2); } // tail
+        """.trimIndent() + "\n\n"
+        val rename = OutputMinifier.buildRenameMap(listOf("add"), setOf("Int32", "Void"))
+        val out = StringBuilder()
+        OutputMinifier.minify(MinifyLanguage.C, listOf(header, StringBuilder(body)), rename, out)
+        assertEquals(OutputMinifier.minify(MinifyLanguage.C, header + body, rename), out.toString())
+        assertTrue(out.endsWith(";}\n"), out.toString())
+    }
 }
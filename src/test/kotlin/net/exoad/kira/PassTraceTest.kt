@@ -0,0 +1,78 @@
+package net.exoad.kira
+
+import com.google.gson.JsonParser
+import net.exoad.kira.compiler.CompilerSession
+import net.exoad.kira.compiler.FrontendService
+import net.exoad.kira.compiler.PassTrace
+import net.exoad.kira.compiler.backend.codegen.c.KiraCCodeGenerator
+import org.junit.jupiter.api.Test
+import java.io.File
+import java.io.StringWriter
+import java.nio.file.Files
+import kotlin.io.path.writeText
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+/**
+ * `--time-passes` / `--trace`: every phase of a build records a span, per
+ * file where the phase works per file, and the trace is valid Chrome
+ * trace-event JSON.
+ */
+class PassTraceTest {
+    @Test
+    fun buildRecordsEveryPhaseAndWritesAChromeTrace() {
+        val dir = Files.createTempDirectory("kira-trace-")
+        try {
+            val main = dir.resolve("main.kira")
+            main.writeText(
+                """
+                module "trace:main"
+
+                class Counter {
+                    require pub total: Int32
+                }
+
+                fx main: () Void {
+                    counter: Counter = Counter { 3 }
+                    trace(counter.total)
+                }
+                """.trimIndent()
+            )
+            val path = File(main.toString()).canonicalPath
+            val sources = Public.Builtin.discoverLegacyKiraFolder().toList() + path
+            val trace = PassTrace()
+            val result = FrontendService.compileSources(sources, session = CompilerSession(trace = trace))
+            assertTrue(result.isOk, "unexpected diagnostics: ${result.diagnostics}")
+            val out = dir.resolve("out.kira.c").toString()
+            KiraCCodeGenerator(result.compilationUnit!!).generate(out)
+
+            val names = trace.spans.map { it.name }.toSet()
+            for (phase in listOf(
+                "read", "lex", "parse", "frontend", "semantic", "semantic declarations",
+                "collect specializations", "emit C", "minify", "write",
+            )) {
+                assertTrue(phase in names, "no '$phase' span in $names")
+            }
+            assertTrue(trace.spans.any { it.name == "parse" && it.file == path })
+            assertTrue(trace.spans.all { it.wallNanos >= 0 })
+
+            val json = StringWriter().also { trace.writeChromeTrace(it) }.toString()
+            val events = JsonParser.parseString(json).asJsonObject.getAsJsonArray("traceEvents")
+            val complete = events.map { it.asJsonObject }.filter { it.get("ph").asString == "X" }
+            assertEquals(trace.spans.size, complete.size)
+            assertTrue(complete.all { it.has("ts") && it.has("dur") && it.has("tid") })
+
+            val report = trace.report()
+            assertTrue(report.lines().first().startsWith("phase"), report)
+            assertTrue(report.contains("emit C"), report)
+        } finally {
+            dir.toFile().deleteRecursively()
+        }
+    }
+
+    @Test
+    fun untracedSessionRecordsNothing() {
+        val session = CompilerSession()
+        assertEquals(42, session.traced("anything") { 42 })
+    }
+}
@@ -0,0 +1,109 @@
+package net.exoad.kira
+
+import net.exoad.kira.compiler.CompilerSession
+import java.io.File
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertNotNull
+import kotlin.test.assertTrue
+
+/**
+ * `--instrument` wraps every user function and method in prelude profiler
+ * probes; the instrumented program prints the same output and writes a
+ * per-function report at exit.
+ */
+class ProfilerInstrumentationTest {
+    private val source = """
+        module "tests:profile"
+
+        class Counter {
+            require pub total: Int32
+
+            pub fx bump: (by: Int32) Int32 {
+                total = total + by
+                return total
+            }
+        }
+
+        fx fib: (n: Int32) Int32 {
+            if n < 2 {
+                return n
+            }
+            return fib(n - 1) + fib(n - 2)
+        }
+
+        fx main: () Void {
+            counter: Counter = Counter { 0 }
+            counter.bump(2)
+            trace(counter.bump(3))
+            trace(fib(10))
+        }
+    """.trimIndent()
+
+    private fun transpile(instrument: Boolean): String {
+        return TestCompileSupport.transpileSnippetToC(
+            source,
+            "tests/profile.kira",
+            session = CompilerSession(instrument = instrument),
+        )
+    }
+
+    @Test
+    fun probesAreOnlyEmittedWhenInstrumenting() {
+        val plain = transpile(instrument = false)
+        assertFalse(plain.contains("#define KIRA_INSTRUMENT"), plain)
+        assertFalse(plain.contains("kira_prof_enter("), plain)
+
+        val output = transpile(instrument = true)
+        assertTrue(output.startsWith("#define KIRA_INSTRUMENT 1\n"), output)
+        val names = assertNotNull(Regex("""static Str const kira_prof_names\[] = \{ (.*) };""").find(output), output)
+        assertEquals(
+            setOf("\"Counter.bump\"", "\"fib\"", "\"main\""),
+            names.groupValues[1].split(", ").toSet()
+        )
+        assertTrue(output.contains("#define KIRA_PROF_COUNT 3"), output)
+        assertTrue(output.contains("kira_prof_install(kira_prof_names, KIRA_PROF_COUNT);"), output)
+        // Value returns close the frame after evaluating the result.
+        assertTrue(output.contains("Int32 kira_prof_ret = "), output)
+        assertTrue(output.contains("return kira_prof_ret;"), output)
+    }
+
+    @Test
+    fun nonVoidMainStillInstallsTheProfiler() {
+        val output = TestCompileSupport.transpileSnippetToC(
+            """
+            module "tests:profile"
+
+            fx main: () Int32 {
+                trace(1)
+                return 0
+            }
+            """.trimIndent(),
+            "tests/profile.kira",
+            session = CompilerSession(instrument = true),
+        )
+        assertTrue(output.contains("kira_prof_install(kira_prof_names, KIRA_PROF_COUNT);"), output)
+        assertTrue(output.contains("Int32 kira_prof_ret = "), output)
+    }
+
+    @Test
+    fun instrumentedProgramWritesAProfileReport() {
+        val cc = TestCompileSupport.findCCompiler() ?: return
+        // compileAndRunC runs in build/tmp/c-run; with KIRA_PROFILE unset the
+        // report is appended to kira.profile.txt there.
+        val report = File("build/tmp/c-run/kira.profile.txt")
+        report.delete()
+        val ran = TestCompileSupport.compileAndRunC(transpile(instrument = true), cc)
+        assertEquals(0, ran.compileResult.exitCode, ran.compileResult.stderr)
+        assertEquals("5\n55\n", ran.runResult?.stdout, ran.runResult?.stderr)
+
+        val text = report.readText()
+        assertTrue(Regex("""\n\s+177\s+\S+\s+\S+\s+fib\n""").containsMatchIn(text), text)
+        assertTrue(Regex("""\n\s+2\s+\S+\s+\S+\s+Counter\.bump\n""").containsMatchIn(text), text)
+        assertTrue(text.contains("<entry> -> main: 1"), text)
+        assertTrue(text.contains("main -> fib: 1"), text)
+        assertTrue(text.contains("fib -> fib: 176"), text)
+        report.delete()
+    }
+}
@@ -3,7 +3,9 @@ package net.exoad.kira
 import org.junit.jupiter.api.Assumptions.assumeTrue
 import org.junit.jupiter.api.BeforeAll
 import org.junit.jupiter.api.Test
+import java.io.File
 import kotlin.test.assertEquals
+import kotlin.test.assertFalse
 import kotlin.test.assertTrue
 
 /**
@@ -204,4 +206,92 @@ class StdlibLoweringTest {
 
         assertEquals("2\ngrace\n1\n", runAndCapture(generated) ?: return)
     }
+
+    @Test
+    fun strParsesReturnResultAndFloatsSlotByBits() {
+        val generated = emit(
+            """
+            fx main: () Void {
+                s: Str = "-1234567890"
+                n: Result<Int32, Str> = s.toInt32()
+                trace(n.unwrap())
+                bad: Str = "12x"
+                oops: Result<Int32, Str> = bad.toInt32()
+                trace(oops.unwrapErr())
+                f: Str = "2.5e-1"
+                x: Result<Float64, Str> = f.toFloat64()
+                trace(x.unwrap())
+            }
+            """,
+            "test:stdlib.parse"
+        )
+
+        assertTrue(generated.contains("Str_toInt32(s)"), generated)
+        assertTrue(generated.contains("Str_toFloat64(f)"), generated)
+        // A Float payload must come back by bit pattern, not an integer cast.
+        assertTrue(generated.contains("KIRA_UNSLOT_FLT(Float64, Result_unwrap(&x))"), generated)
+
+        assertEquals("-1234567890\nnot a valid Int32\n0.25\n", runAndCapture(generated) ?: return)
+    }
+
+    @Test
+    fun scannerReadsNumbersTokensAndLinesFromAFile() {
+        val input = File("build/tmp/c-run").apply { mkdirs() }.resolve("scanner_${System.nanoTime()}.txt")
+        input.writeText("3\n10 20\n  30\n2.5 word  rest of line\r\nlast line")
+        val generated = emit(
+            """
+            fx main: () Void {
+                sc: Scanner = Scanner { "${input.absolutePath}" }
+                count: Int32 = sc.nextInt32()
+                mut total: Int64 = 0
+                mut i: Int32 = 0
+                while i < count {
+                    total = total + sc.nextInt64()
+                    i = i + 1
+                }
+                trace(total)
+                trace(sc.nextFloat64())
+                trace(sc.nextToken())
+                trace(sc.nextLine())
+                trace(sc.nextLine())
+                trace(sc.hasNextLine())
+            }
+            """,
+            "test:stdlib.scanner"
+        )
+
+        assertTrue(generated.contains("Scanner_open("), generated)
+        assertTrue(generated.contains("Scanner_nextInt32(&sc)"), generated)
+        // The Scanner owns its block buffer, so it is disposed like a container.
+        assertTrue(generated.contains("Scanner_dispose(&sc);"), generated)
+
+        assertEquals("60\n2.5\nword\n  rest of line\nlast line\n0\n", runAndCapture(generated) ?: return)
+    }
+
+    @Test
+    fun scannerWithoutAValueIsEmptyAndACopyIsNotDisposed() {
+        val input = File("build/tmp/c-run").apply { mkdirs() }.resolve("scanner_${System.nanoTime()}.txt")
+        input.writeText("7 8")
+        val generated = emit(
+            """
+            fx main: () Void {
+                mut idle: Scanner
+                trace(idle.hasNext())
+                sc: Scanner = Scanner { "${input.absolutePath}" }
+                alias: Scanner = sc
+                trace(alias.nextInt32())
+            }
+            """,
+            "test:stdlib.scanner.copy"
+        )
+
+        // No stdin buffer for a Scanner that is never read from stdin.
+        assertTrue(generated.contains("idle = Scanner_empty()"), generated)
+        assertFalse(generated.contains("Scanner_stdin()"), generated)
+        // The copy shares sc's buffer; disposing both would free it twice.
+        assertTrue(generated.contains("Scanner_dispose(&sc);"), generated)
+        assertFalse(generated.contains("Scanner_dispose(&alias);"), generated)
+
+        assertEquals("0\n7\n", runAndCapture(generated) ?: return)
+    }
 }
@@ -0,0 +1,87 @@
+package net.exoad.kira
+
+import net.exoad.kira.compiler.CompilationUnit
+import net.exoad.kira.compiler.CompilerSession
+import net.exoad.kira.compiler.StdlibSnapshot
+import net.exoad.kira.compiler.backend.codegen.OutputMinifier
+import net.exoad.kira.compiler.backend.codegen.c.CMagicBindingTable
+import net.exoad.kira.compiler.frontend.parser.ast.XMLASTVisitorKira
+import org.junit.jupiter.api.AfterEach
+import org.junit.jupiter.api.BeforeEach
+import org.junit.jupiter.api.Test
+import java.io.File
+import java.nio.file.Files
+import java.nio.file.Path
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertNotNull
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+/**
+ * The stdlib snapshot must rebuild exactly what parsing `kira/` produces, and
+ * must never stand in for a module whose text changed.
+ */
+class StdlibSnapshotTest {
+    private lateinit var file: Path
+
+    @BeforeEach
+    fun setUp() {
+        file = Files.createTempFile("kira-stdlib-", ".snapshot")
+    }
+
+    @AfterEach
+    fun tearDown() {
+        Files.deleteIfExists(file)
+    }
+
+    private fun snapshot(): StdlibSnapshot {
+        val written = StdlibSnapshot.write(Path.of("kira"), file)
+        val snapshot = assertNotNull(StdlibSnapshot.open(file))
+        assertEquals(written, snapshot.size)
+        return snapshot
+    }
+
+    @Test
+    fun bootstrapFromTheSnapshotMatchesParsing() {
+        val parsed = CompilationUnit(CompilerSession(stdlibSnapshot = null))
+        val session = CompilerSession(stdlibSnapshot = snapshot())
+        val loaded = CompilationUnit(session)
+
+        assertTrue(parsed.getSourcesLength() > 0)
+        assertEquals(parsed.getSourcesLength(), loaded.getSourcesLength())
+        parsed.allSources().forEach { expected ->
+            val actual = assertNotNull(loaded.getSource(expected.file))
+            assertEquals(XMLASTVisitorKira.build(expected.ast), XMLASTVisitorKira.build(actual.ast))
+            assertEquals(expected.tokens.map { it.toString() }, actual.tokens.map { it.toString() })
+            assertEquals(expected.ast.statements.map { expected.originOf(it) }, actual.ast.statements.map { actual.originOf(it) })
+            assertEquals(expected.intrinsified.size, actual.intrinsified.size)
+        }
+        // Two units never share nodes.
+        val again = CompilationUnit(session)
+        loaded.allSources().forEach { assertFalse(it.ast === again.getSource(it.file)!!.ast) }
+    }
+
+    @Test
+    fun editedModulesAndManifestsMiss() {
+        val snapshot = snapshot()
+        val io = File("kira/io.kira")
+        val unit = CompilationUnit(bootstrapStdlib = false)
+        assertTrue(snapshot.installSource(unit, io.canonicalPath, io.readText()))
+        assertFalse(snapshot.installSource(unit, io.canonicalPath, io.readText() + "\n"))
+
+        val manifest = File("kira/io.bind.yaml").readText()
+        assertEquals(CMagicBindingTable.parseManifest(manifest), snapshot.bindingsOrNull(manifest))
+        assertNull(snapshot.bindingsOrNull("$manifest\n"))
+    }
+
+    @Test
+    fun runtimePreludeIdentifiersAreCollected() {
+        val snapshot = snapshot()
+        listOf("kira/c/c_bundle.h", "kira/c/c_generator.c", "kira/js/js_generator.js").forEach { path ->
+            val text = File(path).readText()
+            assertEquals(OutputMinifier.extractIdentifiers(text), snapshot.identifiersOrNull(text), path)
+        }
+        assertNull(snapshot.identifiersOrNull("int renamed_prelude;"))
+    }
+}
@@ -2,14 +2,130 @@ package net.exoad.kira
 
 import net.exoad.kira.compiler.CompilationUnit
 import net.exoad.kira.compiler.analysis.semantic.KiraSemanticAnalyzer
+import net.exoad.kira.compiler.analysis.semantic.KiraSymbolTable
+import net.exoad.kira.compiler.analysis.semantic.SemanticScope
+import net.exoad.kira.compiler.analysis.semantic.SemanticSymbol
+import net.exoad.kira.compiler.analysis.semantic.SemanticSymbolKind
+import net.exoad.kira.compiler.frontend.lexer.Token
+import net.exoad.kira.source.SourceLocation
 import net.exoad.kira.compiler.frontend.lexer.KiraLexer
 import net.exoad.kira.compiler.frontend.parser.KiraParser
+import net.exoad.kira.compiler.frontend.parser.ast.declarations.VariableDecl
+import net.exoad.kira.compiler.frontend.parser.ast.elements.Identifier
+import net.exoad.kira.compiler.frontend.parser.ast.statements.Statement
 import net.exoad.kira.compiler.frontend.preprocessor.KiraPreprocessor
+import net.exoad.kira.core.Identifiers
 import org.junit.jupiter.api.Test
 import java.io.File
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
 import kotlin.test.assertNotNull
+import kotlin.test.assertNull
+import kotlin.test.assertSame
+import kotlin.test.assertTrue
 
 class SymbolTableTest {
+    private fun symbol(name: String, kind: SemanticSymbolKind = SemanticSymbolKind.VARIABLE): SemanticSymbol {
+        return SemanticSymbol(name, kind, Token.Type.IDENTIFIER, SourceLocation.bakedIn())
+    }
+
+    @Test
+    fun shadowingResolvesInnermostAndUnwindsOnExit() {
+        val table = KiraSymbolTable()
+        val outer = symbol("x")
+        val inner = symbol("x")
+        table.enter(SemanticScope.Module("test:a"))
+        assertTrue(table.declare("x", outer))
+        assertFalse(table.declare("x", symbol("x")), "same scope twice")
+        table.enter(SemanticScope.Function("f"))
+        assertTrue(table.declare("x", inner))
+        assertSame(inner, table.resolve("x"))
+        table.exit()
+        assertSame(outer, table.resolve("x"))
+        table.exit()
+        assertNull(table.resolve("x"))
+    }
+
+    @Test
+    fun declaringIntoALowerFrameKeepsTheInnerShadow() {
+        val table = KiraSymbolTable()
+        table.enter(SemanticScope.Module("test:a"))
+        val module = table.findScope(SemanticScope.Module("test:a"))!!
+        table.enter(SemanticScope.Class("C"))
+        val member = symbol("T")
+        table.declare("T", member)
+        val imported = symbol("T", SemanticSymbolKind.TYPE_SPECIFIER)
+        assertTrue(table.declareInto(module, "T", imported))
+        assertSame(member, table.resolve("T"))
+        table.exit()
+        assertSame(imported, table.resolve("T"))
+        assertTrue(module.symbols.containsKey("T"))
+        assertFalse(table.declareGlobal("T", symbol("T")), "already visible")
+    }
+
+    @Test
+    fun forksReadThroughAndKeepTheirOwnFrames() {
+        val table = KiraSymbolTable()
+        table.enter(SemanticScope.Module("test:a"))
+        val shared = symbol("shared")
+        table.declare("shared", shared)
+        val fork = table.fork()
+        fork.enter(SemanticScope.Function("f"))
+        val local = symbol("local")
+        fork.declare("local", local)
+        assertSame(shared, fork.resolve("shared"))
+        assertSame(local, fork.resolve("local"))
+        assertNull(table.resolve("local"))
+        assertEquals(
+            listOf("f", "test:a", "global"),
+            fork.map { it.kind.name }
+        )
+        fork.exit()
+        assertNull(fork.resolve("local"))
+    }
+
+    @Test
+    fun resolutionDoesNotDependOnHowManyModulesAreOpen() {
+        // Every module stays open on top of the previous ones; a name from the
+        // first one must still resolve, and unknown names miss without a walk.
+        val table = KiraSymbolTable()
+        val first = symbol("first")
+        for (i in 0 until 5000) {
+            table.enter(SemanticScope.Module("test:m$i"))
+            if (i == 0) {
+                table.declare("first", first)
+            }
+        }
+        assertSame(first, table.resolve("first"))
+        assertNull(table.resolve("never-declared-anywhere"))
+    }
+
+    @Test
+    fun parsedNamesResolveByTheirLexedId() {
+        val cu = CompilationUnit(bootstrapStdlib = false)
+        val src = cu.addSource("ids.kira", "count: Int32 = 1", emptyList())
+        val tokens = KiraLexer(src, cu.identifiers).tokenize()
+        val parsed = cu.addSource("ids.kira", src.content, tokens)
+        KiraParser(parsed).parse()
+        val decl = parsed.ast.statements
+            .map { if (it is Statement) it.expr else it }
+            .filterIsInstance<VariableDecl>()
+            .single()
+        // the parser hands the node the id the lexer gave the name, in the unit's table
+        assertEquals(tokens.symbolId(0), decl.name.symbolIdIn(cu.identifiers))
+        assertEquals(-1, decl.name.symbolIdIn(Identifiers()))
+
+        val table = cu.symbolTable
+        table.enter(SemanticScope.Module("test:ids"))
+        val count = symbol("count")
+        assertTrue(table.declare(decl.name, count))
+        assertSame(count, table.resolve("count"))
+        assertSame(count, table.resolve(decl.name))
+        assertTrue(table.containsInCurrentScope(decl.name))
+        // a node made by hand has no id and is found by its text
+        assertSame(count, table.resolve(Identifier("count")))
+    }
+
     @Test
     fun testSymbolTableDump() {
         // Use the existing sample in test_kira/sub/test.kira
@@ -36,12 +152,13 @@ class SymbolTableTest {
         cu.allSources().forEach { srcCtx ->
             intrOut.appendText("Source: ${srcCtx.file}\n")
             try {
-                intrOut.appendText("  Intrinsic markers count: ${srcCtx.astIntrinsicMarked.size}\n")
-                srcCtx.astIntrinsicMarked.forEach { (node, intrinsics) ->
+                intrOut.appendText("  Intrinsic markers count: ${srcCtx.intrinsified.size}\n")
+                srcCtx.intrinsified.forEach { node ->
+                    val intrinsics = srcCtx.intrinsicsOf(node)
                     intrOut.appendText("    Node: ${node::class.simpleName} -> ${intrinsics.joinToString { intrinsic -> intrinsic.name }}\n")
                 }
             } catch (_: UninitializedPropertyAccessException) {
-                intrOut.appendText("  astIntrinsicMarked not initialized\n")
+                intrOut.appendText("  AST not initialized\n")
             } catch (e: Exception) {
                 intrOut.appendText("  Error: ${e.message}\n")
             }
@@ -87,8 +204,9 @@ class SymbolTableTest {
             intrOut.appendText("\n")
             cu.allSources().forEach { srcCtx ->
                 intrOut.appendText("Source: ${srcCtx.file}\n")
-                intrOut.appendText("  Intrinsic markers count: ${srcCtx.astIntrinsicMarked.size}\n")
-                srcCtx.astIntrinsicMarked.forEach { (node, intrinsics) ->
+                intrOut.appendText("  Intrinsic markers count: ${srcCtx.intrinsified.size}\n")
+                srcCtx.intrinsified.forEach { node ->
+                    val intrinsics = srcCtx.intrinsicsOf(node)
                     intrOut.appendText("    Node: ${node::class.simpleName} -> ${intrinsics.joinToString { intrinsic -> intrinsic.name }}\n")
                 }
                 intrOut.appendText("\n")
@@ -1,6 +1,7 @@
 package net.exoad.kira
 
 import net.exoad.kira.compiler.CompilationUnit
+import net.exoad.kira.compiler.CompilerSession
 import net.exoad.kira.compiler.analysis.semantic.KiraSemanticAnalyzer
 import net.exoad.kira.compiler.analysis.semantic.SemanticAnalyzerResults
 import net.exoad.kira.compiler.backend.codegen.c.KiraCCodeGenerator
@@ -48,11 +49,12 @@ object TestCompileSupport {
     fun compileSnippet(
         source: String,
         logicalPath: String,
-        runSemantic: Boolean = false
+        runSemantic: Boolean = false,
+        session: CompilerSession = CompilerSession(),
     ): FrontendCompilationResult {
         val pre = KiraPreprocessor(source)
         val preprocessed = pre.process()
-        val cu = CompilationUnit()
+        val cu = CompilationUnit(session)
         val src = cu.addSource(logicalPath, preprocessed.processedContent, emptyList())
         val tokens = KiraLexer(src).tokenize()
         val srcWithTokens = cu.addSource(logicalPath, src.content, tokens)
@@ -79,9 +81,10 @@ object TestCompileSupport {
     fun transpileSnippetToC(
         source: String,
         logicalPath: String,
-        runSemantic: Boolean = false
+        runSemantic: Boolean = false,
+        session: CompilerSession = CompilerSession(),
     ): String {
-        val result = compileSnippet(source, logicalPath, runSemantic)
+        val result = compileSnippet(source, logicalPath, runSemantic, session)
         return KiraCCodeGenerator(result.compilationUnit).emitToString()
     }
 
@@ -1,6 +1,6 @@
 package net.exoad.kira.kim
 
-import net.exoad.kira.Public
+import net.exoad.kira.compiler.CompilerSession
 import org.junit.jupiter.api.Test
 import java.nio.file.Files
 import kotlin.test.assertTrue
@@ -30,8 +30,8 @@ dependencies:
 
         val manifest = ManifestLoader.loadFromPath(mf)
         val stdlibEntries = DependencyResolver.resolveDependencySources(manifest, tempDir)
-        Public.Builtin.intrinsicalStandardLibrarySources = stdlibEntries.distinct().sorted().toTypedArray()
-        assertTrue(Public.Builtin.intrinsicalStandardLibrarySources.any { it.endsWith("types.kira") })
+        val session = CompilerSession(stdlibSources = stdlibEntries.distinct().sorted())
+        assertTrue(session.stdlibSources.any { it.endsWith("types.kira") })
     }
 }
 
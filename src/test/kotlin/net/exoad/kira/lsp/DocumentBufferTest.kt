@@ -0,0 +1,92 @@
+package net.exoad.kira.lsp
+
+import org.eclipse.lsp4j.Position
+import org.eclipse.lsp4j.Range
+import org.junit.jupiter.api.Test
+import kotlin.random.Random
+import kotlin.test.assertEquals
+import kotlin.test.assertNotNull
+import kotlin.test.assertNull
+import kotlin.test.assertSame
+
+class DocumentBufferTest {
+    private fun range(startLine: Int, startChar: Int, endLine: Int, endChar: Int): Range {
+        return Range(Position(startLine, startChar), Position(endLine, endChar))
+    }
+
+    @Test
+    fun appliesRangedEditsInOrder() {
+        val buffer = DocumentBuffer("module \"t:x\"\nfx main: () Void {\n}\n")
+        buffer.apply(range(1, 18, 1, 18), "\n    trace(1)")
+        buffer.apply(range(2, 10, 2, 11), "42")
+        buffer.apply(range(0, 8, 0, 9), "app")
+        assertEquals("module \"app:x\"\nfx main: () Void {\n    trace(42)\n}\n", buffer.toString())
+        assertEquals(buffer.toString().length, buffer.length)
+
+        buffer.apply(range(1, 0, 3, 1), "")
+        assertEquals("module \"app:x\"\n\n", buffer.toString())
+        buffer.apply(null, "replaced")
+        assertEquals("replaced", buffer.toString())
+    }
+
+    @Test
+    fun positionsPastTheEndAreClamped() {
+        val buffer = DocumentBuffer("ab\ncd")
+        assertEquals(2, buffer.offsetOf(Position(0, 99)))
+        assertEquals(5, buffer.offsetOf(Position(7, 0)))
+        buffer.apply(range(9, 0, 9, 0), "!")
+        assertEquals("ab\ncd!", buffer.toString())
+    }
+
+    @Test
+    fun matchesPlainStringEdits() {
+        val random = Random(48)
+        var expected = "line one\nline two\n\nline four"
+        val buffer = DocumentBuffer(expected)
+        repeat(2000) { step ->
+            val start = random.nextInt(expected.length + 1)
+            val end = (start + random.nextInt(6)).coerceAtMost(expected.length)
+            val text = listOf("", "x", "\n", "ab\ncd", "\n\n").random(random)
+            buffer.apply(Range(positionOf(expected, start), positionOf(expected, end)), text)
+            expected = expected.substring(0, start) + text + expected.substring(end)
+            assertEquals(expected, buffer.toString(), "after step $step")
+            if (step % 300 == 0) {
+                buffer.compact()
+            }
+        }
+    }
+
+    @Test
+    fun readsReportOneSpanCoveringEveryEditSinceTheLastRead() {
+        val random = Random(49)
+        val buffer = DocumentBuffer("line one\nline two\n\nline four")
+        assertNull(buffer.read().edit, "nothing to compare the first read with")
+        var last = buffer.read()
+        assertNull(last.edit, "nothing changed")
+        repeat(500) { step ->
+            val text = buffer.toString()
+            val start = random.nextInt(text.length + 1)
+            val end = (start + random.nextInt(6)).coerceAtMost(text.length)
+            buffer.apply(Range(positionOf(text, start), positionOf(text, end)), listOf("", "x", "\n", "ab\ncd").random(random))
+            if (step % 7 != 6) {
+                return@repeat
+            }
+            val read = buffer.read()
+            val edit = assertNotNull(read.edit, "after step $step")
+            assertSame(last.text, edit.before)
+            assertSame(read.text, edit.after)
+            val spliced = edit.before.substring(0, edit.start) +
+                edit.after.substring(edit.start, edit.start + edit.inserted) +
+                edit.before.substring(edit.start + edit.removed)
+            assertEquals(read.text, spliced, "after step $step")
+            last = read
+        }
+        buffer.apply(null, "replaced")
+        assertNull(buffer.read().edit, "a whole-text replace says nothing about where it changed")
+    }
+
+    private fun positionOf(text: String, offset: Int): Position {
+        val lineStart = text.lastIndexOf('\n', offset - 1) + 1
+        return Position(text.substring(0, offset).count { it == '\n' }, offset - lineStart)
+    }
+}
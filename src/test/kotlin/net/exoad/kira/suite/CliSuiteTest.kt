@@ -42,11 +42,11 @@ class CliSuiteTest {
     }
 
     /** Run the real CLI main in [dir]. */
-    private fun runCli(dir: File): CliResult {
+    private fun runCli(dir: File, vararg args: String): CliResult {
         val java = System.getProperty("java.home") + "/bin/java"
         val classpath = System.getProperty("java.class.path")
         val proc = ProcessBuilder(
-            java, "-cp", classpath, "net.exoad.kira.cli.MainKt"
+            listOf(java, "-cp", classpath, "net.exoad.kira.cli.MainKt", "--no-daemon") + args
         )
             .directory(dir)
             .redirectErrorStream(false)
@@ -137,6 +137,111 @@ class CliSuiteTest {
         assertTrue(runOut.contains("from-cli"), runOut)
     }
 
+    @Test
+    fun runBuildsOnceAndReusesTheCachedBinary() {
+        val compiler = findCCompiler() ?: return
+        val dir = tempProject(
+            "build-cache",
+            basicManifest(),
+            mapOf(
+                "src/app/main.kira" to """
+                    module "app:main"
+
+                    fx main: () Void {
+                        trace("from-run")
+                    }
+                """.trimIndent(),
+            )
+        )
+        val first = runCli(dir, "run", "--cc", compiler, "--profile", "release")
+        assertEquals(0, first.exitCode, "stdout:\n${first.stdout}\nstderr:\n${first.stderr}")
+        assertTrue(first.stdout.contains("from-run"), first.stdout)
+        assertTrue(first.stderr.contains("Running $compiler -std=c17 -O2 -flto"), first.stderr)
+
+        val second = runCli(dir, "run", "--cc", compiler, "--profile", "release")
+        assertEquals(0, second.exitCode, "stdout:\n${second.stdout}\nstderr:\n${second.stderr}")
+        assertTrue(second.stdout.contains("from-run"), second.stdout)
+        assertFalse(second.stderr.contains("Running $compiler"), "cc ran again on unchanged C:\n${second.stderr}")
+        assertTrue(second.stderr.contains("reused the cached app"), second.stderr)
+
+        // another profile is another binary
+        val debug = runCli(dir, "build", "--cc", compiler, "--profile", "debug")
+        assertEquals(0, debug.exitCode, debug.stderr)
+        assertTrue(debug.stderr.contains("Running $compiler -std=c17 -O0 -g"), debug.stderr)
+    }
+
+    @Test
+    fun editingAHeaderAnExtraSourceIncludesRebuilds() {
+        val compiler = findCCompiler() ?: return
+        val dir = tempProject(
+            "build-cache-headers",
+            basicManifest().replace("  target: c", "  target: c\n  cSources:\n    - native/helper.c"),
+            mapOf(
+                "src/app/main.kira" to """
+                    module "app:main"
+
+                    fx main: () Void {
+                        trace("from-run")
+                    }
+                """.trimIndent(),
+                "native/helper.h" to "#define KIRA_HELPER_VALUE 1\n",
+                "native/helper.c" to "#include \"helper.h\"\nint kira_helper(void) { return KIRA_HELPER_VALUE; }\n",
+            )
+        )
+        val first = runCli(dir, "build", "--cc", compiler)
+        assertEquals(0, first.exitCode, first.stderr)
+        assertTrue(first.stderr.contains("Running $compiler"), first.stderr)
+
+        val unchanged = runCli(dir, "build", "--cc", compiler)
+        assertEquals(0, unchanged.exitCode, unchanged.stderr)
+        assertTrue(unchanged.stderr.contains("reused the cached app"), unchanged.stderr)
+
+        // only the header changes; the binary it went into is stale
+        File(dir, "native/helper.h").writeText("#define KIRA_HELPER_VALUE 2\n")
+        val edited = runCli(dir, "build", "--cc", compiler)
+        assertEquals(0, edited.exitCode, edited.stderr)
+        assertTrue(edited.stderr.contains("Running $compiler"), "a header edit reused the old binary:\n${edited.stderr}")
+    }
+
+    @Test
+    fun pgoBuildTrainsOnceThenReusesTheOptimizedBinary() {
+        // gcc only: clang needs llvm-profdata as well
+        val gcc = ProcessBuilder("which", "gcc").start().let { proc ->
+            proc.inputStream.bufferedReader().readText().trim().takeIf { proc.waitFor() == 0 && it.isNotBlank() }
+        } ?: return
+        val dir = tempProject(
+            "pgo",
+            basicManifest().replace("  target: c", "  target: c\n  pgo:\n    train: ./app > trained.txt"),
+            mapOf(
+                "src/app/main.kira" to """
+                    module "app:main"
+
+                    fx main: () Void {
+                        mut total: Int32 = 0
+                        for mut i: 0..1000 {
+                            if i % 3 == 0 {
+                                total = total + i
+                            }
+                        }
+                        trace(total)
+                    }
+                """.trimIndent(),
+            )
+        )
+        val first = runCli(dir, "build", "--pgo", "--cc", gcc)
+        assertEquals(0, first.exitCode, "stdout:\n${first.stdout}\nstderr:\n${first.stderr}")
+        assertTrue(first.stderr.contains("-fprofile-generate="), first.stderr)
+        assertTrue(first.stderr.contains("-fprofile-use="), first.stderr)
+        assertTrue(File(dir, "trained.txt").readText().isNotBlank(), "training never ran the instrumented app")
+
+        File(dir, "trained.txt").delete()
+        val second = runCli(dir, "run", "--pgo", "--cc", gcc)
+        assertEquals(0, second.exitCode, "stdout:\n${second.stdout}\nstderr:\n${second.stderr}")
+        assertFalse(second.stderr.contains("Running "), "unchanged C was trained or compiled again:\n${second.stderr}")
+        assertFalse(File(dir, "trained.txt").exists())
+        assertTrue(second.stdout.isNotBlank(), second.stdout)
+    }
+
     // --- failure paths -----------------------------------------------------------
 
     @Test
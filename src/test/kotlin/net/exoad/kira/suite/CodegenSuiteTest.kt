@@ -189,7 +189,7 @@ class CodegenSuiteTest {
         assertTrue(output.contains("Str sound;"), output)
         // constructor
         assertTrue(output.contains("Pet* Pet_new(Str name, Str sound)"), output)
-        assertTrue(output.contains("kira_rc_alloc_with(sizeof(Pet), null)"), output)
+        assertTrue(output.contains("kira_rc_alloc_with(sizeof(Pet), null, \"Pet\")"), output)
         // method as free function with receiver
         assertTrue(output.contains("Str Pet_speak(Pet* this)"), output)
         assertTrue(output.contains("return this->sound;"), output)
@@ -4,10 +4,18 @@ import net.exoad.kira.compiler.CompilationUnit
 import net.exoad.kira.compiler.analysis.diagnostics.DiagnosticsException
 import net.exoad.kira.compiler.frontend.lexer.KiraLexer
 import net.exoad.kira.compiler.frontend.lexer.Token
+import net.exoad.kira.compiler.frontend.lexer.TokenStream
 import net.exoad.kira.compiler.frontend.preprocessor.KiraPreprocessor
 import org.junit.jupiter.api.Test
 import org.junit.jupiter.api.assertThrows
+import java.io.ByteArrayInputStream
+import java.io.ByteArrayOutputStream
+import java.io.ObjectInputStream
+import java.io.ObjectOutputStream
 import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertIs
+import kotlin.test.assertSame
 import kotlin.test.assertTrue
 
 /**
@@ -195,9 +203,8 @@ class LexerSuiteTest {
             ),
             tokens.map { it.type }
         )
-        // The modulo token currently carries a '.' as its diagnostic content;
-        // only its type is load-bearing.
         assertEquals(Token.Type.OP_MOD, tokens[9].type)
+        assertEquals("%", tokens[9].content)
     }
 
     @Test
@@ -338,6 +345,120 @@ class LexerSuiteTest {
         assertEquals(1 to 2, intrinsic.canonicalLocation.lineNumber to intrinsic.canonicalLocation.column)
     }
 
+    @Test
+    fun longLinesKeepTheirColumns() {
+        val tokens = lex("x: Int32 = ${" ".repeat(5000)}1")
+        val one = tokens.last()
+        assertEquals(1 to 5012, one.canonicalLocation.lineNumber to one.canonicalLocation.column)
+    }
+
+    // --- token stream -----------------------------------------------------
+
+    @Test
+    fun indexApiMatchesMaterializedTokens() {
+        val stream = assertIs<TokenStream>(lexRaw("module \"t:x\"\n\nfx main: () Void { @trace(0xFF + 1.5) }"))
+        stream.forEachIndexed { i, token ->
+            assertEquals(token.type, stream.type(i))
+            assertEquals(token.content, stream.text(i))
+            assertEquals(token.pointerPosition, stream.pointer(i))
+            assertEquals(token.canonicalLocation, stream.position(i))
+            assertEquals(token.canonicalLocation.lineNumber to token.canonicalLocation.column, stream.line(i) to stream.column(i))
+        }
+        // String tokens point at the opening quote but their text is what is inside.
+        val uri = stream.indexOfFirst { it.type == Token.Type.L_STRING }
+        assertEquals("t:x", stream.text(uri))
+        assertEquals(7, stream.pointer(uri))
+        assertEquals("255", stream.text(stream.indexOfFirst { it.type == Token.Type.L_INTEGER }))
+    }
+
+    @Test
+    fun streamsSurviveSerialization() {
+        val source = "a: Int32 = 0x10 // done"
+        val stream = assertIs<TokenStream>(lexRaw(source))
+        val bytes = ByteArrayOutputStream().also { out -> ObjectOutputStream(out).use { it.writeObject(stream) } }
+        // the text is stored by whoever stores the stream, not a second time inside it
+        assertFalse(String(bytes.toByteArray(), Charsets.ISO_8859_1).contains("Int32 = 0x10"))
+        val copy = ObjectInputStream(ByteArrayInputStream(bytes.toByteArray())).use { it.readObject() } as TokenStream
+        copy.attachSource(source)
+        assertEquals(stream.map { it.toString() }, copy.map { it.toString() })
+    }
+
+    // --- incremental re-lexing --------------------------------------------
+
+    /** Re-lex [before] after replacing [removed] characters at [start] with [inserted]; it must match a fresh lex. */
+    private fun assertRelexes(before: String, start: Int, removed: Int, inserted: String) {
+        val after = before.substring(0, start) + inserted + before.substring(start + removed)
+        val cu = CompilationUnit(bootstrapStdlib = false)
+        val previous = KiraLexer(cu.addSource("before.kira", before, emptyList())).tokenize()
+        val relexed = KiraLexer(cu.addSource("after.kira", after, emptyList()))
+            .relex(previous, start, removed, inserted.length)
+        val fresh = KiraLexer(cu.addSource("fresh.kira", after, emptyList())).tokenize()
+        assertEquals(
+            fresh.map { it.toString() to it.canonicalLocation },
+            relexed.map { it.toString() to it.canonicalLocation },
+            "re-lexing '$inserted' at $start over $removed characters"
+        )
+    }
+
+    private val relexSource = """
+        module "t:relex"
+
+        // counts things
+        fx main: () Void {
+            total: Int32 = 0x1F
+            name: Str = "a // b"
+            trace(total + 1.5)
+        }
+    """.trimIndent()
+
+    @Test
+    fun relexingMatchesAFreshLex() {
+        val at = relexSource.indexOf("total:")
+        assertRelexes(relexSource, at, 0, "x")
+        assertRelexes(relexSource, at + 5, 0, "s")
+        assertRelexes(relexSource, at, 5, "count")
+        assertRelexes(relexSource, relexSource.indexOf("0x1F"), 4, "42")
+        assertRelexes(relexSource, relexSource.indexOf("a // b"), 1, "\"+\"")
+        assertRelexes(relexSource, relexSource.indexOf("// counts"), 0, "x: Int32 = 1\n")
+        assertRelexes(relexSource, 0, 0, "\n\n")
+        assertRelexes(relexSource, relexSource.length, 0, "\nfx other: () Void {}")
+        assertRelexes(relexSource, relexSource.indexOf("fx main"), relexSource.length - relexSource.indexOf("fx main"), "")
+    }
+
+    @Test
+    fun relexingAcrossLinesShiftsTheRest() {
+        val start = relexSource.indexOf("    total")
+        val end = relexSource.indexOf("    trace")
+        // delete two lines, then put them back
+        assertRelexes(relexSource, start, end - start, "")
+        val without = relexSource.removeRange(start, end)
+        assertRelexes(without, start, 0, relexSource.substring(start, end))
+        // join two lines into one
+        val newline = relexSource.indexOf('\n', start)
+        assertRelexes(relexSource, newline, 1, " ")
+    }
+
+    @Test
+    fun namesAreInternedPerUnitNotPerProcess() {
+        val cu = CompilationUnit(bootstrapStdlib = false)
+        val first = KiraLexer(cu.addSource("first.kira", "alpha beta", emptyList()), cu.identifiers).tokenize()
+        val second = KiraLexer(cu.addSource("second.kira", "gamma alpha", emptyList()), cu.identifiers).tokenize()
+        // the unit's files share its table, so a name keeps its id from one file to the next
+        assertSame(cu.identifiers, first.identifiers)
+        assertEquals(first.symbolId(0), second.symbolId(1))
+        assertEquals(first.symbolId(0) + 2, second.symbolId(0))
+        // another unit starts a table of its own, keywords first, then its names from there
+        val other = CompilationUnit(bootstrapStdlib = false)
+        val third = KiraLexer(other.addSource("third.kira", "gamma", emptyList()), other.identifiers).tokenize()
+        assertEquals(first.symbolId(0), third.symbolId(0))
+        // re-lexing for that unit interns the kept tokens into its table, not the old one
+        val relexed = KiraLexer(other.addSource("first.kira", "beta", emptyList()), other.identifiers)
+            .relex(first, 0, 6, 0)
+        assertSame(other.identifiers, relexed.identifiers)
+        assertEquals("beta", relexed.text(0))
+        assertEquals(other.identifiers.find("beta"), relexed.symbolId(0))
+    }
+
     // --- comments and whitespace ------------------------------------------
 
     @Test
@@ -352,6 +473,24 @@ class LexerSuiteTest {
         )
     }
 
+    @Test
+    fun lexerSkipsCommentsWithoutPreprocessing() {
+        val source = "// header\r\nx: Int32 = 1 // trailing\r\n  // indented\r\ny: Str = \"a // b\""
+        val cu = CompilationUnit(bootstrapStdlib = false)
+        val ctx = cu.addSource("raw.kira", source, emptyList())
+        val lexer = KiraLexer(ctx)
+        val tokens = lexer.tokenize().filter { it.type != Token.Type.S_EOF }
+        assertEquals(
+            listOf("x", ":", "Int32", "=", "1", "y", ":", "Str", "=", "a // b"),
+            tokens.map { it.content }
+        )
+        assertEquals(listOf(1, 3), lexer.lineComments)
+        assertEquals(KiraPreprocessor(source).process().lineComments, lexer.lineComments)
+        assertEquals(2 to 1, tokens[0].canonicalLocation.lineNumber to tokens[0].canonicalLocation.column)
+        // Diagnostics read lines back out of the raw text, without the carriage return.
+        assertEquals("x: Int32 = 1 // trailing", ctx.findCanonicalLine(2))
+    }
+
     @Test
     fun commentMarkersInsideStringsAreKept() {
         assertLexes("\"http://x\"", Token.Type.L_STRING to "http://x")
@@ -1,6 +1,7 @@
 package net.exoad.kira.suite
 
 import net.exoad.kira.TestCompileSupport
+import net.exoad.kira.compiler.frontend.parser.ast.ASTNode
 import net.exoad.kira.compiler.frontend.parser.ast.RootASTNode
 import net.exoad.kira.compiler.frontend.parser.ast.declarations.ClassDecl
 import net.exoad.kira.compiler.frontend.parser.ast.declarations.EnumDecl
@@ -10,12 +11,17 @@ import net.exoad.kira.compiler.frontend.parser.ast.declarations.TraitDecl
 import net.exoad.kira.compiler.frontend.parser.ast.declarations.TypeAliasDecl
 import net.exoad.kira.compiler.frontend.parser.ast.declarations.VariableDecl
 import net.exoad.kira.compiler.frontend.parser.ast.elements.Identifier
+import net.exoad.kira.compiler.frontend.parser.ast.expressions.BinaryExpr
+import net.exoad.kira.compiler.frontend.parser.ast.expressions.FunctionCallExpr
+import net.exoad.kira.compiler.frontend.parser.ast.expressions.NoExpr
+import net.exoad.kira.compiler.frontend.parser.ast.expressions.ObjectInitExpr
 import net.exoad.kira.compiler.frontend.parser.ast.statements.Statement
 import org.junit.jupiter.api.Test
 import org.junit.jupiter.api.assertThrows
 import kotlin.test.assertEquals
 import kotlin.test.assertIs
 import kotlin.test.assertNotNull
+import kotlin.test.assertNull
 import kotlin.test.assertTrue
 
 /**
@@ -249,6 +255,55 @@ class ParserSuiteTest {
         )
     }
 
+    @Test
+    fun typeArgumentListsLongerThanTheOldLookaheadWindow() {
+        // Both lists run well past 16 tokens before their closing '>'.
+        val ast = parseModule(
+            """
+            picked: Int32 = pick<Map<Str, Arr<Int32>>, Map<Str, Arr<Int32>>, Arr<Arr<Int32>>>(1)
+            pair: Pair<Map<Str, Arr<Int32>>, Arr<Arr<Int32>>> = Pair<Map<Str, Arr<Int32>>, Arr<Arr<Int32>>> { 1, 2 }
+            """
+        )
+        val (picked, pair) = declsOf(ast).filterIsInstance<VariableDecl>()
+        assertEquals(3, assertIs<FunctionCallExpr>(picked.value).typeArguments.size)
+        assertEquals(2, assertIs<ObjectInitExpr>(pair.value).typeName.children.size)
+    }
+
+    @Test
+    fun longComparisonChainsParse() {
+        // Every '<' asks whether a type-argument list starts there. The first
+        // scan runs to the end of the chain and answers for every '<' it
+        // crossed, so this stays linear in the number of comparisons.
+        val chain = (0 until 2000).joinToString(" < ") { "a" }
+        val ast = parseModule("ok: Bool = $chain")
+        assertIs<BinaryExpr>(declsOf(ast).filterIsInstance<VariableDecl>().single().value)
+    }
+
+    @Test
+    fun positionsAndMarkersAreRecordedOnTheNodes() {
+        val context = TestCompileSupport.compileSnippet(
+            source = module(
+                """
+                pub @_magic class Box {}
+                pub x: Int32 = 1
+                """
+            ),
+            logicalPath = "tests/parser.kira",
+            runSemantic = false,
+        ).sourceContext
+        val decls = declsOf(context.ast)
+        val box = decls.filterIsInstance<ClassDecl>().single()
+        val x = decls.filterIsInstance<VariableDecl>().single()
+        val boxLine = context.relativeOriginOf(box).lineNumber
+        assertTrue(boxLine > 1)
+        assertEquals(boxLine + 1, context.relativeOriginOf(x).lineNumber)
+        assertEquals(listOf("_magic"), context.intrinsicsOf(box).map { it.name })
+        assertEquals(listOf<ASTNode>(box), context.intrinsified)
+        assertNull(x.intrinsicMarks)
+        // shared singletons are never stamped with one file's position
+        assertEquals(ASTNode.NO_ORIGIN, NoExpr.packedOrigin)
+    }
+
     // --- statements ---------------------------------------------------------
 
     @Test
@@ -36,6 +36,7 @@ class SemanticSuiteTest {
     private fun analyzeMultiSource(
         sources: List<Pair<String, String>>,
         uri: String = "test:semantic.basic",
+        jobs: Int = 1,
     ): SemanticAnalyzerResults {
         val cu = net.exoad.kira.compiler.CompilationUnit()
         for ((filePath, body) in sources) {
@@ -48,7 +49,7 @@ class SemanticSuiteTest {
                 cu.getSource(filePath)!!
             ).parse()
         }
-        return net.exoad.kira.compiler.analysis.semantic.KiraSemanticAnalyzer(cu).validateAST()
+        return net.exoad.kira.compiler.analysis.semantic.KiraSemanticAnalyzer(cu, jobs).validateAST()
     }
 
     private fun messages(results: SemanticAnalyzerResults): List<String> =
@@ -458,4 +459,89 @@ class SemanticSuiteTest {
         )
         assertNotNull(results)
     }
+
+    // --- parallel body pass ---------------------------------------------------
+
+    @Test
+    fun parallelBodyPassReportsLikeTheSerialOne() {
+        val sources = (1..6).map { n ->
+            "test/semantic/m$n.kira" to """module "test:semantic.m$n"""" + "\n" + """
+                pub class Shape$n { }
+                fx first$n: () Void {
+                    a: Int32 = "text"
+                    b: Missing$n = 1
+                }
+                dup$n: Int32 = 1
+                dup$n: Int32 = 2
+                fx second$n: () Void {
+                    c: Maybe<Int32> = 1
+                    c.value
+                    d: Shape$n = Shape$n { }
+                }
+                """
+        }
+        fun render(results: SemanticAnalyzerResults) =
+            results.diagnostics.map { "${it.context.file}:${it.location}: ${it.message}" }
+
+        val serial = render(analyzeMultiSource(sources, jobs = 1))
+        val parallel = render(analyzeMultiSource(sources, jobs = 4))
+        assertEquals(serial, parallel)
+        // Each module reports its first body, then the duplicate, then its second body.
+        val m1 = serial.filter { it.startsWith("test/semantic/m1.kira:") }
+        assertEquals(5, m1.size, m1.joinToString("\n"))
+        assertTrue(m1[0].contains("Type mismatch"), m1[0])
+        assertTrue(m1[1].contains("The type 'Missing1' was not found"), m1[1])
+        assertTrue(m1[2].contains("expected a 'Missing1'"), m1[2])
+        assertTrue(m1[3].contains("'dup1'"), m1[3])
+        assertTrue(m1[4].contains("'value' is not available on a 'Maybe'"), m1[4])
+    }
+
+    @Test
+    fun bodiesResolveTheirOwnModulesNamesNotLaterOnes() {
+        // Both modules declare `Count`. Bodies are checked after every module
+        // is declared, yet each must bind to the one its own module declared.
+        val sources = listOf(
+            "test/semantic/counts.kira" to """
+                module "test:semantic.counts"
+                alias Count as Int32
+                fx tally: () Void {
+                    c: Count = 1
+                }
+                """,
+            "test/semantic/labels.kira" to """
+                module "test:semantic.labels"
+                alias Count as Str
+                fx label: () Void {
+                    c: Count = "one"
+                }
+                """,
+        )
+        for (jobs in listOf(1, 4)) {
+            val reported = messages(analyzeMultiSource(sources, jobs = jobs))
+            assertTrue(reported.isEmpty(), "jobs=$jobs: " + reported.joinToString("\n"))
+        }
+    }
+
+    @Test
+    fun bodyIntrinsicsReportWhereTheWalkReachesThem() {
+        // As in the serial analyzer: the misplaced intrinsic is reported
+        // before the rest of its body, not after every body was checked.
+        val reported = messages(
+            analyze(
+                """
+                fx first: () Void {
+                    @_extern a: Int32 = 1
+                    b: Int32 = "text"
+                }
+                fx second: () Void {
+                    c: Int32 = "text"
+                }
+                """
+            )
+        )
+        assertEquals(3, reported.size, reported.joinToString("\n"))
+        assertTrue(reported[0].contains("'@_extern' cannot be applied to VariableDecl"), reported[0])
+        assertTrue(reported[1].contains("Type mismatch"), reported[1])
+        assertTrue(reported[2].contains("Type mismatch"), reported[2])
+    }
 }